@@ -43,6 +43,12 @@ class ChessObject
         // Draw the object
         void render(Shader* shaderPtr, ViewController* viewControllerPtr); 
 
+        // Draw the object into a depth buffer seen from the light
+        void renderDepth(Shader* depthShaderPtr, const glm::mat4& lightViewProjection);
+
+        // Place the object at a world position (translation only)
+        void setPosition(const glm::vec3& position);
+
         // Destructor
         ~ChessObject();
 };
\ No newline at end of file
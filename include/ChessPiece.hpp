@@ -17,6 +17,11 @@ class ChessPiece : public ChessObject{
         MeshTypes type;     // Type of the piece
         Team team;          // Team of the piece (BLACK, WHITE)
         bool alive;         // Is the piece alive or not
+
+        // Bounding capsule of the mesh (model space, vertical axis through the origin)
+        float boundingRadius;   // Horizontal radius of the capsule
+        float boundingBottom;   // Lowest point of the mesh
+        float boundingTop;      // Highest point of the mesh
     
     public :
         // Default constructor
@@ -32,11 +37,15 @@ class ChessPiece : public ChessObject{
         MeshTypes getType() const;
         Team getTeam() const;
         bool getAlive() const;
+        float getBoundingRadius() const;
+        float getBoundingBottom() const;
+        float getBoundingTop() const;
 
         // Setters
         void setType(MeshTypes typeIn);
         void setTeam(Team teamIn);
         void setAlive(bool aliveIn);
+        void setBoundingCapsule(float radiusIn, float bottomIn, float topIn);
 
         // Destructor
         ~ChessPiece();
@@ -8,10 +8,12 @@
 
 // Standard libraries
 #include <array>
+#include <cstdint>
 
 // Project headers
 #include "ChessObject.hpp"
 #include "Square.hpp"
+#include "Ray.hpp"
 
 class Chessboard : public ChessObject{
 
@@ -19,6 +21,9 @@ class Chessboard : public ChessObject{
 
         bool setUpState;  // is the board set up with the pieces ?
 
+        glm::vec3 a1Position;   // Center of the a1 square
+        float squareSize;       // Size of a square side
+
     public :
 
         //2D array of squares representing the chessboard
@@ -36,6 +41,21 @@ class Chessboard : public ChessObject{
         // Render the chessboard
         void render(Shader* shaderPtr, ViewController* viewControllerPtr);
 
+        // Render the board mesh only
+        void renderBoard(Shader* shaderPtr, ViewController* viewControllerPtr);
+
+        // Render the pieces only
+        void renderPieces(Shader* shaderPtr, ViewController* viewControllerPtr);
+
+        // Render the chessboard and the pieces into a depth buffer seen from the light
+        void renderDepth(Shader* depthShaderPtr, const glm::mat4& lightViewProjection);
+
+        // Get a signature of the pieces layout (changes when a piece is placed, moved or removed)
+        uint64_t getLayoutSignature() const;
+
+        // Find the square under a picking ray
+        bool pick(const Ray& ray, int& row, int& col) const;
+
         // Get setUp
         bool getSetUpState() const;
 
@@ -0,0 +1,88 @@
+/**
+ * @author obiwan138
+ * @class DynamicResolution
+ * @brief Render the 3D scene into an offscreen framebuffer whose resolution adapts to hold a GPU frame-time target
+ * @details The scene is rendered into a sub-rectangle (scale x window size) of an offscreen framebuffer allocated once
+ * at the maximum scale, so changing the scale never reallocates GPU memory. The GPU time of the scene is measured with
+ * timer queries and the scale is adjusted towards the target frame time. The result is then upscaled to the window
+ * with a sharpening filter, whose strength grows when the scale decreases.
+ */
+
+#pragma once
+
+// External libraries
+#include <GL/glew.h>              // OpenGL Library
+
+// Project headers
+#include "Shader.hpp"
+#include "GpuTimer.hpp"
+
+class DynamicResolution
+{
+    private :
+
+        // Configuration
+        float targetFrameTimeMs;    // GPU time budget of the scene [ms]
+        float minScale;             // Minimum resolution scale (per axis)
+        float maxScale;             // Maximum resolution scale (per axis)
+
+        // Current state
+        float scale;                // Current resolution scale (per axis)
+        int windowWidth;            // Size of the window [px]
+        int windowHeight;
+        int renderWidth;            // Size of the rendered sub-rectangle [px]
+        int renderHeight;
+
+        // Offscreen framebuffer (allocated at the maximum scale)
+        GLuint fbo;
+        GLuint colorTexture;
+        GLuint depthRenderbuffer;
+        int bufferWidth;
+        int bufferHeight;
+
+        // Upscale pass : fullscreen triangle with a sharpening filter
+        Shader upscaleShader;
+        GLuint emptyVao;
+        GLint sceneTextureID;
+        GLint uvScaleID;
+        GLint texelSizeID;
+        GLint sharpnessID;
+
+        // GPU time of the scene
+        GpuTimer sceneTimer;
+
+        // Allocate the offscreen framebuffer for the current window size
+        void allocateBuffers();
+
+        // Adjust the scale from the last measured GPU time
+        void updateScale(double frameTimeMs);
+
+    public :
+
+        // Constructor (requires a valid OpenGL context)
+        DynamicResolution(int windowWidthIn, int windowHeightIn, float targetFrameTimeMsIn, float minScaleIn, float maxScaleIn);
+
+        // Resize the offscreen framebuffer when the window is resized
+        void resize(int windowWidthIn, int windowHeightIn);
+
+        // Bind the offscreen framebuffer at the current scale, clear it and start timing
+        void beginScene();
+
+        // Stop timing and adapt the scale
+        void endScene();
+
+        // Upscale the offscreen image to the window with sharpening
+        void present();
+
+        // Getters
+        float getScale() const;
+        double getSceneTimeMs() const;
+        int getRenderWidth() const;
+        int getRenderHeight() const;
+
+        // Delete the GL objects
+        void deleteBuffers();
+
+        // Destructor
+        ~DynamicResolution();
+};
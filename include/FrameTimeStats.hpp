@@ -0,0 +1,44 @@
+/**
+ * @author obiwan138
+ * @class FrameTimeStats
+ * @brief Percentiles of the CPU frame times over the last frames
+ * @note The times are kept in a ring buffer, the percentiles are computed on demand (a copy and a partial sort of at
+ * most numFrames values), so recording a frame costs nothing.
+ */
+
+#pragma once
+
+// Standard libraries
+#include <array>
+#include <chrono>
+
+class FrameTimeStats
+{
+    private :
+
+        // Number of frames kept
+        static const int numFrames = 1024;
+
+        std::array<float, numFrames> frameTimesMs;      // Ring buffer of the frame times [ms]
+        int count;                                      // Number of recorded frames (up to numFrames)
+        int next;                                       // Next slot of the ring
+        std::chrono::steady_clock::time_point lastFrame;
+        bool started;
+
+    public :
+
+        // Constructor
+        FrameTimeStats();
+
+        // Record the end of a frame (the first call only starts the clock)
+        void frame();
+
+        // Forget the recorded frames
+        void reset();
+
+        // Get a percentile of the recorded frame times (p between 0 and 100) [ms]
+        float getPercentile(float p) const;
+
+        // Get the number of recorded frames
+        int getCount() const;
+};
@@ -29,6 +29,7 @@ class GLBuffersID
         GLuint vertexVBO;           // Vertex GL buffer object (VBO)
         GLuint uvVBO;               // UV coordinates GL buffer object (VBO)
         GLuint normalVBO;           // Normal vectors GL buffer object (VBO)
+        GLuint tangentVBO;          // Tangent vectors GL buffer object (VBO), 0 if the mesh has no tangents
         GLuint ebo;                 // Index GL buffer object (IBO or EBO)
         unsigned short numIndices;  // Number of indices
 
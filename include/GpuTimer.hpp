@@ -0,0 +1,54 @@
+/**
+ * @author obiwan138
+ * @class GpuTimer
+ * @brief Measure the GPU time spent between two points of the command stream with OpenGL timer queries
+ * @note The queries are used in a ring buffer and their results are read back only once available,
+ * so measuring a pass never stalls the pipeline. The result is typically 1 to 2 frames late.
+ * @note Timestamp queries (glQueryCounter) are used instead of GL_TIME_ELAPSED, so that timers can be nested
+ * (e.g. the main pass inside the whole scene).
+ */
+
+#pragma once
+
+// Standard libraries
+#include <array>
+
+// External libraries
+#include <GL/glew.h>              // OpenGL Library
+
+class GpuTimer
+{
+    private :
+
+        // Number of queries in flight
+        static const int numQueries = 4;
+
+        std::array<GLuint, numQueries> startQueries;    // Timestamp query objects at begin()
+        std::array<GLuint, numQueries> endQueries;      // Timestamp query objects at end()
+        std::array<bool, numQueries> pending;       // Is the query waiting for its result
+        int current;                                // Next query to use
+        double lastTimeMs;                          // Last measured GPU time [ms]
+
+    public :
+
+        // Constructor (requires a valid OpenGL context)
+        GpuTimer();
+
+        // Start measuring
+        void begin();
+
+        // Stop measuring
+        void end();
+
+        // Read the available results without blocking, return true if a new result arrived
+        bool poll();
+
+        // Get the last measured time [ms]
+        double getLastTimeMs() const;
+
+        // Delete the queries
+        void deleteQueries();
+
+        // Destructor
+        ~GpuTimer();
+};
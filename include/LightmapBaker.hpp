@@ -0,0 +1,67 @@
+/**
+ * @author obiwan138
+ * @class LightmapBaker
+ * @brief Bake the static lighting of a mesh into a texture on the CPU (direct diffuse lighting + ambient occlusion)
+ * @details The mesh UV space is rasterized into a texel buffer storing the world position and normal of each texel,
+ * then each texel is lit in parallel using OpenMP. The result is stored in a 24-bit texture :
+ * - red channel : direct diffuse irradiance from the point light (LightPower * cos(theta) / distance^2)
+ * - green channel : ambient occlusion (1 = not occluded) from the capsule occluders
+ * @note The mesh UVs must not overlap (each texel maps to a single point of the surface)
+ */
+
+#pragma once
+
+// Standard libraries
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// External libraries
+#include <glm/glm.hpp>            // OpenGL Mathematics
+
+// Project headers
+#include "RawVertexData.hpp"
+#include "RawTextureData.hpp"
+
+class LightmapBaker
+{
+    private :
+
+        // Vertical capsule occluding the ambient light
+        struct Occluder
+        {
+            glm::vec3 basePoint;
+            float radius;
+            float height;
+        };
+
+        int resolution;                     // Size of the (square) lightmap [px]
+        glm::vec3 lightPosition;            // Position of the point light (world space)
+        float lightPower;                   // Power of the point light (same as the fragment shader)
+        int numAoSamples;                   // Number of hemisphere directions for the ambient occlusion
+        float aoDistance;                   // Maximum distance of the occluders
+        std::vector<Occluder> occluders;    // Ambient light occluders
+
+    public :
+
+        // Constructor
+        LightmapBaker(int resolutionIn, const glm::vec3& lightPositionIn, float lightPowerIn);
+
+        // Add a vertical capsule occluding the ambient light (e.g. a piece at its start position)
+        void addOccluder(const glm::vec3& basePoint, float radius, float height);
+
+        // Getter
+        int getResolution() const;
+
+        // Hash of everything the lightmap of a mesh depends on (bake parameters, light, occluders and mesh), to name its cache
+        uint64_t getCacheKey(const RawVertexData& mesh) const;
+
+        // Bake the lightmap of a mesh
+        RawTextureData bake(const RawVertexData& mesh) const;
+
+        // Save a baked lightmap as a 24-bit BMP file
+        static bool save(const std::string& filePath, const RawTextureData& lightmap);
+
+        // Destructor
+        ~LightmapBaker();
+};
@@ -0,0 +1,27 @@
+/**
+ * @author obiwan138
+ * @class MeshCache
+ * @brief Binary cache of the processed meshes (RawVertexData), to skip the Assimp import and the processing on the next runs
+ * @details The file stores the mesh after processing (centered, with its tangent frames), as raw arrays behind a small header :
+ * magic "C3DM", version, number of vertices, number of indices, has tangents flag, size and last write time of the source
+ * file. The cache is rebuilt when the source file is changed.
+ */
+
+#pragma once
+
+// Standard libraries
+#include <string>
+
+// Project headers
+#include "RawVertexData.hpp"
+
+class MeshCache
+{
+    public :
+
+        // Load a processed mesh from a cache file, false if it is missing, invalid or older than its source file
+        static bool load(const std::string& filePath, const std::string& sourcePath, RawVertexData& vertexStruct);
+
+        // Save a processed mesh to a cache file, with the size and time of its source file
+        static bool save(const std::string& filePath, const std::string& sourcePath, const RawVertexData& vertexStruct);
+};
@@ -17,6 +17,7 @@ struct RawVertexData
     std::vector<glm::vec3> verticies;       // Vector of Vertices (= 3D points)
     std::vector<glm::vec2> uvs;             // UV coordinates for the texture
     std::vector<glm::vec3> normals;         // Normal vectors to the surface at a vertex
+    std::vector<glm::vec4> tangents;        // Tangent vectors (xyz) and bitangent sign (w), optional (normal mapping)
     std::vector<unsigned short> indices;    // Indices of the vertices to form triangles
     int numIndices;                         // Number of indices (verticies)
 };
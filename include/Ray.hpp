@@ -0,0 +1,25 @@
+/**
+ * @author obiwan138
+ * @struct Ray
+ * @brief This structure stores a half-line in world space and its analytic intersection tests (used for mouse picking)
+ */
+
+#pragma once
+
+// External libraries
+#include <glm/glm.hpp>            // OpenGL Mathematics
+
+struct Ray
+{
+    glm::vec3 origin;       // Starting point of the ray (world space)
+    glm::vec3 direction;    // Normalized direction of the ray (world space)
+
+    // Intersect the ray with the horizontal plane y = height
+    bool intersectHorizontalPlane(const float height, float& t) const;
+
+    // Intersect the ray with a vertical capsule standing on basePoint
+    bool intersectVerticalCapsule(const glm::vec3& basePoint, const float height, const float radius, float& t) const;
+
+    // Get the point located at the distance t along the ray
+    glm::vec3 pointAt(const float t) const;
+};
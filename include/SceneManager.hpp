@@ -25,6 +25,10 @@
 #include "Shader.hpp"
 #include "ViewController.hpp"
 #include "Chessboard.hpp"
+#include "Ray.hpp"
+#include "ShadowMap.hpp"
+#include "GpuTimer.hpp"
+#include "engine/Position.hpp"
 
 class SceneManager
 {
@@ -43,9 +47,33 @@ class SceneManager
         // Chess pieces
         std::map<TextureTypes, ChessPiece> chessPieces;
 
+        // Position currently displayed by the chessboard grid
+        engine::Position displayedPosition;
+
+        // Bounding capsules of the piece meshes (radius, bottom, top)
+        std::map<MeshTypes, glm::vec3> pieceBounds;
+
+        // Shadows : depth-only shader and cached shadow map
+        Shader depthShader;
+        ShadowMap shadowMap;
+
+        // GPU time of the main pass
+        GpuTimer mainPassTimer;
+
+        // Baked lighting of the board : CPU copy of the board mesh, lightmap texture and cheap board shader
+        RawVertexData boardVertexData;
+        GLuint lightmapTexture;
+        Shader boardShader;
+
+        // Normal mapped variant of the board shader (used when the board normal map is loaded)
+        Shader boardNormalMapShader;
+
         // Private constructor (singleton)
         SceneManager();
 
+        // Import the board mesh with Assimp (cache miss)
+        bool importBoard(const std::string& filePath, RawVertexData& vertexStruct);
+
     public :
 
         // Get the reference to a static instance of the scene manager existing in the function
@@ -60,24 +88,54 @@ class SceneManager
         // Load a set of texture files using OpenMP
         bool loadTextures(const std::vector<std::pair<TextureTypes, std::string>>& texturePaths);
 
+        // Convert a bump (height) image into a tangent space normal map
+        RawTextureData readBumpAsNormalMap(const std::string& filePath, float strength);
+
+        // Load a bump image as a normal map texture
+        bool loadNormalMap(TextureTypes name, const std::string& filePath, float strength);
+
         // Load the chess board
         bool loadBoard(const std::string& filePath);
 
         // Load the objects all at once (from the same file)
         bool loadPieces(const std::string& filePath);
 
+        // Load the board lightmap from the cache file of its bake parameters, bake it if there is none
+        bool loadLightmap(const std::string& cachePath, const glm::vec3& lightPosition);
+
         // Render the scene
         void render(Shader* shaderPtr, ViewController* viewControllerPtr);
 
         // Set up the board
         void setUpBoard();
 
+        // Update the chessboard grid squares which differ from a position
+        int syncPosition(const engine::Position& position);
+
+        // Get the GPU time of the main pass [ms]
+        double getMainPassTimeMs() const;
+
+        // Get the GPU time of the last shadow map update [ms]
+        double getShadowUpdateTimeMs() const;
+
+        // Get the number of shadow map updates
+        unsigned int getShadowUpdateCount() const;
+
+        // Find the square under a picking ray
+        bool pickSquare(const Ray& ray, int& row, int& col) const;
+
+        // Get the notation of a square of the board
+        std::string getSquareNotation(int row, int col) const;
+
         // Get a texture pointer
         const MeshTypes getMeshType(const TextureTypes& texture) const;
 
         // Get team
         const Team getTeam(const TextureTypes& texture) const;
 
+        // Get the texture type of an engine piece
+        const TextureTypes getTextureType(const engine::Piece& piece) const;
+
         // Get a vao pointer
         const GLuint getVaoID(const MeshTypes& type) const;
 
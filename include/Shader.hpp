@@ -30,6 +30,10 @@ class Shader {
         GLuint mvpMatrixID;     // ID of the MVP (Model-View-Projection) matrix uniform variable
         GLuint textureID;       // ID of the texture uniform variable
         GLuint lightID;         // ID of the Light uniform variable
+        GLuint depthBiasVPID;   // ID of the light view-projection (with bias) uniform variable, used for shadows
+        GLuint shadowMapID;     // ID of the shadow map uniform variable
+        GLuint lightmapID;      // ID of the baked lightmap uniform variable (board shader only)
+        GLuint normalMapID;     // ID of the normal map uniform variable (normal mapped board shader only)
 
         // Light position
         glm::vec3 lightPosition;
@@ -69,6 +73,21 @@ class Shader {
         // Get the light position
         glm::vec3 getLightPosition() const;
 
+        // Set the light position
+        void setLightPosition(const glm::vec3& position);
+
+        // Get the ID of the shader light view-projection (with bias) uniform variable
+        GLuint getDepthBiasVPID() const;
+
+        // Get the ID of the shader shadow map uniform variable
+        GLuint getShadowMapID() const;
+
+        // Get the ID of the shader lightmap uniform variable
+        GLuint getLightmapID() const;
+
+        // Get the ID of the shader normal map uniform variable
+        GLuint getNormalMapID() const;
+
         // Destructor
         ~Shader();
     
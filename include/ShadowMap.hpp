@@ -0,0 +1,82 @@
+/**
+ * @author obiwan138
+ * @class ShadowMap
+ * @brief Depth texture rendered from the light position, cached between frames
+ * @details The scene is almost entirely static, so the depth texture is only rendered again when the pieces layout
+ * or the light position change. Every other frame only samples the cached texture (with PCF in the fragment shader).
+ */
+
+#pragma once
+
+// Standard libraries
+#include <cstdint>
+
+// External libraries
+#include <GL/glew.h>              // OpenGL Library
+#include <glm/glm.hpp>            // OpenGL Mathematics
+
+// Project headers
+#include "Shader.hpp"
+#include "GpuTimer.hpp"
+
+class ShadowMap
+{
+    private :
+
+        GLuint fbo;                     // Framebuffer object rendering into the depth texture
+        GLuint depthTexture;            // Depth texture sampled by the main pass
+        int resolution;                 // Size of the (square) depth texture [px]
+
+        glm::mat4 lightViewProjection;  // Light view-projection matrix used to render the depth texture
+
+        // Cache state
+        bool valid;                     // Is the cached depth texture usable
+        glm::vec3 cachedLightPosition;  // Light position used for the cached texture
+        uint64_t cachedLayout;          // Pieces layout signature used for the cached texture
+
+        // Saved viewport and framebuffer while rendering into the depth texture
+        GLint savedViewport[4];
+        GLint savedFramebuffer;
+
+        // Statistics
+        GpuTimer updateTimer;           // GPU time of the shadow map updates
+        unsigned int updateCount;       // Number of updates since the creation
+
+    public :
+
+        // Constructor (requires a valid OpenGL context)
+        explicit ShadowMap(int resolutionIn);
+
+        // Is an update required for this light position and layout signature
+        bool needsUpdate(const glm::vec3& lightPosition, uint64_t layoutSignature) const;
+
+        // Bind the depth framebuffer and prepare the depth pass
+        void beginUpdate(const glm::vec3& lightPosition, uint64_t layoutSignature);
+
+        // Restore the previous framebuffer
+        void endUpdate();
+
+        // Force an update on the next frame
+        void invalidate();
+
+        // Bind the depth texture on a texture unit and send the light matrix to a shader
+        void bind(Shader* shaderPtr, GLenum textureUnit) const;
+
+        // Get the light view-projection matrix
+        glm::mat4 getLightViewProjection() const;
+
+        // Poll the GPU timer, return true if a new update time is available
+        bool pollUpdateTime();
+
+        // Get the GPU time of the last update [ms]
+        double getLastUpdateTimeMs() const;
+
+        // Get the number of updates
+        unsigned int getUpdateCount() const;
+
+        // Delete the GL objects
+        void deleteBuffers();
+
+        // Destructor
+        ~ShadowMap();
+};
@@ -37,11 +37,17 @@ class Square{
         // Render the piece
         void renderPiece(Shader* shaderPtr, ViewController* viewControllerPtr);
 
+        // Render the piece into a depth buffer seen from the light
+        void renderPieceDepth(Shader* depthShaderPtr, const glm::mat4& lightViewProjection);
+
         // Get the notation of the square
         std::string getNotation() const;
 
         // Get the position of the square
         glm::vec3 getPosition() const;       
+
+        // Get the piece at this square (nullptr if none)
+        ChessPiece* getPiece() const;
         
         // Set the notation
         void setNotation(const std::string& notationIn);
@@ -0,0 +1,22 @@
+/**
+ * @author obiwan138
+ * @class TangentGenerator
+ * @brief Generate the per-vertex tangent frames of a mesh for normal mapping
+ * @details The convention is the MikkTSpace one : the tangent follows the U direction of the texture, it is orthogonalized
+ * against the vertex normal, and the bitangent is not stored but rebuilt in the shader as sign * cross(normal, tangent),
+ * the sign being stored in the w component of the tangent. As in MikkTSpace, the triangle tangents are normalized and
+ * weighted by the corner angles, and the vertices shared by triangles of opposite handedness (mirrored UVs) are split.
+ */
+
+#pragma once
+
+// Project headers
+#include "RawVertexData.hpp"
+
+class TangentGenerator
+{
+    public :
+
+        // Fill the tangents vector of a mesh from its positions, UVs, normals and indices (vertices may be split)
+        static void generate(RawVertexData& vertexStruct);
+};
@@ -14,6 +14,9 @@
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 
+// Project headers
+#include "Ray.hpp"
+
 class ViewController 
 {
     private:
@@ -38,6 +41,7 @@ class ViewController
         // Induced matrices
         glm::mat4 viewMatrix;
         glm::mat4 projectionMatrix;
+        glm::mat4 inverseViewProjectionMatrix;  // Cached for mouse picking (updated with the view matrix)
 
         // Clock for the time difference between current and last frame
         sf::Clock clock;                
@@ -62,6 +66,9 @@ class ViewController
         // Get the projection matrix
         glm::mat4 getProjectionMatrix() const;
 
+        // Cast a ray from the camera through the mouse cursor
+        Ray computePickingRay(const sf::Vector2i& mousePosition, const sf::Vector2u& windowSize) const;
+
         // Destructor
         ~ViewController();
 
@@ -0,0 +1,96 @@
+/**
+ * @author obiwan138
+ * @class AnalysisWorker
+ * @brief Engine thread fed by the render loop through lock-free queues
+ * @details The render thread posts commands (analyze a position without limit, think for a given time, stop) into a
+ * single-producer single-consumer queue and reads the search updates (depth, score, principal variation) back from
+ * another one. Neither side ever waits for the other : posting a command raises the stop flag of the running search and
+ * pushes the command, polling pops whatever arrived. The worker only keeps the latest command when several are queued.
+ * The worker and its search threads run at a lower priority (Linux), and the positions are searched without their game
+ * history (the repetitions before the posted position are not known).
+ */
+
+#pragma once
+
+// Standard libraries
+#include <atomic>
+#include <cstdint>
+#include <thread>
+
+// Project headers
+#include "engine/Move.hpp"
+#include "engine/ParallelSearch.hpp"
+#include "engine/Position.hpp"
+#include "engine/SpscQueue.hpp"
+#include "engine/TranspositionTable.hpp"
+
+namespace engine{
+
+    // Command from the render thread
+    struct AnalysisCommand {
+        enum Type : uint8_t { ANALYZE, THINK, STOP, QUIT };
+        Type type;
+        uint32_t id;                // Identifier of the request, echoed by its updates
+        int64_t moveTimeMs;         // Time budget (THINK only)
+        Position position;
+    };
+
+    // Search update from the worker
+    struct AnalysisUpdate {
+        static constexpr int MAX_PV = 16;
+        uint32_t id;                // Identifier of the request
+        bool final;                 // The search of this request is over (bestMove is the answer of a THINK)
+        Move bestMove;
+        int score;                  // Side to move point of view [centipawns]
+        int depth;
+        uint64_t nodes;
+        uint64_t nps;
+        double ebf;                 // Effective branching factor of the last iteration
+        int pvLength;
+        Move pv[MAX_PV];
+    };
+
+    class AnalysisWorker
+    {
+        private :
+
+            ParallelSearch search;
+            SpscQueue<AnalysisCommand, 16> commands;        // Render thread -> worker
+            SpscQueue<AnalysisUpdate, 256> updates;         // Worker -> render thread
+            uint32_t lastId;                                // Last request identifier (render thread)
+            std::thread thread;
+
+            // Post a command, interrupting the running search
+            uint32_t post(AnalysisCommand::Type type, const Position& position, int64_t moveTimeMs);
+
+            // Worker thread : wait for the commands and run the searches
+            void loop();
+
+            // Push an update (dropped if the render thread does not keep up)
+            void publish(uint32_t id, bool final, const SearchResult& result);
+
+        public :
+
+            // Constructor : starts the worker thread (the table is shared with the caller)
+            AnalysisWorker(TranspositionTable& tt, int threadCount);
+
+            // Analyze a position until another command, return the identifier of the request
+            uint32_t analyze(const Position& position);
+
+            // Search the best move of a position for a given time, return the identifier of the request
+            uint32_t think(const Position& position, int64_t moveTimeMs);
+
+            // Stop the running search
+            void stop();
+
+            // Get the next update, return false if there is none (never blocks)
+            bool poll(AnalysisUpdate& update);
+
+            // Not copyable (owns a thread)
+            AnalysisWorker(const AnalysisWorker&) = delete;
+            AnalysisWorker& operator=(const AnalysisWorker&) = delete;
+
+            // Destructor : stops and joins the worker thread
+            ~AnalysisWorker();
+    };
+}
@@ -0,0 +1,135 @@
+/**
+ * @author obiwan138
+ * @file Attacks.hpp
+ * @brief Precomputed attack tables : leapers, sliders (magic or PEXT bitboards), lines and segments
+ * @details initAttacks() must be called once before any lookup. Sliding attacks are read from a single table per square
+ * indexed either by a magic multiplication or by the BMI2 PEXT instruction. PEXT is only used when the CPU reports BMI2
+ * at runtime, the table layout is chosen accordingly at init, so the same binary runs on every x86-64 CPU.
+ */
+
+#pragma once
+
+// Standard libraries
+#include <cstdint>
+
+#if defined(_MSC_VER) && defined(_M_X64)
+#include <immintrin.h>
+#endif
+
+// Project headers
+#include "engine/Types.hpp"
+#include "engine/Bitboard.hpp"
+
+namespace engine{
+
+    // Slider table of a square
+    struct Magic {
+        Bitboard mask;          // Relevant occupancy (the edges are excluded)
+        Bitboard magic;         // Magic multiplier (unused with PEXT)
+        Bitboard* attacks;      // Attacks indexed by the occupancy of the mask
+        unsigned shift;         // 64 - number of bits of the mask
+    };
+
+    // Attack tables (filled by initAttacks)
+    extern Bitboard pawnAttackTable[COLOR_NB][SQUARE_NB];
+    extern Bitboard knightAttackTable[SQUARE_NB];
+    extern Bitboard kingAttackTable[SQUARE_NB];
+    extern Bitboard betweenTable[SQUARE_NB][SQUARE_NB];
+    extern Bitboard lineTable[SQUARE_NB][SQUARE_NB];
+    extern Magic rookMagics[SQUARE_NB];
+    extern Magic bishopMagics[SQUARE_NB];
+    extern bool pextEnabled;
+
+    // Build the tables, PEXT is used when allowed and supported by the CPU
+    void initAttacks(bool allowPext = true);
+
+    // Does the CPU support BMI2
+    bool cpuHasBmi2();
+
+    // Are the slider tables indexed with PEXT
+    inline bool usesPext(){
+        return pextEnabled;
+    }
+
+    // Parallel bit extract. The instruction is emitted directly so no -mbmi2 flag is needed, it is only executed
+    // when cpuHasBmi2() returned true.
+    inline Bitboard pext(Bitboard source, Bitboard mask){
+#if defined(__GNUC__) && defined(__x86_64__)
+        Bitboard result;
+        __asm__("pextq %2, %1, %0" : "=r"(result) : "r"(source), "rm"(mask));
+        return result;
+#elif defined(_MSC_VER) && defined(_M_X64)
+        return _pext_u64(source, mask);
+#else
+        // Software fallback (never used for the lookups : PEXT is disabled on these targets)
+        Bitboard result = 0;
+        for(Bitboard bit = 1; mask; bit <<= 1){
+            if(source & mask & -mask){
+                result |= bit;
+            }
+            mask &= mask - 1;
+        }
+        return result;
+#endif
+    }
+
+    // Index of an occupancy in the table of a square
+    inline unsigned magicIndex(const Magic& m, Bitboard occupied){
+        if(pextEnabled){
+            return static_cast<unsigned>(pext(occupied, m.mask));
+        }
+        return static_cast<unsigned>(((occupied & m.mask) * m.magic) >> m.shift);
+    }
+
+    inline Bitboard pawnAttacks(Color c, Square s){
+        return pawnAttackTable[c][s];
+    }
+
+    inline Bitboard knightAttacks(Square s){
+        return knightAttackTable[s];
+    }
+
+    inline Bitboard kingAttacks(Square s){
+        return kingAttackTable[s];
+    }
+
+    inline Bitboard bishopAttacks(Square s, Bitboard occupied){
+        const Magic& m = bishopMagics[s];
+        return m.attacks[magicIndex(m, occupied)];
+    }
+
+    inline Bitboard rookAttacks(Square s, Bitboard occupied){
+        const Magic& m = rookMagics[s];
+        return m.attacks[magicIndex(m, occupied)];
+    }
+
+    inline Bitboard queenAttacks(Square s, Bitboard occupied){
+        return bishopAttacks(s, occupied) | rookAttacks(s, occupied);
+    }
+
+    // Attacks of a piece type other than the pawn
+    inline Bitboard attacks(PieceType pt, Square s, Bitboard occupied){
+        switch(pt){
+            case KNIGHT: return knightAttacks(s);
+            case BISHOP: return bishopAttacks(s, occupied);
+            case ROOK:   return rookAttacks(s, occupied);
+            case QUEEN:  return queenAttacks(s, occupied);
+            case KING:   return kingAttacks(s);
+            default:     return 0;
+        }
+    }
+
+    // Squares strictly between two aligned squares (empty if they are not aligned)
+    inline Bitboard between(Square a, Square b){
+        return betweenTable[a][b];
+    }
+
+    // Full line (edge to edge) through two aligned squares (empty if they are not aligned)
+    inline Bitboard line(Square a, Square b){
+        return lineTable[a][b];
+    }
+
+    inline bool aligned(Square a, Square b, Square c){
+        return lineTable[a][b] & squareBB(c);
+    }
+}
@@ -0,0 +1,38 @@
+/**
+ * @author obiwan138
+ * @file Bench.hpp
+ * @brief Fixed-depth search of a fixed set of positions, to spot speed regressions and compare hardware
+ * @details Single-threaded, with the table and the move ordering statistics cleared before each position, the search
+ * is deterministic : the total node count is a signature of the engine behaviour (it changes only with the search or
+ * the evaluation), while the nodes per second measure the speed.
+ */
+
+#pragma once
+
+// Standard libraries
+#include <cstdint>
+#include <ostream>
+
+// Project headers
+#include "engine/ParallelSearch.hpp"
+#include "engine/TranspositionTable.hpp"
+
+namespace engine{
+
+    // Positions of the bench : openings, middle games and endgames of various structures
+    extern const char* const benchPositions[];
+    extern const int benchPositionCount;
+
+    // Default depth of the bench (a few seconds on a recent core)
+    constexpr int BENCH_DEFAULT_DEPTH = 9;
+
+    // Totals of a bench run
+    struct BenchResult {
+        uint64_t nodes = 0;         // Node count signature (deterministic with one thread)
+        int64_t timeMs = 0;
+        uint64_t nps = 0;
+    };
+
+    // Search all the positions to a depth with the threads of the search, the progress is written on log (may be null)
+    BenchResult runBench(TranspositionTable& tt, ParallelSearch& search, int depth, std::ostream* log = nullptr);
+}
@@ -0,0 +1,82 @@
+/**
+ * @author obiwan138
+ * @file Bitboard.hpp
+ * @brief Bit manipulation helpers on bitboards
+ */
+
+#pragma once
+
+// Standard libraries
+#include <cstdint>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+// Project headers
+#include "engine/Types.hpp"
+
+namespace engine{
+
+    constexpr Bitboard FILE_A_BB = 0x0101010101010101ull;
+    constexpr Bitboard FILE_H_BB = FILE_A_BB << 7;
+    constexpr Bitboard RANK_1_BB = 0xFFull;
+    constexpr Bitboard RANK_2_BB = RANK_1_BB << 8;
+    constexpr Bitboard RANK_3_BB = RANK_1_BB << 16;
+    constexpr Bitboard RANK_6_BB = RANK_1_BB << 40;
+    constexpr Bitboard RANK_7_BB = RANK_1_BB << 48;
+    constexpr Bitboard RANK_8_BB = RANK_1_BB << 56;
+
+    inline constexpr Bitboard squareBB(Square s){
+        return Bitboard(1) << s;
+    }
+
+    // Shift a set one step towards the opponent of a color
+    template<Color C>
+    inline constexpr Bitboard shiftUp(Bitboard b){
+        return C == WHITE ? b << 8 : b >> 8;
+    }
+
+    // Shift a set one diagonal step towards the opponent, to the a-file side
+    template<Color C>
+    inline constexpr Bitboard shiftUpWest(Bitboard b){
+        return C == WHITE ? (b & ~FILE_A_BB) << 7 : (b & ~FILE_A_BB) >> 9;
+    }
+
+    // Shift a set one diagonal step towards the opponent, to the h-file side
+    template<Color C>
+    inline constexpr Bitboard shiftUpEast(Bitboard b){
+        return C == WHITE ? (b & ~FILE_H_BB) << 9 : (b & ~FILE_H_BB) >> 7;
+    }
+
+    inline bool moreThanOne(Bitboard b){
+        return b & (b - 1);
+    }
+
+    // Number of squares in the set
+    inline int popCount(Bitboard b){
+#ifdef _MSC_VER
+        return static_cast<int>(__popcnt64(b));
+#else
+        return __builtin_popcountll(b);
+#endif
+    }
+
+    // Least significant square of a non empty set
+    inline Square lsb(Bitboard b){
+#ifdef _MSC_VER
+        unsigned long index;
+        _BitScanForward64(&index, b);
+        return static_cast<Square>(index);
+#else
+        return static_cast<Square>(__builtin_ctzll(b));
+#endif
+    }
+
+    // Remove and return the least significant square of a non empty set
+    inline Square popLsb(Bitboard& b){
+        Square s = lsb(b);
+        b &= b - 1;
+        return s;
+    }
+}
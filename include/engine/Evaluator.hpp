@@ -0,0 +1,82 @@
+/**
+ * @author obiwan138
+ * @class Evaluator
+ * @brief Hand-crafted static evaluation of the positions
+ * @details Material and piece-square tables tapered between the middle game and the end game by the remaining
+ * material, bishop pair, and a pawn structure term (passed, doubled and isolated pawns). The pawn structure only depends
+ * on the pawns, so its score is cached in a small table indexed by the pawn key of GameState.
+ * When a network is set (setNetwork), the positions are evaluated by the network instead : the search reports its moves
+ * (push, pop) so that the first layer is updated incrementally.
+ */
+
+#pragma once
+
+// Standard libraries
+#include <cstdint>
+
+// Project headers
+#include "engine/GameState.hpp"
+#include "engine/Move.hpp"
+#include "engine/Network.hpp"
+#include "engine/NnueAccumulator.hpp"
+#include "engine/Position.hpp"
+
+namespace engine{
+
+    class Evaluator
+    {
+        private :
+
+            // Pawn structure cache entry (scores from the white point of view)
+            struct PawnEntry {
+                uint64_t key;
+                int16_t middleGame;
+                int16_t endGame;
+            };
+
+            static constexpr int PAWN_TABLE_SIZE = 16384;
+            PawnEntry pawnTable[PAWN_TABLE_SIZE];
+
+            // Network evaluation (null : hand-crafted evaluation), shared by all the evaluators
+            static const Network* network;
+            NnueAccumulator accumulator;
+
+            // Network of this evaluator only (see useNetwork), in place of the shared one
+            const Network* ownNetwork;
+            bool hasOwnNetwork;
+
+            // Network in use (null : hand-crafted evaluation)
+            const Network* activeNetwork() const;
+
+            // Evaluate the pawn structure (white point of view)
+            void evaluatePawns(const Position& position, int& middleGame, int& endGame) const;
+
+        public :
+
+            // Constructor (empty cache)
+            Evaluator();
+
+            // Empty the pawn cache
+            void clear();
+
+            // Static evaluation from the side to move point of view [centipawns]
+            int evaluate(const GameState& state);
+
+            // Moves of the search, reported around the moves played on the state (network evaluation)
+            void reset();
+            void push(const Position& position, Move move);
+            void pushNull();
+            void pop();
+
+            // Evaluate with a network (null : hand-crafted evaluation), only while no search runs
+            static void setNetwork(const Network* networkIn);
+            static const Network* getNetwork();
+
+            // Evaluate this evaluator with its own network (null : hand-crafted evaluation) whatever the shared one,
+            // only while it does not search (two engine configurations in the same process)
+            void useNetwork(const Network* networkIn);
+
+            // Material value of a piece type in the middle game (move ordering)
+            static int pieceValue(PieceType type);
+    };
+}
@@ -0,0 +1,112 @@
+/**
+ * @author obiwan138
+ * @class GameArchive
+ * @brief Compact binary archive of games, read with random access
+ * @details Each move is stored as its index among the legal moves of the position, in the order of their 16-bit
+ * encoding (so the format does not depend on the order of the move generator), with a truncated binary code : with n
+ * legal moves, the index takes floor(log2 n) or ceil(log2 n) bits, and no bit at all for a forced move. The games
+ * take about 5 bits per move, and replaying one is a move generation per ply.
+ * The archive is mapped in memory (little endian integers) :
+ * - a 64-byte header : magic "C3DGAMES", version, games per block, number of games and blocks, offset of the index
+ * - the blocks : the fixed-size headers of their games (GameRecord), then the moves of the games, each game starting
+ *   on a byte (preceded by the length and the text of its FEN if it does not start from the standard position)
+ * - the index : the offset of each block
+ * Game i is in block i / GAMES_PER_BLOCK, so reaching any game costs two reads of the mapping. See GameArchiveWriter.
+ */
+
+#pragma once
+
+// Standard libraries
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Project headers
+#include "engine/MappedFile.hpp"
+#include "engine/Move.hpp"
+#include "engine/PgnReader.hpp"
+#include "engine/Position.hpp"
+
+namespace engine{
+
+    // Header of an archive file (followed by zeros up to GameArchive::HEADER_SIZE)
+    struct ArchiveHeader {
+        char magic[8];
+        uint32_t version;
+        uint32_t gamesPerBlock;
+        uint64_t gameCount;
+        uint64_t blockCount;
+        uint64_t indexOffset;       // Offset of the block index [bytes]
+    };
+
+    // Fixed-size header of a game of the archive
+    struct GameRecord {
+        uint32_t dataOffset;        // Start of the data of the game, from the start of its block [bytes]
+        uint16_t plyCount;          // Number of moves
+        uint8_t result;             // GameResult
+        uint8_t flags;              // GameArchive::FLAG_*
+        uint16_t whiteElo;          // 0 if unknown
+        uint16_t blackElo;
+        uint32_t date;              // yyyymmdd, 0 if unknown
+    };
+
+    static_assert(sizeof(GameRecord) == 16, "GameRecord is a 16-byte record of the archive file");
+    static_assert(sizeof(ArchiveHeader) <= 64, "The header must fit in its block");
+
+    class GameArchive
+    {
+        public :
+
+            // File format
+            static constexpr char FILE_MAGIC[8] = {'C', '3', 'D', 'G', 'A', 'M', 'E', 'S'};
+            static constexpr uint32_t FILE_VERSION = 1;
+            static constexpr size_t HEADER_SIZE = 64;
+            static constexpr uint32_t GAMES_PER_BLOCK = 1024;
+
+            // Flags of a game
+            static constexpr uint8_t FLAG_SETUP = 1;        // The game starts from its FEN
+
+        private :
+
+            MappedFile file;
+            uint64_t gameCount;
+            const uint8_t* blockIndex;          // Offsets of the blocks, in the mapping
+
+        public :
+
+            // Constructor (no archive)
+            GameArchive();
+
+            // Map an archive, return false (with a message on stderr) if it is not a valid archive
+            bool open(const std::string& path);
+
+            // Unmap the archive
+            void close();
+
+            // Getters
+            bool isOpen() const;
+            uint64_t getGameCount() const;
+            size_t getFileSize() const;
+
+            // Header of a game (index below the number of games)
+            GameRecord getRecord(uint64_t index) const;
+
+            // Replay a game : position is its last position and moves its moves (reused), with the Zobrist keys of its
+            // positions from the initial one if keys is not null. Return false if the data is corrupted
+            bool readGame(uint64_t index, Position& position, std::vector<Move>& moves, std::vector<uint64_t>* keys = nullptr) const;
+
+            // Initial position of a game, false if it is malformed or illegal
+            bool readStartPosition(uint64_t index, Position& position) const;
+
+            // Longer length of the code of a move index among count legal moves : ceil(log2 count) bits
+            static int codeLength(int count);
+
+            // Index of a move among the legal moves, in the order of their encoding
+            static int moveIndex(const MoveList& moves, Move move);
+
+            // The mapping is owned
+            GameArchive(const GameArchive&) = delete;
+            GameArchive& operator=(const GameArchive&) = delete;
+    };
+}
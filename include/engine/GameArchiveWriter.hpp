@@ -0,0 +1,67 @@
+/**
+ * @author obiwan138
+ * @class GameArchiveWriter
+ * @brief Writer of the binary game archives (format described in GameArchive)
+ * @details The games are added one by one : the headers and the moves of the current block are kept in memory, and
+ * each full block is written to the file, so the memory does not depend on the number of games. The index and the
+ * header are written by close.
+ */
+
+#pragma once
+
+// Standard libraries
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+// Project headers
+#include "engine/GameArchive.hpp"
+#include "engine/Move.hpp"
+#include "engine/Position.hpp"
+
+namespace engine{
+
+    class GameArchiveWriter
+    {
+        private :
+
+            std::FILE* file;
+            std::string path;
+            std::vector<GameRecord> records;        // Games of the current block
+            std::vector<uint8_t> data;              // Moves of the games of the current block
+            std::vector<uint64_t> blockOffsets;     // Offsets of the blocks written
+            uint64_t gameCount;
+            uint64_t fileSize;
+            bool failed;                            // A write failed
+
+            // Write the current block
+            void writeBlock();
+
+        public :
+
+            // Constructor (no file)
+            GameArchiveWriter();
+
+            // Create an archive, return false (with a message on stderr) if it cannot be written
+            bool open(const std::string& path);
+
+            // Add a game : its initial position, its legal moves, and its header (the offset and the number of moves are filled)
+            void addGame(const Position& start, const Move* moves, size_t moveCount, GameRecord record);
+
+            // Write the last block, the index and the header, return false if a write failed
+            bool close();
+
+            // Getters
+            uint64_t getGameCount() const;
+            uint64_t getFileSize() const;
+
+            // The file is owned
+            GameArchiveWriter(const GameArchiveWriter&) = delete;
+            GameArchiveWriter& operator=(const GameArchiveWriter&) = delete;
+
+            // Destructor (closes the file)
+            ~GameArchiveWriter();
+    };
+}
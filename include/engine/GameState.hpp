@@ -0,0 +1,103 @@
+/**
+ * @author obiwan138
+ * @class GameState
+ * @brief Position with its move history, played by make/unmake
+ * @details The moves are played in place on a single Position. What cannot be recovered from a move (captured piece,
+ * castling rights, en passant square, 50-move counter, keys) is pushed on a fixed-size stack instead of copying the board.
+ * The Zobrist key, the pawn structure key and the material signature are updated with XOR deltas. The repetition count
+ * and the 50-move rule are answered in O(1) per move. When the stack is full, its oldest half is dropped : those moves
+ * can no longer be taken back, and their positions no longer count for the repetitions (a game line of thousands of
+ * plies, far beyond what the search takes back).
+ * Building with CHESS3D_VERIFY_KEYS defined checks every incremental key against a full recompute after each move.
+ */
+
+#pragma once
+
+// Standard libraries
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+// Project headers
+#include "engine/Position.hpp"
+#include "engine/Move.hpp"
+#include "engine/RepetitionTable.hpp"
+
+namespace engine{
+
+    class GameState
+    {
+        public :
+
+            // Plies of the history stack (not allocated dynamically), the oldest half is dropped when it is full
+            static constexpr int MAX_GAME_PLY = 2000;
+
+        private :
+
+            // History entry : what is needed to undo a move
+            struct StateEntry {
+                Move move;
+                bool nullMove;
+                UndoInfo undo;
+                uint64_t pawnKey;       // Pawn key before the move
+                uint64_t materialKey;   // Material signature before the move
+            };
+
+            Position position;
+            uint64_t pawnKey;
+            uint64_t materialKey;
+
+            StateEntry history[MAX_GAME_PLY];
+            int ply;                    // Entries of the history
+            int droppedPlies;           // Plies dropped from the history (the game ply is droppedPlies + ply)
+
+            RepetitionTable repetitions;
+
+            // Drop the oldest half of the history to make room for a move
+            void dropOldestPlies();
+
+            // Check the incremental keys against a full recompute (CHESS3D_VERIFY_KEYS builds)
+            void verifyKeys(const char* context) const;
+
+        public :
+
+            // Default constructor (initial position)
+            GameState();
+
+            // Set the position from a FEN string and clear the history
+            bool setFromFen(std::string_view fen);
+
+            // Set the position and clear the history
+            void setPosition(const Position& positionIn);
+
+            // Play a legal move
+            void doMove(Move move);
+
+            // Take back the last move (nothing if it was dropped from the history)
+            void undoMove();
+
+            // Pass the turn (null move pruning), take it back
+            void doNullMove();
+            void undoNullMove();
+
+            // Getters
+            const Position& getPosition() const;
+            uint64_t getKey() const;
+            uint64_t getPawnKey() const;
+            uint64_t getMaterialKey() const;
+            int getPly() const;
+            Move getLastMove() const;
+
+            // Number of occurrences of the current position in the game (1 if it is new)
+            int getRepetitionCount() const;
+
+            // Threefold repetition
+            bool isThreefoldRepetition() const;
+
+            // 50-move rule (100 half moves without capture nor pawn move)
+            bool isFiftyMoveDraw() const;
+
+            // Neither side can mate : kings with at most one minor piece
+            bool isInsufficientMaterial() const;
+    };
+}
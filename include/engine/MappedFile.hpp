@@ -0,0 +1,52 @@
+/**
+ * @author obiwan138
+ * @class MappedFile
+ * @brief Read-only memory mapping of a whole file
+ * @details The file is mapped with mmap instead of being read into a buffer : the pages are loaded on demand by the
+ * system, shared between the processes using the same file, and the data starts on a page boundary, so any block at an
+ * aligned offset of the file is aligned in memory too. Without mmap (Windows), the file is read into a 4096-byte aligned
+ * buffer with the same guarantees of alignment.
+ */
+
+#pragma once
+
+// Standard libraries
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace engine{
+
+    class MappedFile
+    {
+        private :
+
+            const uint8_t* data;        // Start of the mapping (null if no file is open)
+            size_t size;                // Size of the file [bytes]
+            bool mapped;                // Mapped with mmap (read into an aligned buffer otherwise)
+
+        public :
+
+            // Constructor (no file)
+            MappedFile();
+
+            // Map a file, return false (with a message on stderr) if it cannot be opened or is empty. Random access : the
+            // file is probed in a few places (large books), otherwise it is read ahead as it will be read whole
+            bool open(const std::string& path, bool randomAccess = false);
+
+            // Unmap the file
+            void close();
+
+            // Getters
+            bool isOpen() const;
+            const uint8_t* getData() const;
+            size_t getSize() const;
+
+            // The mapping is owned
+            MappedFile(const MappedFile&) = delete;
+            MappedFile& operator=(const MappedFile&) = delete;
+
+            // Destructor (unmaps the file)
+            ~MappedFile();
+    };
+}
@@ -0,0 +1,113 @@
+/**
+ * @author obiwan138
+ * @file Move.hpp
+ * @brief Move encoding and fixed-capacity move list
+ */
+
+#pragma once
+
+// Standard libraries
+#include <cstdint>
+#include <string>
+
+// Project headers
+#include "engine/Types.hpp"
+
+namespace engine{
+
+    // Special move kinds, stored in the 2 high bits of a move
+    enum MoveType : uint16_t {
+        NORMAL     = 0,
+        PROMOTION  = 1 << 14,
+        EN_PASSANT = 2 << 14,
+        CASTLING   = 3 << 14
+    };
+
+    /**
+     * @class Move
+     * @brief A move packed in 16 bits
+     * @details bits 0-5 : origin square, bits 6-11 : destination square, bits 12-13 : promotion piece (knight to queen),
+     * bits 14-15 : MoveType. Castling moves are encoded with the king origin and destination squares (e1g1).
+     */
+
+    class Move
+    {
+        private :
+
+            uint16_t data;
+
+        public :
+
+            // Default constructor (null move)
+            constexpr Move():data(0){}
+
+            // Construct from the raw 16 bits
+            constexpr explicit Move(uint16_t dataIn):data(dataIn){}
+
+            // Construct a move
+            constexpr Move(Square from, Square to, MoveType type = NORMAL, PieceType promotion = KNIGHT)
+                :data(static_cast<uint16_t>(type | ((promotion - KNIGHT) << 12) | (to << 6) | from)){}
+
+            constexpr Square from() const{ return static_cast<Square>(this->data & 0x3F); }
+            constexpr Square to() const{ return static_cast<Square>((this->data >> 6) & 0x3F); }
+            constexpr MoveType type() const{ return static_cast<MoveType>(this->data & (3 << 14)); }
+            constexpr PieceType promotionType() const{ return static_cast<PieceType>(((this->data >> 12) & 3) + KNIGHT); }
+            constexpr uint16_t raw() const{ return this->data; }
+
+            // A null move has the same origin and destination squares
+            constexpr bool isNull() const{ return this->from() == this->to(); }
+
+            constexpr bool operator==(const Move& other) const{ return this->data == other.data; }
+            constexpr bool operator!=(const Move& other) const{ return this->data != other.data; }
+
+            // Long algebraic notation (e2e4, e7e8q), as used by UCI
+            std::string toUci() const;
+    };
+
+    // Maximum number of legal moves in a chess position is 218
+    constexpr int MAX_MOVES = 256;
+
+    /**
+     * @class MoveList
+     * @brief Fixed-capacity list of moves, allocated on the stack
+     */
+
+    class MoveList
+    {
+        private :
+
+            Move moves[MAX_MOVES];
+            Move* last;
+
+        public :
+
+            MoveList():last(moves){}
+
+            // The list points into itself, it must not be copied
+            MoveList(const MoveList&) = delete;
+            MoveList& operator=(const MoveList&) = delete;
+
+            void add(Move move){ *this->last++ = move; }
+            void clear(){ this->last = this->moves; }
+
+            int size() const{ return static_cast<int>(this->last - this->moves); }
+            bool empty() const{ return this->last == this->moves; }
+            bool contains(Move move) const{
+                for(const Move* m = this->moves; m != this->last; m++){
+                    if(*m == move) return true;
+                }
+                return false;
+            }
+
+            Move& operator[](int i){ return this->moves[i]; }
+            const Move& operator[](int i) const{ return this->moves[i]; }
+
+            Move* begin(){ return this->moves; }
+            Move* end(){ return this->last; }
+            const Move* begin() const{ return this->moves; }
+            const Move* end() const{ return this->last; }
+
+            // Direct write access for the generator
+            Move*& tail(){ return this->last; }
+    };
+}
@@ -0,0 +1,25 @@
+/**
+ * @author obiwan138
+ * @file MoveGen.hpp
+ * @brief Legal move generation
+ * @details The moves are generated fully legal (pins, checks, castling through attacked squares, en passant discovered
+ * checks) directly into a stack MoveList, without any heap allocation nor make/unmake to filter them.
+ */
+
+#pragma once
+
+// Project headers
+#include "engine/Position.hpp"
+#include "engine/Move.hpp"
+
+namespace engine{
+
+    // Generate the legal moves of the side to move
+    void generateLegalMoves(const Position& position, MoveList& moves);
+
+    // Generate the legal captures and promotions of the side to move (quiescence search)
+    void generateLegalCaptures(const Position& position, MoveList& moves);
+
+    // Is a move legal in a position (used to validate moves coming from outside, like the UI)
+    bool isLegalMove(const Position& position, Move move);
+}
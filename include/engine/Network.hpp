@@ -0,0 +1,94 @@
+/**
+ * @author obiwan138
+ * @class Network
+ * @brief Efficiently updatable neural network (NNUE) evaluating the positions
+ * @details HalfKP inputs : for each point of view (white and black), one feature per (own king square, non-king piece,
+ * square), the board being flipped vertically for black. The first layer (feature transformer) is a sum of one int16
+ * row per active feature : it is kept in an accumulator updated with the moves (see NnueAccumulator). The two
+ * accumulators, side to move first, are clamped to [0, 127] and go through two int8 hidden layers of 32 neurons and an
+ * int8 output neuron.
+ * The network file is mapped in memory, not copied : a 64-byte header then the blocks of weights, each one starting at
+ * a multiple of 64 bytes (little endian integers) :
+ * - feature biases int16[256], feature weights int16[40960][256]
+ * - hidden layer 1 biases int32[32], weights int8[32][512]
+ * - hidden layer 2 biases int32[32], weights int8[32][32]
+ * - output bias int32 (padded to 64 bytes), weights int8[32] (padded to 64 bytes)
+ */
+
+#pragma once
+
+// Standard libraries
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Project headers
+#include "engine/MappedFile.hpp"
+#include "engine/NnueKernels.hpp"
+#include "engine/Types.hpp"
+
+namespace engine{
+
+    class Network
+    {
+        public :
+
+            // Architecture
+            static constexpr int FEATURE_COUNT = 64 * 10 * 64;     // King square x non-king piece x square
+            static constexpr int ACCUMULATOR_SIZE = 256;            // Per point of view
+            static constexpr int HIDDEN_SIZE = 32;
+            static constexpr int WEIGHT_SHIFT = 6;                  // Scale of the int8 weights of the hidden layers
+            static constexpr int OUTPUT_SCALE = 16;                 // Output units per centipawn
+
+            // File format
+            static constexpr uint32_t FILE_VERSION = 1;
+            static constexpr size_t HEADER_SIZE = 64;
+
+        private :
+
+            MappedFile file;
+
+            // Blocks of the mapped file
+            const int16_t* featureBiases;
+            const int16_t* featureWeights;
+            const int32_t* hidden1Biases;
+            const int8_t* hidden1Weights;
+            const int32_t* hidden2Biases;
+            const int8_t* hidden2Weights;
+            const int32_t* outputBias;
+            const int8_t* outputWeights;
+
+            const NnueKernels* kernels;     // Best instruction set of the processor by default
+
+        public :
+
+            // Constructor (no network)
+            Network();
+
+            // Map a network file, return false (with a message on stderr, and no network) if it is not valid
+            bool load(const std::string& path);
+
+            // Is a network loaded
+            bool isLoaded() const;
+
+            // Select the kernels (benchmarks and bit-exactness checks)
+            void setSimdLevel(SimdLevel level);
+            const NnueKernels& getKernels() const;
+
+            // First layer rows
+            const int16_t* getFeatureBiases() const;
+            const int16_t* getFeatureWeights(int feature) const;
+
+            // Evaluate from the two accumulators (side to move first) [centipawns, side to move point of view]
+            int forward(const int16_t* us, const int16_t* them) const;
+
+            // Index of the feature of a non-king piece from a point of view
+            static int featureIndex(Color perspective, Square kingSquare, Piece piece, Square square);
+
+            // Size of a network file [bytes]
+            static size_t getFileSize();
+
+            // Write a network of random weights (tests and benchmarks : it does not play chess)
+            static bool writeRandom(const std::string& path, uint64_t seed);
+    };
+}
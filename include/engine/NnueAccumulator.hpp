@@ -0,0 +1,76 @@
+/**
+ * @author obiwan138
+ * @class NnueAccumulator
+ * @brief Stack of the first layer outputs of the network, updated with the moves of the search
+ * @details push records the pieces changed by a move (at most 3 : moved piece, captured piece, castling rook) and pop
+ * only goes back one entry : nothing is computed on make/unmake. The accumulators are computed when a position is
+ * evaluated, from the closest computed ancestor by adding and removing the rows of the changed features (a few rows
+ * instead of the ~30 of the whole position). A king move changes every feature of its own point of view, which is then
+ * recomputed from the position (refresh). Each Search has its own stack, the network weights are shared.
+ */
+
+#pragma once
+
+// Standard libraries
+#include <cstdint>
+
+// Project headers
+#include "engine/Move.hpp"
+#include "engine/Network.hpp"
+#include "engine/Position.hpp"
+
+namespace engine{
+
+    class NnueAccumulator
+    {
+        public :
+
+            // Maximum number of moves pushed on the root (above the maximum ply of the search)
+            static constexpr int STACK_SIZE = 256;
+
+        private :
+
+            // Pieces changed by a move : from NO_SQUARE is an added piece, to NO_SQUARE a removed one
+            struct DirtyPieces {
+                int count;
+                Piece piece[3];
+                Square from[3];
+                Square to[3];
+            };
+
+            struct Entry {
+                alignas(64) int16_t values[COLOR_NB][Network::ACCUMULATOR_SIZE];
+                bool computed[COLOR_NB];
+                DirtyPieces dirty;          // Changes from the previous entry
+            };
+
+            Entry stack[STACK_SIZE];
+            int top;
+
+            // Compute the accumulator of a point of view from the whole position
+            void refresh(Entry& entry, Color perspective, const Position& position, const Network& network);
+
+            // Compute the accumulator of a point of view from the previous entry
+            void update(int index, Color perspective, Square kingSquare, const Network& network);
+
+        public :
+
+            // Constructor (empty stack)
+            NnueAccumulator();
+
+            // Start from a new root position (nothing computed)
+            void reset();
+
+            // Record a move, before it is played on the position
+            void push(const Position& position, Move move);
+
+            // Record a null move
+            void pushNull();
+
+            // Go back to the previous position
+            void pop();
+
+            // Evaluate the current position (the one of the top of the stack) [centipawns, side to move point of view]
+            int evaluate(const Position& position, const Network& network);
+    };
+}
@@ -0,0 +1,53 @@
+/**
+ * @author obiwan138
+ * @file NnueKernels.hpp
+ * @brief Integer kernels of the neural network evaluation, with runtime selection of the instruction set
+ * @details Each kernel exists in a scalar version and in SSE4.1, AVX2 and AVX-512 (BW) versions compiled with function
+ * target attributes, so a single binary runs everywhere and uses the best set of the processor. All the versions do the
+ * same integer operations (the sums only differ in their order, which does not change an integer result), so their
+ * outputs are bit-exact : the nnue tool checks it.
+ */
+
+#pragma once
+
+// Standard libraries
+#include <cstdint>
+
+namespace engine{
+
+    enum SimdLevel : uint8_t {
+        SIMD_SCALAR,
+        SIMD_SSE41,
+        SIMD_AVX2,
+        SIMD_AVX512,
+        SIMD_LEVEL_NB
+    };
+
+    struct NnueKernels {
+        SimdLevel level;
+        const char* name;
+
+        // out = base + sum of the added rows - sum of the removed rows (int16, size a multiple of 32)
+        void (*addSubRows)(int16_t* out, const int16_t* base, const int16_t* const* added, int addedCount,
+                           const int16_t* const* removed, int removedCount, int size);
+
+        // out = clamp(in, 0, 127) (size a multiple of 64)
+        void (*clampAccumulator)(const int16_t* in, uint8_t* out, int size);
+
+        // out[i] = bias[i] + sum_j weights[i * inputSize + j] * in[j] (inputs in [0, 127], inputSize a multiple of 32)
+        void (*affine)(const uint8_t* in, const int8_t* weights, const int32_t* biases, int32_t* out,
+                       int inputSize, int outputSize);
+
+        // out = clamp(in >> shift, 0, 127) (size a multiple of 8)
+        void (*clippedRelu)(const int32_t* in, uint8_t* out, int size, int shift);
+    };
+
+    // Can the processor run the kernels of a level
+    bool isSimdLevelSupported(SimdLevel level);
+
+    // Best level supported by the processor
+    SimdLevel getBestSimdLevel();
+
+    // Kernels of a level (the scalar ones if the level is not supported)
+    const NnueKernels& getNnueKernels(SimdLevel level);
+}
@@ -0,0 +1,59 @@
+/**
+ * @author obiwan138
+ * @class ParallelSearch
+ * @brief Lazy SMP : several threads search the same position and share the transposition table
+ * @details The threads do not split the tree, they all run an iterative deepening search of the root (Search) and
+ * communicate only through the transposition table : what one thread stores prunes or orders the search of the others.
+ * The helper threads skip some depths (a pattern per thread) and have their own move ordering statistics, so that they
+ * diverge from the main thread. The main thread (0) checks the limits and stops the helpers when it is done. The threads
+ * are OpenMP threads, their number can be changed between two searches.
+ */
+
+#pragma once
+
+// Standard libraries
+#include <functional>
+#include <memory>
+#include <vector>
+
+// Project headers
+#include "engine/GameState.hpp"
+#include "engine/Search.hpp"
+#include "engine/TranspositionTable.hpp"
+
+namespace engine{
+
+    class ParallelSearch
+    {
+        private :
+
+            TranspositionTable& tt;
+            SharedSearchState shared;
+            std::vector<std::unique_ptr<Search>> searches;    // One per thread, the main one first
+
+        public :
+
+            // Constructor (the table is shared with the caller)
+            ParallelSearch(TranspositionTable& ttIn, int threadCount = 1);
+
+            // Change the number of threads (not during a search, the move ordering statistics are lost)
+            void setThreadCount(int threadCount);
+            int getThreadCount() const;
+
+            // Search the best move with all the threads, onIteration is called by the main thread after each depth
+            SearchResult run(const GameState& root, const SearchLimits& limits,
+                             const std::function<void(const SearchResult&)>& onIteration = nullptr);
+
+            // Ask a running search to stop (thread safe)
+            void stop();
+
+            // The move pondered on was played : the limits apply from now on (thread safe)
+            void ponderhit();
+
+            // Forget the move ordering statistics of all the threads (new game)
+            void clear();
+
+            // Number of hardware threads
+            static int getMaxThreads();
+    };
+}
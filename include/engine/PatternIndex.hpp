@@ -0,0 +1,128 @@
+/**
+ * @author obiwan138
+ * @class PatternIndex
+ * @brief On-disk index of the material signatures and pawn structures reached by the games of an archive
+ * @details Each key is either a material signature (number of pieces of each kind, the kings implied) or the Zobrist
+ * key of the pawns of a position (the pawn skeleton), and maps to the roaring bitmap of the games which reached it at any
+ * ply. Queries combine the keys with AND (&) and OR (|) and match the positions :
+ *   KRPvKR                   a material signature, white first, for either color (KRPvKR or KRvKRP)
+ *   pawns:<placement>        the pawn structure of the piece placement of a FEN (the other pieces are ignored)
+ *   KRPvKR & (pawns:... | KRvKR)
+ * The bitmaps only tell which keys a game reached, not at which plies : combined by AND, they give the candidate games
+ * which reached each key at some ply, maybe at different plies. The games with a position matching the whole query are
+ * then found by replaying the candidates from the archive (a query without AND needs no replay : a game reaching one
+ * of the keys has a matching position).
+ * The index is mapped in memory (little endian integers) :
+ * - a 64-byte header : magic "C3DPATRN", version, number of keys, number of games of the archive, section offsets
+ * - the serialized bitmaps, one after the other in the order of the keys
+ * - the keys, sorted (the pawn structures, then the material signatures which have the high bit set)
+ * - the offset of the bitmap of each key (and the end of the last one)
+ */
+
+#pragma once
+
+// Standard libraries
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Project headers
+#include "engine/GameArchive.hpp"
+#include "engine/MappedFile.hpp"
+#include "engine/Position.hpp"
+#include "engine/RoaringBitmap.hpp"
+
+namespace engine{
+
+    class PatternIndex
+    {
+        public :
+
+            // File format
+            static constexpr uint32_t FILE_VERSION = 1;
+            static constexpr size_t HEADER_SIZE = 64;
+
+            // High bit of the material signatures (4 bits per count : white pawns to queens, then black)
+            static constexpr uint64_t MATERIAL_FLAG = 1ull << 63;
+
+        private :
+
+            MappedFile file;
+            uint64_t keyCount;
+            uint64_t gameCount;
+            const uint8_t* bitmaps;
+            const uint64_t* keys;
+            const uint64_t* bitmapOffsets;
+
+            // Step of a compiled query, in postfix order
+            struct QueryStep {
+                enum Kind : uint8_t {MATERIAL, PAWNS, AND, OR};
+                Kind kind;
+                uint64_t key;       // Key of a MATERIAL (either color) or PAWNS step
+            };
+
+            // Recursive descent of a query : OR of ANDs of terms, a term being a key or a parenthesized query
+            static bool compile(std::string_view expression, std::vector<QueryStep>& steps, std::string& error);
+            static bool parseOr(std::string_view& text, std::vector<QueryStep>& steps, std::string& error);
+            static bool parseAnd(std::string_view& text, std::vector<QueryStep>& steps, std::string& error);
+            static bool parseTerm(std::string_view& text, std::vector<QueryStep>& steps, std::string& error);
+
+            // Evaluation of a compiled query on the bitmaps of the games (false if one is corrupted), and on a position
+            bool evaluate(const std::vector<QueryStep>& steps, RoaringBitmap& games) const;
+            static bool matches(const std::vector<QueryStep>& steps, uint64_t material, uint64_t pawns);
+
+        public :
+
+            // Constructor (no index)
+            PatternIndex();
+
+            // Map an index, return false (with a message on stderr) if it is not a valid index
+            bool open(const std::string& path);
+
+            // Unmap the index
+            void close();
+
+            // Getters
+            bool isOpen() const;
+            uint64_t getKeyCount() const;
+            uint64_t getGameCount() const;
+
+            // Games which reached a key (empty if none). Return false if its bitmap is corrupted
+            bool lookup(uint64_t key, RoaringBitmap& games) const;
+
+            // Candidate games of a query : the games which reached each key of the query at some ply. Return false with
+            // a message in error if the query is malformed
+            bool candidates(std::string_view expression, RoaringBitmap& games, std::string& error) const;
+
+            // Games with a position matching a query : the candidates replayed from the archive of the index, on threads
+            bool query(std::string_view expression, const GameArchive& archive, RoaringBitmap& games, std::string& error,
+                       int threads = 1) const;
+
+            // Keys of a position
+            static uint64_t materialKey(const Position& position);
+            static uint64_t pawnKey(const Position& position);
+
+            // Material signature of a name such as KRPvKR (white first), false if it is not valid
+            static bool parseMaterial(std::string_view name, uint64_t& key);
+
+            // Name of a material signature, and the signature with the colors swapped
+            static std::string materialName(uint64_t key);
+            static uint64_t mirrorMaterial(uint64_t key);
+
+            // Pawn structure of the piece placement of a FEN, false if it is not valid
+            static bool parsePawns(std::string_view placement, uint64_t& key);
+
+            // Build the index of an archive in one pass over its games, decoded on several threads. The pairs (key,
+            // game) beyond the memory budget are sorted into runs next to the index, merged at the end. The progress
+            // is written on log (may be null)
+            static bool build(const GameArchive& archive, const std::string& path, int threads, size_t memoryMiB,
+                              std::ostream* log = nullptr);
+
+            // The mapping is owned
+            PatternIndex(const PatternIndex&) = delete;
+            PatternIndex& operator=(const PatternIndex&) = delete;
+    };
+}
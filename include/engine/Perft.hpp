@@ -0,0 +1,67 @@
+/**
+ * @author obiwan138
+ * @file Perft.hpp
+ * @brief Move path enumeration (perft), used to check and benchmark the move generator
+ */
+
+#pragma once
+
+// Standard libraries
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+// Project headers
+#include "engine/Position.hpp"
+#include "engine/Move.hpp"
+#include "engine/GameState.hpp"
+
+namespace engine{
+
+    /**
+     * @class PerftHashTable
+     * @brief Cache of the subtree sizes, shared by the threads of a parallel perft
+     * @details Transpositions are very frequent in perft, so caching the node count of (position, depth) pairs saves
+     * most of the work at large depths. Each entry stores the key XOR the data next to the data : a torn write by
+     * another thread fails the verification and is seen as a miss, so no lock is needed.
+     */
+
+    class PerftHashTable
+    {
+        private :
+
+            struct Entry {
+                uint64_t check;     // key ^ data
+                uint64_t data;      // nodes << 8 | depth
+            };
+
+            std::vector<Entry> entries;
+            uint64_t mask;
+
+        public :
+
+            // Constructor (size in MiB, rounded down to a power of two number of entries)
+            explicit PerftHashTable(size_t sizeMb);
+
+            // Look up the node count of a position at a depth
+            bool probe(uint64_t key, int depth, uint64_t& nodes) const;
+
+            // Store the node count of a position at a depth (always replace)
+            void store(uint64_t key, int depth, uint64_t nodes);
+
+            // Empty the table
+            void clear();
+    };
+
+    // Count the leaf nodes at a depth (bulk counting : the moves of the last ply are counted, not played)
+    uint64_t perft(const Position& position, int depth, PerftHashTable* table = nullptr);
+
+    // Same as perft, playing the moves in place with make/unmake
+    uint64_t perft(GameState& state, int depth);
+
+    // Same as perft, with the root moves split between OpenMP threads
+    uint64_t perftParallel(const Position& position, int depth, PerftHashTable* table = nullptr, int threads = 0);
+
+    // Node count of each root move
+    std::vector<std::pair<Move, uint64_t>> perftDivide(const Position& position, int depth, PerftHashTable* table = nullptr);
+}
@@ -0,0 +1,120 @@
+/**
+ * @author obiwan138
+ * @class PgnReader
+ * @brief Zero-copy reader of the games of a PGN file
+ * @details The file is mapped in memory and the games are tokenized in place : the tags and the SAN moves of a game
+ * are string views into the mapping, valid as long as the reader is open. The movetext is reduced to its main line :
+ * move numbers, comments, variations, NAGs and escaped lines are skipped, and the delimiters are searched 16 bytes at a
+ * time. The PgnGame given to readGame is reused from one game to the next, so reading a file does not allocate once
+ * the longest game has been seen. For the parallel reading, split gives offsets at game boundaries, and a reader over
+ * each part of the mapping is opened with openMemory.
+ */
+
+#pragma once
+
+// Standard libraries
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+// Project headers
+#include "engine/MappedFile.hpp"
+#include "engine/Move.hpp"
+#include "engine/Position.hpp"
+
+namespace engine{
+
+    enum GameResult : uint8_t {
+        RESULT_WHITE_WIN,
+        RESULT_BLACK_WIN,
+        RESULT_DRAW,
+        RESULT_UNKNOWN
+    };
+
+    // A game of a PGN file (views into the text of the reader)
+    struct PgnGame {
+        std::vector<std::pair<std::string_view, std::string_view>> tags;   // In the order of the file, escapes kept
+        std::vector<std::string_view> moves;                                // SAN moves of the main line
+        GameResult result = RESULT_UNKNOWN;                                 // Game termination marker
+
+        // Value of a tag (empty if absent)
+        std::string_view getTag(std::string_view name) const;
+
+        // Empty the game, keeping the memory
+        void clear();
+
+        // Initial position of the game : the FEN tag, the standard position otherwise. Return false if the FEN is
+        // malformed or the position illegal (see Position::checkLegality)
+        bool setUpPosition(Position& position) const;
+
+        // Resolve the SAN moves against the move generator, from the initial position (moves is reused). Return false at
+        // the first move which is not legal, the legal moves before it being kept; position is the last position reached
+        bool replay(Position& position, std::vector<Move>& moves) const;
+    };
+
+    class PgnReader
+    {
+        private :
+
+            MappedFile file;
+            const char* text;           // Text of the games
+            const char* cursor;         // Next character to read
+            const char* textEnd;        // End of the text
+            PgnGame current;            // Game of the iterator
+
+        public :
+
+            // Input iterator over the games : for(const PgnGame& game : reader)
+            class Iterator
+            {
+                private :
+
+                    PgnReader* reader;  // Null at the end
+
+                public :
+
+                    explicit Iterator(PgnReader* reader);
+                    const PgnGame& operator*() const;
+                    const PgnGame* operator->() const;
+                    Iterator& operator++();
+                    bool operator!=(const Iterator& other) const;
+            };
+
+            // Constructor (no file)
+            PgnReader();
+
+            // Map a file, return false (with a message on stderr) if it cannot be read
+            bool open(const std::string& path);
+
+            // Read the games of a text in memory, which must outlive the reading (part of the mapping of another reader)
+            void openMemory(const char* data, size_t size);
+
+            // Close the file
+            void close();
+
+            // Read the next game, return false at the end of the text
+            bool readGame(PgnGame& game);
+
+            // Iterator on the next game (the games read with readGame are not seen again)
+            Iterator begin();
+            Iterator end();
+
+            // Offsets of the starts of parts of about equal size, each starting at a game (parts + 1 offsets, from 0 to
+            // the size of the text, some parts being empty if there are fewer games than parts)
+            std::vector<size_t> split(int parts) const;
+
+            // Getters
+            const char* getData() const;
+            size_t getSize() const;
+
+            // Bytes of the text consumed so far (progress)
+            uint64_t getBytesRead() const;
+
+            // The game of the iterator points into the reader
+            PgnReader(const PgnReader&) = delete;
+            PgnReader& operator=(const PgnReader&) = delete;
+    };
+}
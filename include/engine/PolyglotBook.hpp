@@ -0,0 +1,88 @@
+/**
+ * @author obiwan138
+ * @class PolyglotBook
+ * @brief Opening book in the Polyglot .bin format, probed in place in the mapped file
+ * @details A book is a sorted array of 16-byte big endian entries (position key, move, weight, learning data), several
+ * entries per position. The file is mapped and never parsed nor copied : opening a book of any size takes constant time,
+ * a probe is a binary search on the key which touches about log2(entries) pages.
+ * The Polyglot position keys are computed from a table of 781 random numbers (piece on square, castling rights, en
+ * passant file, side to move), independent of the Zobrist keys of the engine. The built-in table is the Random64 array
+ * of the Polyglot specification, so the books of the other programs are read as they are and the books of the bookbuild
+ * tool are standard ones. Another table can still be loaded from a text file (loadKeys).
+ */
+
+#pragma once
+
+// Standard libraries
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Project headers
+#include "engine/MappedFile.hpp"
+#include "engine/Move.hpp"
+#include "engine/Position.hpp"
+#include "engine/RandomGenerator.hpp"
+
+namespace engine{
+
+    // A move of the book and its weight
+    struct BookMove {
+        Move move;
+        uint16_t weight;
+    };
+
+    class PolyglotBook
+    {
+        public :
+
+            // Number of random numbers of the key table
+            static constexpr int KEY_COUNT = 781;
+
+            // Size of an entry in the file [bytes]
+            static constexpr size_t ENTRY_SIZE = 16;
+
+            // Maximum number of moves returned by a probe
+            static constexpr int MAX_BOOK_MOVES = 64;
+
+        private :
+
+            MappedFile file;
+            size_t entryCount;
+
+            // Key of an entry of the file
+            uint64_t entryKey(size_t index) const;
+
+        public :
+
+            // Constructor (no book)
+            PolyglotBook();
+
+            // Map a book file, return false (with a message on stderr) if it is not a book
+            bool open(const std::string& path);
+
+            // Close the book
+            void close();
+
+            // Getters
+            bool isOpen() const;
+            size_t getEntryCount() const;
+
+            // Get the legal book moves of a position (highest weight first), return their number
+            int probe(const Position& position, BookMove* moves, int maxMoves = MAX_BOOK_MOVES) const;
+
+            // Choose a book move : the best one or at random in proportion to the weights (null move if out of book)
+            Move pick(const Position& position, bool bestOnly, RandomGenerator& random) const;
+
+            // Polyglot key of a position
+            static uint64_t computeKey(const Position& position);
+
+            // Polyglot encoding of a move (castling as king takes rook) and decoding against a position (null if illegal)
+            static uint16_t encodeMove(Move move);
+            static Move decodeMove(const Position& position, uint16_t polyglotMove);
+
+            // Replace the built-in Polyglot key table by the 781 numbers (hexadecimal) of a text file, for the books
+            // hashed with another table. Not thread-safe : call it before probing
+            static bool loadKeys(const std::string& path);
+    };
+}
@@ -0,0 +1,143 @@
+/**
+ * @author obiwan138
+ * @class Position
+ * @brief Compact bitboard representation of a chess position
+ * @details One bitboard per colored piece and per color, plus the side to move, the castling rights, the en passant
+ * square, the 50-move counters and the Zobrist key. The whole position fits in 128 bytes (two cache lines) so it can be
+ * copied cheaply by the rules and analysis code. Moves are played either by copy-make (doMove on a copy) or by make/unmake
+ * with an UndoInfo (see GameState, which also tracks the pawn and material keys). It knows nothing about the 3D objects : the render grid is updated from it
+ * (see SceneManager::syncPosition), never the other way around.
+ */
+
+#pragma once
+
+// Standard libraries
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+// Project headers
+#include "engine/Types.hpp"
+#include "engine/Bitboard.hpp"
+#include "engine/Move.hpp"
+
+namespace engine{
+
+    // State which cannot be recovered from the move when it is undone
+    struct UndoInfo {
+        uint64_t key;               // Zobrist key before the move
+        Piece captured;             // Captured piece (NO_PIECE if none)
+        uint8_t castlingRights;     // Castling rights before the move
+        Square epSquare;            // En passant square before the move
+        uint8_t halfmoveClock;      // 50-move counter before the move
+    };
+
+    class Position
+    {
+        private :
+
+            Bitboard pieceBB[PIECE_NB];     // Squares of each colored piece
+            Bitboard colorBB[COLOR_NB];     // Squares occupied by each color
+
+            Color sideToMove;               // Color to play
+            uint8_t castlingRights;         // CastlingRights flags
+            Square epSquare;                // En passant target square (NO_SQUARE if none)
+            uint8_t halfmoveClock;          // Half moves since the last capture or pawn move (50-move rule)
+            uint16_t fullmoveNumber;        // Starts at 1, incremented after each black move
+
+            uint64_t key;                   // Zobrist key, updated incrementally
+
+            // Reason why the en passant square cannot follow a double pawn push, nullptr if it can (or if there is none)
+            const char* checkEpSquare() const;
+
+        public :
+
+            // FEN of the initial position
+            static constexpr const char* startFen = "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1";
+
+            // Default constructor (empty board, white to move)
+            Position();
+
+            // Longest FEN written by writeFen (placement, fields and counters)
+            static constexpr size_t MAX_FEN_LENGTH = 96;
+
+            // Set the position from a FEN string without allocating, return false (and leave the position empty) if it is
+            // malformed, with the reason in error if not null. The position may still be illegal (see checkLegality)
+            bool setFromFen(std::string_view fen, const char** error = nullptr);
+
+            // Write the FEN string of the position in a buffer of MAX_FEN_LENGTH characters (no terminating zero),
+            // return its length
+            size_t writeFen(char* buffer) const;
+
+            // Get the FEN string of the position
+            std::string toFen() const;
+
+            // Reason why the position cannot be reached in a game (king counts, pawns on the back ranks, too many
+            // promoted pieces, side not to move in check, castling rights without their king and rook), null if none
+            const char* checkLegality() const;
+
+            // Place, remove and move pieces (the board and the key only, the other fields are left untouched)
+            void putPiece(Piece piece, Square square);
+            void removePiece(Square square);
+            void movePiece(Square from, Square to);
+
+            // Get the set of squares whose content differs from another position
+            Bitboard diff(const Position& other) const;
+
+            // Play a legal move (copy-make : copy the position first to be able to go back)
+            void doMove(Move move);
+
+            // Play a legal move, saving what undoMove needs
+            void doMove(Move move, UndoInfo& undo);
+
+            // Take back the last move played with doMove(move, undo)
+            void undoMove(Move move, const UndoInfo& undo);
+
+            // Pass the turn (for the null move pruning of the search), the side to move must not be in check
+            void doNullMove(UndoInfo& undo);
+            void undoNullMove(const UndoInfo& undo);
+
+            // Key after a move, ignoring the castling rights and en passant changes (to prefetch the transposition table)
+            uint64_t keyAfter(Move move) const;
+
+            // Compute the keys from scratch (initialization and debug checks of the incremental updates)
+            uint64_t computeKey() const;
+            uint64_t computePawnKey() const;
+            uint64_t computeMaterialKey() const;
+
+            // Get the pieces of both colors attacking a square, for a given occupancy
+            Bitboard attackersTo(Square square, Bitboard occupied) const;
+
+            // Is a square attacked by a color
+            bool isAttacked(Square square, Color by, Bitboard occupied) const;
+
+            // Get the pieces giving check to the side to move
+            Bitboard getCheckers() const;
+
+            // Get the king square of a color
+            Square getKingSquare(Color color) const;
+
+            // Getters
+            Bitboard getPieces(Piece piece) const;
+            Bitboard getPieces(Color color, PieceType type) const;
+            Bitboard getOccupancy(Color color) const;
+            Bitboard getOccupied() const;
+            Piece getPieceOn(Square square) const;
+            Color getSideToMove() const;
+            uint8_t getCastlingRights() const;
+            Square getEpSquare() const;
+            uint8_t getHalfmoveClock() const;
+            uint16_t getFullmoveNumber() const;
+            uint64_t getKey() const;
+
+            // Setters
+            void setSideToMove(Color color);
+            void setCastlingRights(uint8_t rights);
+            void setEpSquare(Square square);
+            void setHalfmoveClock(uint8_t clock);
+            void setFullmoveNumber(uint16_t number);
+    };
+
+    static_assert(sizeof(Position) <= 128, "Position must stay within two cache lines");
+}
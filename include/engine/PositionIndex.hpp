@@ -0,0 +1,89 @@
+/**
+ * @author obiwan138
+ * @class PositionIndex
+ * @brief On-disk index of the positions of a game archive : the games which reached a position
+ * @details For each Zobrist key of the positions of the games, the posting list of the games which reached it (each
+ * game once), the game numbers in increasing order written as LEB128 varints of their differences. The index is
+ * mapped in memory (little endian integers) :
+ * - a 64-byte header : magic "C3DPOSIX", version, number of keys, number of games of the archive, section offsets
+ * - the posting lists, one after the other in the order of the keys
+ * - the keys, sorted, in blocks of KEYS_PER_BLOCK
+ * - the offset of the posting list of each key (and the end of the last one)
+ * - the first key of each block in Eytzinger order (breadth-first layout of the binary search tree) with its block
+ *   number : the search only goes down, and the top levels share a few cache lines which stay in the cache
+ * A lookup is a branchless descent of the Eytzinger tree, a binary search in one block of keys, then the decoding of
+ * one posting list : a few cache misses, whatever the size of the index.
+ */
+
+#pragma once
+
+// Standard libraries
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// Project headers
+#include "engine/GameArchive.hpp"
+#include "engine/MappedFile.hpp"
+
+namespace engine{
+
+    class PositionIndex
+    {
+        public :
+
+            // File format
+            static constexpr uint32_t FILE_VERSION = 1;
+            static constexpr size_t HEADER_SIZE = 64;
+            static constexpr uint64_t KEYS_PER_BLOCK = 64;
+
+            // Node of the Eytzinger tree
+            struct TreeNode {
+                uint64_t firstKey;
+                uint64_t block;
+            };
+
+        private :
+
+            MappedFile file;
+            uint64_t keyCount;
+            uint64_t blockCount;
+            uint64_t gameCount;
+            const uint8_t* postings;
+            const uint64_t* keys;
+            const uint64_t* postingOffsets;
+            const TreeNode* tree;               // Eytzinger order, from index 1
+
+        public :
+
+            // Constructor (no index)
+            PositionIndex();
+
+            // Map an index, return false (with a message on stderr) if it is not a valid index
+            bool open(const std::string& path);
+
+            // Unmap the index
+            void close();
+
+            // Getters
+            bool isOpen() const;
+            uint64_t getKeyCount() const;
+            uint64_t getGameCount() const;
+
+            // Games (numbers in the archive, increasing) which reached a position, at most maxGames. Return the number of
+            // games of the posting list, which may be more than the games written
+            uint64_t lookup(uint64_t key, std::vector<uint32_t>& games, uint64_t maxGames = UINT64_MAX) const;
+
+            // Build the index of an archive on several threads. The pairs (key, game) of the archive are sorted in
+            // memory, in as many passes over the archive as the memory budget needs (each pass takes a range of keys).
+            // The progress is written on log (may be null)
+            static bool build(const GameArchive& archive, const std::string& path, int threads, size_t memoryMiB,
+                              std::ostream* log = nullptr);
+
+            // The mapping is owned
+            PositionIndex(const PositionIndex&) = delete;
+            PositionIndex& operator=(const PositionIndex&) = delete;
+    };
+}
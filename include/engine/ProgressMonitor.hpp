@@ -0,0 +1,49 @@
+/**
+ * @author obiwan138
+ * @class ProgressMonitor
+ * @brief Thread printing the progress of a long run at a fixed period
+ * @details The report function is called every period by a thread of its own, which sleeps on a condition variable in
+ * between, so stop wakes it up at once instead of waiting for the end of the period. The report reads the state of the
+ * run itself : it must synchronize with the workers (atomics or a mutex).
+ */
+
+#pragma once
+
+// Standard libraries
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+namespace engine{
+
+    class ProgressMonitor
+    {
+        private :
+
+            std::function<void()> report;
+            double periodSeconds;
+            bool finished;                          // Guarded by mutex
+            std::mutex mutex;
+            std::condition_variable condition;
+            std::thread thread;
+
+            // Loop of the thread
+            void run();
+
+        public :
+
+            // Start calling report every periodSeconds
+            ProgressMonitor(double periodSecondsIn, std::function<void()> reportIn);
+
+            // Stop the thread (no more report once it returns)
+            void stop();
+
+            // Destructor (stops the thread)
+            ~ProgressMonitor();
+
+            // The thread is owned
+            ProgressMonitor(const ProgressMonitor&) = delete;
+            ProgressMonitor& operator=(const ProgressMonitor&) = delete;
+    };
+}
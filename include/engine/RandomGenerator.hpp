@@ -0,0 +1,34 @@
+/**
+ * @author obiwan138
+ * @class RandomGenerator
+ * @brief Fast pseudo-random generator of the tools (xorshift64*)
+ * @details Not for the keys (see Zobrist) : the sequences of the games played, of the random openings and of the
+ * shuffles of the training data, which must be the same for the same seed on every platform (unlike std::mt19937 with
+ * the standard distributions). One generator per thread.
+ */
+
+#pragma once
+
+// Standard libraries
+#include <cstdint>
+
+namespace engine{
+
+    class RandomGenerator
+    {
+        private :
+
+            uint64_t state;     // Never 0
+
+        public :
+
+            // Constructor (the same seed gives the same sequence)
+            explicit RandomGenerator(uint64_t seed = 0);
+
+            // Restart the sequence of a seed
+            void seed(uint64_t seedIn);
+
+            // Next number of the sequence
+            uint64_t next();
+    };
+}
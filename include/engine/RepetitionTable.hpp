@@ -0,0 +1,49 @@
+/**
+ * @author obiwan138
+ * @class RepetitionTable
+ * @brief Occurrence count of the position keys along the current game line
+ * @details Small open addressing hash table (linear probing with backward shift deletion, so no tombstones pile up
+ * during a search). The key of a position includes the pawns, the material and the castling rights, so a position
+ * played before an irreversible move can never come back : counting the keys of the whole line gives the repetition
+ * count in O(1), without scanning the history.
+ */
+
+#pragma once
+
+// Standard libraries
+#include <cstdint>
+
+namespace engine{
+
+    class RepetitionTable
+    {
+        private :
+
+            // Must stay above twice the maximum number of keys (GameState::MAX_GAME_PLY + 1)
+            static constexpr int CAPACITY = 4096;
+
+            struct Slot {
+                uint64_t key;
+                uint32_t count;     // 0 : empty slot
+            };
+
+            Slot slots[CAPACITY];
+
+        public :
+
+            // Constructor (empty table)
+            RepetitionTable();
+
+            // Empty the table
+            void clear();
+
+            // Count one more occurrence of a key, return the new count
+            int add(uint64_t key);
+
+            // Count one less occurrence of a key
+            void remove(uint64_t key);
+
+            // Get the number of occurrences of a key
+            int count(uint64_t key) const;
+    };
+}
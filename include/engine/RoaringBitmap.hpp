@@ -0,0 +1,70 @@
+/**
+ * @author obiwan138
+ * @class RoaringBitmap
+ * @brief Compressed set of 32-bit integers (game numbers), in the layout of the roaring bitmaps
+ * @details The values are split by their 16 high bits into containers, sorted by those bits. A container of at most
+ * ARRAY_MAX values is a sorted array of their 16 low bits (2 bytes per value), a denser one a bitmap of the 65536 low
+ * values (8 KiB) : a sparse set costs its values, a dense one one bit per possible value, and the intersections and
+ * unions go container by container with the fastest kernel for each pair of kinds (merge, filter or word AND / OR).
+ * Serialized form (little endian) : the number of containers (uint32), then per container its high bits (uint16), its
+ * cardinality minus one (uint16) and its values (a bitmap beyond ARRAY_MAX values).
+ */
+
+#pragma once
+
+// Standard libraries
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace engine{
+
+    class RoaringBitmap
+    {
+        public :
+
+            // Largest array container : beyond, a bitmap is smaller
+            static constexpr uint32_t ARRAY_MAX = 4096;
+
+        private :
+
+            struct Container {
+                uint16_t high;
+                uint32_t cardinality;
+                std::vector<uint16_t> array;        // Sorted low bits of an array container
+                std::vector<uint64_t> bitmap;       // 1024 words of a bitmap container, empty for an array container
+            };
+
+            std::vector<Container> containers;     // Sorted by high bits, none empty
+
+            // Convert a container to the other kind
+            static void toBitmap(Container& container);
+            static void toArray(Container& container);
+
+        public :
+
+            // Remove all the values
+            void clear();
+
+            // Getters
+            bool isEmpty() const;
+            uint64_t getCardinality() const;
+            bool contains(uint32_t value) const;
+
+            // Add a value (fastest in increasing order)
+            void add(uint32_t value);
+
+            // Keep the values which are also in other (AND), add the values of other (OR)
+            void intersect(const RoaringBitmap& other);
+            void unite(const RoaringBitmap& other);
+
+            // Values in increasing order, at most maxCount
+            void toVector(std::vector<uint32_t>& values, uint64_t maxCount = UINT64_MAX) const;
+
+            // Append the serialized form to output
+            void serialize(std::vector<uint8_t>& output) const;
+
+            // Read a serialized form, return false if it is malformed (the bitmap is then empty)
+            bool deserialize(const uint8_t* data, size_t size);
+    };
+}
@@ -0,0 +1,29 @@
+/**
+ * @author obiwan138
+ * @file San.hpp
+ * @brief Standard algebraic notation (SAN) of the moves, as written in the PGN files
+ * @details The parser is tolerant of the usual variations of the files : check and annotation suffixes (+, #, !, ?),
+ * castling written with zeros, promotions with or without '=', pawn captures without the 'x', and over-specified
+ * origin squares. It does not allocate : the move is found among the legal moves of the position.
+ */
+
+#pragma once
+
+// Standard libraries
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+// Project headers
+#include "engine/Move.hpp"
+#include "engine/Position.hpp"
+
+namespace engine{
+
+    // Parse a move in SAN, return a null move if it is malformed, illegal or ambiguous
+    Move parseSan(const Position& position, const char* text, size_t length);
+    Move parseSan(const Position& position, std::string_view text);
+
+    // Write a legal move in SAN (with the check and mate suffixes)
+    std::string toSan(const Position& position, Move move);
+}
@@ -0,0 +1,151 @@
+/**
+ * @author obiwan138
+ * @class Search
+ * @brief Alpha-beta search of the best move
+ * @details Principal variation search driven by iterative deepening, with aspiration windows around the previous score,
+ * transposition table cutoffs, null move pruning, late move reductions and a quiescence search of the captures. The moves
+ * are tried in the order : transposition table move, captures (MVV-LVA), killer moves, then quiet moves by history score.
+ * The search runs on its own copy of the GameState (make/unmake) and stops on a depth, node or time limit, or when
+ * stop() is called from another thread. Several searches can share a stop flag and a node counter (SharedSearchState) to
+ * work on the same position in parallel (see ParallelSearch) : the main one (thread 0) checks the limits, the helpers skip
+ * some depths so that the threads do not all search the same depth at the same time.
+ */
+
+#pragma once
+
+// Standard libraries
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <thread>
+#include <vector>
+
+// Project headers
+#include "engine/Evaluator.hpp"
+#include "engine/GameState.hpp"
+#include "engine/Move.hpp"
+#include "engine/TranspositionTable.hpp"
+
+namespace engine{
+
+    // Maximum search depth [plies]
+    constexpr int MAX_PLY = 128;
+
+    // Scores [centipawns]
+    constexpr int SCORE_INFINITE = 32001;
+    constexpr int SCORE_MATE = 32000;
+    constexpr int SCORE_MATE_IN_MAX_PLY = SCORE_MATE - MAX_PLY;
+
+    // Limits of a search (0 means no limit, the search stops at the first reached limit)
+    struct SearchLimits {
+        int depth = 0;              // Maximum depth [plies]
+        uint64_t nodes = 0;         // Maximum number of nodes
+        int64_t moveTimeMs = 0;     // Time budget [ms]
+        bool infinite = false;      // Search until stop() is called (the other limits are ignored)
+        bool ponder = false;        // Search without limit until ponderhit (the limits then apply) or stop()
+    };
+
+    // Time budget of a move from a clock (movesToGo 0 : sudden death), keeping overheadMs in reserve [ms]
+    int64_t allocateMoveTime(int64_t timeLeftMs, int64_t incrementMs, int movesToGo, int64_t overheadMs);
+
+    // State shared by the threads searching the same position
+    struct SharedSearchState {
+        std::atomic<bool> stop{false};          // Raised by the main thread or stop()
+        std::atomic<uint64_t> nodes{0};         // Nodes of all the threads (flushed every few thousand nodes)
+        std::atomic<bool> pondering{false};     // The limits are ignored until ponderhit
+    };
+
+    // Result of a completed iteration (also the final result of the search)
+    struct SearchResult {
+        Move bestMove;
+        int score = 0;              // Side to move point of view [centipawns], mate scores are +-(SCORE_MATE - plies)
+        int depth = 0;              // Completed depth [plies]
+        int selDepth = 0;           // Maximum ply reached (quiescence included)
+        uint64_t nodes = 0;         // Total nodes searched (all threads)
+        int64_t timeMs = 0;         // Elapsed time [ms]
+        uint64_t nps = 0;           // Nodes per second
+        double ebf = 0.0;           // Effective branching factor : nodes of the last iteration / nodes of the one before
+        int hashfull = 0;           // Per mille of the transposition table in use
+        std::vector<Move> pv;       // Principal variation
+    };
+
+    class Search
+    {
+        private :
+
+            TranspositionTable& tt;
+            Evaluator evaluator;
+            GameState state;
+
+            // Move ordering
+            Move killers[MAX_PLY][2];
+            int history[COLOR_NB][64][64];
+
+            // Triangular principal variation table
+            Move pvTable[MAX_PLY][MAX_PLY];
+            int pvLength[MAX_PLY];
+
+            // Limits and statistics
+            SearchLimits limits;
+            std::chrono::steady_clock::time_point startTime;
+            uint64_t nodes;                 // Nodes of this thread
+            uint64_t flushedNodes;          // Part of them already added to the shared counter
+            int selDepth;
+
+            // Parallel search
+            int threadId;                   // 0 for the main thread, which checks the limits
+            SharedSearchState ownShared;    // Used when the search runs alone
+            SharedSearchState* shared;
+
+            // Recursive search
+            int search(int alpha, int beta, int depth, int ply, bool pvNode, bool allowNull);
+            int quiescence(int alpha, int beta, int ply);
+
+            // Score the moves for the ordering and pick the best remaining one
+            void scoreMoves(const MoveList& moves, int* scores, Move ttMove, int ply) const;
+            Move pickMove(MoveList& moves, int* scores, int index) const;
+
+            // Update the killers and the history after a beta cutoff by a quiet move
+            void updateQuietStats(Move best, const Move* quietsTried, int quietCount, int depth, int ply);
+
+            // Is a move a capture or a promotion
+            bool isTactical(Move move) const;
+
+            // Check the time and node limits (sets the stop flag)
+            void checkLimits();
+
+            // Add the new nodes of this thread to the shared counter
+            void flushNodes();
+
+            // Has the search been stopped
+            bool stopped() const;
+
+            // Elapsed time since the start of the search [ms]
+            int64_t elapsedMs() const;
+
+        public :
+
+            // Constructor (the table is shared with the caller, a null shared state makes the search run alone)
+            explicit Search(TranspositionTable& ttIn, int threadIdIn = 0, SharedSearchState* sharedIn = nullptr);
+
+            // Search the best move of a position, calling onIteration after each completed depth
+            SearchResult run(const GameState& root, const SearchLimits& limitsIn,
+                             const std::function<void(const SearchResult&)>& onIteration = nullptr);
+
+            // Ask a running search to stop (thread safe), run() then returns the last completed iteration
+            void stop();
+
+            // The move pondered on was played : the limits apply from now on (thread safe)
+            void ponderhit();
+
+            // Index of the thread (0 for the main one)
+            int getThreadId() const;
+
+            // Forget the move ordering statistics and the pawn cache (new game)
+            void clear();
+
+            // Evaluate with a network of this search only (null : hand-crafted evaluation), while it does not run
+            void setNetwork(const Network* networkIn);
+    };
+}
@@ -0,0 +1,75 @@
+/**
+ * @author obiwan138
+ * @class SpscQueue
+ * @brief Lock-free bounded queue between exactly one producer thread and one consumer thread
+ * @details Ring buffer of Capacity slots (a power of two). The producer only writes the tail and the consumer only
+ * writes the head, each index on its own cache line, so push and pop are wait-free : a few loads and one release store,
+ * never a lock nor a system call. Each side also keeps a cached copy of the other index to avoid reading the shared
+ * cache line at every call. The elements are copied, they should be small trivially copyable structs.
+ */
+
+#pragma once
+
+// Standard libraries
+#include <atomic>
+#include <cstddef>
+#include <type_traits>
+
+namespace engine{
+
+    template<typename T, size_t Capacity>
+    class SpscQueue
+    {
+        static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0, "The capacity must be a power of two");
+        static_assert(std::is_trivially_copyable<T>::value, "The elements are copied between the threads");
+
+        private :
+
+            static constexpr size_t MASK = Capacity - 1;
+
+            // Consumer side
+            alignas(64) std::atomic<size_t> head{0};
+            size_t cachedTail = 0;
+
+            // Producer side
+            alignas(64) std::atomic<size_t> tail{0};
+            size_t cachedHead = 0;
+
+            alignas(64) T slots[Capacity];
+
+        public :
+
+            // Add an element (producer thread only), return false if the queue is full
+            bool push(const T& value){
+                const size_t t = this->tail.load(std::memory_order_relaxed);
+                if(t - this->cachedHead == Capacity){
+                    this->cachedHead = this->head.load(std::memory_order_acquire);
+                    if(t - this->cachedHead == Capacity){
+                        return false;
+                    }
+                }
+                this->slots[t & MASK] = value;
+                this->tail.store(t + 1, std::memory_order_release);
+                return true;
+            }
+
+            // Remove the oldest element (consumer thread only), return false if the queue is empty
+            bool pop(T& value){
+                const size_t h = this->head.load(std::memory_order_relaxed);
+                if(h == this->cachedTail){
+                    this->cachedTail = this->tail.load(std::memory_order_acquire);
+                    if(h == this->cachedTail){
+                        return false;
+                    }
+                }
+                value = this->slots[h & MASK];
+                this->head.store(h + 1, std::memory_order_release);
+                return true;
+            }
+
+            // Is the queue empty (approximate when called from the producer)
+            bool empty() const{
+                return this->head.load(std::memory_order_acquire) == this->tail.load(std::memory_order_acquire);
+            }
+    };
+}
@@ -0,0 +1,93 @@
+/**
+ * @author obiwan138
+ * @class TrainingChunk
+ * @brief Chunk of training positions for the evaluation networks, read from a memory-mapped file
+ * @details Each position is a fixed-size 32-byte record (PackedPosition) : the occupied squares, the piece of each one
+ * in 4 bits, the side to move, castling rights, en passant square and halfmove clock, then the labels (search score,
+ * game result) and the ply of the position in its game. A position has at most 32 pieces, so the board always fits.
+ * A chunk file (little endian integers) :
+ * - a 64-byte header : magic "C3DTRAIN", version, size of a record, number of records
+ * - the records, shuffled when the chunk was written (the positions of a game are spread over the chunk)
+ * The chunks are independent and of the same size (except the last one of each writer), so a trainer shuffles the
+ * positions by reading the chunks in a random order, and several chunks at once. See TrainingDataWriter.
+ */
+
+#pragma once
+
+// Standard libraries
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Project headers
+#include "engine/MappedFile.hpp"
+#include "engine/Position.hpp"
+
+namespace engine{
+
+    // Header of a chunk file (followed by zeros up to TrainingChunk::HEADER_SIZE)
+    struct TrainingChunkHeader {
+        char magic[8];
+        uint32_t version;
+        uint32_t recordSize;
+        uint64_t recordCount;
+    };
+
+    // Training position
+    struct PackedPosition {
+        uint64_t occupied;          // Occupied squares
+        uint8_t pieces[16];         // Piece of each occupied square, from a1 to h8, 4 bits each (low bits first)
+        uint8_t flags;              // Bit 0 : black to move, bits 1 to 4 : castling rights
+        uint8_t epSquare;           // En passant square, 64 if none
+        uint8_t halfmoveClock;
+        uint8_t result;             // Result of the game for white : 0 loss, 1 draw, 2 win
+        int16_t score;              // Score of the search, side to move point of view [centipawns]
+        uint16_t ply;               // Ply of the position in its game
+    };
+
+    static_assert(sizeof(PackedPosition) == 32, "PackedPosition is a 32-byte record of the chunk files");
+    static_assert(sizeof(TrainingChunkHeader) <= 64, "The header must fit in its block");
+
+    class TrainingChunk
+    {
+        public :
+
+            // File format
+            static constexpr char FILE_MAGIC[8] = {'C', '3', 'D', 'T', 'R', 'A', 'I', 'N'};
+            static constexpr uint32_t FILE_VERSION = 1;
+            static constexpr size_t HEADER_SIZE = 64;
+
+        private :
+
+            MappedFile file;
+            uint64_t recordCount;
+
+        public :
+
+            // Constructor (no chunk)
+            TrainingChunk();
+
+            // Map a chunk, return false (with a message on stderr) if it is not a valid chunk
+            bool open(const std::string& path);
+
+            // Unmap the chunk
+            void close();
+
+            // Getters
+            bool isOpen() const;
+            uint64_t getRecordCount() const;
+
+            // Record of a position (index below the record count)
+            PackedPosition getRecord(uint64_t index) const;
+
+            // Pack a position and its labels
+            static PackedPosition pack(const Position& position, int score, uint8_t result, int ply);
+
+            // Unpack the position of a record, return false if the record is malformed
+            static bool unpack(const PackedPosition& record, Position& position);
+
+            // The mapping is owned
+            TrainingChunk(const TrainingChunk&) = delete;
+            TrainingChunk& operator=(const TrainingChunk&) = delete;
+    };
+}
@@ -0,0 +1,60 @@
+/**
+ * @author obiwan138
+ * @class TrainingDataWriter
+ * @brief Writer of the chunks of training positions (format described in TrainingChunk)
+ * @details The positions are added one by one into a buffer of one chunk : a full buffer is shuffled and written to a
+ * new file <prefix>-<number>.c3t, so each writer (one per thread) writes its own files without any locking, and the
+ * positions of a game end up spread over its chunk. The last chunk, smaller, is written by close.
+ */
+
+#pragma once
+
+// Standard libraries
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Project headers
+#include "engine/RandomGenerator.hpp"
+#include "engine/TrainingChunk.hpp"
+
+namespace engine{
+
+    class TrainingDataWriter
+    {
+        private :
+
+            std::string prefix;
+            std::vector<PackedPosition> buffer;     // Positions of the current chunk
+            size_t chunkSize;                       // Positions per chunk
+            RandomGenerator random;                 // Shuffle of the chunks
+            uint64_t recordCount;                   // Positions written
+            uint64_t chunkCount;                    // Chunks written
+            bool failed;                            // A write failed
+
+            // Shuffle and write the buffer to the next chunk file
+            void writeChunk();
+
+        public :
+
+            // Constructor (no output)
+            TrainingDataWriter();
+
+            // Start writing chunks of chunkSize positions to <prefix>-<number>.c3t, shuffled from seed
+            void open(const std::string& prefixIn, size_t chunkSizeIn, uint64_t seed);
+
+            // Add a position
+            void add(const PackedPosition& record);
+
+            // Write the last chunk, return false if a write failed
+            bool close();
+
+            // Getters
+            uint64_t getRecordCount() const;
+            uint64_t getChunkCount() const;
+
+            // Path of a chunk file
+            static std::string chunkPath(const std::string& prefix, uint64_t number);
+    };
+}
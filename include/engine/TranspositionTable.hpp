@@ -0,0 +1,111 @@
+/**
+ * @author obiwan138
+ * @class TranspositionTable
+ * @brief Cache of the search results, indexed by the Zobrist key of the positions, shared by the search threads
+ * @details The table is an array of 64-byte buckets (one cache line) of four 16-byte entries. It is lockless : an entry
+ * is two 64-bit words, the packed data and the key XORed with the data. A probe recomputes the key from the two words,
+ * so an entry torn by two threads writing at the same time does not match any position and is simply a miss. The words
+ * are relaxed atomics, which compile to plain loads and stores.
+ * In a full bucket, the replaced entry is the one with the lowest depth, the entries of the previous searches (older
+ * generation) being replaced first. The memory is allocated with mmap on Linux, with transparent huge pages requested
+ * by madvise, or explicit huge pages (MAP_HUGETLB) on demand, and cleared by all the cores in parallel.
+ */
+
+#pragma once
+
+// Standard libraries
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+// Project headers
+#include "engine/Move.hpp"
+
+namespace engine{
+
+    // Kind of bound stored with a score
+    enum Bound : uint8_t {
+        BOUND_NONE,
+        BOUND_UPPER,    // Fail low : the score is at most this value
+        BOUND_LOWER,    // Fail high : the score is at least this value
+        BOUND_EXACT
+    };
+
+    // Result of a probe
+    struct TTData {
+        Move move;
+        int16_t score;
+        int16_t eval;
+        int8_t depth;
+        Bound bound;
+    };
+
+    class TranspositionTable
+    {
+        private :
+
+            // Data bits : move (0-15), score (16-31), eval (32-47), depth (48-55), bound (56-57), generation (58-63)
+            struct Entry {
+                std::atomic<uint64_t> keyXorData;
+                std::atomic<uint64_t> data;
+            };
+
+            static constexpr int BUCKET_SIZE = 4;
+
+            struct alignas(64) Bucket {
+                Entry entries[BUCKET_SIZE];
+            };
+
+            static_assert(sizeof(Bucket) == 64, "A bucket must fill exactly one cache line");
+
+            Bucket* buckets;
+            size_t bucketCount;
+            size_t allocatedBytes;
+            bool mapped;                    // Allocated with mmap (munmap to free it)
+            bool explicitHugePages;         // Try MAP_HUGETLB first
+            uint8_t generation;             // Age of the current search (6 bits)
+
+            // Bucket of a key (multiply-high, the bucket count needs not be a power of two)
+            Bucket& bucketOf(uint64_t key) const;
+
+            // Allocate and free the buckets
+            bool allocate(size_t bytes);
+            void release();
+
+        public :
+
+            // Constructor (size in MiB), explicit huge pages must be reserved by the system (vm.nr_hugepages)
+            explicit TranspositionTable(size_t sizeMb, bool explicitHugePagesIn = false);
+
+            // Not copyable (owns the memory)
+            TranspositionTable(const TranspositionTable&) = delete;
+            TranspositionTable& operator=(const TranspositionTable&) = delete;
+
+            // Change the size (the content is lost), return false if the memory could not be allocated (1 MiB is used)
+            bool resize(size_t sizeMb);
+
+            // Empty the table (all the cores)
+            void clear();
+
+            // Start a new search : the entries of the previous ones become the first to be replaced
+            void newSearch();
+
+            // Look up a position
+            bool probe(uint64_t key, TTData& data) const;
+
+            // Store a search result
+            void store(uint64_t key, Move move, int score, int eval, int depth, Bound bound);
+
+            // Load the bucket of a key into the cache ahead of the probe
+            void prefetch(uint64_t key) const;
+
+            // Per mille of the entries written by the current search (sampled)
+            int hashfull() const;
+
+            // Size of the table in MiB
+            size_t getSizeMb() const;
+
+            // Destructor
+            ~TranspositionTable();
+    };
+}
@@ -0,0 +1,94 @@
+/**
+ * @author obiwan138
+ * @file Types.hpp
+ * @brief Basic types of the chess engine (colors, pieces, squares, castling rights)
+ * @note The engine does not depend on the rendering code. Its types live in the engine namespace,
+ * so engine::Square (a 0-63 index) does not clash with the Square class of the render grid.
+ */
+
+#pragma once
+
+// Standard libraries
+#include <cstdint>
+
+namespace engine{
+
+    // A set of squares, bit i is the square i (a1 = bit 0, h8 = bit 63)
+    using Bitboard = uint64_t;
+
+    enum Color : uint8_t {
+        WHITE,
+        BLACK,
+        COLOR_NB = 2
+    };
+
+    enum PieceType : uint8_t {
+        PAWN,
+        KNIGHT,
+        BISHOP,
+        ROOK,
+        QUEEN,
+        KING,
+        PIECE_TYPE_NB = 6
+    };
+
+    // Colored pieces, piece = color * 6 + piece type
+    enum Piece : uint8_t {
+        W_PAWN, W_KNIGHT, W_BISHOP, W_ROOK, W_QUEEN, W_KING,
+        B_PAWN, B_KNIGHT, B_BISHOP, B_ROOK, B_QUEEN, B_KING,
+        PIECE_NB = 12,
+        NO_PIECE = 12
+    };
+
+    // Squares, square = rank * 8 + file (same layout as the render grid : grid[rank][file])
+    enum Square : uint8_t {
+        A1, B1, C1, D1, E1, F1, G1, H1,
+        A2, B2, C2, D2, E2, F2, G2, H2,
+        A3, B3, C3, D3, E3, F3, G3, H3,
+        A4, B4, C4, D4, E4, F4, G4, H4,
+        A5, B5, C5, D5, E5, F5, G5, H5,
+        A6, B6, C6, D6, E6, F6, G6, H6,
+        A7, B7, C7, D7, E7, F7, G7, H7,
+        A8, B8, C8, D8, E8, F8, G8, H8,
+        SQUARE_NB = 64,
+        NO_SQUARE = 64
+    };
+
+    // Castling rights (bit flags)
+    enum CastlingRights : uint8_t {
+        NO_CASTLING = 0,
+        WHITE_OO    = 1,
+        WHITE_OOO   = 2,
+        BLACK_OO    = 4,
+        BLACK_OOO   = 8,
+        ALL_CASTLING = 15
+    };
+
+    inline constexpr Piece makePiece(Color c, PieceType pt){
+        return static_cast<Piece>(c * 6 + pt);
+    }
+
+    inline constexpr Color colorOf(Piece p){
+        return static_cast<Color>(p / 6);
+    }
+
+    inline constexpr PieceType typeOf(Piece p){
+        return static_cast<PieceType>(p % 6);
+    }
+
+    inline constexpr Color operator~(Color c){
+        return static_cast<Color>(c ^ 1);
+    }
+
+    inline constexpr Square makeSquare(int file, int rank){
+        return static_cast<Square>(rank * 8 + file);
+    }
+
+    inline constexpr int fileOf(Square s){
+        return s & 7;
+    }
+
+    inline constexpr int rankOf(Square s){
+        return s >> 3;
+    }
+}
@@ -0,0 +1,83 @@
+/**
+ * @author obiwan138
+ * @class Uci
+ * @brief Universal Chess Interface front-end of the engine (standard input and output, no graphics)
+ * @details The commands are read and parsed on the calling thread while the searches run on their own thread, so
+ * "stop" and "ponderhit" are handled immediately. Supported commands : uci, isready, ucinewgame, setoption (Hash,
+ * Threads, Ponder, EvalFile, OwnBook, BookFile, BookBestMove,
+ * BookKeyFile), position (startpos or fen, then moves), go (depth, nodes, movetime, wtime, btime, winc, binc, movestogo,
+ * infinite, ponder), stop, ponderhit, bench and quit.
+ */
+
+#pragma once
+
+// Standard libraries
+#include <iostream>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+
+// Project headers
+#include "engine/GameState.hpp"
+#include "engine/Move.hpp"
+#include "engine/Network.hpp"
+#include "engine/ParallelSearch.hpp"
+#include "engine/PolyglotBook.hpp"
+#include "engine/Position.hpp"
+#include "engine/RandomGenerator.hpp"
+#include "engine/TranspositionTable.hpp"
+
+namespace engine{
+
+    class Uci
+    {
+        private :
+
+            TranspositionTable tt;
+            ParallelSearch search;
+            Network network;            // Evaluation network (EvalFile option), hand-crafted evaluation if none
+            PolyglotBook book;          // Opening book (BookFile option), played from when OwnBook is set
+            bool ownBook;
+            bool bookBestMove;          // Best book move, or random in proportion to the weights
+            RandomGenerator bookRandom;  // Choice of the random book moves
+            GameState game;             // Position set by the "position" command
+            GameState searchRoot;       // Copy searched by the search thread
+            std::thread searchThread;
+            std::mutex outputMutex;
+
+            // Write a line on the standard output (the search thread and the input thread both write)
+            void send(const std::string& line);
+
+            // Commands
+            void handleUci();
+            void handleSetOption(std::istringstream& input);
+            void handlePosition(std::istringstream& input);
+            void handleGo(std::istringstream& input);
+            void handleBench(std::istringstream& input);
+
+            // Wait for the end of the running search (if any)
+            void waitSearch();
+
+            // Format a search iteration as an "info" line
+            static std::string formatInfo(const SearchResult& result);
+
+        public :
+
+            // Default and maximum sizes of the transposition table [MiB]
+            static constexpr size_t DEFAULT_HASH_MB = 256;
+            static constexpr size_t MAX_HASH_MB = 131072;
+
+            // Constructor (one search thread, default table size, no book)
+            Uci();
+
+            // Read and execute the commands until "quit" or the end of the input
+            void loop(std::istream& input = std::cin);
+
+            // Parse a move in UCI notation (e.g. e2e4, e7e8q), return a null move if it is not legal
+            static Move parseMove(const Position& position, const std::string& text);
+
+            // Destructor (stops the running search)
+            ~Uci();
+    };
+}
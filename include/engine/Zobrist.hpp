@@ -0,0 +1,62 @@
+/**
+ * @author obiwan138
+ * @file Zobrist.hpp
+ * @brief Zobrist keys of the positions
+ * @details A position key is the XOR of one random key per (piece, square), per castling rights set, per en passant
+ * file and for the side to move, so a move updates it with a few XORs. The keys are generated at compile time by a
+ * fixed PRNG : they are identical in every build and need no initialization.
+ */
+
+#pragma once
+
+// Standard libraries
+#include <cstdint>
+
+// Project headers
+#include "engine/Types.hpp"
+
+namespace engine{
+
+    struct ZobristKeys {
+        uint64_t psq[PIECE_NB][SQUARE_NB];   // Piece on square (also indexed by piece count for the material key)
+        uint64_t castling[16];               // Castling rights set
+        uint64_t enPassant[8];               // File of the en passant square
+        uint64_t side;                       // Black to move
+
+        constexpr ZobristKeys():psq(), castling(), enPassant(), side(0){
+
+            // splitmix64
+            uint64_t state = 0x3C6EF372FE94F82Aull;
+            auto next = [&state](){
+                uint64_t z = (state += 0x9E3779B97F4A7C15ull);
+                z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+                z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+                return z ^ (z >> 31);
+            };
+
+            for(int p = 0; p < PIECE_NB; p++){
+                for(int s = 0; s < SQUARE_NB; s++){
+                    psq[p][s] = next();
+                }
+            }
+
+            // The key of a rights set is the XOR of the keys of its single rights, so removing one right is one XOR
+            uint64_t single[4] = {next(), next(), next(), next()};
+            for(int rights = 0; rights < 16; rights++){
+                castling[rights] = 0;
+                for(int bit = 0; bit < 4; bit++){
+                    if(rights & (1 << bit)){
+                        castling[rights] ^= single[bit];
+                    }
+                }
+            }
+
+            for(int f = 0; f < 8; f++){
+                enPassant[f] = next();
+            }
+            side = next();
+        }
+    };
+
+    inline constexpr ZobristKeys zobrist{};
+}
@@ -20,5 +20,6 @@
     BLACK_QUEEN,
     BLACK_KING,
     BOARD,
+    BOARD_NORMAL,
     NONE
  };
\ No newline at end of file
@@ -73,6 +73,8 @@ ChessObject& ChessObject::operator=(const ChessObject& other){
     // Send the corresponding matrices to the shader
     glUniformMatrix4fv(shaderPtr->getMvpMatrixID(), 1, GL_FALSE, &MVP[0][0]);                       // Send the MVP matrix to the shader
     glUniformMatrix4fv(shaderPtr->getModelMatrixID(), 1, GL_FALSE, &(this->modelMatrix[0][0]));     // Send the model matrix to the shader
+    glm::mat4 viewMatrix = viewControllerPtr->getViewMatrix();
+    glUniformMatrix4fv(shaderPtr->getViewMatrixID(), 1, GL_FALSE, &viewMatrix[0][0]);               // Send the view matrix to the shader
     glUniform3f(shaderPtr->getLightID(),                                                            // Send the ligth position
                 shaderPtr->getLightPosition().x, 
                 shaderPtr->getLightPosition().y, 
@@ -98,6 +100,40 @@ ChessObject& ChessObject::operator=(const ChessObject& other){
 	glBindVertexArray(0);
 }
 
+//////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * @brief Render a chess object into a depth buffer seen from the light
+ * @details Only the positions are used, so no texture is bound
+ * @param depthShaderPtr : the pointer to the depth-only shader program
+ * @param lightViewProjection : the view-projection matrix of the light
+ */
+
+void ChessObject::renderDepth(Shader* depthShaderPtr, const glm::mat4& lightViewProjection){
+
+    // Compute the MVP matrix from the light point of view
+    glm::mat4 MVP = lightViewProjection * this->modelMatrix;
+
+    // Use the shader and send the MVP matrix
+    depthShaderPtr->use();
+    glUniformMatrix4fv(depthShaderPtr->getMvpMatrixID(), 1, GL_FALSE, &MVP[0][0]);
+
+    // Draw the triangles
+    glBindVertexArray(this->vao);
+    glDrawElements(GL_TRIANGLES, this->numIndices, GL_UNSIGNED_SHORT, (void*)0);
+	glBindVertexArray(0);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * @brief Place the object at a world position
+ * @details The model matrix is reset to a pure translation (the meshes are centered on the origin of the horizontal plane when loaded)
+ * @param position : the world position of the object
+ */
+
+void ChessObject::setPosition(const glm::vec3& position){
+    this->modelMatrix = glm::translate(glm::mat4(1.0f), position);
+}
+
 //////////////////////////////////////////////////////////////////////////////////////////
 /**
  * @brief Default Destructor
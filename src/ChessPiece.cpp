@@ -16,6 +16,9 @@ ChessPiece::ChessPiece():ChessObject(){
     this->type = MeshTypes::BOARD;
     this->team = Team::NONE;
     this->alive = false;
+    this->boundingRadius = 0.f;
+    this->boundingBottom = 0.f;
+    this->boundingTop = 0.f;
 }
 
 //////////////////////////////////////////////////////////////////////////////////////////
@@ -30,6 +33,9 @@ ChessPiece::ChessPiece(MeshTypes typeIn, Team teamIn, GLuint vaoID, GLuint textu
     this->type = typeIn;
     this->team = teamIn;
     this->alive = true;
+    this->boundingRadius = 0.f;
+    this->boundingBottom = 0.f;
+    this->boundingTop = 0.f;
 }
 
 //////////////////////////////////////////////////////////////////////////////////////////
@@ -51,6 +57,9 @@ ChessPiece& ChessPiece::operator=(const ChessPiece& other){
         this->type = other.type;
         this->team = other.team;
         this->alive = other.alive;
+        this->boundingRadius = other.boundingRadius;
+        this->boundingBottom = other.boundingBottom;
+        this->boundingTop = other.boundingTop;
         return *this;
     }
 }
@@ -83,6 +92,33 @@ bool ChessPiece::getAlive() const{
     return this->alive;
 }
 
+//////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * @brief Get the horizontal radius of the bounding capsule
+ * @return Radius of the capsule
+ */
+float ChessPiece::getBoundingRadius() const{
+    return this->boundingRadius;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * @brief Get the lowest point of the bounding capsule (model space)
+ * @return Bottom height of the capsule
+ */
+float ChessPiece::getBoundingBottom() const{
+    return this->boundingBottom;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * @brief Get the highest point of the bounding capsule (model space)
+ * @return Top height of the capsule
+ */
+float ChessPiece::getBoundingTop() const{
+    return this->boundingTop;
+}
+
 //////////////////////////////////////////////////////////////////////////////////////////
 /**
  * @brief Set the team of the piece
@@ -110,6 +146,19 @@ void ChessPiece::setAlive(bool aliveIn){
     this->alive = aliveIn;
 }
 
+//////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * @brief Set the bounding capsule of the piece, used for mouse picking
+ * @param radiusIn Horizontal radius of the capsule
+ * @param bottomIn Lowest point of the mesh
+ * @param topIn Highest point of the mesh
+ */
+void ChessPiece::setBoundingCapsule(float radiusIn, float bottomIn, float topIn){
+    this->boundingRadius = radiusIn;
+    this->boundingBottom = bottomIn;
+    this->boundingTop = topIn;
+}
+
 //////////////////////////////////////////////////////////////////////////////////////////
 /**
  * @brief Default Destructor
@@ -5,6 +5,7 @@
  */ 
 
 #include "Chessboard.hpp"
+#include <cmath>
 #include <string>
 
 //////////////////////////////////////////////////////////////////////////////////////////
@@ -14,6 +15,8 @@
 
 Chessboard::Chessboard():ChessObject(){
     this->setUpState = false;
+    this->a1Position = glm::vec3(-3.5f, 0.f, +3.5f);
+    this->squareSize = 1.f;
 }
 
 //////////////////////////////////////////////////////////////////////////////////////////
@@ -27,6 +30,8 @@ Chessboard::Chessboard():ChessObject(){
 
 Chessboard::Chessboard(GLuint vaoID, GLuint textureID, unsigned short numIndicesIn):ChessObject(vaoID, textureID, numIndicesIn){
     this->setUpState = false;
+    this->a1Position = glm::vec3(-3.5f, 0.f, +3.5f);
+    this->squareSize = 1.f;
 }
 
 //////////////////////////////////////////////////////////////////////////////////////////
@@ -41,10 +46,10 @@ Chessboard::Chessboard(GLuint vaoID, GLuint textureID, unsigned short numIndices
 
 void Chessboard::initGrid(){
     // First cell and cell size
-    glm::vec3 a1(-3.5f, 0.f, +3.5f);
+    glm::vec3 a1 = this->a1Position;
     char a1Letter = 'a';
     char a1Num = '1';
-    float dpos = 1.f;
+    float dpos = this->squareSize;
 
     // Go over the squares
     for(int i=0; i<grid.size(); i++){
@@ -75,9 +80,32 @@ void Chessboard::initGrid(){
 void Chessboard::render(Shader* shaderPtr, ViewController* viewControllerPtr){
 
     // Render the chessboard
+    this->renderBoard(shaderPtr, viewControllerPtr);
+
+    // Render the pieces
+    this->renderPieces(shaderPtr, viewControllerPtr);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * @brief Render the board mesh only
+ * @param shaderPtr Pointer to the shader
+ * @param viewControllerPtr Pointer to the view controller
+ */
+
+void Chessboard::renderBoard(Shader* shaderPtr, ViewController* viewControllerPtr){
     this->ChessObject::render(shaderPtr, viewControllerPtr);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * @brief Render the pieces only (if the board is set up)
+ * @param shaderPtr Pointer to the shader
+ * @param viewControllerPtr Pointer to the view controller
+ */
+
+void Chessboard::renderPieces(Shader* shaderPtr, ViewController* viewControllerPtr){
 
-    
     // If the board is set up, render the pieces
     if(this->setUpState){
 
@@ -96,6 +124,110 @@ void Chessboard::render(Shader* shaderPtr, ViewController* viewControllerPtr){
     }
 }
 
+//////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * @brief Render the chessboard and the pieces into a depth buffer seen from the light
+ * @param depthShaderPtr Pointer to the depth-only shader
+ * @param lightViewProjection View-projection matrix of the light
+ */
+
+void Chessboard::renderDepth(Shader* depthShaderPtr, const glm::mat4& lightViewProjection){
+
+    // Render the chessboard
+    this->ChessObject::renderDepth(depthShaderPtr, lightViewProjection);
+
+    // If the board is set up, render the pieces
+    if(this->setUpState){
+        for(auto& row : this->grid){
+            for(auto& square : row){
+                square.renderPieceDepth(depthShaderPtr, lightViewProjection);
+            }
+        }
+    }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * @brief Get a signature of the pieces layout
+ * @details FNV-1a hash of the piece pointers of the 64 squares. It is cheap enough to be computed every frame,
+ * and it changes whenever a piece is placed, moved or removed, whoever modifies the grid.
+ * @return uint64_t the layout signature
+ */
+
+uint64_t Chessboard::getLayoutSignature() const{
+    uint64_t hash = 14695981039346656037ull;
+    for(const auto& row : this->grid){
+        for(const auto& square : row){
+            hash ^= reinterpret_cast<uintptr_t>(square.getPiece());
+            hash *= 1099511628211ull;
+        }
+    }
+    return hash ^ static_cast<uint64_t>(this->setUpState);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * @brief Find the square under a picking ray
+ * @details The ray is first tested against the bounding capsules of the pieces (a tall piece can hide the square behind it),
+ * then analytically intersected with the board plane. The closest hit wins. The hit point on the plane is mapped to the grid
+ * with the same layout as initGrid, so no GPU readback is needed.
+ * @param ray Picking ray in world space
+ * @param row Output row index of the picked square (0 to 7, maps to the numbers 1 to 8)
+ * @param col Output column index of the picked square (0 to 7, maps to the letters a to h)
+ * @return true if a square (or a piece) is under the ray, false otherwise
+ */
+
+bool Chessboard::pick(const Ray& ray, int& row, int& col) const{
+
+    bool hit = false;
+    float closestT = 0.f;
+
+    // Test the pieces bounding capsules
+    if(this->setUpState){
+        for(int i=0; i<grid.size(); i++){
+            for(int j=0; j<grid[0].size(); j++){
+
+                const ChessPiece* piecePtr = this->grid[i][j].getPiece();
+                if(piecePtr == nullptr){
+                    continue;
+                }
+
+                // Capsule standing on the square
+                glm::vec3 basePoint = this->grid[i][j].getPosition();
+                basePoint.y += piecePtr->getBoundingBottom();
+                float height = piecePtr->getBoundingTop() - piecePtr->getBoundingBottom();
+
+                float t;
+                if(ray.intersectVerticalCapsule(basePoint, height, piecePtr->getBoundingRadius(), t) && (!hit || t < closestT)){
+                    hit = true;
+                    closestT = t;
+                    row = i;
+                    col = j;
+                }
+            }
+        }
+    }
+
+    // Test the board plane
+    float t;
+    if(ray.intersectHorizontalPlane(this->a1Position.y, t) && (!hit || t < closestT)){
+
+        // Map the hit point to the grid (a1 is the center of the first square)
+        glm::vec3 point = ray.pointAt(t);
+        int j = static_cast<int>(std::floor((point.x - this->a1Position.x) / this->squareSize + 0.5f));
+        int i = static_cast<int>(std::floor((this->a1Position.z - point.z) / this->squareSize + 0.5f));
+
+        // Keep the hit only if it is on the board
+        if(i >= 0 && i < static_cast<int>(grid.size()) && j >= 0 && j < static_cast<int>(grid[0].size())){
+            hit = true;
+            row = i;
+            col = j;
+        }
+    }
+
+    return hit;
+}
+
 //////////////////////////////////////////////////////////////////////////////////////////
 /**
  * @brief Determine if the board is set up
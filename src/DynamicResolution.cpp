@@ -0,0 +1,263 @@
+/**
+ * @author obiwan138
+ * @file DynamicResolution.cpp
+ * @brief Implementation of the DynamicResolution class
+ */
+
+#include "DynamicResolution.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+/////////////////////////////////////////////////////////////////////////////////////
+/**
+ * @brief Constructor
+ * @param windowWidthIn : width of the window [px]
+ * @param windowHeightIn : height of the window [px]
+ * @param targetFrameTimeMsIn : GPU time budget of the scene [ms]
+ * @param minScaleIn : minimum resolution scale per axis (e.g. 0.5)
+ * @param maxScaleIn : maximum resolution scale per axis (e.g. 1.0)
+ */
+
+DynamicResolution::DynamicResolution(int windowWidthIn, int windowHeightIn, float targetFrameTimeMsIn, float minScaleIn, float maxScaleIn)
+    :upscaleShader("shaders/upscaleVertexShader.glsl", "shaders/upscaleFragmentShader.glsl"){
+
+    // Configuration
+    this->targetFrameTimeMs = targetFrameTimeMsIn;
+    this->minScale = std::min(minScaleIn, maxScaleIn);
+    this->maxScale = std::max(minScaleIn, maxScaleIn);
+    this->scale = this->maxScale;
+
+    // Offscreen framebuffer
+    this->fbo = 0;
+    this->colorTexture = 0;
+    this->depthRenderbuffer = 0;
+    this->windowWidth = windowWidthIn;
+    this->windowHeight = windowHeightIn;
+    this->renderWidth = this->windowWidth;
+    this->renderHeight = this->windowHeight;
+    this->allocateBuffers();
+
+    // Upscale shader uniforms
+    this->sceneTextureID = glGetUniformLocation(this->upscaleShader.getID(), "SceneTexture");
+    this->uvScaleID = glGetUniformLocation(this->upscaleShader.getID(), "UvScale");
+    this->texelSizeID = glGetUniformLocation(this->upscaleShader.getID(), "TexelSize");
+    this->sharpnessID = glGetUniformLocation(this->upscaleShader.getID(), "Sharpness");
+
+    // The fullscreen triangle is generated from gl_VertexID, but a VAO must be bound to draw
+    glGenVertexArrays(1, &(this->emptyVao));
+}
+
+/////////////////////////////////////////////////////////////////////////////////////
+/**
+ * @brief Allocate the offscreen framebuffer
+ * @details The buffers are allocated at the maximum scale, the lower scales only use a sub-rectangle
+ */
+
+void DynamicResolution::allocateBuffers(){
+
+    // Delete the previous buffers
+    if(this->fbo != 0){
+        glDeleteFramebuffers(1, &(this->fbo));
+        glDeleteTextures(1, &(this->colorTexture));
+        glDeleteRenderbuffers(1, &(this->depthRenderbuffer));
+    }
+
+    this->bufferWidth = std::max(1, static_cast<int>(std::ceil(this->windowWidth * this->maxScale)));
+    this->bufferHeight = std::max(1, static_cast<int>(std::ceil(this->windowHeight * this->maxScale)));
+
+    // Color texture, bilinear filtering for the upscale
+    glGenTextures(1, &(this->colorTexture));
+    glBindTexture(GL_TEXTURE_2D, this->colorTexture);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, this->bufferWidth, this->bufferHeight, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+    // Depth and stencil
+    glGenRenderbuffers(1, &(this->depthRenderbuffer));
+    glBindRenderbuffer(GL_RENDERBUFFER, this->depthRenderbuffer);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, this->bufferWidth, this->bufferHeight);
+
+    // Framebuffer
+    glGenFramebuffers(1, &(this->fbo));
+    glBindFramebuffer(GL_FRAMEBUFFER, this->fbo);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, this->colorTexture, 0);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, this->depthRenderbuffer);
+
+    if(glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE){
+        std::cerr << "Error: the dynamic resolution framebuffer is not complete" << std::endl;
+    }
+
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+/////////////////////////////////////////////////////////////////////////////////////
+/**
+ * @brief Resize the offscreen framebuffer when the window is resized
+ * @param windowWidthIn : new width of the window [px]
+ * @param windowHeightIn : new height of the window [px]
+ */
+
+void DynamicResolution::resize(int windowWidthIn, int windowHeightIn){
+    this->windowWidth = windowWidthIn;
+    this->windowHeight = windowHeightIn;
+    this->allocateBuffers();
+}
+
+/////////////////////////////////////////////////////////////////////////////////////
+/**
+ * @brief Bind the offscreen framebuffer at the current scale, clear it and start timing
+ */
+
+void DynamicResolution::beginScene(){
+
+    // Sub-rectangle at the current scale
+    this->renderWidth = std::max(1, static_cast<int>(this->windowWidth * this->scale));
+    this->renderHeight = std::max(1, static_cast<int>(this->windowHeight * this->scale));
+
+    glBindFramebuffer(GL_FRAMEBUFFER, this->fbo);
+    glViewport(0, 0, this->renderWidth, this->renderHeight);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+    this->sceneTimer.begin();
+}
+
+/////////////////////////////////////////////////////////////////////////////////////
+/**
+ * @brief Stop timing and adapt the scale
+ * @details The timer results arrive 1 to 2 frames late, the scale is updated each time a new one is available
+ */
+
+void DynamicResolution::endScene(){
+    this->sceneTimer.end();
+    if(this->sceneTimer.poll()){
+        this->updateScale(this->sceneTimer.getLastTimeMs());
+    }
+}
+
+/////////////////////////////////////////////////////////////////////////////////////
+/**
+ * @brief Adjust the scale from the last measured GPU time
+ * @details The cost of the fragment-bound scene is roughly proportional to the number of pixels (scale^2), so the
+ * scale reaching the target is scale * sqrt(target / measured). The scale moves only part of the way (damping) and
+ * ignores small changes (hysteresis) to avoid oscillations.
+ * @param frameTimeMs : last measured GPU time of the scene [ms]
+ */
+
+void DynamicResolution::updateScale(double frameTimeMs){
+    if(frameTimeMs <= 0.0){
+        return;
+    }
+
+    const float desiredScale = this->scale * static_cast<float>(std::sqrt(this->targetFrameTimeMs / frameTimeMs));
+    const float clampedScale = std::clamp(desiredScale, this->minScale, this->maxScale);
+    const float newScale = this->scale + 0.25f * (clampedScale - this->scale);
+
+    if(std::abs(newScale - this->scale) > 0.01f || clampedScale == this->minScale || clampedScale == this->maxScale){
+        this->scale = std::clamp(newScale, this->minScale, this->maxScale);
+    }
+}
+
+/////////////////////////////////////////////////////////////////////////////////////
+/**
+ * @brief Upscale the offscreen image to the window with sharpening
+ */
+
+void DynamicResolution::present(){
+
+    // Back to the window
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glViewport(0, 0, this->windowWidth, this->windowHeight);
+    glDisable(GL_DEPTH_TEST);
+
+    this->upscaleShader.use();
+
+    // Only the rendered sub-rectangle of the texture is sampled
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, this->colorTexture);
+    glUniform1i(this->sceneTextureID, 0);
+    glUniform2f(this->uvScaleID,
+                static_cast<float>(this->renderWidth) / this->bufferWidth,
+                static_cast<float>(this->renderHeight) / this->bufferHeight);
+    glUniform2f(this->texelSizeID, 1.f / this->bufferWidth, 1.f / this->bufferHeight);
+
+    // Stronger sharpening when the image is more stretched
+    const float upscaleRatio = 1.f - this->scale;
+    glUniform1f(this->sharpnessID, std::clamp(0.2f + upscaleRatio, 0.f, 1.f));
+
+    // Fullscreen triangle
+    glBindVertexArray(this->emptyVao);
+    glDrawArrays(GL_TRIANGLES, 0, 3);
+    glBindVertexArray(0);
+
+    glEnable(GL_DEPTH_TEST);
+}
+
+/////////////////////////////////////////////////////////////////////////////////////
+/**
+ * @brief Get the current resolution scale (per axis)
+ * @return float
+ */
+
+float DynamicResolution::getScale() const{
+    return this->scale;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////
+/**
+ * @brief Get the last measured GPU time of the scene
+ * @return double the time in milliseconds
+ */
+
+double DynamicResolution::getSceneTimeMs() const{
+    return this->sceneTimer.getLastTimeMs();
+}
+
+/////////////////////////////////////////////////////////////////////////////////////
+/**
+ * @brief Get the width of the rendered sub-rectangle
+ * @return int the width in pixels
+ */
+
+int DynamicResolution::getRenderWidth() const{
+    return this->renderWidth;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////
+/**
+ * @brief Get the height of the rendered sub-rectangle
+ * @return int the height in pixels
+ */
+
+int DynamicResolution::getRenderHeight() const{
+    return this->renderHeight;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////
+/**
+ * @brief Delete the GL objects
+ */
+
+void DynamicResolution::deleteBuffers(){
+    if(this->fbo != 0){
+        glDeleteFramebuffers(1, &(this->fbo));
+        glDeleteTextures(1, &(this->colorTexture));
+        glDeleteRenderbuffers(1, &(this->depthRenderbuffer));
+        this->fbo = 0;
+    }
+    if(this->emptyVao != 0){
+        glDeleteVertexArrays(1, &(this->emptyVao));
+        this->emptyVao = 0;
+    }
+    this->sceneTimer.deleteQueries();
+}
+
+/////////////////////////////////////////////////////////////////////////////////////
+/**
+ * @brief Destructor
+ */
+
+DynamicResolution::~DynamicResolution(){}
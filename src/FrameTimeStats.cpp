@@ -0,0 +1,75 @@
+/**
+ * @author obiwan138
+ * @file FrameTimeStats.cpp
+ * @brief Implementation of the FrameTimeStats class
+ */
+
+#include "FrameTimeStats.hpp"
+
+#include <algorithm>
+#include <vector>
+
+/////////////////////////////////////////////////////////////////////////////////////
+/**
+ * @brief Constructor
+ */
+
+FrameTimeStats::FrameTimeStats(){
+    this->frameTimesMs.fill(0.f);
+    this->reset();
+}
+
+/////////////////////////////////////////////////////////////////////////////////////
+/**
+ * @brief Record the end of a frame
+ * @details The frame time is the time since the previous call
+ */
+
+void FrameTimeStats::frame(){
+    const std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+    if(this->started){
+        this->frameTimesMs[this->next] = std::chrono::duration<float, std::milli>(now - this->lastFrame).count();
+        this->next = (this->next + 1) % numFrames;
+        this->count = std::min(this->count + 1, numFrames);
+    }
+    this->lastFrame = now;
+    this->started = true;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////
+/**
+ * @brief Forget the recorded frames
+ */
+
+void FrameTimeStats::reset(){
+    this->count = 0;
+    this->next = 0;
+    this->started = false;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////
+/**
+ * @brief Get a percentile of the recorded frame times
+ * @param p : percentile between 0 and 100 (e.g. 50 for the median, 99 for the slowest 1%)
+ * @return float the frame time in milliseconds (0 if no frame was recorded)
+ */
+
+float FrameTimeStats::getPercentile(float p) const{
+    if(this->count == 0){
+        return 0.f;
+    }
+    std::vector<float> sorted(this->frameTimesMs.begin(), this->frameTimesMs.begin() + this->count);
+    const int rank = std::clamp(static_cast<int>(p / 100.f * (this->count - 1) + 0.5f), 0, this->count - 1);
+    std::nth_element(sorted.begin(), sorted.begin() + rank, sorted.end());
+    return sorted[rank];
+}
+
+/////////////////////////////////////////////////////////////////////////////////////
+/**
+ * @brief Get the number of recorded frames
+ * @return int
+ */
+
+int FrameTimeStats::getCount() const{
+    return this->count;
+}
@@ -93,7 +93,34 @@ GLBuffersID::GLBuffersID(RawVertexData vertexStruct){
     glEnableVertexAttribArray(2);
 
     /**
-     * VAO attribute 3 : index/element buffer (EBO)
+     * VAO attribute 3 : tangent vectors buffer (only for the meshes with tangents, used for normal mapping)
+     */
+    this->tangentVBO = 0;
+    if(!vertexStruct.tangents.empty()){
+        // Generate a buffer for the tangents
+        glGenBuffers(1, &(this->tangentVBO));
+        glBindBuffer(GL_ARRAY_BUFFER, this->tangentVBO);
+        glBufferData(GL_ARRAY_BUFFER, 
+                    vertexStruct.tangents.size() * sizeof(glm::vec4), 
+                    vertexStruct.tangents.data(), 
+                    GL_STATIC_DRAW);
+
+        // Allocate the required memory in the corresponding VAO attribute
+        glVertexAttribPointer(
+            3,                                // VAO attribute index is 3 (fourth)
+            4,                                // element size is 4 (glm::vec4, w is the bitangent sign)
+            GL_FLOAT,                         // type of the element
+            GL_FALSE,                         // normalized?
+            0,                                // stride
+            (void*)0                          // array buffer offset
+        );
+
+        // Enable the attribute 3 of VAO for the shader program
+        glEnableVertexAttribArray(3);
+    }
+
+    /**
+     * Index/element buffer (EBO)
      * This buffer has a different state "GL_ELEMENT_ARRAY_BUFFER" instead of GL_ARRAY_BUFFER
      * so it does not require to call glVertexAttribPointer and glEnableVertexAttribArray
      */
@@ -153,6 +180,10 @@ void GLBuffersID::deleteBuffers(){
         glDeleteBuffers(1, &(this->normalVBO));
         std::cout << "Deleted normal VBO"<< std::endl;
     }
+    if(this->tangentVBO != 0){
+        glDeleteBuffers(1, &(this->tangentVBO));
+        std::cout << "Deleted tangent VBO"<< std::endl;
+    }
     if(this->ebo != 0){
         glDeleteBuffers(1, &(this->ebo));
         std::cout << "Deleted EBO"<< std::endl;
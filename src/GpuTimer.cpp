@@ -0,0 +1,110 @@
+/**
+ * @author obiwan138
+ * @file GpuTimer.cpp
+ * @brief Implementation of the GpuTimer class
+ */
+
+#include "GpuTimer.hpp"
+
+/////////////////////////////////////////////////////////////////////////////////////
+/**
+ * @brief Constructor
+ * @details Generate the ring of timer queries
+ */
+
+GpuTimer::GpuTimer(){
+    glGenQueries(numQueries, this->startQueries.data());
+    glGenQueries(numQueries, this->endQueries.data());
+    this->pending.fill(false);
+    this->current = 0;
+    this->lastTimeMs = 0.0;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////
+/**
+ * @brief Start measuring
+ * @details If the next query of the ring is still in flight (more than numQueries measures per frame), its result is read first
+ */
+
+void GpuTimer::begin(){
+    if(this->pending[this->current]){
+        GLuint64 start = 0, end = 0;
+        glGetQueryObjectui64v(this->startQueries[this->current], GL_QUERY_RESULT, &start);
+        glGetQueryObjectui64v(this->endQueries[this->current], GL_QUERY_RESULT, &end);
+        this->lastTimeMs = static_cast<double>(end - start) * 1e-6;
+        this->pending[this->current] = false;
+    }
+    glQueryCounter(this->startQueries[this->current], GL_TIMESTAMP);
+}
+
+/////////////////////////////////////////////////////////////////////////////////////
+/**
+ * @brief Stop measuring
+ */
+
+void GpuTimer::end(){
+    glQueryCounter(this->endQueries[this->current], GL_TIMESTAMP);
+    this->pending[this->current] = true;
+    this->current = (this->current + 1) % numQueries;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////
+/**
+ * @brief Read the available results without blocking
+ * @details The queries are checked from the oldest to the newest one, so the last result read is the most recent one
+ * @return true if at least one new result was read
+ */
+
+bool GpuTimer::poll(){
+    bool updated = false;
+    for(int k=0; k<numQueries; k++){
+        int i = (this->current + k) % numQueries;
+        if(!this->pending[i]){
+            continue;
+        }
+
+        // Stop at the first result not available yet (the next ones are more recent)
+        GLint available = 0;
+        glGetQueryObjectiv(this->endQueries[i], GL_QUERY_RESULT_AVAILABLE, &available);
+        if(!available){
+            break;
+        }
+
+        GLuint64 start = 0, end = 0;
+        glGetQueryObjectui64v(this->startQueries[i], GL_QUERY_RESULT, &start);
+        glGetQueryObjectui64v(this->endQueries[i], GL_QUERY_RESULT, &end);
+        this->lastTimeMs = static_cast<double>(end - start) * 1e-6;
+        this->pending[i] = false;
+        updated = true;
+    }
+    return updated;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////
+/**
+ * @brief Get the last measured time
+ * @return double the GPU time in milliseconds
+ */
+
+double GpuTimer::getLastTimeMs() const{
+    return this->lastTimeMs;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////
+/**
+ * @brief Delete the queries
+ */
+
+void GpuTimer::deleteQueries(){
+    glDeleteQueries(numQueries, this->startQueries.data());
+    glDeleteQueries(numQueries, this->endQueries.data());
+    this->startQueries.fill(0);
+    this->endQueries.fill(0);
+}
+
+/////////////////////////////////////////////////////////////////////////////////////
+/**
+ * @brief Destructor
+ */
+
+GpuTimer::~GpuTimer(){}
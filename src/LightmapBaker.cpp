@@ -0,0 +1,313 @@
+/**
+ * @author obiwan138
+ * @file LightmapBaker.cpp
+ * @brief Implementation of the LightmapBaker class
+ */
+
+#include "LightmapBaker.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <fstream>
+#include <omp.h>
+
+#include "Ray.hpp"
+
+/////////////////////////////////////////////////////////////////////////////////////
+/**
+ * @brief Constructor
+ * @param resolutionIn : size of the lightmap [px], a multiple of 4 (BMP rows are not padded)
+ * @param lightPositionIn : position of the point light (world space)
+ * @param lightPowerIn : power of the point light
+ */
+
+LightmapBaker::LightmapBaker(int resolutionIn, const glm::vec3& lightPositionIn, float lightPowerIn){
+    this->resolution = resolutionIn;
+    this->lightPosition = lightPositionIn;
+    this->lightPower = lightPowerIn;
+    this->numAoSamples = 64;
+    this->aoDistance = 2.f;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////
+/**
+ * @brief Add a vertical capsule occluding the ambient light
+ * @param basePoint : lowest point of the capsule
+ * @param radius : radius of the capsule
+ * @param height : height of the capsule
+ */
+
+void LightmapBaker::addOccluder(const glm::vec3& basePoint, float radius, float height){
+    this->occluders.push_back({basePoint, radius, height});
+}
+
+/////////////////////////////////////////////////////////////////////////////////////
+/**
+ * @brief Get the size of the lightmap
+ * @return int [px]
+ */
+
+int LightmapBaker::getResolution() const{
+    return this->resolution;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////
+/**
+ * @brief Hash of everything the lightmap of a mesh depends on
+ * @details FNV-1a over the bake parameters, the light, the occluders and the mesh positions, normals, UVs and indices :
+ * a lightmap cached under this key is the one bake would return
+ * @param mesh : the vertex data of the mesh
+ * @return uint64_t
+ */
+
+uint64_t LightmapBaker::getCacheKey(const RawVertexData& mesh) const{
+    uint64_t key = 0xCBF29CE484222325ull;
+    auto hashBytes = [&key](const void* data, size_t size){
+        const unsigned char* bytes = static_cast<const unsigned char*>(data);
+        for(size_t i=0; i<size; i++){
+            key = (key ^ bytes[i]) * 0x100000001B3ull;
+        }
+    };
+
+    hashBytes(&this->resolution, sizeof(this->resolution));
+    hashBytes(&this->lightPosition, sizeof(this->lightPosition));
+    hashBytes(&this->lightPower, sizeof(this->lightPower));
+    hashBytes(&this->numAoSamples, sizeof(this->numAoSamples));
+    hashBytes(&this->aoDistance, sizeof(this->aoDistance));
+    for(const Occluder& occluder : this->occluders){
+        hashBytes(&occluder.basePoint, sizeof(occluder.basePoint));
+        hashBytes(&occluder.radius, sizeof(occluder.radius));
+        hashBytes(&occluder.height, sizeof(occluder.height));
+    }
+    hashBytes(mesh.verticies.data(), mesh.verticies.size() * sizeof(glm::vec3));
+    hashBytes(mesh.normals.data(), mesh.normals.size() * sizeof(glm::vec3));
+    hashBytes(mesh.uvs.data(), mesh.uvs.size() * sizeof(glm::vec2));
+    hashBytes(mesh.indices.data(), mesh.indices.size() * sizeof(unsigned short));
+    return key;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////
+/**
+ * @brief Bake the lightmap of a mesh
+ * @details 1. Rasterize the triangles in UV space (sequential, cheap) : each covered texel gets an interpolated position and normal
+ * 2. Light the covered texels in parallel (OpenMP) : direct diffuse term + ambient occlusion by hemisphere sampling
+ * 3. Dilate the result over the uncovered texels so that bilinear filtering does not bleed black on the UV seams
+ * @param mesh : the vertex data of the mesh (positions in world space)
+ * @return RawTextureData the lightmap in BGR order (ready for SceneManager::sendTextureToGPU)
+ */
+
+RawTextureData LightmapBaker::bake(const RawVertexData& mesh) const{
+
+    const int res = this->resolution;
+    const size_t numTexels = static_cast<size_t>(res) * res;
+
+    // Texel buffer
+    std::vector<glm::vec3> positions(numTexels);
+    std::vector<glm::vec3> normals(numTexels);
+    std::vector<uint8_t> covered(numTexels, 0);
+
+    /**
+     * 1. Rasterize the UV space
+     */
+    for(size_t f=0; f+2<mesh.indices.size(); f+=3){
+        const unsigned short i0 = mesh.indices[f], i1 = mesh.indices[f+1], i2 = mesh.indices[f+2];
+
+        // Triangle in texel space
+        const glm::vec2 t0 = mesh.uvs[i0] * static_cast<float>(res);
+        const glm::vec2 t1 = mesh.uvs[i1] * static_cast<float>(res);
+        const glm::vec2 t2 = mesh.uvs[i2] * static_cast<float>(res);
+
+        const float area = (t1.x - t0.x)*(t2.y - t0.y) - (t2.x - t0.x)*(t1.y - t0.y);
+        if(std::abs(area) < 1e-12f){
+            continue;
+        }
+
+        // Bounding box of the triangle, clamped to the texture
+        const int xMin = std::max(0, static_cast<int>(std::floor(std::min({t0.x, t1.x, t2.x}))));
+        const int xMax = std::min(res-1, static_cast<int>(std::ceil(std::max({t0.x, t1.x, t2.x}))));
+        const int yMin = std::max(0, static_cast<int>(std::floor(std::min({t0.y, t1.y, t2.y}))));
+        const int yMax = std::min(res-1, static_cast<int>(std::ceil(std::max({t0.y, t1.y, t2.y}))));
+
+        for(int y=yMin; y<=yMax; y++){
+            for(int x=xMin; x<=xMax; x++){
+
+                // Barycentric coordinates of the texel center
+                const glm::vec2 p(x + 0.5f, y + 0.5f);
+                const float w0 = ((t1.x - p.x)*(t2.y - p.y) - (t2.x - p.x)*(t1.y - p.y)) / area;
+                const float w1 = ((t2.x - p.x)*(t0.y - p.y) - (t0.x - p.x)*(t2.y - p.y)) / area;
+                const float w2 = 1.f - w0 - w1;
+                if(w0 < 0.f || w1 < 0.f || w2 < 0.f){
+                    continue;
+                }
+
+                const size_t idx = static_cast<size_t>(y) * res + x;
+                positions[idx] = w0*mesh.verticies[i0] + w1*mesh.verticies[i1] + w2*mesh.verticies[i2];
+                normals[idx] = glm::normalize(w0*mesh.normals[i0] + w1*mesh.normals[i1] + w2*mesh.normals[i2]);
+                covered[idx] = 1;
+            }
+        }
+    }
+
+    /**
+     * 2. Light the texels in parallel
+     */
+    std::vector<float> direct(numTexels, 0.f);
+    std::vector<float> occlusion(numTexels, 1.f);
+
+    // Cosine weighted hemisphere directions around +z (golden angle spiral), shared by all the texels
+    std::vector<glm::vec3> hemisphere(this->numAoSamples);
+    for(int s=0; s<this->numAoSamples; s++){
+        const float r = std::sqrt((s + 0.5f) / this->numAoSamples);
+        const float angle = 2.39996323f * s;
+        hemisphere[s] = glm::vec3(r * std::cos(angle), r * std::sin(angle), std::sqrt(1.f - r*r));
+    }
+
+    #pragma omp parallel for schedule(dynamic, 8)
+    for(int y=0; y<res; y++){
+        for(int x=0; x<res; x++){
+
+            const size_t idx = static_cast<size_t>(y) * res + x;
+            if(!covered[idx]){
+                continue;
+            }
+
+            const glm::vec3& p = positions[idx];
+            const glm::vec3& n = normals[idx];
+
+            // Direct diffuse term (same falloff as the fragment shader)
+            const glm::vec3 toLight = this->lightPosition - p;
+            const float distance2 = glm::dot(toLight, toLight);
+            const float cosTheta = std::max(glm::dot(n, toLight / std::sqrt(distance2)), 0.f);
+            direct[idx] = this->lightPower * cosTheta / distance2;
+
+            // Ambient occlusion : fraction of the hemisphere directions hitting an occluder nearby
+            if(!this->occluders.empty()){
+
+                // Tangent frame around the normal
+                const glm::vec3 helper = (std::abs(n.y) < 0.99f) ? glm::vec3(0, 1, 0) : glm::vec3(1, 0, 0);
+                const glm::vec3 tangent = glm::normalize(glm::cross(helper, n));
+                const glm::vec3 bitangent = glm::cross(n, tangent);
+
+                int occluded = 0;
+                for(const glm::vec3& h : hemisphere){
+                    Ray ray;
+                    ray.direction = h.x * tangent + h.y * bitangent + h.z * n;
+                    ray.origin = p + 1e-3f * n;
+
+                    for(const Occluder& occluder : this->occluders){
+                        float t;
+                        if(ray.intersectVerticalCapsule(occluder.basePoint, occluder.height, occluder.radius, t) && t < this->aoDistance){
+                            occluded++;
+                            break;
+                        }
+                    }
+                }
+                occlusion[idx] = 1.f - static_cast<float>(occluded) / this->numAoSamples;
+            }
+        }
+    }
+
+    /**
+     * 3. Dilate the covered texels over the uncovered ones
+     */
+    for(int pass=0; pass<4; pass++){
+        std::vector<uint8_t> coveredNext = covered;
+        for(int y=0; y<res; y++){
+            for(int x=0; x<res; x++){
+                const size_t idx = static_cast<size_t>(y) * res + x;
+                if(covered[idx]){
+                    continue;
+                }
+
+                // Average of the covered neighbours
+                float sumDirect = 0.f, sumOcclusion = 0.f;
+                int count = 0;
+                for(int dy=-1; dy<=1; dy++){
+                    for(int dx=-1; dx<=1; dx++){
+                        const int nx = x + dx, ny = y + dy;
+                        if(nx < 0 || ny < 0 || nx >= res || ny >= res){
+                            continue;
+                        }
+                        const size_t nIdx = static_cast<size_t>(ny) * res + nx;
+                        if(covered[nIdx]){
+                            sumDirect += direct[nIdx];
+                            sumOcclusion += occlusion[nIdx];
+                            count++;
+                        }
+                    }
+                }
+                if(count > 0){
+                    direct[idx] = sumDirect / count;
+                    occlusion[idx] = sumOcclusion / count;
+                    coveredNext[idx] = 1;
+                }
+            }
+        }
+        covered.swap(coveredNext);
+    }
+
+    // Pack into a BGR texture
+    RawTextureData lightmap;
+    lightmap.width = res;
+    lightmap.height = res;
+    lightmap.data.resize(3 * numTexels);
+    for(size_t idx=0; idx<numTexels; idx++){
+        lightmap.data[3*idx + 0] = 0;
+        lightmap.data[3*idx + 1] = static_cast<unsigned char>(std::clamp(occlusion[idx], 0.f, 1.f) * 255.f + 0.5f);
+        lightmap.data[3*idx + 2] = static_cast<unsigned char>(std::clamp(direct[idx], 0.f, 1.f) * 255.f + 0.5f);
+    }
+    return lightmap;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////
+/**
+ * @brief Save a baked lightmap as a 24-bit BMP file (the format read by SceneManager::readTextureData)
+ * @param filePath : the path of the file to write
+ * @param lightmap : the lightmap to save (BGR, rows not padded)
+ * @return true if the file is written, false otherwise
+ */
+
+bool LightmapBaker::save(const std::string& filePath, const RawTextureData& lightmap){
+
+    std::ofstream file(filePath, std::ios::binary);
+    if(!file){
+        return false;
+    }
+
+    // Little endian writers for the header fields
+    auto write16 = [&file](uint16_t value){ file.put(static_cast<char>(value & 0xFF)); file.put(static_cast<char>(value >> 8)); };
+    auto write32 = [&file](uint32_t value){ for(int i=0; i<4; i++) file.put(static_cast<char>((value >> (8*i)) & 0xFF)); };
+
+    const uint32_t imageSize = static_cast<uint32_t>(lightmap.data.size());
+
+    // File header (14 bytes)
+    file.put('B'); file.put('M');
+    write32(54 + imageSize);    // File size
+    write32(0);                 // Reserved
+    write32(54);                // Offset of the pixel data
+
+    // Info header (40 bytes)
+    write32(40);                // Header size
+    write32(lightmap.width);
+    write32(lightmap.height);
+    write16(1);                 // Planes
+    write16(24);                // Bits per pixel
+    write32(0);                 // No compression
+    write32(imageSize);
+    write32(2835);              // Horizontal resolution (72 DPI)
+    write32(2835);              // Vertical resolution
+    write32(0);                 // Colors in the palette
+    write32(0);                 // Important colors
+
+    // Pixel data
+    file.write(reinterpret_cast<const char*>(lightmap.data.data()), imageSize);
+    return static_cast<bool>(file);
+}
+
+/////////////////////////////////////////////////////////////////////////////////////
+/**
+ * @brief Destructor
+ */
+
+LightmapBaker::~LightmapBaker(){}
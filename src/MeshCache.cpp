@@ -0,0 +1,131 @@
+/**
+ * @author obiwan138
+ * @file MeshCache.cpp
+ * @brief Implementation of the MeshCache class
+ */
+
+#include "MeshCache.hpp"
+
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <system_error>
+
+// Header of the cache files
+namespace {
+    const char meshCacheMagic[4] = {'C', '3', 'D', 'M'};
+    const uint32_t meshCacheVersion = 2;
+
+    struct MeshCacheHeader
+    {
+        char magic[4];
+        uint32_t version;
+        uint32_t numVertices;
+        uint32_t numIndices;
+        uint32_t hasTangents;
+        uint32_t padding;
+        uint64_t sourceSize;        // Size of the source file [bytes]
+        int64_t sourceTime;         // Last write time of the source file (clock ticks of the file system)
+    };
+
+    // Size and last write time of the source file, false if it cannot be read
+    bool getSourceStamp(const std::string& sourcePath, uint64_t& size, int64_t& time){
+        std::error_code error;
+        size = static_cast<uint64_t>(std::filesystem::file_size(sourcePath, error));
+        if(error){
+            return false;
+        }
+        time = static_cast<int64_t>(std::filesystem::last_write_time(sourcePath, error).time_since_epoch().count());
+        return !error;
+    }
+}
+
+/////////////////////////////////////////////////////////////////////////////////////
+/**
+ * @brief Load a processed mesh from a cache file
+ * @param filePath : the path to the cache file
+ * @param sourcePath : the path to the file the mesh was imported from
+ * @param vertexStruct : the output mesh
+ * @return true if the cache file exists, is valid and was made from the current source file, false otherwise
+ */
+
+bool MeshCache::load(const std::string& filePath, const std::string& sourcePath, RawVertexData& vertexStruct){
+
+    uint64_t sourceSize;
+    int64_t sourceTime;
+    if(!getSourceStamp(sourcePath, sourceSize, sourceTime)){
+        return false;
+    }
+
+    std::ifstream file(filePath, std::ios::binary);
+    if(!file){
+        return false;
+    }
+
+    // Check the header
+    MeshCacheHeader header;
+    if(!file.read(reinterpret_cast<char*>(&header), sizeof(header))
+       || std::memcmp(header.magic, meshCacheMagic, sizeof(meshCacheMagic)) != 0
+       || header.version != meshCacheVersion){
+        return false;
+    }
+
+    // The source file changed since the cache was written
+    if(header.sourceSize != sourceSize || header.sourceTime != sourceTime){
+        return false;
+    }
+
+    // Read the arrays
+    vertexStruct.verticies.resize(header.numVertices);
+    vertexStruct.uvs.resize(header.numVertices);
+    vertexStruct.normals.resize(header.numVertices);
+    vertexStruct.tangents.resize(header.hasTangents ? header.numVertices : 0);
+    vertexStruct.indices.resize(header.numIndices);
+
+    file.read(reinterpret_cast<char*>(vertexStruct.verticies.data()), vertexStruct.verticies.size() * sizeof(glm::vec3));
+    file.read(reinterpret_cast<char*>(vertexStruct.uvs.data()), vertexStruct.uvs.size() * sizeof(glm::vec2));
+    file.read(reinterpret_cast<char*>(vertexStruct.normals.data()), vertexStruct.normals.size() * sizeof(glm::vec3));
+    file.read(reinterpret_cast<char*>(vertexStruct.tangents.data()), vertexStruct.tangents.size() * sizeof(glm::vec4));
+    file.read(reinterpret_cast<char*>(vertexStruct.indices.data()), vertexStruct.indices.size() * sizeof(unsigned short));
+
+    vertexStruct.numIndices = static_cast<int>(header.numIndices);
+    return static_cast<bool>(file);
+}
+
+/////////////////////////////////////////////////////////////////////////////////////
+/**
+ * @brief Save a processed mesh to a cache file
+ * @param filePath : the path to the cache file
+ * @param sourcePath : the path to the file the mesh was imported from (its size and time are stored)
+ * @param vertexStruct : the mesh to save
+ * @return true if the file is written, false otherwise
+ */
+
+bool MeshCache::save(const std::string& filePath, const std::string& sourcePath, const RawVertexData& vertexStruct){
+
+    MeshCacheHeader header = {};
+    if(!getSourceStamp(sourcePath, header.sourceSize, header.sourceTime)){
+        return false;
+    }
+
+    std::ofstream file(filePath, std::ios::binary);
+    if(!file){
+        return false;
+    }
+
+    std::memcpy(header.magic, meshCacheMagic, sizeof(meshCacheMagic));
+    header.version = meshCacheVersion;
+    header.numVertices = static_cast<uint32_t>(vertexStruct.verticies.size());
+    header.numIndices = static_cast<uint32_t>(vertexStruct.indices.size());
+    header.hasTangents = vertexStruct.tangents.empty() ? 0 : 1;
+
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char*>(vertexStruct.verticies.data()), vertexStruct.verticies.size() * sizeof(glm::vec3));
+    file.write(reinterpret_cast<const char*>(vertexStruct.uvs.data()), vertexStruct.uvs.size() * sizeof(glm::vec2));
+    file.write(reinterpret_cast<const char*>(vertexStruct.normals.data()), vertexStruct.normals.size() * sizeof(glm::vec3));
+    file.write(reinterpret_cast<const char*>(vertexStruct.tangents.data()), vertexStruct.tangents.size() * sizeof(glm::vec4));
+    file.write(reinterpret_cast<const char*>(vertexStruct.indices.data()), vertexStruct.indices.size() * sizeof(unsigned short));
+
+    return static_cast<bool>(file);
+}
@@ -0,0 +1,110 @@
+/**
+ * @author obiwan138
+ * @file Ray.cpp
+ * @brief Implementation of the analytic ray intersection tests
+ */
+
+#include "Ray.hpp"
+
+#include <cmath>
+#include <initializer_list>
+
+/////////////////////////////////////////////////////////////////////////////////////
+/**
+ * @brief Intersect the ray with the horizontal plane y = height
+ * @param height : height of the plane
+ * @param t : output distance along the ray to the intersection point
+ * @return true if the plane is hit in front of the origin, false otherwise
+ */
+
+bool Ray::intersectHorizontalPlane(const float height, float& t) const{
+
+    // A ray parallel to the plane never hits it
+    if(std::abs(this->direction.y) < 1e-6f){
+        return false;
+    }
+
+    // Solve origin.y + t * direction.y = height
+    t = (height - this->origin.y) / this->direction.y;
+    return t >= 0.f;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////
+/**
+ * @brief Intersect the ray with a vertical capsule
+ * @details The capsule is the set of points within "radius" of the vertical segment [basePoint + radius, basePoint + height - radius].
+ * The test is done analytically : first against the infinite cylinder around the segment, then against the two end spheres.
+ * @param basePoint : lowest point of the capsule
+ * @param height : total height of the capsule (must be >= 2 * radius)
+ * @param radius : radius of the capsule
+ * @param t : output distance along the ray to the closest intersection point
+ * @return true if the capsule is hit in front of the origin, false otherwise
+ */
+
+bool Ray::intersectVerticalCapsule(const glm::vec3& basePoint, const float height, const float radius, float& t) const{
+
+    // Segment end points (centers of the two end spheres)
+    const float bottomY = basePoint.y + radius;
+    const float topY = basePoint.y + glm::max(height - radius, radius);
+
+    // Work in the horizontal plane relatively to the capsule axis
+    const float ox = this->origin.x - basePoint.x;
+    const float oz = this->origin.z - basePoint.z;
+    const float dx = this->direction.x;
+    const float dz = this->direction.z;
+
+    // Infinite cylinder : |(o + t*d)_xz|^2 = r^2
+    const float a = dx*dx + dz*dz;
+    const float b = ox*dx + oz*dz;
+    const float c = ox*ox + oz*oz - radius*radius;
+
+    if(a > 1e-12f){
+        const float delta = b*b - a*c;
+
+        // The ray misses the infinite cylinder, so it misses the capsule
+        if(delta < 0.f){
+            return false;
+        }
+
+        // The entry point is on the cylinder body if its height is between both end spheres
+        const float tCylinder = (-b - std::sqrt(delta)) / a;
+        const float y = this->origin.y + tCylinder * this->direction.y;
+        if(tCylinder >= 0.f && y >= bottomY && y <= topY){
+            t = tCylinder;
+            return true;
+        }
+    }
+    else if(c > 0.f){
+        // Vertical ray outside the cylinder
+        return false;
+    }
+
+    // Otherwise the closest hit (if any) is on one of the end spheres
+    bool hit = false;
+    for(const float sphereY : {bottomY, topY}){
+        const glm::vec3 oc = this->origin - glm::vec3(basePoint.x, sphereY, basePoint.z);
+        const float bs = glm::dot(oc, this->direction);
+        const float cs = glm::dot(oc, oc) - radius*radius;
+        const float deltaSphere = bs*bs - cs;
+
+        if(deltaSphere >= 0.f){
+            const float tSphere = -bs - std::sqrt(deltaSphere);
+            if(tSphere >= 0.f && (!hit || tSphere < t)){
+                t = tSphere;
+                hit = true;
+            }
+        }
+    }
+    return hit;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////
+/**
+ * @brief Get the point located at the distance t along the ray
+ * @param t : distance along the ray
+ * @return glm::vec3 the corresponding point
+ */
+
+glm::vec3 Ray::pointAt(const float t) const{
+    return this->origin + t * this->direction;
+}
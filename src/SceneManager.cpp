@@ -9,15 +9,26 @@
 #include <stdexcept>
 #include <vector>
 #include <map>
+#include <array>
 #include <utility>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <filesystem>
 #include <omp.h> 
 
+// Include SFML (image decoding)
+#include <SFML/Graphics/Image.hpp>
+
 // Include AssImp
 #include <assimp/Importer.hpp>      // C++ importer interface
 #include <assimp/scene.h>           // Output data structure
 #include <assimp/postprocess.h>     // Post processing flags
 
 #include "SceneManager.hpp"
+#include "LightmapBaker.hpp"
+#include "MeshCache.hpp"
+#include "TangentGenerator.hpp"
 
 //////////////////////////////////////////////////////////////////////////////////////
 /**
@@ -26,7 +37,12 @@
  * @note The constructor is private to ensure that the SceneManager is a singleton class
  */
 
-SceneManager::SceneManager(){
+SceneManager::SceneManager()
+    :depthShader("shaders/shadowVertexShader.glsl", "shaders/shadowFragmentShader.glsl"),
+     shadowMap(2048),
+     lightmapTexture(0),
+     boardShader("shaders/vertexShader.glsl", "shaders/boardFragmentShader.glsl"),
+     boardNormalMapShader("shaders/boardVertexShader.glsl", "shaders/boardNormalMapFragmentShader.glsl"){
 
     // Load the meshes
     std::cout << "Loading meshes and GL buffers ..." << std::endl;
@@ -66,8 +82,14 @@ SceneManager::SceneManager(){
         std::cerr << "Error while loading the textures. Check the correspond file and path" << std::endl;
     };
 
+    // The bump image of the board is converted into a normal map
+    if(!this->loadNormalMap(TextureTypes::BOARD_NORMAL, "../resources/Stone_Chess_Board/Stone_chessboard_bump_image.bmp.jpg", 4.f)){
+        std::cerr << "Error while loading the board normal map, the board is rendered without normal mapping" << std::endl;
+    };
+
     // Create chessboard
     this->chessboard = Chessboard(this->getVaoID(MeshTypes::BOARD), this->getTextureID(TextureTypes::BOARD), this->objectBuffers.at(MeshTypes::BOARD).getNumIndices());
+    this->chessboard.initGrid();
 
     // Create the set of chess pieces
     for(const auto& pair : texturePaths)
@@ -80,6 +102,10 @@ SceneManager::SceneManager(){
 
             // Create the ChessObject
             this->chessPieces.insert(std::make_pair(textureType, ChessPiece(meshType, this->getTeam(textureType), this->getVaoID(meshType), getTextureID(textureType), this->objectBuffers.at(meshType).getNumIndices())));
+
+            // Give it the bounding capsule of its mesh for picking
+            const glm::vec3& bounds = this->pieceBounds.at(meshType);
+            this->chessPieces.at(textureType).setBoundingCapsule(bounds.x, bounds.y, bounds.z);
         }
         
     }
@@ -108,12 +134,55 @@ SceneManager& SceneManager::getInstance(){
 /////////////////////////////////////////////////////////////////////////////////////
 /**
  * @brief Load the chess board
- * @details This function uses the Assimp library to load the RawVertexData structure of the chess board and create the RawVertexData attribute of the SceneManager class
+ * @details The processed board mesh (centered, with its tangent frames for normal mapping) is read from the mesh cache if it exists
+ * and the .obj file did not change since. Otherwise it is imported with Assimp, processed and saved to the cache for the next runs.
  * @param filePath : the path to the file containing the chess board
  * @return true if the loading is successful, false otherwise
  */
 
 bool SceneManager::loadBoard(const std::string& filePath){
+
+    // Create a new RawVertexData object
+    RawVertexData vertexStruct;
+
+    // Try the mesh cache first
+    const std::string cachePath = filePath + ".cache";
+    if(MeshCache::load(cachePath, filePath, vertexStruct)){
+        std::cout << "Board mesh loaded from " << cachePath << std::endl;
+    }
+    else{
+        // Import and process the mesh
+        if(!this->importBoard(filePath, vertexStruct)){
+            return false;
+        }
+        TangentGenerator::generate(vertexStruct);
+
+        // Save it for the next runs
+        if(!MeshCache::save(cachePath, filePath, vertexStruct)){
+            std::cerr << "Error: could not save the board mesh cache to " << cachePath << std::endl;
+        }
+    }
+
+    // Build the openGL buffers from the RawVertexData structure
+    this->objectBuffers.emplace(MeshTypes::BOARD, GLBuffersID(vertexStruct));
+
+    // Keep a CPU copy of the board mesh for the lightmap baker
+    this->boardVertexData = vertexStruct;
+    
+    // If we end up here, the loading step is sucessful
+    return true;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////
+/**
+ * @brief Import the chess board
+ * @details This function uses the Assimp library to load the RawVertexData structure of the chess board, centered on the origin of the horizontal plane
+ * @param filePath : the path to the file containing the chess board
+ * @param vertexStruct : the output vertex data
+ * @return true if the import is successful, false otherwise
+ */
+
+bool SceneManager::importBoard(const std::string& filePath, RawVertexData& vertexStruct){
     
     // Load the file using AssImp
 	Assimp::Importer importer;
@@ -126,9 +195,6 @@ bool SceneManager::loadBoard(const std::string& filePath){
 		return false;
 	}
 
-    // Create a new RawVertexData object
-    RawVertexData vertexStruct;
-    
     // Get the main (and only) mesh
     const aiMesh* mesh = scene->mMeshes[0];
         
@@ -179,11 +245,8 @@ bool SceneManager::loadBoard(const std::string& filePath){
         vertex -= center;
     }
 
-    // Build the openGL buffers from the RawVertexData structure
-    this->objectBuffers.emplace(MeshTypes::BOARD, GLBuffersID(vertexStruct));
-    
     // The "scene" pointer will be deleted automatically by "importer"   
-    // If we end up here, the loading step is sucessful
+    // If we end up here, the import step is sucessful
     return true;
 }
 
@@ -282,11 +345,22 @@ bool SceneManager::loadPieces(const std::string& filePath){
             vertex -= center;
         }
 
+        // Compute the bounding capsule (vertical axis through the origin) used for picking
+        float radius = 0.f;
+        float bottom = vertexStruct.verticies.empty() ? 0.f : vertexStruct.verticies[0].y;
+        float top = bottom;
+        for(const auto& vertex : vertexStruct.verticies){
+            radius = std::max(radius, std::sqrt(vertex.x*vertex.x + vertex.z*vertex.z));
+            bottom = std::min(bottom, vertex.y);
+            top = std::max(top, vertex.y);
+        }
+
         // Save the mesh data in a thread-safe manner
         #pragma omp critical
         {
             // Add the mesh data to the map
             meshData.emplace(meshIdx[i].first, vertexStruct);
+            this->pieceBounds.emplace(meshIdx[i].first, glm::vec3(radius, bottom, top));
         }
     }
     // The "scene" pointer will be deleted automatically by "importer"   
@@ -400,6 +474,161 @@ GLuint SceneManager::sendTextureToGPU(const RawTextureData& textureData) {
     return textureID;
 }
 
+/////////////////////////////////////////////////////////////////////////////////////
+/**
+ * @brief Load the board lightmap
+ * @details The board mesh and the light are static, so their lighting is computed once : the lightmap is read from the cache file,
+ * or baked on the CPU (OpenMP) and saved on the first run. The ambient occlusion is computed from the pieces at their start positions.
+ * The name of the cache file holds the hash of the bake parameters, the light, the occluders and the mesh
+ * (<cachePath without extension>-<key>.bmp), so moving the light or changing the board bakes a new lightmap.
+ * An unreadable or truncated cache file is baked again.
+ * 
+ * @param cachePath : the path to the lightmap cache file (24-bit BMP), before the key is added to its name
+ * @param lightPosition : the position of the static light (world space)
+ * 
+ * @return true if the lightmap is loaded, false otherwise
+ */
+bool SceneManager::loadLightmap(const std::string& cachePath, const glm::vec3& lightPosition){
+
+    // Occluders : every piece at its start position
+    const std::array<MeshTypes, 8> backRank = {
+        MeshTypes::ROOK, MeshTypes::KNIGHT, MeshTypes::BISHOP, MeshTypes::QUEEN,
+        MeshTypes::KING, MeshTypes::BISHOP, MeshTypes::KNIGHT, MeshTypes::ROOK
+    };
+    LightmapBaker baker(512, lightPosition, 50.f);
+    for(int col=0; col<8; col++){
+        for(const auto& rowType : {std::make_pair(0, backRank[col]), std::make_pair(1, MeshTypes::PAWN),
+                                   std::make_pair(6, MeshTypes::PAWN), std::make_pair(7, backRank[col])}){
+            const glm::vec3& bounds = this->pieceBounds.at(rowType.second);
+            glm::vec3 basePoint = this->chessboard.grid[rowType.first][col].getPosition();
+            basePoint.y += bounds.y;
+            baker.addOccluder(basePoint, bounds.x, bounds.z - bounds.y);
+        }
+    }
+
+    // Cache file of these parameters
+    char keyText[32];
+    std::snprintf(keyText, sizeof(keyText), "-%016llx", static_cast<unsigned long long>(baker.getCacheKey(this->boardVertexData)));
+    std::filesystem::path cacheFilePath(cachePath);
+    cacheFilePath.replace_filename(cacheFilePath.stem().string() + keyText + cacheFilePath.extension().string());
+    const std::string keyedPath = cacheFilePath.string();
+
+    // Try the cache first
+    RawTextureData lightmap;
+    std::ifstream cacheFile(keyedPath, std::ios::binary);
+    if(cacheFile){
+        cacheFile.close();
+        try{
+            lightmap = this->readTextureData(keyedPath);
+        }
+        catch(const std::exception& e){
+            std::cerr << "Warning: cannot read the lightmap " << keyedPath << " (" << e.what() << "), it is baked again" << std::endl;
+            lightmap = RawTextureData();
+        }
+        const uint32_t resolution = static_cast<uint32_t>(baker.getResolution());
+        if(lightmap.width == resolution && lightmap.height == resolution && lightmap.data.size() >= static_cast<size_t>(resolution) * resolution * 3){
+            std::cout << "Lightmap loaded from " << keyedPath << std::endl;
+        }
+        else{
+            lightmap = RawTextureData();
+        }
+    }
+
+    if(lightmap.data.empty()){
+        std::cout << "Baking the board lightmap ..." << std::endl;
+        double startTime = omp_get_wtime();
+
+        lightmap = baker.bake(this->boardVertexData);
+        std::cout << "Lightmap baked in " << omp_get_wtime() - startTime << " s" << std::endl;
+
+        if(!LightmapBaker::save(keyedPath, lightmap)){
+            std::cerr << "Error: could not save the lightmap to " << keyedPath << std::endl;
+        }
+    }
+
+    // Send it to the GPU
+    this->lightmapTexture = this->sendTextureToGPU(lightmap);
+    return this->lightmapTexture != 0;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////
+/**
+ * @brief Convert a bump (height) image into a tangent space normal map
+ * @details The image is decoded with SFML (the bump image is a JPEG file), its luminance is used as height.
+ * The normal of each texel is computed from the Sobel gradients of the height (rows processed in parallel with OpenMP).
+ * The rows are flipped so that the first row is the bottom one, as in the BMP textures.
+ * 
+ * @param filePath : the path to the bump image
+ * @param strength : scale of the height gradients (higher = bumpier)
+ * 
+ * @return RawTextureData The normal map, in BGR order (x in red, y in green, z in blue)
+ */
+RawTextureData SceneManager::readBumpAsNormalMap(const std::string& filePath, float strength){
+
+    // Decode the image
+    sf::Image image;
+    if(!image.loadFromFile(filePath)){
+        throw std::runtime_error("Could not open file: " + filePath);
+    }
+    const int width = static_cast<int>(image.getSize().x);
+    const int height = static_cast<int>(image.getSize().y);
+    const sf::Uint8* pixels = image.getPixelsPtr();
+
+    // Height of a texel (bottom-up rows, clamped at the borders)
+    auto heightAt = [&](int x, int y) -> float {
+        x = std::min(std::max(x, 0), width - 1);
+        y = std::min(std::max(y, 0), height - 1);
+        const sf::Uint8* p = pixels + 4 * (static_cast<size_t>(height - 1 - y) * width + x);
+        return (0.299f * p[0] + 0.587f * p[1] + 0.114f * p[2]) / 255.f;
+    };
+
+    RawTextureData textureData;
+    textureData.width = width;
+    textureData.height = height;
+    textureData.data.resize(3 * static_cast<size_t>(width) * height);
+
+    #pragma omp parallel for
+    for(int y=0; y<height; y++){
+        for(int x=0; x<width; x++){
+
+            // Sobel gradients
+            float dx = (heightAt(x+1, y-1) + 2.f*heightAt(x+1, y) + heightAt(x+1, y+1))
+                     - (heightAt(x-1, y-1) + 2.f*heightAt(x-1, y) + heightAt(x-1, y+1));
+            float dy = (heightAt(x-1, y+1) + 2.f*heightAt(x, y+1) + heightAt(x+1, y+1))
+                     - (heightAt(x-1, y-1) + 2.f*heightAt(x, y-1) + heightAt(x+1, y-1));
+
+            glm::vec3 n = glm::normalize(glm::vec3(-strength * dx, -strength * dy, 1.f));
+
+            // Encode [-1,1] to [0,255], BGR order
+            unsigned char* out = textureData.data.data() + 3 * (static_cast<size_t>(y) * width + x);
+            out[0] = static_cast<unsigned char>((n.z * 0.5f + 0.5f) * 255.f + 0.5f);
+            out[1] = static_cast<unsigned char>((n.y * 0.5f + 0.5f) * 255.f + 0.5f);
+            out[2] = static_cast<unsigned char>((n.x * 0.5f + 0.5f) * 255.f + 0.5f);
+        }
+    }
+
+    return textureData;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////
+/**
+ * @brief Load a bump image as a normal map texture
+ * @param name : the texture type to register the normal map with
+ * @param filePath : the path to the bump image
+ * @param strength : scale of the height gradients
+ * @return true if the loading is successful, false otherwise
+ */
+bool SceneManager::loadNormalMap(TextureTypes name, const std::string& filePath, float strength){
+    try{
+        this->textures.emplace(name, this->sendTextureToGPU(this->readBumpAsNormalMap(filePath, strength)));
+    }
+    catch(const std::exception& e){
+        std::cerr << e.what() << std::endl;
+        return false;
+    }
+    return true;
+}
+
 ///////////////////////////////////////////////////////////////////////////////////////
 
 /**
@@ -450,31 +679,151 @@ bool SceneManager::loadTextures(const std::vector<std::pair<TextureTypes, std::s
 void SceneManager::setUpBoard(){
 
     // Allow the setup if it is not already done
-    if(this->chessboard.getSetUpState()){
-        // Place the pawns
-        for(int i=0; i<8; i++){
-            // White pawns on row 1 (from 0)
-            this->chessboard.grid[1][i].setPiece(&(this->chessPieces[TextureTypes::WHITE_PAWN]));
-            // Black pawns on row 6 (from 0)
-            this->chessboard.grid[6][i].setPiece(&(this->chessPieces[TextureTypes::BLACK_PAWN]));
-        }
+    if(!this->chessboard.getSetUpState()){
 
-        // Now the board is set up
-        this->chessboard.setSetUpState();
+        // Place the pieces of the initial position
+        engine::Position startPosition;
+        startPosition.setFromFen(engine::Position::startFen);
+        this->syncPosition(startPosition);
     }
     
 }
 
+/////////////////////////////////////////////////////////////////////////////////////
+/**
+ * @brief Update the chessboard grid squares which differ from a position
+ * @details One-way sync : the game logic only works on engine::Position, the grid is a view of it. Only the squares whose
+ * content changed since the last sync are touched (2 to 4 squares after a move), so the render objects are never scanned.
+ * @param position : the position to display
+ * @return int the number of updated squares
+ */
+int SceneManager::syncPosition(const engine::Position& position){
+
+    int updated = 0;
+    engine::Bitboard changed = this->displayedPosition.diff(position);
+    while(changed){
+        engine::Square square = engine::popLsb(changed);
+        engine::Piece piece = position.getPieceOn(square);
+
+        // The grid rows are the ranks and the columns are the files, as for the engine squares
+        Square& gridSquare = this->chessboard.grid[engine::rankOf(square)][engine::fileOf(square)];
+        gridSquare.setPiece(piece == engine::NO_PIECE ? nullptr : &(this->chessPieces.at(this->getTextureType(piece))));
+        updated++;
+    }
+
+    this->displayedPosition = position;
+    this->chessboard.setSetUpState();
+
+    return updated;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////
+/**
+ * @brief Find the square under a picking ray
+ * @param ray : the picking ray in world space (see ViewController::computePickingRay)
+ * @param row : output row index of the picked square
+ * @param col : output column index of the picked square
+ * @return true if a square is under the ray, false otherwise
+ */
+bool SceneManager::pickSquare(const Ray& ray, int& row, int& col) const{
+    return this->chessboard.pick(ray, row, col);
+}
+
+/////////////////////////////////////////////////////////////////////////////////////
+/**
+ * @brief Get the notation of a square of the board
+ * @param row : row index of the square
+ * @param col : column index of the square
+ * @return std::string the notation of the square (like "e4")
+ */
+std::string SceneManager::getSquareNotation(int row, int col) const{
+    return this->chessboard.grid[row][col].getNotation();
+}
 
 /////////////////////////////////////////////////////////////////////////////////////
 /**
  * @brief Render the scene
- * @details This function renders the scene by calling the render function of the chessboard
+ * @details This function renders the scene by calling the render function of the chessboard.
+ * The shadow map is rendered again only when the pieces layout or the light moved, otherwise the cached one is sampled.
+ * Both passes are timed separately with GPU timer queries.
  * @param shaderPtr : Pointer to the shader to use
  * @param viewController+tr : Pointer to the view controller to use
  */
 void SceneManager::render(Shader* shaderPtr, ViewController* viewControllerPtr){
-    this->chessboard.render(shaderPtr, viewControllerPtr);
+
+    // Update the cached shadow map if needed
+    uint64_t layoutSignature = this->chessboard.getLayoutSignature();
+    if(this->shadowMap.needsUpdate(shaderPtr->getLightPosition(), layoutSignature)){
+        this->shadowMap.beginUpdate(shaderPtr->getLightPosition(), layoutSignature);
+        this->chessboard.renderDepth(&(this->depthShader), this->shadowMap.getLightViewProjection());
+        this->shadowMap.endUpdate();
+    }
+    this->shadowMap.pollUpdateTime();
+
+    // Main pass, sampling the shadow map on the texture unit 1 (unit 0 is the object texture)
+    this->mainPassTimer.begin();
+
+    // Board : cheap shader sampling the baked lightmap on the texture unit 2, and the normal map on the unit 3 if available
+    if(this->lightmapTexture != 0 && this->textures.count(TextureTypes::BOARD_NORMAL) != 0){
+        this->boardNormalMapShader.use();
+        this->shadowMap.bind(&(this->boardNormalMapShader), GL_TEXTURE1);
+        glActiveTexture(GL_TEXTURE2);
+        glBindTexture(GL_TEXTURE_2D, this->lightmapTexture);
+        glUniform1i(this->boardNormalMapShader.getLightmapID(), 2);
+        glActiveTexture(GL_TEXTURE3);
+        glBindTexture(GL_TEXTURE_2D, this->textures.at(TextureTypes::BOARD_NORMAL));
+        glUniform1i(this->boardNormalMapShader.getNormalMapID(), 3);
+        this->chessboard.renderBoard(&(this->boardNormalMapShader), viewControllerPtr);
+    }
+    else if(this->lightmapTexture != 0){
+        this->boardShader.use();
+        this->shadowMap.bind(&(this->boardShader), GL_TEXTURE1);
+        glActiveTexture(GL_TEXTURE2);
+        glBindTexture(GL_TEXTURE_2D, this->lightmapTexture);
+        glUniform1i(this->boardShader.getLightmapID(), 2);
+        this->chessboard.renderBoard(&(this->boardShader), viewControllerPtr);
+    }
+    else{
+        shaderPtr->use();
+        this->shadowMap.bind(shaderPtr, GL_TEXTURE1);
+        this->chessboard.renderBoard(shaderPtr, viewControllerPtr);
+    }
+
+    // Pieces : dynamic lighting
+    shaderPtr->use();
+    this->shadowMap.bind(shaderPtr, GL_TEXTURE1);
+    this->chessboard.renderPieces(shaderPtr, viewControllerPtr);
+
+    this->mainPassTimer.end();
+    this->mainPassTimer.poll();
+}
+
+/////////////////////////////////////////////////////////////////////////////////////
+/**
+ * @brief Get the GPU time of the main pass
+ * @return double the time in milliseconds (1 to 2 frames late)
+ */
+double SceneManager::getMainPassTimeMs() const{
+    return this->mainPassTimer.getLastTimeMs();
+}
+
+/////////////////////////////////////////////////////////////////////////////////////
+/**
+ * @brief Get the GPU time of the last shadow map update
+ * @return double the time in milliseconds
+ */
+double SceneManager::getShadowUpdateTimeMs() const{
+    return this->shadowMap.getLastUpdateTimeMs();
+}
+
+/////////////////////////////////////////////////////////////////////////////////////
+/**
+ * @brief Get the number of shadow map updates
+ * @return unsigned int
+ */
+unsigned int SceneManager::getShadowUpdateCount() const{
+    return this->shadowMap.getUpdateCount();
 }
 
 /////////////////////////////////////////////////////////////////////////////////////
@@ -506,6 +855,9 @@ const GLuint SceneManager::getTextureID(const TextureTypes& name) const{
         case TextureTypes::BOARD:
             return static_cast<const GLuint>(this->textures.at(TextureTypes::BOARD));
             break;
+        case TextureTypes::BOARD_NORMAL:
+            return static_cast<const GLuint>(this->textures.at(TextureTypes::BOARD_NORMAL));
+            break;
         case TextureTypes::WHITE_PAWN:
             return static_cast<const GLuint>(this->textures.at(TextureTypes::WHITE_PAWN));
             break;
@@ -617,6 +969,33 @@ const Team SceneManager::getTeam(const TextureTypes& texture) const
     }
 }
 
+/////////////////////////////////////////////////////////////////////////////////////
+/**
+ * @brief Get the texture type of an engine piece
+ * @param piece : the engine piece
+ * @return TextureTypes the texture (and thus the ChessPiece) used to draw it, NONE for engine::NO_PIECE
+ */
+
+const TextureTypes SceneManager::getTextureType(const engine::Piece& piece) const
+{
+    switch (piece) 
+    {
+        case engine::W_PAWN:   return TextureTypes::WHITE_PAWN;
+        case engine::W_KNIGHT: return TextureTypes::WHITE_KNIGHT;
+        case engine::W_BISHOP: return TextureTypes::WHITE_BISHOP;
+        case engine::W_ROOK:   return TextureTypes::WHITE_ROOK;
+        case engine::W_QUEEN:  return TextureTypes::WHITE_QUEEN;
+        case engine::W_KING:   return TextureTypes::WHITE_KING;
+        case engine::B_PAWN:   return TextureTypes::BLACK_PAWN;
+        case engine::B_KNIGHT: return TextureTypes::BLACK_KNIGHT;
+        case engine::B_BISHOP: return TextureTypes::BLACK_BISHOP;
+        case engine::B_ROOK:   return TextureTypes::BLACK_ROOK;
+        case engine::B_QUEEN:  return TextureTypes::BLACK_QUEEN;
+        case engine::B_KING:   return TextureTypes::BLACK_KING;
+        default:               return TextureTypes::NONE;
+    }
+}
+
 /////////////////////////////////////////////////////////////////////////////////////
 
 /**
@@ -638,6 +1017,15 @@ SceneManager::~SceneManager(){
         std::cout << "Deleted black texures"<< std::endl;
     }
 
+    // Delete the lightmap
+    if(this->lightmapTexture != 0){
+        glDeleteTextures(1, &(this->lightmapTexture));
+    }
+
+    // Delete the shadow map and the timer queries
+    this->shadowMap.deleteBuffers();
+    this->mainPassTimer.deleteQueries();
+
     // Delete the GL buffers for each object (vbos, ebo, vao)
     for(auto it=this->objectBuffers.begin(); it!=this->objectBuffers.end(); it++){
         it->second.deleteBuffers();
@@ -25,6 +25,10 @@ Shader::Shader(const char* vertexPath, const char* fragmentPath) {
     this->mvpMatrixID = glGetUniformLocation(this->getID(), "MVP");
     this->textureID = glGetUniformLocation(this->getID(), "ShaderTexture");
     this->lightID = glGetUniformLocation(this->getID(), "LightPosition_worldspace");
+    this->depthBiasVPID = glGetUniformLocation(this->getID(), "DepthBiasVP");
+    this->shadowMapID = glGetUniformLocation(this->getID(), "ShadowMap");
+    this->lightmapID = glGetUniformLocation(this->getID(), "Lightmap");
+    this->normalMapID = glGetUniformLocation(this->getID(), "NormalMap");
     
     // Set the light's position
     this->lightPosition = glm::vec3(0,15,0);
@@ -219,4 +223,49 @@ GLuint Shader::getLightID() const{
  */
 glm::vec3 Shader::getLightPosition() const{
     return this->lightPosition;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////
+/**
+ * @brief Set Light position vector
+ * @param position : the new light position (world space)
+ */
+void Shader::setLightPosition(const glm::vec3& position){
+    this->lightPosition = position;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////
+/**
+ * @brief Get the ID of the shader light view-projection (with bias) uniform variable
+ * @return GLuint
+ */
+GLuint Shader::getDepthBiasVPID() const{
+    return this->depthBiasVPID;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////
+/**
+ * @brief Get the ID of the shader shadow map uniform variable
+ * @return GLuint
+ */
+GLuint Shader::getShadowMapID() const{
+    return this->shadowMapID;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////
+/**
+ * @brief Get the ID of the shader lightmap uniform variable
+ * @return GLuint
+ */
+GLuint Shader::getLightmapID() const{
+    return this->lightmapID;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////
+/**
+ * @brief Get the ID of the shader normal map uniform variable
+ * @return GLuint
+ */
+GLuint Shader::getNormalMapID() const{
+    return this->normalMapID;
 }
\ No newline at end of file
@@ -0,0 +1,221 @@
+/**
+ * @author obiwan138
+ * @file ShadowMap.cpp
+ * @brief Implementation of the ShadowMap class
+ */
+
+#include "ShadowMap.hpp"
+
+#include <cmath>
+#include <iostream>
+#include <glm/gtc/matrix_transform.hpp>
+
+/////////////////////////////////////////////////////////////////////////////////////
+/**
+ * @brief Constructor
+ * @details Create the depth texture (with hardware depth comparison enabled for sampler2DShadow) and its framebuffer
+ * @param resolutionIn : size of the depth texture [px]
+ */
+
+ShadowMap::ShadowMap(int resolutionIn){
+
+    this->resolution = resolutionIn;
+
+    // Depth texture
+    glGenTextures(1, &(this->depthTexture));
+    glBindTexture(GL_TEXTURE_2D, this->depthTexture);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT24, this->resolution, this->resolution, 0, GL_DEPTH_COMPONENT, GL_FLOAT, nullptr);
+
+    // Linear filtering + comparison mode gives a 2x2 hardware PCF for each shader tap
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_COMPARE_MODE, GL_COMPARE_REF_TO_TEXTURE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_COMPARE_FUNC, GL_LEQUAL);
+
+    // Framebuffer with only a depth attachment
+    glGenFramebuffers(1, &(this->fbo));
+    glBindFramebuffer(GL_FRAMEBUFFER, this->fbo);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, this->depthTexture, 0);
+    glDrawBuffer(GL_NONE);
+    glReadBuffer(GL_NONE);
+
+    if(glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE){
+        std::cerr << "Error: the shadow map framebuffer is not complete" << std::endl;
+    }
+
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+    // Nothing is cached yet
+    this->savedFramebuffer = 0;
+    this->lightViewProjection = glm::mat4(1.0f);
+    this->valid = false;
+    this->cachedLightPosition = glm::vec3(0.f);
+    this->cachedLayout = 0;
+    this->updateCount = 0;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////
+/**
+ * @brief Is an update required
+ * @param lightPosition : the current light position
+ * @param layoutSignature : the current pieces layout signature (see Chessboard::getLayoutSignature)
+ * @return true if the cached depth texture is out of date
+ */
+
+bool ShadowMap::needsUpdate(const glm::vec3& lightPosition, uint64_t layoutSignature) const{
+    return !this->valid
+        || lightPosition != this->cachedLightPosition
+        || layoutSignature != this->cachedLayout;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////
+/**
+ * @brief Bind the depth framebuffer and prepare the depth pass
+ * @details The light is a point light above the board, so a perspective projection looking at the board center is used.
+ * The depth pass is timed separately from the main pass.
+ * @param lightPosition : the current light position
+ * @param layoutSignature : the current pieces layout signature
+ */
+
+void ShadowMap::beginUpdate(const glm::vec3& lightPosition, uint64_t layoutSignature){
+
+    // Light matrices : look at the board center, with an up vector never parallel to the view direction
+    glm::vec3 target(0.f, 0.f, 0.f);
+    glm::vec3 up = (std::abs(glm::normalize(target - lightPosition).y) > 0.99f) ? glm::vec3(0, 0, -1) : glm::vec3(0, 1, 0);
+    glm::mat4 lightView = glm::lookAt(lightPosition, target, up);
+    glm::mat4 lightProjection = glm::perspective(glm::radians(60.f), 1.f, 1.f, 2.f * glm::length(lightPosition) + 10.f);
+    this->lightViewProjection = lightProjection * lightView;
+
+    // Start timing the update
+    this->updateTimer.begin();
+
+    // Render into the depth texture
+    glGetIntegerv(GL_VIEWPORT, this->savedViewport);
+    glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &(this->savedFramebuffer));
+    glBindFramebuffer(GL_FRAMEBUFFER, this->fbo);
+    glViewport(0, 0, this->resolution, this->resolution);
+    glClear(GL_DEPTH_BUFFER_BIT);
+
+    // Slope scaled bias against shadow acne
+    glEnable(GL_POLYGON_OFFSET_FILL);
+    glPolygonOffset(2.f, 4.f);
+
+    // Save the cache state
+    this->cachedLightPosition = lightPosition;
+    this->cachedLayout = layoutSignature;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////
+/**
+ * @brief Restore the previous framebuffer (default or offscreen) and the viewport
+ */
+
+void ShadowMap::endUpdate(){
+    glDisable(GL_POLYGON_OFFSET_FILL);
+    glBindFramebuffer(GL_FRAMEBUFFER, static_cast<GLuint>(this->savedFramebuffer));
+    glViewport(this->savedViewport[0], this->savedViewport[1], this->savedViewport[2], this->savedViewport[3]);
+
+    this->updateTimer.end();
+    this->valid = true;
+    this->updateCount++;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////
+/**
+ * @brief Force an update on the next frame
+ */
+
+void ShadowMap::invalidate(){
+    this->valid = false;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////
+/**
+ * @brief Bind the depth texture and send the light matrix to a shader
+ * @details The bias matrix maps the light clip space [-1,1] to the texture space [0,1]
+ * @param shaderPtr : the shader sampling the shadow map (must be in use)
+ * @param textureUnit : the texture unit to use (GL_TEXTURE1, ...)
+ */
+
+void ShadowMap::bind(Shader* shaderPtr, GLenum textureUnit) const{
+
+    glm::mat4 biasMatrix(
+        0.5f, 0.0f, 0.0f, 0.0f,
+        0.0f, 0.5f, 0.0f, 0.0f,
+        0.0f, 0.0f, 0.5f, 0.0f,
+        0.5f, 0.5f, 0.5f, 1.0f
+    );
+    glm::mat4 depthBiasVP = biasMatrix * this->lightViewProjection;
+
+    glUniformMatrix4fv(shaderPtr->getDepthBiasVPID(), 1, GL_FALSE, &depthBiasVP[0][0]);
+
+    glActiveTexture(textureUnit);
+    glBindTexture(GL_TEXTURE_2D, this->depthTexture);
+    glUniform1i(shaderPtr->getShadowMapID(), static_cast<GLint>(textureUnit - GL_TEXTURE0));
+}
+
+/////////////////////////////////////////////////////////////////////////////////////
+/**
+ * @brief Get the light view-projection matrix
+ * @return glm::mat4
+ */
+
+glm::mat4 ShadowMap::getLightViewProjection() const{
+    return this->lightViewProjection;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////
+/**
+ * @brief Poll the GPU timer of the updates
+ * @return true if a new update time is available
+ */
+
+bool ShadowMap::pollUpdateTime(){
+    return this->updateTimer.poll();
+}
+
+/////////////////////////////////////////////////////////////////////////////////////
+/**
+ * @brief Get the GPU time of the last update
+ * @return double the time in milliseconds
+ */
+
+double ShadowMap::getLastUpdateTimeMs() const{
+    return this->updateTimer.getLastTimeMs();
+}
+
+/////////////////////////////////////////////////////////////////////////////////////
+/**
+ * @brief Get the number of updates
+ * @return unsigned int
+ */
+
+unsigned int ShadowMap::getUpdateCount() const{
+    return this->updateCount;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////
+/**
+ * @brief Delete the GL objects
+ */
+
+void ShadowMap::deleteBuffers(){
+    if(this->fbo != 0){
+        glDeleteFramebuffers(1, &(this->fbo));
+        this->fbo = 0;
+    }
+    if(this->depthTexture != 0){
+        glDeleteTextures(1, &(this->depthTexture));
+        this->depthTexture = 0;
+    }
+    this->updateTimer.deleteQueries();
+}
+
+/////////////////////////////////////////////////////////////////////////////////////
+/**
+ * @brief Destructor
+ */
+
+ShadowMap::~ShadowMap(){}
@@ -37,14 +37,28 @@ bool Square::isOccupied() const{
 ///////////////////////////////////////////////////////////////////
 /**
  * @brief render piece
+ * @note The same ChessPiece is shared by all the squares holding this kind of piece, so it is moved on the square before being drawn
  */
 
 void Square::renderPiece(Shader* shaderPtr, ViewController* viewControllerPtr){
     if(this->isOccupied()){
+        this->piecePtr->setPosition(this->position);
         this->piecePtr->render(shaderPtr, viewControllerPtr);
     }
 }
 
+///////////////////////////////////////////////////////////////////
+/**
+ * @brief render piece into a depth buffer seen from the light
+ */
+
+void Square::renderPieceDepth(Shader* depthShaderPtr, const glm::mat4& lightViewProjection){
+    if(this->isOccupied()){
+        this->piecePtr->setPosition(this->position);
+        this->piecePtr->renderDepth(depthShaderPtr, lightViewProjection);
+    }
+}
+
 ///////////////////////////////////////////////////////////////////
 /**
  * @brief Get the notation of the square
@@ -63,6 +77,15 @@ glm::vec3 Square::getPosition() const {
     return this->position;
 }
 
+///////////////////////////////////////////////////////////////////
+/**
+ * @brief Get the piece at this square
+ * @return A pointer to the piece (nullptr if the square is empty)
+ */
+ChessPiece* Square::getPiece() const {
+    return this->piecePtr;
+}
+
 ///////////////////////////////////////////////////////////////////
 /**
  * @brief Set notation
@@ -0,0 +1,133 @@
+/**
+ * @author obiwan138
+ * @file TangentGenerator.cpp
+ * @brief Implementation of the TangentGenerator class
+ */
+
+#include "TangentGenerator.hpp"
+
+#include <cmath>
+#include <cstdint>
+
+/////////////////////////////////////////////////////////////////////////////////////
+/**
+ * @brief Fill the tangents vector of a mesh
+ * @details 1. For each triangle, solve the tangent (dP/du) and bitangent (dP/dv) from the position and UV edges, the
+ * handedness of the triangle being the sign of its UV area
+ * 2. Split the vertices shared by triangles of both handedness (mirrored UVs) : the triangles of negative handedness get
+ * a copy of the vertex, so the two frames are not averaged together
+ * 3. At each corner, project the triangle tangent on the plane of the vertex normal, normalize it and accumulate it
+ * weighted by the corner angle (as MikkTSpace does, so the result depends neither on the size of the triangles nor on
+ * the triangulation)
+ * 4. Normalize the sums and store the handedness of the frame in w
+ * @param vertexStruct : the mesh, its tangents vector is overwritten (and vertices may be added)
+ */
+
+void TangentGenerator::generate(RawVertexData& vertexStruct){
+
+    /**
+     * 1. Per triangle tangents and handedness
+     */
+    const size_t numFaces = vertexStruct.indices.size() / 3;
+    std::vector<glm::vec3> faceTangents(numFaces, glm::vec3(0.f));
+    std::vector<glm::vec3> faceBitangents(numFaces, glm::vec3(0.f));
+    std::vector<int> faceSigns(numFaces, 0);     // 0 : degenerated UV mapping, no information from this triangle
+
+    for(size_t f=0; f<numFaces; f++){
+        const unsigned short* idx = &vertexStruct.indices[3 * f];
+
+        // Edges in object and texture space
+        const glm::vec3 e1 = vertexStruct.verticies[idx[1]] - vertexStruct.verticies[idx[0]];
+        const glm::vec3 e2 = vertexStruct.verticies[idx[2]] - vertexStruct.verticies[idx[0]];
+        const glm::vec2 d1 = vertexStruct.uvs[idx[1]] - vertexStruct.uvs[idx[0]];
+        const glm::vec2 d2 = vertexStruct.uvs[idx[2]] - vertexStruct.uvs[idx[0]];
+
+        const float det = d1.x * d2.y - d2.x * d1.y;
+        if(std::abs(det) < 1e-12f){
+            continue;
+        }
+        const float invDet = 1.f / det;
+        faceTangents[f] = (e1 * d2.y - e2 * d1.y) * invDet;
+        faceBitangents[f] = (e2 * d1.x - e1 * d2.x) * invDet;
+        faceSigns[f] = (det > 0.f) ? 1 : -1;
+    }
+
+    /**
+     * 2. Split of the vertices with both handedness
+     */
+    const size_t numVertices = vertexStruct.verticies.size();
+    std::vector<uint8_t> vertexSigns(numVertices, 0);      // Bit 0 : positive triangles, bit 1 : negative ones
+    for(size_t f=0; f<numFaces; f++){
+        for(int corner=0; corner<3 && faceSigns[f] != 0; corner++){
+            vertexSigns[vertexStruct.indices[3 * f + corner]] |= (faceSigns[f] > 0) ? 1 : 2;
+        }
+    }
+
+    // Copy of each mixed vertex, if the 16-bit indices can address it
+    std::vector<unsigned short> mirrors(numVertices, 0);
+    for(size_t i=0; i<numVertices; i++){
+        if(vertexSigns[i] == 3 && vertexStruct.verticies.size() < 65536){
+            mirrors[i] = static_cast<unsigned short>(vertexStruct.verticies.size());
+            vertexStruct.verticies.push_back(vertexStruct.verticies[i]);
+            vertexStruct.uvs.push_back(vertexStruct.uvs[i]);
+            vertexStruct.normals.push_back(vertexStruct.normals[i]);
+        }
+    }
+    for(size_t f=0; f<numFaces; f++){
+        for(int corner=0; corner<3 && faceSigns[f] < 0; corner++){
+            unsigned short& index = vertexStruct.indices[3 * f + corner];
+            if(mirrors[index] != 0){
+                index = mirrors[index];
+            }
+        }
+    }
+
+    /**
+     * 3. Normalized corner tangents, accumulated on the vertices
+     */
+    const size_t numSplitVertices = vertexStruct.verticies.size();
+    std::vector<glm::vec3> tangentSums(numSplitVertices, glm::vec3(0.f));
+    std::vector<glm::vec3> bitangentSums(numSplitVertices, glm::vec3(0.f));
+
+    for(size_t f=0; f<numFaces; f++){
+        if(faceSigns[f] == 0){
+            continue;
+        }
+        const unsigned short* idx = &vertexStruct.indices[3 * f];
+        for(int corner=0; corner<3; corner++){
+            const glm::vec3& p = vertexStruct.verticies[idx[corner]];
+            const glm::vec3 a = vertexStruct.verticies[idx[(corner+1)%3]] - p;
+            const glm::vec3 b = vertexStruct.verticies[idx[(corner+2)%3]] - p;
+            const float lengths = glm::length(a) * glm::length(b);
+            const glm::vec3& n = vertexStruct.normals[idx[corner]];
+            const glm::vec3 t = faceTangents[f] - n * glm::dot(n, faceTangents[f]);
+            if(lengths < 1e-12f || glm::dot(t, t) < 1e-12f){
+                continue;
+            }
+            const float angle = std::acos(glm::clamp(glm::dot(a, b) / lengths, -1.f, 1.f));
+            tangentSums[idx[corner]] += angle * glm::normalize(t);
+            bitangentSums[idx[corner]] += angle * glm::normalize(faceBitangents[f]);
+        }
+    }
+
+    /**
+     * 4. Normalization and handedness
+     */
+    vertexStruct.tangents.resize(numSplitVertices);
+    for(size_t i=0; i<numSplitVertices; i++){
+        const glm::vec3& n = vertexStruct.normals[i];
+
+        // The sums are already orthogonal to the normal
+        glm::vec3 t = tangentSums[i];
+        if(glm::dot(t, t) < 1e-12f){
+            // No usable UV derivative : any vector orthogonal to the normal
+            const glm::vec3 helper = (std::abs(n.x) < 0.9f) ? glm::vec3(1, 0, 0) : glm::vec3(0, 1, 0);
+            t = glm::cross(helper, n);
+        }
+        t = glm::normalize(t);
+
+        // Handedness : is the accumulated bitangent on the side of cross(n, t)
+        const float sign = (glm::dot(glm::cross(n, t), bitangentSums[i]) < 0.f) ? -1.f : 1.f;
+        vertexStruct.tangents[i] = glm::vec4(t, sign);
+    }
+}
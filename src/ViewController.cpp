@@ -29,6 +29,9 @@ ViewController::ViewController(){
 
     // Compute the projection matrix : 45 deg Field of View, 4:3 ratio, display range : 0.1 unit <-> 100 units
 	this->projectionMatrix = glm::perspective(glm::radians(this->fov), 4.0f / 3.0f, 0.1f, 100.0f);
+
+	// Cache the inverse view-projection matrix for picking
+	this->inverseViewProjectionMatrix = glm::inverse(this->projectionMatrix * this->viewMatrix);
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -56,6 +59,9 @@ ViewController::ViewController(const float radius, const float elevationDegrees,
 
     // Compute the projection matrix : 45 deg Field of View, 4:3 ratio, display range : 0.1 unit <-> 100 units
 	this->projectionMatrix = glm::perspective(glm::radians(this->fov), 4.0f / 3.0f, 0.1f, 100.0f);
+
+	// Cache the inverse view-projection matrix for picking
+	this->inverseViewProjectionMatrix = glm::inverse(this->projectionMatrix * this->viewMatrix);
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -116,6 +122,9 @@ void ViewController::updateMatrices()
 		glm::vec3(0,0,0),           // and looks here : origin
 		glm::vec3(0,1,0)            // Head is up (set to 0,-1,0 to look upside-down)
 	);
+
+	// Cache the inverse view-projection matrix for picking
+	this->inverseViewProjectionMatrix = glm::inverse(this->projectionMatrix * this->viewMatrix);
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -155,6 +164,34 @@ glm::mat4 ViewController::getViewMatrix() const
 	return this->viewMatrix;
 }
 
+///////////////////////////////////////////////////////////////////////////////
+/**
+ * @brief Cast a ray from the camera through the mouse cursor
+ * @details The cursor is converted to normalized device coordinates, then the points on the near and far planes
+ * are unprojected with the cached inverse view-projection matrix. This avoids any GPU readback.
+ * @param mousePosition : cursor position relative to the window (pixels, origin at the top-left corner)
+ * @param windowSize : size of the window (pixels)
+ * @return Ray the picking ray in world space
+ */
+Ray ViewController::computePickingRay(const sf::Vector2i& mousePosition, const sf::Vector2u& windowSize) const
+{
+	// Cursor in normalized device coordinates (y axis points up in NDC)
+	float xNdc = 2.f * static_cast<float>(mousePosition.x) / static_cast<float>(windowSize.x) - 1.f;
+	float yNdc = 1.f - 2.f * static_cast<float>(mousePosition.y) / static_cast<float>(windowSize.y);
+
+	// Unproject the points on the near and far planes
+	glm::vec4 nearPoint = this->inverseViewProjectionMatrix * glm::vec4(xNdc, yNdc, -1.f, 1.f);
+	glm::vec4 farPoint = this->inverseViewProjectionMatrix * glm::vec4(xNdc, yNdc, 1.f, 1.f);
+	nearPoint /= nearPoint.w;
+	farPoint /= farPoint.w;
+
+	// Build the ray
+	Ray ray;
+	ray.origin = glm::vec3(nearPoint);
+	ray.direction = glm::normalize(glm::vec3(farPoint) - glm::vec3(nearPoint));
+	return ray;
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 /**
  * @brief Destructor
@@ -0,0 +1,195 @@
+/**
+ * @author obiwan138
+ * @file AnalysisWorker.cpp
+ * @brief Implementation of the AnalysisWorker class
+ */
+
+#include "engine/AnalysisWorker.hpp"
+
+#include <algorithm>
+#include <chrono>
+
+#include "engine/GameState.hpp"
+
+#if defined(__linux__)
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace engine{
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Constructor
+     * @param tt : transposition table used by the searches
+     * @param threadCount : number of search threads
+     */
+
+    AnalysisWorker::AnalysisWorker(TranspositionTable& tt, int threadCount)
+        :search(tt, threadCount){
+        this->lastId = 0;
+        this->thread = std::thread(&AnalysisWorker::loop, this);
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Post a command
+     * @details The stop flag is raised before the command is pushed : a running search returns and the worker finds the
+     * command. A search started just before the flag is raised sees the queued command after its first iteration.
+     * @param type : kind of command
+     * @param position : position to search
+     * @param moveTimeMs : time budget (THINK only)
+     * @return uint32_t the identifier of the request (0 if the queue is full)
+     */
+
+    uint32_t AnalysisWorker::post(AnalysisCommand::Type type, const Position& position, int64_t moveTimeMs){
+        AnalysisCommand command;
+        command.type = type;
+        command.id = ++(this->lastId);
+        command.moveTimeMs = moveTimeMs;
+        command.position = position;
+
+        this->search.stop();
+        return this->commands.push(command) ? command.id : 0;
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Analyze a position until another command
+     * @param position : position to analyze
+     * @return uint32_t the identifier of the request
+     */
+
+    uint32_t AnalysisWorker::analyze(const Position& position){
+        return this->post(AnalysisCommand::ANALYZE, position, 0);
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Search the best move of a position for a given time
+     * @param position : position to search
+     * @param moveTimeMs : time budget [ms]
+     * @return uint32_t the identifier of the request, its final update holds the move
+     */
+
+    uint32_t AnalysisWorker::think(const Position& position, int64_t moveTimeMs){
+        return this->post(AnalysisCommand::THINK, position, moveTimeMs);
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Stop the running search
+     */
+
+    void AnalysisWorker::stop(){
+        this->post(AnalysisCommand::STOP, Position(), 0);
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Get the next update
+     * @param update : output update
+     * @return bool false if there is none
+     */
+
+    bool AnalysisWorker::poll(AnalysisUpdate& update){
+        return this->updates.pop(update);
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Push a search update for the render thread
+     * @param id : identifier of the request
+     * @param final : is it the last update of the request
+     * @param result : search result
+     */
+
+    void AnalysisWorker::publish(uint32_t id, bool final, const SearchResult& result){
+        AnalysisUpdate update;
+        update.id = id;
+        update.final = final;
+        update.bestMove = result.bestMove;
+        update.score = result.score;
+        update.depth = result.depth;
+        update.nodes = result.nodes;
+        update.nps = result.nps;
+        update.ebf = result.ebf;
+        update.pvLength = std::min(static_cast<int>(result.pv.size()), AnalysisUpdate::MAX_PV);
+        std::copy(result.pv.begin(), result.pv.begin() + update.pvLength, update.pv);
+        this->updates.push(update);
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Worker thread : wait for the commands and run the searches
+     * @details The thread sleeps 1 ms when it has nothing to do. Its priority is lowered so that the render thread keeps
+     * its frame rate when the search threads use all the cores (the OpenMP threads it creates inherit the priority).
+     */
+
+    void AnalysisWorker::loop(){
+#if defined(__linux__)
+        setpriority(PRIO_PROCESS, static_cast<id_t>(syscall(SYS_gettid)), 10);
+#endif
+
+        GameState state;
+        while(true){
+            AnalysisCommand command;
+            if(!this->commands.pop(command)){
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                continue;
+            }
+
+            // Only the latest command matters (but a quit is never skipped)
+            AnalysisCommand next;
+            while(command.type != AnalysisCommand::QUIT && this->commands.pop(next)){
+                command = next;
+            }
+
+            if(command.type == AnalysisCommand::QUIT){
+                return;
+            }
+            if(command.type == AnalysisCommand::STOP){
+                continue;
+            }
+
+            state.setPosition(command.position);
+            SearchLimits limits;
+            if(command.type == AnalysisCommand::ANALYZE){
+                limits.infinite = true;
+            }
+            else{
+                limits.moveTimeMs = command.moveTimeMs;
+            }
+
+            const SearchResult result = this->search.run(state, limits, [&](const SearchResult& iteration){
+                this->publish(command.id, false, iteration);
+
+                // A command posted while the search was starting
+                if(!this->commands.empty()){
+                    this->search.stop();
+                }
+            });
+            this->publish(command.id, true, result);
+        }
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Destructor
+     */
+
+    AnalysisWorker::~AnalysisWorker(){
+        AnalysisCommand command;
+        command.type = AnalysisCommand::QUIT;
+        command.id = 0;
+        command.moveTimeMs = 0;
+
+        // The queue can only be full for a few milliseconds (the worker drains it)
+        this->search.stop();
+        while(!this->commands.push(command)){
+            std::this_thread::yield();
+        }
+        this->thread.join();
+    }
+}
@@ -0,0 +1,282 @@
+/**
+ * @author obiwan138
+ * @file Attacks.cpp
+ * @brief Initialization of the attack tables
+ */
+
+#include "engine/Attacks.hpp"
+
+#include <cstdlib>
+#include <initializer_list>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <cpuid.h>
+#elif defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace engine{
+
+    Bitboard pawnAttackTable[COLOR_NB][SQUARE_NB];
+    Bitboard knightAttackTable[SQUARE_NB];
+    Bitboard kingAttackTable[SQUARE_NB];
+    Bitboard betweenTable[SQUARE_NB][SQUARE_NB];
+    Bitboard lineTable[SQUARE_NB][SQUARE_NB];
+    Magic rookMagics[SQUARE_NB];
+    Magic bishopMagics[SQUARE_NB];
+    bool pextEnabled = false;
+
+    namespace{
+
+        // Slider attack storage (number of occupancy subsets of all the masks)
+        Bitboard rookTable[0x19000];
+        Bitboard bishopTable[0x1480];
+
+        const int rookDirections[4][2] = {{1, 0}, {-1, 0}, {0, 1}, {0, -1}};
+        const int bishopDirections[4][2] = {{1, 1}, {1, -1}, {-1, 1}, {-1, -1}};
+
+        /////////////////////////////////////////////////////////////////////////////////
+        /**
+         * @brief Square reached by a (file, rank) step, if it is on the board
+         */
+
+        bool offsetSquare(Square s, int df, int dr, Square& result){
+            int file = fileOf(s) + df;
+            int rank = rankOf(s) + dr;
+            if(file < 0 || file > 7 || rank < 0 || rank > 7){
+                return false;
+            }
+            result = makeSquare(file, rank);
+            return true;
+        }
+
+        /////////////////////////////////////////////////////////////////////////////////
+        /**
+         * @brief Slow ray walk, used to fill the tables
+         */
+
+        Bitboard slidingAttacks(const int directions[4][2], Square s, Bitboard occupied){
+            Bitboard result = 0;
+            for(int d = 0; d < 4; d++){
+                Square current = s;
+                Square next;
+                while(offsetSquare(current, directions[d][0], directions[d][1], next)){
+                    result |= squareBB(next);
+                    if(occupied & squareBB(next)){
+                        break;
+                    }
+                    current = next;
+                }
+            }
+            return result;
+        }
+
+        /////////////////////////////////////////////////////////////////////////////////
+        /**
+         * @brief Pseudo random generator (xorshift64*) for the magic search
+         */
+
+        class Prng
+        {
+            private :
+                uint64_t state;
+
+            public :
+                explicit Prng(uint64_t seed):state(seed){}
+
+                uint64_t next(){
+                    this->state ^= this->state >> 12;
+                    this->state ^= this->state << 25;
+                    this->state ^= this->state >> 27;
+                    return this->state * 2685821657736338717ull;
+                }
+
+                // Numbers with few bits set make better magic candidates
+                uint64_t sparse(){
+                    return this->next() & this->next() & this->next();
+                }
+        };
+
+        // Seeds of the magic search (one per rank), chosen to find the magics quickly
+        const uint64_t magicSeeds[8] = {728, 10316, 55013, 32803, 12281, 15100, 16645, 255};
+
+        /////////////////////////////////////////////////////////////////////////////////
+        /**
+         * @brief Fill the slider tables of one piece type
+         * @details The occupancy subsets of each mask are enumerated with the Carry-Rippler trick. With PEXT the index is
+         * the extracted occupancy, otherwise a magic multiplier without destructive collisions is searched (a few ms).
+         */
+
+        void initMagics(const int directions[4][2], Bitboard table[], Magic magics[]){
+
+            static Bitboard occupancy[4096], reference[4096];
+            static int epoch[4096];
+            int attempt = 0;
+            int size = 0;
+
+            for(int sq = A1; sq <= H8; sq++){
+                Square s = static_cast<Square>(sq);
+
+                // The edges do not change the attacks, unless the slider stands on them
+                Bitboard edges = ((RANK_1_BB | RANK_8_BB) & ~(RANK_1_BB << (8 * rankOf(s))))
+                               | ((FILE_A_BB | FILE_H_BB) & ~(FILE_A_BB << fileOf(s)));
+
+                Magic& m = magics[s];
+                m.mask = slidingAttacks(directions, s, 0) & ~edges;
+                m.shift = 64 - popCount(m.mask);
+                m.attacks = (s == A1) ? table : magics[s - 1].attacks + size;
+                m.magic = 0;
+
+                // Enumerate the subsets of the mask
+                size = 0;
+                Bitboard b = 0;
+                do{
+                    occupancy[size] = b;
+                    reference[size] = slidingAttacks(directions, s, b);
+                    if(pextEnabled){
+                        m.attacks[pext(b, m.mask)] = reference[size];
+                    }
+                    size++;
+                    b = (b - m.mask) & m.mask;
+                }while(b);
+
+                if(pextEnabled){
+                    continue;
+                }
+
+                // Search a magic mapping every subset to a slot holding its attacks
+                Prng rng(magicSeeds[rankOf(s)]);
+                for(int i = 0; i < size; ){
+                    m.magic = 0;
+                    while(popCount((m.magic * m.mask) >> 56) < 6){
+                        m.magic = rng.sparse();
+                    }
+
+                    // Epochs avoid clearing the table between two attempts
+                    attempt++;
+                    for(i = 0; i < size; i++){
+                        unsigned index = magicIndex(m, occupancy[i]);
+                        if(epoch[index] < attempt){
+                            epoch[index] = attempt;
+                            m.attacks[index] = reference[i];
+                        }
+                        else if(m.attacks[index] != reference[i]){
+                            break;
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Does the CPU support BMI2 (and PEXT at full speed)
+     * @details AMD CPUs before Zen 3 (family 0x19) implement PEXT in microcode, much slower than the magic multiplication
+     * @return true if PEXT should be used
+     */
+
+    bool cpuHasBmi2(){
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+        unsigned eax, ebx, ecx, edx;
+        if(__get_cpuid_max(0, nullptr) < 7){
+            return false;
+        }
+        __cpuid_count(7, 0, eax, ebx, ecx, edx);
+        if(!(ebx & (1u << 8))){
+            return false;
+        }
+
+        // Vendor "AuthenticAMD" : check the family
+        __cpuid(0, eax, ebx, ecx, edx);
+        if(ebx == 0x68747541u){
+            __cpuid(1, eax, ebx, ecx, edx);
+            unsigned family = (eax >> 8) & 0xF;
+            if(family == 0xF){
+                family += (eax >> 20) & 0xFF;
+            }
+            return family >= 0x19;
+        }
+        return true;
+#elif defined(_MSC_VER) && defined(_M_X64)
+        int info[4];
+        __cpuid(info, 0);
+        if(info[0] < 7){
+            return false;
+        }
+        bool isAmd = (info[1] == 0x68747541);
+        __cpuidex(info, 7, 0);
+        if(!(info[1] & (1 << 8))){
+            return false;
+        }
+        if(isAmd){
+            __cpuid(info, 1);
+            unsigned family = (info[0] >> 8) & 0xF;
+            if(family == 0xF){
+                family += (info[0] >> 20) & 0xFF;
+            }
+            return family >= 0x19;
+        }
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Build the attack tables
+     * @details The CHESS3D_NO_PEXT environment variable forces the magic bitboards (to compare both paths)
+     * @param allowPext : use PEXT when the CPU supports it
+     */
+
+    void initAttacks(bool allowPext){
+
+        pextEnabled = allowPext && std::getenv("CHESS3D_NO_PEXT") == nullptr && cpuHasBmi2();
+
+        // Leapers
+        const int knightSteps[8][2] = {{1, 2}, {2, 1}, {2, -1}, {1, -2}, {-1, -2}, {-2, -1}, {-2, 1}, {-1, 2}};
+        const int kingSteps[8][2] = {{1, 0}, {1, 1}, {0, 1}, {-1, 1}, {-1, 0}, {-1, -1}, {0, -1}, {1, -1}};
+
+        for(int sq = A1; sq <= H8; sq++){
+            Square s = static_cast<Square>(sq);
+            Square target;
+
+            pawnAttackTable[WHITE][s] = 0;
+            pawnAttackTable[BLACK][s] = 0;
+            for(int df : {-1, 1}){
+                if(offsetSquare(s, df, 1, target)) pawnAttackTable[WHITE][s] |= squareBB(target);
+                if(offsetSquare(s, df, -1, target)) pawnAttackTable[BLACK][s] |= squareBB(target);
+            }
+
+            knightAttackTable[s] = 0;
+            kingAttackTable[s] = 0;
+            for(int i = 0; i < 8; i++){
+                if(offsetSquare(s, knightSteps[i][0], knightSteps[i][1], target)) knightAttackTable[s] |= squareBB(target);
+                if(offsetSquare(s, kingSteps[i][0], kingSteps[i][1], target)) kingAttackTable[s] |= squareBB(target);
+            }
+        }
+
+        // Sliders
+        initMagics(rookDirections, rookTable, rookMagics);
+        initMagics(bishopDirections, bishopTable, bishopMagics);
+
+        // Lines and segments between aligned squares
+        for(int a = A1; a <= H8; a++){
+            for(int b = A1; b <= H8; b++){
+                Square sa = static_cast<Square>(a), sb = static_cast<Square>(b);
+                betweenTable[a][b] = 0;
+                lineTable[a][b] = 0;
+                if(a == b){
+                    continue;
+                }
+                for(PieceType pt : {BISHOP, ROOK}){
+                    if(attacks(pt, sa, 0) & squareBB(sb)){
+                        lineTable[a][b] = (attacks(pt, sa, 0) & attacks(pt, sb, 0)) | squareBB(sa) | squareBB(sb);
+                        betweenTable[a][b] = attacks(pt, sa, squareBB(sb)) & attacks(pt, sb, squareBB(sa));
+                    }
+                }
+            }
+        }
+    }
+}
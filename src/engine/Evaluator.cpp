@@ -0,0 +1,365 @@
+/**
+ * @author obiwan138
+ * @file Evaluator.cpp
+ * @brief Implementation of the Evaluator class
+ */
+
+#include "engine/Evaluator.hpp"
+
+#include <algorithm>
+
+namespace engine{
+
+    const Network* Evaluator::network = nullptr;
+
+    namespace{
+
+        // Material [centipawns], in the PieceType order
+        const int middleGameValue[PIECE_TYPE_NB] = {100, 320, 330, 500, 900, 0};
+        const int endGameValue[PIECE_TYPE_NB] = {130, 300, 320, 530, 950, 0};
+
+        // Game phase weight of each piece type (24 with all the pieces on the board)
+        const int phaseWeight[PIECE_TYPE_NB] = {0, 1, 1, 2, 4, 0};
+        const int MAX_PHASE = 24;
+
+        // Piece-square tables, from the white point of view, written with a8 first (as the board is seen by white)
+        const int pawnTable[64] = {
+              0,   0,   0,   0,   0,   0,   0,   0,
+             50,  50,  50,  50,  50,  50,  50,  50,
+             10,  10,  20,  30,  30,  20,  10,  10,
+              5,   5,  10,  25,  25,  10,   5,   5,
+              0,   0,   0,  20,  20,   0,   0,   0,
+              5,  -5, -10,   0,   0, -10,  -5,   5,
+              5,  10,  10, -20, -20,  10,  10,   5,
+              0,   0,   0,   0,   0,   0,   0,   0
+        };
+        const int pawnEndGameTable[64] = {
+              0,   0,   0,   0,   0,   0,   0,   0,
+             80,  80,  80,  80,  80,  80,  80,  80,
+             50,  50,  50,  50,  50,  50,  50,  50,
+             30,  30,  30,  30,  30,  30,  30,  30,
+             15,  15,  15,  15,  15,  15,  15,  15,
+              5,   5,   5,   5,   5,   5,   5,   5,
+              0,   0,   0,   0,   0,   0,   0,   0,
+              0,   0,   0,   0,   0,   0,   0,   0
+        };
+        const int knightTable[64] = {
+            -50, -40, -30, -30, -30, -30, -40, -50,
+            -40, -20,   0,   0,   0,   0, -20, -40,
+            -30,   0,  10,  15,  15,  10,   0, -30,
+            -30,   5,  15,  20,  20,  15,   5, -30,
+            -30,   0,  15,  20,  20,  15,   0, -30,
+            -30,   5,  10,  15,  15,  10,   5, -30,
+            -40, -20,   0,   5,   5,   0, -20, -40,
+            -50, -40, -30, -30, -30, -30, -40, -50
+        };
+        const int bishopTable[64] = {
+            -20, -10, -10, -10, -10, -10, -10, -20,
+            -10,   0,   0,   0,   0,   0,   0, -10,
+            -10,   0,   5,  10,  10,   5,   0, -10,
+            -10,   5,   5,  10,  10,   5,   5, -10,
+            -10,   0,  10,  10,  10,  10,   0, -10,
+            -10,  10,  10,  10,  10,  10,  10, -10,
+            -10,   5,   0,   0,   0,   0,   5, -10,
+            -20, -10, -10, -10, -10, -10, -10, -20
+        };
+        const int rookTable[64] = {
+              0,   0,   0,   0,   0,   0,   0,   0,
+              5,  10,  10,  10,  10,  10,  10,   5,
+             -5,   0,   0,   0,   0,   0,   0,  -5,
+             -5,   0,   0,   0,   0,   0,   0,  -5,
+             -5,   0,   0,   0,   0,   0,   0,  -5,
+             -5,   0,   0,   0,   0,   0,   0,  -5,
+             -5,   0,   0,   0,   0,   0,   0,  -5,
+              0,   0,   0,   5,   5,   0,   0,   0
+        };
+        const int queenTable[64] = {
+            -20, -10, -10,  -5,  -5, -10, -10, -20,
+            -10,   0,   0,   0,   0,   0,   0, -10,
+            -10,   0,   5,   5,   5,   5,   0, -10,
+             -5,   0,   5,   5,   5,   5,   0,  -5,
+              0,   0,   5,   5,   5,   5,   0,  -5,
+            -10,   5,   5,   5,   5,   5,   0, -10,
+            -10,   0,   5,   0,   0,   0,   0, -10,
+            -20, -10, -10,  -5,  -5, -10, -10, -20
+        };
+        const int kingTable[64] = {
+            -30, -40, -40, -50, -50, -40, -40, -30,
+            -30, -40, -40, -50, -50, -40, -40, -30,
+            -30, -40, -40, -50, -50, -40, -40, -30,
+            -30, -40, -40, -50, -50, -40, -40, -30,
+            -20, -30, -30, -40, -40, -30, -30, -20,
+            -10, -20, -20, -20, -20, -20, -20, -10,
+             20,  20,   0,   0,   0,   0,  20,  20,
+             20,  30,  10,   0,   0,  10,  30,  20
+        };
+        const int kingEndGameTable[64] = {
+            -50, -40, -30, -20, -20, -30, -40, -50,
+            -30, -20, -10,   0,   0, -10, -20, -30,
+            -30, -10,  20,  30,  30,  20, -10, -30,
+            -30, -10,  30,  40,  40,  30, -10, -30,
+            -30, -10,  30,  40,  40,  30, -10, -30,
+            -30, -10,  20,  30,  30,  20, -10, -30,
+            -30, -30,   0,   0,   0,   0, -30, -30,
+            -50, -30, -30, -30, -30, -30, -30, -50
+        };
+
+        const int* middleGameTables[PIECE_TYPE_NB] = {pawnTable, knightTable, bishopTable, rookTable, queenTable, kingTable};
+        const int* endGameTables[PIECE_TYPE_NB] = {pawnEndGameTable, knightTable, bishopTable, rookTable, queenTable, kingEndGameTable};
+
+        // Pawn structure terms, indexed by the rank seen from the pawn owner
+        const int passedMiddleGame[8] = {0, 5, 10, 15, 25, 40, 60, 0};
+        const int passedEndGame[8] = {0, 10, 20, 35, 60, 100, 150, 0};
+        const int DOUBLED_MG = -10, DOUBLED_EG = -20;
+        const int ISOLATED_MG = -10, ISOLATED_EG = -15;
+        const int BISHOP_PAIR_MG = 30, BISHOP_PAIR_EG = 50;
+        const int TEMPO = 10;
+
+        // The network scores are kept out of the mate range of the search
+        const int NETWORK_SCORE_LIMIT = 20000;
+
+        // Index in the tables (written a8 first) of a square seen from a color
+        inline int tableIndex(Color c, Square s){
+            return (c == WHITE) ? ((7 - rankOf(s)) * 8 + fileOf(s)) : (rankOf(s) * 8 + fileOf(s));
+        }
+
+        // Files next to a file
+        inline Bitboard adjacentFiles(int file){
+            Bitboard f = FILE_A_BB << file;
+            return ((f & ~FILE_A_BB) >> 1) | ((f & ~FILE_H_BB) << 1);
+        }
+
+        // Squares strictly in front of a rank, seen from a color
+        inline Bitboard forwardRanks(Color c, int rank){
+            if(c == WHITE){
+                return (rank < 7) ? (~Bitboard(0) << (8 * (rank + 1))) : 0;
+            }
+            return (rank > 0) ? (~Bitboard(0) >> (8 * (8 - rank))) : 0;
+        }
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Constructor
+     */
+
+    Evaluator::Evaluator(){
+        this->ownNetwork = nullptr;
+        this->hasOwnNetwork = false;
+        this->clear();
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Empty the pawn cache
+     */
+
+    void Evaluator::clear(){
+        for(PawnEntry& entry : this->pawnTable){
+            entry.key = 0;
+            entry.middleGame = 0;
+            entry.endGame = 0;
+        }
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Material value of a piece type in the middle game
+     * @param type : the piece type
+     * @return int the value in centipawns (0 for the king)
+     */
+
+    int Evaluator::pieceValue(PieceType type){
+        return middleGameValue[type];
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Evaluate the pawn structure
+     * @param position : the position
+     * @param middleGame : output middle game score (white point of view)
+     * @param endGame : output end game score (white point of view)
+     */
+
+    void Evaluator::evaluatePawns(const Position& position, int& middleGame, int& endGame) const{
+        middleGame = 0;
+        endGame = 0;
+
+        for(Color c : {WHITE, BLACK}){
+            const int sign = (c == WHITE) ? 1 : -1;
+            const Bitboard ours = position.getPieces(c, PAWN);
+            const Bitboard theirs = position.getPieces(~c, PAWN);
+
+            Bitboard pawns = ours;
+            while(pawns){
+                const Square s = popLsb(pawns);
+                const int file = fileOf(s);
+                const int relativeRank = (c == WHITE) ? rankOf(s) : 7 - rankOf(s);
+                const Bitboard fileBB = FILE_A_BB << file;
+                const Bitboard ahead = forwardRanks(c, rankOf(s));
+
+                // Passed : no enemy pawn in front, on the same file or the adjacent ones
+                if(!(theirs & (fileBB | adjacentFiles(file)) & ahead)){
+                    middleGame += sign * passedMiddleGame[relativeRank];
+                    endGame += sign * passedEndGame[relativeRank];
+                }
+
+                // Doubled : another own pawn in front on the same file
+                if(ours & fileBB & ahead){
+                    middleGame += sign * DOUBLED_MG;
+                    endGame += sign * DOUBLED_EG;
+                }
+
+                // Isolated : no own pawn on the adjacent files
+                if(!(ours & adjacentFiles(file))){
+                    middleGame += sign * ISOLATED_MG;
+                    endGame += sign * ISOLATED_EG;
+                }
+            }
+        }
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Static evaluation
+     * @param state : the game state (its pawn key indexes the pawn cache)
+     * @return int the score from the side to move point of view [centipawns]
+     */
+
+    int Evaluator::evaluate(const GameState& state){
+
+        const Position& position = state.getPosition();
+        if(const Network* active = this->activeNetwork()){
+            return std::clamp(this->accumulator.evaluate(position, *active), -NETWORK_SCORE_LIMIT, NETWORK_SCORE_LIMIT);
+        }
+
+        int middleGame = 0;
+        int endGame = 0;
+        int phase = 0;
+
+        // Material and piece-square tables
+        for(Color c : {WHITE, BLACK}){
+            const int sign = (c == WHITE) ? 1 : -1;
+            for(int pt = PAWN; pt <= KING; pt++){
+                Bitboard pieces = position.getPieces(c, static_cast<PieceType>(pt));
+                phase += phaseWeight[pt] * popCount(pieces);
+                while(pieces){
+                    const int index = tableIndex(c, popLsb(pieces));
+                    middleGame += sign * (middleGameValue[pt] + middleGameTables[pt][index]);
+                    endGame += sign * (endGameValue[pt] + endGameTables[pt][index]);
+                }
+            }
+
+            if(moreThanOne(position.getPieces(c, BISHOP))){
+                middleGame += sign * BISHOP_PAIR_MG;
+                endGame += sign * BISHOP_PAIR_EG;
+            }
+        }
+
+        // Pawn structure (cached)
+        PawnEntry& entry = this->pawnTable[state.getPawnKey() & (PAWN_TABLE_SIZE - 1)];
+        if(entry.key != state.getPawnKey()){
+            int pawnMiddleGame, pawnEndGame;
+            this->evaluatePawns(position, pawnMiddleGame, pawnEndGame);
+            entry.key = state.getPawnKey();
+            entry.middleGame = static_cast<int16_t>(pawnMiddleGame);
+            entry.endGame = static_cast<int16_t>(pawnEndGame);
+        }
+        middleGame += entry.middleGame;
+        endGame += entry.endGame;
+
+        // Taper between the middle game and the end game
+        phase = std::min(phase, MAX_PHASE);
+        int score = (middleGame * phase + endGame * (MAX_PHASE - phase)) / MAX_PHASE;
+
+        return ((position.getSideToMove() == WHITE) ? score : -score) + TEMPO;
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Start from the root position of a search
+     */
+
+    void Evaluator::reset(){
+        this->accumulator.reset();
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Report a move, before it is played on the state
+     * @details Nothing to do for the hand-crafted evaluation (the network does not change during a search)
+     * @param position : the position before the move
+     * @param move : the move
+     */
+
+    void Evaluator::push(const Position& position, Move move){
+        if(this->activeNetwork()){
+            this->accumulator.push(position, move);
+        }
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Report a null move
+     */
+
+    void Evaluator::pushNull(){
+        if(this->activeNetwork()){
+            this->accumulator.pushNull();
+        }
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Report that the last move was taken back
+     */
+
+    void Evaluator::pop(){
+        if(this->activeNetwork()){
+            this->accumulator.pop();
+        }
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Evaluate with a network
+     * @details The network is read by all the search threads : it must not be changed (nor destroyed) during a search
+     * @param networkIn : a loaded network, null for the hand-crafted evaluation
+     */
+
+    void Evaluator::setNetwork(const Network* networkIn){
+        network = (networkIn && networkIn->isLoaded()) ? networkIn : nullptr;
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Get the network of the evaluation
+     * @return const Network* null for the hand-crafted evaluation
+     */
+
+    const Network* Evaluator::getNetwork(){
+        return network;
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Evaluate this evaluator with its own network
+     * @details The shared network (setNetwork) no longer applies to this evaluator
+     * @param networkIn : a loaded network, null for the hand-crafted evaluation
+     */
+
+    void Evaluator::useNetwork(const Network* networkIn){
+        this->ownNetwork = (networkIn && networkIn->isLoaded()) ? networkIn : nullptr;
+        this->hasOwnNetwork = true;
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Get the network in use
+     * @return const Network* its own network if it has one, else the shared one (null for the hand-crafted evaluation)
+     */
+
+    const Network* Evaluator::activeNetwork() const{
+        return this->hasOwnNetwork ? this->ownNetwork : network;
+    }
+}
@@ -0,0 +1,301 @@
+/**
+ * @author obiwan138
+ * @file GameArchive.cpp
+ * @brief Implementation of the GameArchive class
+ */
+
+#include "engine/GameArchive.hpp"
+#include "engine/MoveGen.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+namespace engine{
+
+    namespace{
+
+        // Reader of the bits of a game, most significant bit first
+        class BitReader
+        {
+            private :
+
+                const uint8_t* data;
+                const uint8_t* end;
+                uint64_t cache;         // Bits not read yet, aligned on the most significant bit
+                int cacheBits;
+
+            public :
+
+                BitReader(const uint8_t* dataIn, const uint8_t* endIn)
+                    :data(dataIn), end(endIn), cache(0), cacheBits(0){}
+
+                // Read up to 32 bits, false past the end of the data
+                bool read(int bits, uint32_t& value){
+                    while(this->cacheBits < bits){
+                        if(this->data == this->end){
+                            return false;
+                        }
+                        this->cache |= static_cast<uint64_t>(*this->data++) << (56 - this->cacheBits);
+                        this->cacheBits += 8;
+                    }
+                    value = (bits == 0) ? 0 : static_cast<uint32_t>(this->cache >> (64 - bits));
+                    this->cache = (bits == 0) ? this->cache : this->cache << bits;
+                    this->cacheBits -= bits;
+                    return true;
+                }
+        };
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Constructor
+     */
+
+    GameArchive::GameArchive(){
+        this->gameCount = 0;
+        this->blockIndex = nullptr;
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Map an archive
+     * @details The header and the size of the index are checked, the games are only read when they are replayed
+     * @param path : path of the archive
+     * @return true if the archive is open
+     */
+
+    bool GameArchive::open(const std::string& path){
+        this->close();
+
+        if(!this->file.open(path, true)){
+            return false;
+        }
+
+        ArchiveHeader header;
+        if(this->file.getSize() < HEADER_SIZE){
+            std::cerr << "Error: " << path << " is not a game archive" << std::endl;
+            this->file.close();
+            return false;
+        }
+        std::memcpy(&header, this->file.getData(), sizeof(header));
+
+        if(std::memcmp(header.magic, FILE_MAGIC, sizeof(FILE_MAGIC)) != 0 || header.version != FILE_VERSION
+        || header.gamesPerBlock != GAMES_PER_BLOCK){
+            std::cerr << "Error: " << path << " is not a game archive (version " << FILE_VERSION << ")" << std::endl;
+            this->file.close();
+            return false;
+        }
+        if(header.blockCount != (header.gameCount + GAMES_PER_BLOCK - 1) / GAMES_PER_BLOCK
+        || header.indexOffset > this->file.getSize() || (this->file.getSize() - header.indexOffset) / sizeof(uint64_t) < header.blockCount){
+            std::cerr << "Error: the index of " << path << " is truncated" << std::endl;
+            this->file.close();
+            return false;
+        }
+
+        this->gameCount = header.gameCount;
+        this->blockIndex = this->file.getData() + header.indexOffset;
+        return true;
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Unmap the archive
+     */
+
+    void GameArchive::close(){
+        this->file.close();
+        this->gameCount = 0;
+        this->blockIndex = nullptr;
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Is an archive open
+     * @return bool
+     */
+
+    bool GameArchive::isOpen() const{
+        return this->file.isOpen();
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Get the number of games
+     * @return uint64_t
+     */
+
+    uint64_t GameArchive::getGameCount() const{
+        return this->gameCount;
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Get the size of the archive
+     * @return size_t [bytes]
+     */
+
+    size_t GameArchive::getFileSize() const{
+        return this->file.getSize();
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Get the header of a game
+     * @param index : index of the game
+     * @return GameRecord
+     */
+
+    GameRecord GameArchive::getRecord(uint64_t index) const{
+        uint64_t blockOffset;
+        std::memcpy(&blockOffset, this->blockIndex + (index / GAMES_PER_BLOCK) * sizeof(uint64_t), sizeof(blockOffset));
+
+        GameRecord record = {};
+        const uint64_t offset = blockOffset + (index % GAMES_PER_BLOCK) * sizeof(GameRecord);
+        if(offset + sizeof(GameRecord) <= this->file.getSize()){
+            std::memcpy(&record, this->file.getData() + offset, sizeof(record));
+        }
+        return record;
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Set up the initial position of a game
+     * @param index : index of the game
+     * @param position : output position
+     * @return true if the position is well formed and legal
+     */
+
+    bool GameArchive::readStartPosition(uint64_t index, Position& position) const{
+        const GameRecord record = this->getRecord(index);
+
+        static const Position start = [](){
+            Position initial;
+            initial.setFromFen(Position::startFen);
+            return initial;
+        }();
+        if(!(record.flags & FLAG_SETUP)){
+            position = start;
+            return true;
+        }
+
+        uint64_t blockOffset;
+        std::memcpy(&blockOffset, this->blockIndex + (index / GAMES_PER_BLOCK) * sizeof(uint64_t), sizeof(blockOffset));
+        const uint64_t offset = blockOffset + record.dataOffset;
+        if(offset >= this->file.getSize() || offset + 1 + this->file.getData()[offset] > this->file.getSize()){
+            return false;
+        }
+        const char* fen = reinterpret_cast<const char*>(this->file.getData() + offset + 1);
+        return position.setFromFen(std::string_view(fen, this->file.getData()[offset])) && !position.checkLegality();
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Replay a game
+     * @details Each ply generates the legal moves, selects the coded index among them in the order of their encoding
+     * (nth_element, linear on average) and plays it.
+     * @param index : index of the game
+     * @param position : output, the last position of the game
+     * @param moves : output, the moves of the game
+     * @param keys : output, the keys of the positions of the game (may be null)
+     * @return true if the game could be replayed
+     */
+
+    bool GameArchive::readGame(uint64_t index, Position& position, std::vector<Move>& moves, std::vector<uint64_t>* keys) const{
+        moves.clear();
+        if(keys){
+            keys->clear();
+        }
+        if(index >= this->gameCount || !this->readStartPosition(index, position)){
+            return false;
+        }
+        if(keys){
+            keys->push_back(position.getKey());
+        }
+
+        const GameRecord record = this->getRecord(index);
+        uint64_t blockOffset;
+        std::memcpy(&blockOffset, this->blockIndex + (index / GAMES_PER_BLOCK) * sizeof(uint64_t), sizeof(blockOffset));
+        uint64_t offset = blockOffset + record.dataOffset;
+        if(record.flags & FLAG_SETUP){
+            offset += 1 + this->file.getData()[offset];
+        }
+        if(offset > this->file.getSize()){
+            return false;
+        }
+
+        BitReader reader(this->file.getData() + offset, this->file.getData() + this->file.getSize());
+        for(int ply = 0; ply < record.plyCount; ply++){
+            MoveList legal;
+            generateLegalMoves(position, legal);
+            const int count = legal.size();
+            if(count == 0){
+                return false;
+            }
+
+            // Truncated binary code : the first 2^length - count indices take one bit less
+            const int length = codeLength(count);
+            const uint32_t shortCodes = (1u << length) - static_cast<uint32_t>(count);
+            uint32_t code = 0;
+            if(length > 0){
+                uint32_t bit;
+                if(!reader.read(length - 1, code)){
+                    return false;
+                }
+                if(code >= shortCodes){
+                    if(!reader.read(1, bit)){
+                        return false;
+                    }
+                    code = ((code << 1) | bit) - shortCodes;
+                }
+            }
+            if(code >= static_cast<uint32_t>(count)){
+                return false;
+            }
+
+            std::nth_element(legal.begin(), legal.begin() + code, legal.end(), [](Move a, Move b){
+                return a.raw() < b.raw();
+            });
+            const Move move = legal[static_cast<int>(code)];
+            position.doMove(move);
+            moves.push_back(move);
+            if(keys){
+                keys->push_back(position.getKey());
+            }
+        }
+        return true;
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Longer length of the code of a move index
+     * @param count : number of legal moves
+     * @return int ceil(log2 count), 0 for a single move
+     */
+
+    int GameArchive::codeLength(int count){
+        int length = 0;
+        while((1 << length) < count){
+            length++;
+        }
+        return length;
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Index of a move among the legal moves
+     * @param moves : the legal moves of the position
+     * @param move : a legal move
+     * @return int the number of legal moves of smaller encoding, -1 if the move is not in the list
+     */
+
+    int GameArchive::moveIndex(const MoveList& moves, Move move){
+        int index = 0;
+        bool found = false;
+        for(Move other : moves){
+            index += (other.raw() < move.raw()) ? 1 : 0;
+            found = found || other == move;
+        }
+        return found ? index : -1;
+    }
+}
@@ -0,0 +1,224 @@
+/**
+ * @author obiwan138
+ * @file GameArchiveWriter.cpp
+ * @brief Implementation of the GameArchiveWriter class
+ */
+
+#include "engine/GameArchiveWriter.hpp"
+#include "engine/MoveGen.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+namespace engine{
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Constructor
+     */
+
+    GameArchiveWriter::GameArchiveWriter(){
+        this->file = nullptr;
+        this->gameCount = 0;
+        this->fileSize = 0;
+        this->failed = false;
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Create an archive
+     * @details The header is written at the end, its block is left empty until then
+     * @param path : path of the archive
+     * @return true if the file is created
+     */
+
+    bool GameArchiveWriter::open(const std::string& path){
+        if(this->file){
+            this->close();
+        }
+
+        this->file = std::fopen(path.c_str(), "wb");
+        if(!this->file){
+            std::cerr << "Error: cannot create " << path << std::endl;
+            return false;
+        }
+        this->path = path;
+        this->records.clear();
+        this->data.clear();
+        this->blockOffsets.clear();
+        this->gameCount = 0;
+        this->fileSize = GameArchive::HEADER_SIZE;
+        this->failed = false;
+
+        const uint8_t zeros[GameArchive::HEADER_SIZE] = {};
+        this->failed = std::fwrite(zeros, 1, sizeof(zeros), this->file) != sizeof(zeros);
+        return true;
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Add a game
+     * @param start : initial position of the game
+     * @param moves : legal moves of the game, from the initial position
+     * @param moveCount : number of moves (at most 65535)
+     * @param record : header of the game (result, Elo and date)
+     */
+
+    void GameArchiveWriter::addGame(const Position& start, const Move* moves, size_t moveCount, GameRecord record){
+        if(!this->file){
+            return;
+        }
+
+        record.dataOffset = static_cast<uint32_t>(this->data.size());
+        record.plyCount = static_cast<uint16_t>(std::min<size_t>(moveCount, UINT16_MAX));
+        record.flags = 0;
+
+        // Initial position, when it is not the standard one
+        const std::string fen = start.toFen();
+        if(fen != Position::startFen){
+            record.flags |= GameArchive::FLAG_SETUP;
+            this->data.push_back(static_cast<uint8_t>(fen.size()));
+            this->data.insert(this->data.end(), fen.begin(), fen.end());
+        }
+
+        // Move indices, most significant bit first
+        uint64_t bits = 0;
+        int bitCount = 0;
+        auto write = [&](uint32_t value, int length){
+            bits = (bits << length) | value;
+            bitCount += length;
+            while(bitCount >= 8){
+                bitCount -= 8;
+                this->data.push_back(static_cast<uint8_t>(bits >> bitCount));
+            }
+        };
+
+        Position position = start;
+        for(size_t ply = 0; ply < record.plyCount; ply++){
+            MoveList legal;
+            generateLegalMoves(position, legal);
+            const int index = GameArchive::moveIndex(legal, moves[ply]);
+            if(index < 0){
+                record.plyCount = static_cast<uint16_t>(ply);
+                break;
+            }
+
+            // Truncated binary code : the first 2^length - count indices take one bit less
+            const int length = GameArchive::codeLength(legal.size());
+            const uint32_t shortCodes = (1u << length) - static_cast<uint32_t>(legal.size());
+            if(length > 0){
+                if(static_cast<uint32_t>(index) < shortCodes){
+                    write(static_cast<uint32_t>(index), length - 1);
+                }
+                else{
+                    write(static_cast<uint32_t>(index) + shortCodes, length);
+                }
+            }
+            position.doMove(moves[ply]);
+        }
+        if(bitCount > 0){
+            this->data.push_back(static_cast<uint8_t>(bits << (8 - bitCount)));
+        }
+
+        this->records.push_back(record);
+        this->gameCount++;
+        if(this->records.size() == GameArchive::GAMES_PER_BLOCK){
+            this->writeBlock();
+        }
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Write the current block
+     * @details The block is padded to 16 bytes, so the game headers of every block are aligned
+     */
+
+    void GameArchiveWriter::writeBlock(){
+        if(this->records.empty()){
+            return;
+        }
+
+        // The data of the games follows the headers
+        const uint32_t headersSize = static_cast<uint32_t>(this->records.size() * sizeof(GameRecord));
+        for(GameRecord& record : this->records){
+            record.dataOffset += headersSize;
+        }
+        this->data.resize((this->data.size() + 15) & ~static_cast<size_t>(15));
+
+        this->blockOffsets.push_back(this->fileSize);
+        this->failed = this->failed
+            || std::fwrite(this->records.data(), sizeof(GameRecord), this->records.size(), this->file) != this->records.size()
+            || std::fwrite(this->data.data(), 1, this->data.size(), this->file) != this->data.size();
+        this->fileSize += headersSize + this->data.size();
+
+        this->records.clear();
+        this->data.clear();
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Finish the archive
+     * @return true if the archive is complete
+     */
+
+    bool GameArchiveWriter::close(){
+        if(!this->file){
+            return false;
+        }
+
+        this->writeBlock();
+
+        ArchiveHeader header = {};
+        std::memcpy(header.magic, GameArchive::FILE_MAGIC, sizeof(header.magic));
+        header.version = GameArchive::FILE_VERSION;
+        header.gamesPerBlock = GameArchive::GAMES_PER_BLOCK;
+        header.gameCount = this->gameCount;
+        header.blockCount = this->blockOffsets.size();
+        header.indexOffset = this->fileSize;
+
+        this->failed = this->failed
+            || std::fwrite(this->blockOffsets.data(), sizeof(uint64_t), this->blockOffsets.size(), this->file) != this->blockOffsets.size()
+            || std::fseek(this->file, 0, SEEK_SET) != 0
+            || std::fwrite(&header, sizeof(header), 1, this->file) != 1;
+        this->fileSize += this->blockOffsets.size() * sizeof(uint64_t);
+
+        this->failed = (std::fclose(this->file) != 0) || this->failed;
+        this->file = nullptr;
+        if(this->failed){
+            std::cerr << "Error: cannot write " << this->path << std::endl;
+        }
+        return !this->failed;
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Get the number of games added
+     * @return uint64_t
+     */
+
+    uint64_t GameArchiveWriter::getGameCount() const{
+        return this->gameCount;
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Get the size of the archive
+     * @return uint64_t [bytes], complete after close
+     */
+
+    uint64_t GameArchiveWriter::getFileSize() const{
+        return this->fileSize;
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Destructor
+     */
+
+    GameArchiveWriter::~GameArchiveWriter(){
+        if(this->file){
+            this->close();
+        }
+    }
+}
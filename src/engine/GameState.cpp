@@ -0,0 +1,316 @@
+/**
+ * @author obiwan138
+ * @file GameState.cpp
+ * @brief Implementation of the GameState class
+ */
+
+#include "engine/GameState.hpp"
+#include "engine/Zobrist.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cstdlib>
+#include <iostream>
+
+namespace engine{
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Default constructor
+     * @details Initial position, empty history
+     */
+
+    GameState::GameState(){
+        this->setFromFen(Position::startFen);
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Set the position from a FEN string and clear the history
+     * @param fen : the FEN string
+     * @return true if the FEN is well formed
+     */
+
+    bool GameState::setFromFen(std::string_view fen){
+        Position newPosition;
+        bool ok = newPosition.setFromFen(fen);
+        this->setPosition(newPosition);
+        return ok;
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Set the position and clear the history
+     * @param positionIn : the new position
+     */
+
+    void GameState::setPosition(const Position& positionIn){
+        this->position = positionIn;
+        this->pawnKey = this->position.computePawnKey();
+        this->materialKey = this->position.computeMaterialKey();
+        this->ply = 0;
+        this->droppedPlies = 0;
+        this->repetitions.clear();
+        this->repetitions.add(this->position.getKey());
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Play a legal move
+     * @details The pawn key changes only when a pawn moves or is captured. The material signature changes only on a
+     * capture or a promotion : the key of the last piece of a kind (index count - 1) is removed or added.
+     * @param move : a legal move of the current position
+     */
+
+    void GameState::doMove(Move move){
+        if(this->ply >= MAX_GAME_PLY){
+            this->dropOldestPlies();
+        }
+
+        StateEntry& entry = this->history[this->ply++];
+        entry.move = move;
+        entry.nullMove = false;
+        entry.pawnKey = this->pawnKey;
+        entry.materialKey = this->materialKey;
+
+        const Color us = this->position.getSideToMove();
+        const Square from = move.from();
+        const Square to = move.to();
+        const bool isPawnMove = (move.type() == PROMOTION) || (this->position.getPieces(us, PAWN) & squareBB(from));
+
+        this->position.doMove(move, entry.undo);
+
+        // Pawn structure
+        if(isPawnMove){
+            const Piece pawn = makePiece(us, PAWN);
+            this->pawnKey ^= zobrist.psq[pawn][from];
+            if(move.type() != PROMOTION){
+                this->pawnKey ^= zobrist.psq[pawn][to];
+            }
+        }
+
+        // Material
+        const Piece captured = entry.undo.captured;
+        if(captured != NO_PIECE){
+            this->materialKey ^= zobrist.psq[captured][popCount(this->position.getPieces(captured))];
+            if(typeOf(captured) == PAWN){
+                Square captureSquare = (move.type() == EN_PASSANT) ? static_cast<Square>(us == WHITE ? to - 8 : to + 8) : to;
+                this->pawnKey ^= zobrist.psq[captured][captureSquare];
+            }
+        }
+        if(move.type() == PROMOTION){
+            const Piece pawn = makePiece(us, PAWN);
+            const Piece promoted = makePiece(us, move.promotionType());
+            this->materialKey ^= zobrist.psq[pawn][popCount(this->position.getPieces(pawn))];
+            this->materialKey ^= zobrist.psq[promoted][popCount(this->position.getPieces(promoted)) - 1];
+        }
+
+        this->repetitions.add(this->position.getKey());
+
+#ifdef CHESS3D_VERIFY_KEYS
+        this->verifyKeys("doMove");
+#endif
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Take back the last move
+     */
+
+    void GameState::undoMove(){
+        assert(this->ply == 0 || !this->history[this->ply - 1].nullMove);
+        if(this->ply == 0){
+            return;
+        }
+
+        const StateEntry& entry = this->history[--this->ply];
+        this->repetitions.remove(this->position.getKey());
+        this->position.undoMove(entry.move, entry.undo);
+        this->pawnKey = entry.pawnKey;
+        this->materialKey = entry.materialKey;
+
+#ifdef CHESS3D_VERIFY_KEYS
+        this->verifyKeys("undoMove");
+#endif
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Pass the turn
+     * @details The position after a null move is not counted in the repetitions : it does not occur in the game
+     */
+
+    void GameState::doNullMove(){
+        if(this->ply >= MAX_GAME_PLY){
+            this->dropOldestPlies();
+        }
+
+        StateEntry& entry = this->history[this->ply++];
+        entry.move = Move();
+        entry.nullMove = true;
+        entry.pawnKey = this->pawnKey;
+        entry.materialKey = this->materialKey;
+        this->position.doNullMove(entry.undo);
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Take back a null move
+     */
+
+    void GameState::undoNullMove(){
+        assert(this->ply == 0 || this->history[this->ply - 1].nullMove);
+        if(this->ply == 0){
+            return;
+        }
+
+        const StateEntry& entry = this->history[--this->ply];
+        this->position.undoNullMove(entry.undo);
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Drop the oldest half of the history to make room for a move
+     * @details Only the moves of the search are taken back, a few hundred plies at most. The dropped positions leave
+     * the repetition table, which keeps it within its capacity : a position played before an irreversible move cannot
+     * come back anyway, so only a repetition of a position more than MAX_GAME_PLY / 2 reversible plies ago is missed.
+     */
+
+    void GameState::dropOldestPlies(){
+        const int dropped = this->ply - MAX_GAME_PLY / 2;
+        for(int i = 0; i < dropped; i++){
+            // The position before an entry was counted unless a null move led to it (the first entry follows a move)
+            if(i == 0 || !this->history[i - 1].nullMove){
+                this->repetitions.remove(this->history[i].undo.key);
+            }
+        }
+        std::move(this->history + dropped, this->history + this->ply, this->history);
+        this->ply -= dropped;
+        this->droppedPlies += dropped;
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Check the incremental keys against a full recompute
+     * @details Only called in CHESS3D_VERIFY_KEYS builds. A mismatch is a bug in the incremental updates : the program stops.
+     * @param context : name of the caller, printed on a mismatch
+     */
+
+    void GameState::verifyKeys(const char* context) const{
+        bool keyOk = this->position.getKey() == this->position.computeKey();
+        bool pawnOk = this->pawnKey == this->position.computePawnKey();
+        bool materialOk = this->materialKey == this->position.computeMaterialKey();
+        if(!keyOk || !pawnOk || !materialOk){
+            std::cerr << "Error: incremental key mismatch after " << context << " (ply " << this->ply << ", "
+                      << this->position.toFen() << ") :"
+                      << (keyOk ? "" : " zobrist") << (pawnOk ? "" : " pawn") << (materialOk ? "" : " material") << std::endl;
+            std::abort();
+        }
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Get the current position
+     * @return const Position&
+     */
+
+    const Position& GameState::getPosition() const{
+        return this->position;
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Get the Zobrist key of the current position
+     * @return uint64_t
+     */
+
+    uint64_t GameState::getKey() const{
+        return this->position.getKey();
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Get the pawn structure key of the current position
+     * @return uint64_t
+     */
+
+    uint64_t GameState::getPawnKey() const{
+        return this->pawnKey;
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Get the material signature of the current position
+     * @return uint64_t
+     */
+
+    uint64_t GameState::getMaterialKey() const{
+        return this->materialKey;
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Get the number of plies played since the position was set
+     * @return int (the dropped plies included)
+     */
+
+    int GameState::getPly() const{
+        return this->droppedPlies + this->ply;
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Get the last move played
+     * @return Move the null move if there is none
+     */
+
+    Move GameState::getLastMove() const{
+        return (this->ply > 0) ? this->history[this->ply - 1].move : Move();
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Get the number of occurrences of the current position in the game
+     * @return int
+     */
+
+    int GameState::getRepetitionCount() const{
+        return this->repetitions.count(this->position.getKey());
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Is the current position a threefold repetition
+     * @return bool
+     */
+
+    bool GameState::isThreefoldRepetition() const{
+        return this->getRepetitionCount() >= 3;
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Can a draw be claimed by the 50-move rule
+     * @return bool
+     */
+
+    bool GameState::isFiftyMoveDraw() const{
+        return this->position.getHalfmoveClock() >= 100;
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Is the game a dead draw by material
+     * @details Only the kings with at most one knight or bishop : the rarer dead positions (bishops of one color) are
+     * left to the other rules
+     * @return bool
+     */
+
+    bool GameState::isInsufficientMaterial() const{
+        if(this->position.getPieces(W_PAWN) | this->position.getPieces(B_PAWN) | this->position.getPieces(W_ROOK)
+        | this->position.getPieces(B_ROOK) | this->position.getPieces(W_QUEEN) | this->position.getPieces(B_QUEEN)){
+            return false;
+        }
+        return popCount(this->position.getOccupied()) <= 3;
+    }
+}
@@ -0,0 +1,173 @@
+/**
+ * @author obiwan138
+ * @file MappedFile.cpp
+ * @brief Implementation of the MappedFile class
+ */
+
+#include "engine/MappedFile.hpp"
+
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <new>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define CHESS3D_HAS_MMAP
+#endif
+
+namespace engine{
+
+    namespace{
+
+        // Alignment of the buffer when the file cannot be mapped (a page, as mmap)
+        constexpr size_t BUFFER_ALIGNMENT = 4096;
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Constructor
+     */
+
+    MappedFile::MappedFile(){
+        this->data = nullptr;
+        this->size = 0;
+        this->mapped = false;
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Map a file (the previous one is unmapped)
+     * @param path : path of the file
+     * @param randomAccess : only a few pages will be read (no read ahead)
+     * @return true if the file is mapped
+     */
+
+    bool MappedFile::open(const std::string& path, bool randomAccess){
+        this->close();
+
+#ifdef CHESS3D_HAS_MMAP
+        const int fd = ::open(path.c_str(), O_RDONLY);
+        if(fd < 0){
+            std::cerr << "Error: cannot open " << path << std::endl;
+            return false;
+        }
+
+        struct stat status;
+        if(fstat(fd, &status) != 0 || status.st_size <= 0){
+            std::cerr << "Error: " << path << " is empty or cannot be read" << std::endl;
+            ::close(fd);
+            return false;
+        }
+
+        // The mapping keeps its own reference to the file
+        void* memory = mmap(nullptr, static_cast<size_t>(status.st_size), PROT_READ, MAP_SHARED, fd, 0);
+        ::close(fd);
+        if(memory == MAP_FAILED){
+            std::cerr << "Error: cannot map " << path << std::endl;
+            return false;
+        }
+        madvise(memory, static_cast<size_t>(status.st_size), randomAccess ? MADV_RANDOM : MADV_WILLNEED);
+
+        this->data = static_cast<const uint8_t*>(memory);
+        this->size = static_cast<size_t>(status.st_size);
+        this->mapped = true;
+        return true;
+#else
+        (void)randomAccess;
+        std::FILE* file = std::fopen(path.c_str(), "rb");
+        if(!file){
+            std::cerr << "Error: cannot open " << path << std::endl;
+            return false;
+        }
+        std::fseek(file, 0, SEEK_END);
+        const long length = std::ftell(file);
+        std::fseek(file, 0, SEEK_SET);
+        if(length <= 0){
+            std::cerr << "Error: " << path << " is empty or cannot be read" << std::endl;
+            std::fclose(file);
+            return false;
+        }
+
+        uint8_t* buffer = static_cast<uint8_t*>(::operator new(static_cast<size_t>(length), std::align_val_t(BUFFER_ALIGNMENT)));
+        const size_t read = std::fread(buffer, 1, static_cast<size_t>(length), file);
+        std::fclose(file);
+        if(read != static_cast<size_t>(length)){
+            std::cerr << "Error: cannot read " << path << std::endl;
+            ::operator delete(buffer, std::align_val_t(BUFFER_ALIGNMENT));
+            return false;
+        }
+
+        this->data = buffer;
+        this->size = static_cast<size_t>(length);
+        this->mapped = false;
+        return true;
+#endif
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Unmap the file
+     */
+
+    void MappedFile::close(){
+        if(!this->data){
+            return;
+        }
+
+#ifdef CHESS3D_HAS_MMAP
+        if(this->mapped){
+            munmap(const_cast<uint8_t*>(this->data), this->size);
+        }
+#endif
+        if(!this->mapped){
+            ::operator delete(const_cast<uint8_t*>(this->data), std::align_val_t(BUFFER_ALIGNMENT));
+        }
+
+        this->data = nullptr;
+        this->size = 0;
+        this->mapped = false;
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Is a file mapped
+     * @return bool
+     */
+
+    bool MappedFile::isOpen() const{
+        return this->data != nullptr;
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Get the content of the file
+     * @return const uint8_t* (null if no file is mapped)
+     */
+
+    const uint8_t* MappedFile::getData() const{
+        return this->data;
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Get the size of the file
+     * @return size_t [bytes]
+     */
+
+    size_t MappedFile::getSize() const{
+        return this->size;
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Destructor
+     */
+
+    MappedFile::~MappedFile(){
+        this->close();
+    }
+}
@@ -0,0 +1,31 @@
+/**
+ * @author obiwan138
+ * @file Move.cpp
+ * @brief Implementation of the Move class
+ */
+
+#include "engine/Move.hpp"
+
+namespace engine{
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Long algebraic notation of the move, as used by UCI
+     * @return std::string like "e2e4", "e7e8q", or "0000" for the null move
+     */
+
+    std::string Move::toUci() const{
+        if(this->isNull()){
+            return "0000";
+        }
+
+        std::string uci = {
+            static_cast<char>('a' + fileOf(this->from())), static_cast<char>('1' + rankOf(this->from())),
+            static_cast<char>('a' + fileOf(this->to())), static_cast<char>('1' + rankOf(this->to()))
+        };
+        if(this->type() == PROMOTION){
+            uci += "nbrq"[this->promotionType() - KNIGHT];
+        }
+        return uci;
+    }
+}
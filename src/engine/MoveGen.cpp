@@ -0,0 +1,286 @@
+/**
+ * @author obiwan138
+ * @file MoveGen.cpp
+ * @brief Implementation of the legal move generator
+ */
+
+#include "engine/MoveGen.hpp"
+#include "engine/Attacks.hpp"
+
+namespace engine{
+
+    namespace{
+
+        /////////////////////////////////////////////////////////////////////////////////
+        /**
+         * @brief Add the moves from one square to a set of destination squares
+         */
+
+        inline Move* addMoves(Move* list, Square from, Bitboard targets){
+            while(targets){
+                *list++ = Move(from, popLsb(targets));
+            }
+            return list;
+        }
+
+        /////////////////////////////////////////////////////////////////////////////////
+        /**
+         * @brief Add the 4 promotions of a pawn move
+         */
+
+        inline Move* addPromotions(Move* list, Square from, Square to){
+            *list++ = Move(from, to, PROMOTION, QUEEN);
+            *list++ = Move(from, to, PROMOTION, ROOK);
+            *list++ = Move(from, to, PROMOTION, BISHOP);
+            *list++ = Move(from, to, PROMOTION, KNIGHT);
+            return list;
+        }
+
+        /////////////////////////////////////////////////////////////////////////////////
+        /**
+         * @brief Add the pawn moves of a set of pawns
+         * @details The moves are generated set-wise (all the pawns shifted at once). The set is either all the unpinned
+         * pawns, or a single pinned pawn whose allowed squares are restricted to its pin line.
+         * @param pawns : the pawns to move
+         * @param allowed : the allowed destination squares (check and pin restrictions)
+         * @tparam CapturesOnly : only the captures and the promotions
+         */
+
+        template<Color Us, bool CapturesOnly>
+        Move* addPawnMoves(Move* list, Bitboard pawns, Bitboard allowed, Bitboard empty, Bitboard enemies){
+
+            constexpr int up = (Us == WHITE) ? 8 : -8;
+            constexpr Bitboard rank7 = (Us == WHITE) ? RANK_7_BB : RANK_2_BB;
+            constexpr Bitboard rank3 = (Us == WHITE) ? RANK_3_BB : RANK_6_BB;
+
+            const Bitboard notPromoting = pawns & ~rank7;
+            const Bitboard promoting = pawns & rank7;
+
+            // Pushes
+            if(!CapturesOnly){
+                Bitboard single = shiftUp<Us>(notPromoting) & empty;
+                Bitboard twice = shiftUp<Us>(single & rank3) & empty & allowed;
+                single &= allowed;
+                while(single){
+                    Square to = popLsb(single);
+                    *list++ = Move(static_cast<Square>(to - up), to);
+                }
+                while(twice){
+                    Square to = popLsb(twice);
+                    *list++ = Move(static_cast<Square>(to - 2 * up), to);
+                }
+            }
+
+            // Captures
+            Bitboard west = shiftUpWest<Us>(notPromoting) & enemies & allowed;
+            Bitboard east = shiftUpEast<Us>(notPromoting) & enemies & allowed;
+            while(west){
+                Square to = popLsb(west);
+                *list++ = Move(static_cast<Square>(to - up + 1), to);
+            }
+            while(east){
+                Square to = popLsb(east);
+                *list++ = Move(static_cast<Square>(to - up - 1), to);
+            }
+
+            // Promotions (pushes and captures)
+            if(promoting){
+                Bitboard push = shiftUp<Us>(promoting) & empty & allowed;
+                Bitboard westPromo = shiftUpWest<Us>(promoting) & enemies & allowed;
+                Bitboard eastPromo = shiftUpEast<Us>(promoting) & enemies & allowed;
+                while(push){
+                    Square to = popLsb(push);
+                    list = addPromotions(list, static_cast<Square>(to - up), to);
+                }
+                while(westPromo){
+                    Square to = popLsb(westPromo);
+                    list = addPromotions(list, static_cast<Square>(to - up + 1), to);
+                }
+                while(eastPromo){
+                    Square to = popLsb(eastPromo);
+                    list = addPromotions(list, static_cast<Square>(to - up - 1), to);
+                }
+            }
+
+            return list;
+        }
+
+        /////////////////////////////////////////////////////////////////////////////////
+        /**
+         * @brief Generate the legal moves for one side
+         * @details
+         * - King moves : destination squares not attacked, the king being removed from the occupancy (x-rays).
+         * - Double check : only the king moves.
+         * - Single check : the other pieces must capture the checker or block the segment (check mask).
+         * - Pinned pieces stay on the line through their king and the pinning slider.
+         * - En passant is checked by recomputing the slider attacks with both pawns removed (rank discovered checks).
+         * @tparam CapturesOnly : only the captures and the promotions (quiescence search)
+         */
+
+        template<Color Us, bool CapturesOnly>
+        Move* generate(const Position& pos, Move* list){
+
+            constexpr Color Them = (Us == WHITE) ? BLACK : WHITE;
+
+            const Bitboard us = pos.getOccupancy(Us);
+            const Bitboard them = pos.getOccupancy(Them);
+            const Bitboard occupied = us | them;
+            const Square king = pos.getKingSquare(Us);
+
+            const Bitboard theirQueens = pos.getPieces(Them, QUEEN);
+            const Bitboard theirDiagonals = pos.getPieces(Them, BISHOP) | theirQueens;
+            const Bitboard theirOrthogonals = pos.getPieces(Them, ROOK) | theirQueens;
+
+            const Bitboard checkers = pos.attackersTo(king, occupied) & them;
+
+            // King moves
+            const Bitboard withoutKing = occupied ^ squareBB(king);
+            Bitboard kingTargets = kingAttacks(king) & (CapturesOnly ? them : ~us);
+            while(kingTargets){
+                Square to = popLsb(kingTargets);
+                if(!pos.isAttacked(to, Them, withoutKing)){
+                    *list++ = Move(king, to);
+                }
+            }
+
+            if(moreThanOne(checkers)){
+                return list;
+            }
+
+            // Squares where a piece must land : capture or block the checker
+            const Bitboard checkMask = checkers ? (between(king, lsb(checkers)) | checkers) : ~Bitboard(0);
+            const Bitboard targets = (CapturesOnly ? them : ~us) & checkMask;
+
+            // Pinned pieces
+            Bitboard pinned = 0;
+            Bitboard snipers = (rookAttacks(king, them) & theirOrthogonals) | (bishopAttacks(king, them) & theirDiagonals);
+            while(snipers){
+                Bitboard blockers = between(king, popLsb(snipers)) & occupied;
+                if(!moreThanOne(blockers)){
+                    pinned |= blockers & us;
+                }
+            }
+
+            // Pawns
+            const Bitboard pawns = pos.getPieces(Us, PAWN);
+            const Bitboard empty = ~occupied;
+            list = addPawnMoves<Us, CapturesOnly>(list, pawns & ~pinned, checkMask, empty, them);
+            Bitboard pinnedPawns = pawns & pinned;
+            while(pinnedPawns){
+                Square from = popLsb(pinnedPawns);
+                list = addPawnMoves<Us, CapturesOnly>(list, squareBB(from), checkMask & line(king, from), empty, them);
+            }
+
+            // En passant
+            const Square ep = pos.getEpSquare();
+            if(ep != NO_SQUARE){
+                const Square captured = static_cast<Square>(Us == WHITE ? ep - 8 : ep + 8);
+
+                // The capture must resolve a check (only a check by the captured pawn can be)
+                if(!checkers || (checkers & squareBB(captured))){
+                    Bitboard capturers = pawnAttacks(Them, ep) & pawns;
+                    while(capturers){
+                        Square from = popLsb(capturers);
+                        Bitboard after = (occupied ^ squareBB(from) ^ squareBB(captured)) | squareBB(ep);
+                        if(!(rookAttacks(king, after) & theirOrthogonals) && !(bishopAttacks(king, after) & theirDiagonals)){
+                            *list++ = Move(from, ep, EN_PASSANT);
+                        }
+                    }
+                }
+            }
+
+            // Knights (a pinned knight can never move)
+            Bitboard knights = pos.getPieces(Us, KNIGHT) & ~pinned;
+            while(knights){
+                Square from = popLsb(knights);
+                list = addMoves(list, from, knightAttacks(from) & targets);
+            }
+
+            // Sliders
+            Bitboard diagonals = pos.getPieces(Us, BISHOP) | pos.getPieces(Us, QUEEN);
+            while(diagonals){
+                Square from = popLsb(diagonals);
+                Bitboard b = bishopAttacks(from, occupied) & targets;
+                if(pinned & squareBB(from)){
+                    b &= line(king, from);
+                }
+                list = addMoves(list, from, b);
+            }
+            Bitboard orthogonals = pos.getPieces(Us, ROOK) | pos.getPieces(Us, QUEEN);
+            while(orthogonals){
+                Square from = popLsb(orthogonals);
+                Bitboard b = rookAttacks(from, occupied) & targets;
+                if(pinned & squareBB(from)){
+                    b &= line(king, from);
+                }
+                list = addMoves(list, from, b);
+            }
+
+            // Castling : not in check, empty path, king path not attacked
+            if(!CapturesOnly && !checkers){
+                constexpr CastlingRights kingSide = (Us == WHITE) ? WHITE_OO : BLACK_OO;
+                constexpr CastlingRights queenSide = (Us == WHITE) ? WHITE_OOO : BLACK_OOO;
+                constexpr Square kingFrom = (Us == WHITE) ? E1 : E8;
+                const uint8_t rights = pos.getCastlingRights();
+                const Bitboard rooks = pos.getPieces(Us, ROOK);
+
+                if((rights & kingSide) && king == kingFrom && (rooks & squareBB(static_cast<Square>(kingFrom + 3)))
+                    && !(between(kingFrom, static_cast<Square>(kingFrom + 3)) & occupied)
+                    && !pos.isAttacked(static_cast<Square>(kingFrom + 1), Them, occupied)
+                    && !pos.isAttacked(static_cast<Square>(kingFrom + 2), Them, occupied)){
+                    *list++ = Move(kingFrom, static_cast<Square>(kingFrom + 2), CASTLING);
+                }
+                if((rights & queenSide) && king == kingFrom && (rooks & squareBB(static_cast<Square>(kingFrom - 4)))
+                    && !(between(kingFrom, static_cast<Square>(kingFrom - 4)) & occupied)
+                    && !pos.isAttacked(static_cast<Square>(kingFrom - 1), Them, occupied)
+                    && !pos.isAttacked(static_cast<Square>(kingFrom - 2), Them, occupied)){
+                    *list++ = Move(kingFrom, static_cast<Square>(kingFrom - 2), CASTLING);
+                }
+            }
+
+            return list;
+        }
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Generate the legal moves of the side to move
+     * @param position : the position
+     * @param moves : the list receiving the moves (cleared first)
+     */
+
+    void generateLegalMoves(const Position& position, MoveList& moves){
+        moves.clear();
+        moves.tail() = (position.getSideToMove() == WHITE)
+            ? generate<WHITE, false>(position, moves.begin())
+            : generate<BLACK, false>(position, moves.begin());
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Generate the legal captures and promotions of the side to move
+     * @param position : the position
+     * @param moves : the list receiving the moves (cleared first)
+     */
+
+    void generateLegalCaptures(const Position& position, MoveList& moves){
+        moves.clear();
+        moves.tail() = (position.getSideToMove() == WHITE)
+            ? generate<WHITE, true>(position, moves.begin())
+            : generate<BLACK, true>(position, moves.begin());
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Is a move legal in a position
+     * @param position : the position
+     * @param move : the move to check
+     * @return true if the generator produces this move
+     */
+
+    bool isLegalMove(const Position& position, Move move){
+        MoveList moves;
+        generateLegalMoves(position, moves);
+        return moves.contains(move);
+    }
+}
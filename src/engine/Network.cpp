@@ -0,0 +1,295 @@
+/**
+ * @author obiwan138
+ * @file Network.cpp
+ * @brief Implementation of the Network class
+ */
+
+#include "engine/Network.hpp"
+
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+namespace engine{
+
+    namespace{
+
+        const char FILE_MAGIC[8] = {'C', '3', 'D', 'N', 'N', 'U', 'E', '\0'};
+
+        // Header of a network file (followed by zeros up to HEADER_SIZE)
+        struct FileHeader {
+            char magic[8];
+            uint32_t version;
+            uint32_t featureCount;
+            uint32_t accumulatorSize;
+            uint32_t hiddenSize;
+        };
+
+        // Size of a block rounded up to 64 bytes
+        constexpr size_t padded(size_t bytes){
+            return (bytes + 63) & ~static_cast<size_t>(63);
+        }
+
+        // Offsets of the blocks in the file
+        constexpr size_t FEATURE_BIASES_OFFSET = Network::HEADER_SIZE;
+        constexpr size_t FEATURE_WEIGHTS_OFFSET = FEATURE_BIASES_OFFSET + padded(Network::ACCUMULATOR_SIZE * sizeof(int16_t));
+        constexpr size_t HIDDEN1_BIASES_OFFSET = FEATURE_WEIGHTS_OFFSET
+            + padded(static_cast<size_t>(Network::FEATURE_COUNT) * Network::ACCUMULATOR_SIZE * sizeof(int16_t));
+        constexpr size_t HIDDEN1_WEIGHTS_OFFSET = HIDDEN1_BIASES_OFFSET + padded(Network::HIDDEN_SIZE * sizeof(int32_t));
+        constexpr size_t HIDDEN2_BIASES_OFFSET = HIDDEN1_WEIGHTS_OFFSET + padded(Network::HIDDEN_SIZE * 2 * Network::ACCUMULATOR_SIZE);
+        constexpr size_t HIDDEN2_WEIGHTS_OFFSET = HIDDEN2_BIASES_OFFSET + padded(Network::HIDDEN_SIZE * sizeof(int32_t));
+        constexpr size_t OUTPUT_BIAS_OFFSET = HIDDEN2_WEIGHTS_OFFSET + padded(Network::HIDDEN_SIZE * Network::HIDDEN_SIZE);
+        constexpr size_t OUTPUT_WEIGHTS_OFFSET = OUTPUT_BIAS_OFFSET + padded(sizeof(int32_t));
+        constexpr size_t FILE_SIZE = OUTPUT_WEIGHTS_OFFSET + padded(Network::HIDDEN_SIZE);
+
+        static_assert(sizeof(FileHeader) <= Network::HEADER_SIZE, "The header must fit in its block");
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Constructor
+     */
+
+    Network::Network(){
+        this->featureBiases = nullptr;
+        this->featureWeights = nullptr;
+        this->hidden1Biases = nullptr;
+        this->hidden1Weights = nullptr;
+        this->hidden2Biases = nullptr;
+        this->hidden2Weights = nullptr;
+        this->outputBias = nullptr;
+        this->outputWeights = nullptr;
+        this->kernels = &getNnueKernels(getBestSimdLevel());
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Map a network file
+     * @details The weights are used in place : the file is mapped on a page boundary and every block starts at a
+     * multiple of 64 bytes, so the rows are aligned for the SIMD loads.
+     * @param path : path of the file
+     * @return true if the file is a network of this architecture
+     */
+
+    bool Network::load(const std::string& path){
+        this->featureBiases = nullptr;
+
+        if(!this->file.open(path)){
+            return false;
+        }
+
+        FileHeader header;
+        if(this->file.getSize() < sizeof(header)){
+            std::cerr << "Error: " << path << " is not a network file" << std::endl;
+            this->file.close();
+            return false;
+        }
+        std::memcpy(&header, this->file.getData(), sizeof(header));
+
+        if(std::memcmp(header.magic, FILE_MAGIC, sizeof(FILE_MAGIC)) != 0 || header.version != FILE_VERSION){
+            std::cerr << "Error: " << path << " is not a network file (version " << FILE_VERSION << ")" << std::endl;
+            this->file.close();
+            return false;
+        }
+        if(header.featureCount != FEATURE_COUNT || header.accumulatorSize != ACCUMULATOR_SIZE
+        || header.hiddenSize != HIDDEN_SIZE || this->file.getSize() != FILE_SIZE){
+            std::cerr << "Error: the architecture of " << path << " (" << header.featureCount << " features, "
+                      << header.accumulatorSize << "x2-" << header.hiddenSize << "-" << header.hiddenSize
+                      << "-1) is not the one of the engine" << std::endl;
+            this->file.close();
+            return false;
+        }
+
+        const uint8_t* data = this->file.getData();
+        this->featureBiases = reinterpret_cast<const int16_t*>(data + FEATURE_BIASES_OFFSET);
+        this->featureWeights = reinterpret_cast<const int16_t*>(data + FEATURE_WEIGHTS_OFFSET);
+        this->hidden1Biases = reinterpret_cast<const int32_t*>(data + HIDDEN1_BIASES_OFFSET);
+        this->hidden1Weights = reinterpret_cast<const int8_t*>(data + HIDDEN1_WEIGHTS_OFFSET);
+        this->hidden2Biases = reinterpret_cast<const int32_t*>(data + HIDDEN2_BIASES_OFFSET);
+        this->hidden2Weights = reinterpret_cast<const int8_t*>(data + HIDDEN2_WEIGHTS_OFFSET);
+        this->outputBias = reinterpret_cast<const int32_t*>(data + OUTPUT_BIAS_OFFSET);
+        this->outputWeights = reinterpret_cast<const int8_t*>(data + OUTPUT_WEIGHTS_OFFSET);
+        return true;
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Is a network loaded
+     * @return bool
+     */
+
+    bool Network::isLoaded() const{
+        return this->featureBiases != nullptr;
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Select the kernels
+     * @param level : the instruction set (the scalar kernels are used if the processor does not support it)
+     */
+
+    void Network::setSimdLevel(SimdLevel level){
+        this->kernels = &getNnueKernels(level);
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Get the selected kernels
+     * @return const NnueKernels&
+     */
+
+    const NnueKernels& Network::getKernels() const{
+        return *this->kernels;
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Get the biases of the first layer
+     * @return const int16_t* ACCUMULATOR_SIZE values
+     */
+
+    const int16_t* Network::getFeatureBiases() const{
+        return this->featureBiases;
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Get the first layer weights of a feature
+     * @param feature : index of the feature
+     * @return const int16_t* ACCUMULATOR_SIZE values
+     */
+
+    const int16_t* Network::getFeatureWeights(int feature) const{
+        return this->featureWeights + static_cast<size_t>(feature) * ACCUMULATOR_SIZE;
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Evaluate from the accumulators
+     * @param us : accumulator of the side to move
+     * @param them : accumulator of the other side
+     * @return int the score from the side to move point of view [centipawns]
+     */
+
+    int Network::forward(const int16_t* us, const int16_t* them) const{
+        alignas(64) uint8_t input[2 * ACCUMULATOR_SIZE];
+        alignas(64) int32_t hidden[HIDDEN_SIZE];
+        alignas(64) uint8_t hidden1[HIDDEN_SIZE];
+        alignas(64) uint8_t hidden2[HIDDEN_SIZE];
+        int32_t output;
+
+        this->kernels->clampAccumulator(us, input, ACCUMULATOR_SIZE);
+        this->kernels->clampAccumulator(them, input + ACCUMULATOR_SIZE, ACCUMULATOR_SIZE);
+
+        this->kernels->affine(input, this->hidden1Weights, this->hidden1Biases, hidden, 2 * ACCUMULATOR_SIZE, HIDDEN_SIZE);
+        this->kernels->clippedRelu(hidden, hidden1, HIDDEN_SIZE, WEIGHT_SHIFT);
+
+        this->kernels->affine(hidden1, this->hidden2Weights, this->hidden2Biases, hidden, HIDDEN_SIZE, HIDDEN_SIZE);
+        this->kernels->clippedRelu(hidden, hidden2, HIDDEN_SIZE, WEIGHT_SHIFT);
+
+        this->kernels->affine(hidden2, this->outputWeights, this->outputBias, &output, HIDDEN_SIZE, 1);
+        return output / OUTPUT_SCALE;
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Index of a feature
+     * @details For black, the squares are flipped vertically so both points of view see their pieces on the first ranks.
+     * The pieces are numbered own pawn, their pawn, own knight, ... their queen.
+     * @param perspective : the point of view
+     * @param kingSquare : the king square of the point of view
+     * @param piece : a non-king piece
+     * @param square : the square of the piece
+     * @return int the feature index in [0, FEATURE_COUNT)
+     */
+
+    int Network::featureIndex(Color perspective, Square kingSquare, Piece piece, Square square){
+        const int flip = (perspective == WHITE) ? 0 : 56;
+        const int pieceIndex = typeOf(piece) * 2 + (colorOf(piece) != perspective ? 1 : 0);
+        return ((kingSquare ^ flip) * 10 + pieceIndex) * 64 + (square ^ flip);
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Get the size of a network file
+     * @return size_t [bytes]
+     */
+
+    size_t Network::getFileSize(){
+        return FILE_SIZE;
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Write a network of random weights
+     * @details The ranges keep the accumulators and the hidden layers in their useful range (neither all clamped to 0
+     * nor all saturated), so the benchmarks and the checks exercise every path of the kernels. Same seed, same file.
+     * @param path : path of the file
+     * @param seed : seed of the generator
+     * @return true if the file is written
+     */
+
+    bool Network::writeRandom(const std::string& path, uint64_t seed){
+        std::vector<uint8_t> buffer(FILE_SIZE, 0);
+
+        // splitmix64
+        uint64_t state = seed;
+        auto next = [&state](){
+            uint64_t z = (state += 0x9E3779B97F4A7C15ull);
+            z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+            z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+            return z ^ (z >> 31);
+        };
+        auto uniform = [&next](int low, int high){
+            return low + static_cast<int>(next() % static_cast<uint64_t>(high - low + 1));
+        };
+
+        FileHeader header = {};
+        std::memcpy(header.magic, FILE_MAGIC, sizeof(FILE_MAGIC));
+        header.version = FILE_VERSION;
+        header.featureCount = FEATURE_COUNT;
+        header.accumulatorSize = ACCUMULATOR_SIZE;
+        header.hiddenSize = HIDDEN_SIZE;
+        std::memcpy(buffer.data(), &header, sizeof(header));
+
+        auto fill16 = [&](size_t offset, size_t count, int low, int high){
+            for(size_t i = 0; i < count; i++){
+                const int16_t value = static_cast<int16_t>(uniform(low, high));
+                std::memcpy(buffer.data() + offset + i * sizeof(value), &value, sizeof(value));
+            }
+        };
+        auto fill32 = [&](size_t offset, size_t count, int low, int high){
+            for(size_t i = 0; i < count; i++){
+                const int32_t value = uniform(low, high);
+                std::memcpy(buffer.data() + offset + i * sizeof(value), &value, sizeof(value));
+            }
+        };
+        auto fill8 = [&](size_t offset, size_t count, int low, int high){
+            for(size_t i = 0; i < count; i++){
+                buffer[offset + i] = static_cast<uint8_t>(static_cast<int8_t>(uniform(low, high)));
+            }
+        };
+
+        fill16(FEATURE_BIASES_OFFSET, ACCUMULATOR_SIZE, 0, 64);
+        fill16(FEATURE_WEIGHTS_OFFSET, static_cast<size_t>(FEATURE_COUNT) * ACCUMULATOR_SIZE, -8, 8);
+        fill32(HIDDEN1_BIASES_OFFSET, HIDDEN_SIZE, -2048, 2048);
+        fill8(HIDDEN1_WEIGHTS_OFFSET, HIDDEN_SIZE * 2 * ACCUMULATOR_SIZE, -16, 16);
+        fill32(HIDDEN2_BIASES_OFFSET, HIDDEN_SIZE, -2048, 2048);
+        fill8(HIDDEN2_WEIGHTS_OFFSET, HIDDEN_SIZE * HIDDEN_SIZE, -16, 16);
+        fill32(OUTPUT_BIAS_OFFSET, 1, -256, 256);
+        fill8(OUTPUT_WEIGHTS_OFFSET, HIDDEN_SIZE, -16, 16);
+
+        std::ofstream output(path, std::ios::binary);
+        if(!output){
+            std::cerr << "Error: cannot create " << path << std::endl;
+            return false;
+        }
+        output.write(reinterpret_cast<const char*>(buffer.data()), static_cast<std::streamsize>(buffer.size()));
+        if(!output){
+            std::cerr << "Error: cannot write " << path << std::endl;
+            return false;
+        }
+        return true;
+    }
+}
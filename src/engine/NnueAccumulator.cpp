@@ -0,0 +1,210 @@
+/**
+ * @author obiwan138
+ * @file NnueAccumulator.cpp
+ * @brief Implementation of the NnueAccumulator class
+ */
+
+#include "engine/NnueAccumulator.hpp"
+
+#include <cassert>
+
+namespace engine{
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Constructor
+     */
+
+    NnueAccumulator::NnueAccumulator(){
+        this->reset();
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Start from a new root position
+     */
+
+    void NnueAccumulator::reset(){
+        this->top = 0;
+        this->stack[0].computed[WHITE] = false;
+        this->stack[0].computed[BLACK] = false;
+        this->stack[0].dirty.count = 0;
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Record a move
+     * @param position : the position before the move
+     * @param move : a legal move of the position
+     */
+
+    void NnueAccumulator::push(const Position& position, Move move){
+        assert(this->top < STACK_SIZE - 1);
+
+        Entry& entry = this->stack[++this->top];
+        entry.computed[WHITE] = false;
+        entry.computed[BLACK] = false;
+
+        DirtyPieces& dirty = entry.dirty;
+        const Square from = move.from();
+        const Square to = move.to();
+        const MoveType type = move.type();
+        const Piece piece = position.getPieceOn(from);
+        const Color us = colorOf(piece);
+
+        // The moving piece first (the king moves are spotted on it)
+        dirty.piece[0] = piece;
+        dirty.from[0] = from;
+        dirty.to[0] = (type == PROMOTION) ? NO_SQUARE : to;
+        dirty.count = 1;
+
+        if(type == PROMOTION){
+            dirty.piece[1] = makePiece(us, move.promotionType());
+            dirty.from[1] = NO_SQUARE;
+            dirty.to[1] = to;
+            dirty.count = 2;
+        }
+
+        if(type == CASTLING){
+            const bool kingSide = to > from;
+            dirty.piece[1] = makePiece(us, ROOK);
+            dirty.from[1] = makeSquare(kingSide ? 7 : 0, rankOf(from));
+            dirty.to[1] = makeSquare(kingSide ? 5 : 3, rankOf(from));
+            dirty.count = 2;
+        }
+        else if(type == EN_PASSANT){
+            dirty.piece[dirty.count] = makePiece(~us, PAWN);
+            dirty.from[dirty.count] = static_cast<Square>(us == WHITE ? to - 8 : to + 8);
+            dirty.to[dirty.count] = NO_SQUARE;
+            dirty.count++;
+        }
+        else if(position.getPieceOn(to) != NO_PIECE){
+            dirty.piece[dirty.count] = position.getPieceOn(to);
+            dirty.from[dirty.count] = to;
+            dirty.to[dirty.count] = NO_SQUARE;
+            dirty.count++;
+        }
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Record a null move (no piece changes)
+     */
+
+    void NnueAccumulator::pushNull(){
+        assert(this->top < STACK_SIZE - 1);
+
+        Entry& entry = this->stack[++this->top];
+        entry.computed[WHITE] = false;
+        entry.computed[BLACK] = false;
+        entry.dirty.count = 0;
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Go back to the previous position
+     */
+
+    void NnueAccumulator::pop(){
+        assert(this->top > 0);
+        this->top--;
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Compute an accumulator from the whole position
+     * @param entry : the entry of the position
+     * @param perspective : the point of view
+     * @param position : the position
+     * @param network : the network
+     */
+
+    void NnueAccumulator::refresh(Entry& entry, Color perspective, const Position& position, const Network& network){
+        const Square kingSquare = position.getKingSquare(perspective);
+        const int16_t* rows[32];
+        int rowCount = 0;
+
+        Bitboard pieces = position.getOccupied() & ~(position.getPieces(W_KING) | position.getPieces(B_KING));
+        while(pieces){
+            const Square square = popLsb(pieces);
+            rows[rowCount++] = network.getFeatureWeights(Network::featureIndex(perspective, kingSquare, position.getPieceOn(square), square));
+        }
+
+        network.getKernels().addSubRows(entry.values[perspective], network.getFeatureBiases(), rows, rowCount,
+                                         nullptr, 0, Network::ACCUMULATOR_SIZE);
+        entry.computed[perspective] = true;
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Compute an accumulator from the previous entry
+     * @param index : the entry to compute (the previous one is computed)
+     * @param perspective : the point of view
+     * @param kingSquare : the king square of the point of view (it did not move)
+     * @param network : the network
+     */
+
+    void NnueAccumulator::update(int index, Color perspective, Square kingSquare, const Network& network){
+        Entry& entry = this->stack[index];
+        const DirtyPieces& dirty = entry.dirty;
+        const int16_t* added[3];
+        const int16_t* removed[3];
+        int addedCount = 0;
+        int removedCount = 0;
+
+        for(int i = 0; i < dirty.count; i++){
+            if(typeOf(dirty.piece[i]) == KING){
+                continue;
+            }
+            if(dirty.from[i] != NO_SQUARE){
+                removed[removedCount++] = network.getFeatureWeights(Network::featureIndex(perspective, kingSquare, dirty.piece[i], dirty.from[i]));
+            }
+            if(dirty.to[i] != NO_SQUARE){
+                added[addedCount++] = network.getFeatureWeights(Network::featureIndex(perspective, kingSquare, dirty.piece[i], dirty.to[i]));
+            }
+        }
+
+        network.getKernels().addSubRows(entry.values[perspective], this->stack[index - 1].values[perspective],
+                                         added, addedCount, removed, removedCount, Network::ACCUMULATOR_SIZE);
+        entry.computed[perspective] = true;
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Evaluate the current position
+     * @param position : the position of the top of the stack
+     * @param network : the network
+     * @return int the score from the side to move point of view [centipawns]
+     */
+
+    int NnueAccumulator::evaluate(const Position& position, const Network& network){
+        Entry& current = this->stack[this->top];
+
+        for(Color perspective : {WHITE, BLACK}){
+            if(current.computed[perspective]){
+                continue;
+            }
+
+            // Closest computed ancestor, unless the king of this point of view moved since
+            const Piece king = makePiece(perspective, KING);
+            int index = this->top;
+            while(index > 0 && !this->stack[index].computed[perspective]
+            && !(this->stack[index].dirty.count > 0 && this->stack[index].dirty.piece[0] == king)){
+                index--;
+            }
+
+            if(this->stack[index].computed[perspective]){
+                const Square kingSquare = position.getKingSquare(perspective);
+                for(int i = index + 1; i <= this->top; i++){
+                    this->update(i, perspective, kingSquare, network);
+                }
+            }
+            else{
+                this->refresh(current, perspective, position, network);
+            }
+        }
+
+        const Color us = position.getSideToMove();
+        return network.forward(current.values[us], current.values[~us]);
+    }
+}
@@ -0,0 +1,315 @@
+/**
+ * @author obiwan138
+ * @file NnueKernels.cpp
+ * @brief Scalar and SIMD versions of the neural network kernels
+ * @details The SIMD versions are compiled with target attributes (no global -mavx2 flag), and only called when the
+ * processor supports them. Why they give the same results as the scalar versions :
+ * - the int16 additions wrap in both cases (and the networks are built so that they do not overflow),
+ * - maddubs multiplies the inputs (uint8, at most 127 after the clamp) by the weights (int8) and adds the products two by
+ *   two with int16 saturation, which is never reached : 2 * 127 * 128 = 32512 < 32767,
+ * - the packs instructions saturate to the int16 then int8 range before the clamp to [0, 127], which gives the same value
+ *   as clamping first.
+ */
+
+#include "engine/NnueKernels.hpp"
+
+#include <algorithm>
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define CHESS3D_NNUE_X86
+#endif
+
+namespace engine{
+
+    namespace{
+
+        /////////////////////////////////////////////////////////////////////////////////////
+        // Scalar reference
+
+        void addSubRowsScalar(int16_t* out, const int16_t* base, const int16_t* const* added, int addedCount,
+                              const int16_t* const* removed, int removedCount, int size){
+            for(int i = 0; i < size; i++){
+                int value = base[i];
+                for(int r = 0; r < addedCount; r++){
+                    value = static_cast<int16_t>(value + added[r][i]);
+                }
+                for(int r = 0; r < removedCount; r++){
+                    value = static_cast<int16_t>(value - removed[r][i]);
+                }
+                out[i] = static_cast<int16_t>(value);
+            }
+        }
+
+        void clampAccumulatorScalar(const int16_t* in, uint8_t* out, int size){
+            for(int i = 0; i < size; i++){
+                out[i] = static_cast<uint8_t>(std::clamp<int>(in[i], 0, 127));
+            }
+        }
+
+        void affineScalar(const uint8_t* in, const int8_t* weights, const int32_t* biases, int32_t* out,
+                          int inputSize, int outputSize){
+            for(int i = 0; i < outputSize; i++){
+                const int8_t* row = weights + i * inputSize;
+                int32_t sum = biases[i];
+                for(int j = 0; j < inputSize; j++){
+                    sum += in[j] * row[j];
+                }
+                out[i] = sum;
+            }
+        }
+
+        void clippedReluScalar(const int32_t* in, uint8_t* out, int size, int shift){
+            for(int i = 0; i < size; i++){
+                out[i] = static_cast<uint8_t>(std::clamp(in[i] >> shift, 0, 127));
+            }
+        }
+
+#ifdef CHESS3D_NNUE_X86
+
+        /////////////////////////////////////////////////////////////////////////////////////
+        // SSE4.1
+
+        __attribute__((target("sse4.1")))
+        void addSubRowsSse41(int16_t* out, const int16_t* base, const int16_t* const* added, int addedCount,
+                             const int16_t* const* removed, int removedCount, int size){
+            for(int i = 0; i < size; i += 8){
+                __m128i value = _mm_loadu_si128(reinterpret_cast<const __m128i*>(base + i));
+                for(int r = 0; r < addedCount; r++){
+                    value = _mm_add_epi16(value, _mm_loadu_si128(reinterpret_cast<const __m128i*>(added[r] + i)));
+                }
+                for(int r = 0; r < removedCount; r++){
+                    value = _mm_sub_epi16(value, _mm_loadu_si128(reinterpret_cast<const __m128i*>(removed[r] + i)));
+                }
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), value);
+            }
+        }
+
+        __attribute__((target("sse4.1")))
+        void clampAccumulatorSse41(const int16_t* in, uint8_t* out, int size){
+            const __m128i zero = _mm_setzero_si128();
+            for(int i = 0; i < size; i += 16){
+                const __m128i low = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i));
+                const __m128i high = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i + 8));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), _mm_max_epi8(_mm_packs_epi16(low, high), zero));
+            }
+        }
+
+        __attribute__((target("sse4.1")))
+        void affineSse41(const uint8_t* in, const int8_t* weights, const int32_t* biases, int32_t* out,
+                         int inputSize, int outputSize){
+            const __m128i ones = _mm_set1_epi16(1);
+            for(int i = 0; i < outputSize; i++){
+                const int8_t* row = weights + i * inputSize;
+                __m128i sum = _mm_setzero_si128();
+                for(int j = 0; j < inputSize; j += 16){
+                    const __m128i products = _mm_maddubs_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(in + j)),
+                                                               _mm_loadu_si128(reinterpret_cast<const __m128i*>(row + j)));
+                    sum = _mm_add_epi32(sum, _mm_madd_epi16(products, ones));
+                }
+                sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, 0x4E));
+                sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, 0xB1));
+                out[i] = biases[i] + _mm_cvtsi128_si32(sum);
+            }
+        }
+
+        __attribute__((target("sse4.1")))
+        void clippedReluSse41(const int32_t* in, uint8_t* out, int size, int shift){
+            const __m128i zero = _mm_setzero_si128();
+            const __m128i count = _mm_cvtsi32_si128(shift);
+            for(int i = 0; i < size; i += 8){
+                const __m128i low = _mm_sra_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i)), count);
+                const __m128i high = _mm_sra_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i + 4)), count);
+                const __m128i words = _mm_packs_epi32(low, high);
+                _mm_storel_epi64(reinterpret_cast<__m128i*>(out + i), _mm_max_epi8(_mm_packs_epi16(words, words), zero));
+            }
+        }
+
+        /////////////////////////////////////////////////////////////////////////////////////
+        // AVX2 (the clipped ReLU only runs on 32 values : the SSE4.1 version is used)
+
+        __attribute__((target("avx2")))
+        void addSubRowsAvx2(int16_t* out, const int16_t* base, const int16_t* const* added, int addedCount,
+                            const int16_t* const* removed, int removedCount, int size){
+            for(int i = 0; i < size; i += 16){
+                __m256i value = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(base + i));
+                for(int r = 0; r < addedCount; r++){
+                    value = _mm256_add_epi16(value, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(added[r] + i)));
+                }
+                for(int r = 0; r < removedCount; r++){
+                    value = _mm256_sub_epi16(value, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(removed[r] + i)));
+                }
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), value);
+            }
+        }
+
+        __attribute__((target("avx2")))
+        void clampAccumulatorAvx2(const int16_t* in, uint8_t* out, int size){
+            const __m256i zero = _mm256_setzero_si256();
+            for(int i = 0; i < size; i += 32){
+                const __m256i low = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + i));
+                const __m256i high = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + i + 16));
+
+                // packs works in each 128-bit lane : the 64-bit blocks are put back in order
+                const __m256i packed = _mm256_permute4x64_epi64(_mm256_packs_epi16(low, high), 0xD8);
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), _mm256_max_epi8(packed, zero));
+            }
+        }
+
+        __attribute__((target("avx2")))
+        int32_t horizontalSumAvx2(__m256i sum){
+            __m128i half = _mm_add_epi32(_mm256_castsi256_si128(sum), _mm256_extracti128_si256(sum, 1));
+            half = _mm_add_epi32(half, _mm_shuffle_epi32(half, 0x4E));
+            half = _mm_add_epi32(half, _mm_shuffle_epi32(half, 0xB1));
+            return _mm_cvtsi128_si32(half);
+        }
+
+        __attribute__((target("avx2")))
+        void affineAvx2(const uint8_t* in, const int8_t* weights, const int32_t* biases, int32_t* out,
+                        int inputSize, int outputSize){
+            const __m256i ones = _mm256_set1_epi16(1);
+            for(int i = 0; i < outputSize; i++){
+                const int8_t* row = weights + i * inputSize;
+                __m256i sum = _mm256_setzero_si256();
+                for(int j = 0; j < inputSize; j += 32){
+                    const __m256i products = _mm256_maddubs_epi16(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + j)),
+                                                                  _mm256_loadu_si256(reinterpret_cast<const __m256i*>(row + j)));
+                    sum = _mm256_add_epi32(sum, _mm256_madd_epi16(products, ones));
+                }
+                out[i] = biases[i] + horizontalSumAvx2(sum);
+            }
+        }
+
+        /////////////////////////////////////////////////////////////////////////////////////
+        // AVX-512 (byte and word instructions : AVX512BW)
+
+        // The AVX-512 intrinsics of GCC start from undefined registers, which -Wmaybe-uninitialized reports
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#endif
+
+        __attribute__((target("avx512f,avx512bw")))
+        void addSubRowsAvx512(int16_t* out, const int16_t* base, const int16_t* const* added, int addedCount,
+                              const int16_t* const* removed, int removedCount, int size){
+            for(int i = 0; i < size; i += 32){
+                __m512i value = _mm512_loadu_si512(base + i);
+                for(int r = 0; r < addedCount; r++){
+                    value = _mm512_add_epi16(value, _mm512_loadu_si512(added[r] + i));
+                }
+                for(int r = 0; r < removedCount; r++){
+                    value = _mm512_sub_epi16(value, _mm512_loadu_si512(removed[r] + i));
+                }
+                _mm512_storeu_si512(out + i, value);
+            }
+        }
+
+        __attribute__((target("avx512f,avx512bw")))
+        void clampAccumulatorAvx512(const int16_t* in, uint8_t* out, int size){
+            const __m512i zero = _mm512_setzero_si512();
+            const __m512i order = _mm512_setr_epi64(0, 2, 4, 6, 1, 3, 5, 7);
+            for(int i = 0; i < size; i += 64){
+                const __m512i low = _mm512_loadu_si512(in + i);
+                const __m512i high = _mm512_loadu_si512(in + i + 32);
+                const __m512i packed = _mm512_permutexvar_epi64(order, _mm512_packs_epi16(low, high));
+                _mm512_storeu_si512(out + i, _mm512_max_epi8(packed, zero));
+            }
+        }
+
+        __attribute__((target("avx512f,avx512bw")))
+        void affineAvx512(const uint8_t* in, const int8_t* weights, const int32_t* biases, int32_t* out,
+                          int inputSize, int outputSize){
+            const __m512i ones = _mm512_set1_epi16(1);
+            const __m256i halfOnes = _mm256_set1_epi16(1);
+            const int wideSize = inputSize & ~63;
+            for(int i = 0; i < outputSize; i++){
+                const int8_t* row = weights + i * inputSize;
+                __m512i sum = _mm512_setzero_si512();
+                for(int j = 0; j < wideSize; j += 64){
+                    const __m512i products = _mm512_maddubs_epi16(_mm512_loadu_si512(in + j), _mm512_loadu_si512(row + j));
+                    sum = _mm512_add_epi32(sum, _mm512_madd_epi16(products, ones));
+                }
+
+                // Last 32 inputs (the hidden layers have 32 inputs only)
+                __m256i tail = _mm256_setzero_si256();
+                if(wideSize < inputSize){
+                    const __m256i products = _mm256_maddubs_epi16(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + wideSize)),
+                                                                  _mm256_loadu_si256(reinterpret_cast<const __m256i*>(row + wideSize)));
+                    tail = _mm256_madd_epi16(products, halfOnes);
+                }
+                const __m512i folded = _mm512_add_epi32(sum, _mm512_shuffle_i64x2(sum, sum, 0x4E));
+                out[i] = biases[i] + horizontalSumAvx2(_mm256_add_epi32(_mm512_castsi512_si256(folded), tail));
+            }
+        }
+
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+
+        const NnueKernels sse41Kernels = {SIMD_SSE41, "sse4.1", addSubRowsSse41, clampAccumulatorSse41, affineSse41, clippedReluSse41};
+        const NnueKernels avx2Kernels = {SIMD_AVX2, "avx2", addSubRowsAvx2, clampAccumulatorAvx2, affineAvx2, clippedReluSse41};
+        const NnueKernels avx512Kernels = {SIMD_AVX512, "avx512", addSubRowsAvx512, clampAccumulatorAvx512, affineAvx512, clippedReluSse41};
+
+#endif
+
+        const NnueKernels scalarKernels = {SIMD_SCALAR, "scalar", addSubRowsScalar, clampAccumulatorScalar, affineScalar, clippedReluScalar};
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Can the processor run the kernels of a level
+     * @param level : the instruction set
+     * @return bool
+     */
+
+    bool isSimdLevelSupported(SimdLevel level){
+#ifdef CHESS3D_NNUE_X86
+        switch(level){
+            case SIMD_SCALAR : return true;
+            case SIMD_SSE41 : return __builtin_cpu_supports("sse4.1");
+            case SIMD_AVX2 : return __builtin_cpu_supports("avx2");
+            case SIMD_AVX512 : return __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw");
+            default : return false;
+        }
+#else
+        return level == SIMD_SCALAR;
+#endif
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Get the best level supported by the processor
+     * @return SimdLevel
+     */
+
+    SimdLevel getBestSimdLevel(){
+        for(int level = SIMD_LEVEL_NB - 1; level > SIMD_SCALAR; level--){
+            if(isSimdLevelSupported(static_cast<SimdLevel>(level))){
+                return static_cast<SimdLevel>(level);
+            }
+        }
+        return SIMD_SCALAR;
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Get the kernels of a level
+     * @param level : the instruction set
+     * @return const NnueKernels& the scalar kernels if the level is not supported
+     */
+
+    const NnueKernels& getNnueKernels(SimdLevel level){
+        if(!isSimdLevelSupported(level)){
+            return scalarKernels;
+        }
+#ifdef CHESS3D_NNUE_X86
+        switch(level){
+            case SIMD_SSE41 : return sse41Kernels;
+            case SIMD_AVX2 : return avx2Kernels;
+            case SIMD_AVX512 : return avx512Kernels;
+            default : break;
+        }
+#endif
+        return scalarKernels;
+    }
+}
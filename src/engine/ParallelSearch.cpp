@@ -0,0 +1,144 @@
+/**
+ * @author obiwan138
+ * @file ParallelSearch.cpp
+ * @brief Implementation of the ParallelSearch class
+ */
+
+#include "engine/ParallelSearch.hpp"
+
+#include <algorithm>
+
+#include <omp.h>
+
+namespace engine{
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Constructor
+     * @param ttIn : transposition table (shared with the caller, which owns it)
+     * @param threadCount : number of threads (at least 1)
+     */
+
+    ParallelSearch::ParallelSearch(TranspositionTable& ttIn, int threadCount)
+        :tt(ttIn){
+        this->setThreadCount(threadCount);
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Change the number of threads
+     * @details Must not be called during a search. The searches are rebuilt, their move ordering statistics are lost.
+     * @param threadCount : number of threads (at least 1)
+     */
+
+    void ParallelSearch::setThreadCount(int threadCount){
+        threadCount = std::max(threadCount, 1);
+        this->searches.clear();
+        for(int i = 0; i < threadCount; i++){
+            this->searches.push_back(std::make_unique<Search>(this->tt, i, &(this->shared)));
+        }
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Get the number of threads
+     * @return int
+     */
+
+    int ParallelSearch::getThreadCount() const{
+        return static_cast<int>(this->searches.size());
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Get the number of hardware threads
+     * @return int
+     */
+
+    int ParallelSearch::getMaxThreads(){
+        return omp_get_num_procs();
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Search the best move with all the threads
+     * @details The main thread searches with the limits and raises the shared stop flag when it returns, the helpers
+     * search without limit until then. The move of a helper is preferred when it completed a deeper iteration without a
+     * lower score.
+     * @param root : the position and its history
+     * @param limits : depth, node and time limits
+     * @param onIteration : called by the main thread after each completed depth (may be empty)
+     * @return SearchResult the result, with the node count of all the threads
+     */
+
+    SearchResult ParallelSearch::run(const GameState& root, const SearchLimits& limits,
+                                     const std::function<void(const SearchResult&)>& onIteration){
+
+        this->shared.stop.store(false, std::memory_order_relaxed);
+        this->shared.nodes.store(0, std::memory_order_relaxed);
+        this->shared.pondering.store(limits.ponder, std::memory_order_relaxed);
+        this->tt.newSearch();
+
+        const int threadCount = this->getThreadCount();
+        std::vector<SearchResult> results(threadCount);
+
+        #pragma omp parallel num_threads(threadCount)
+        {
+            const int id = omp_get_thread_num();
+            if(id == 0){
+                results[0] = this->searches[0]->run(root, limits, onIteration);
+                this->shared.stop.store(true, std::memory_order_relaxed);
+            }
+            else{
+                SearchLimits helperLimits;
+                helperLimits.infinite = true;
+                results[id] = this->searches[id]->run(root, helperLimits);
+            }
+        }
+
+        // Vote : the main thread, unless a helper went deeper with at least the same score
+        SearchResult best = results[0];
+        for(int i = 1; i < threadCount; i++){
+            if(results[i].depth > best.depth && results[i].score >= best.score && !results[i].bestMove.isNull()){
+                best.bestMove = results[i].bestMove;
+                best.score = results[i].score;
+                best.depth = results[i].depth;
+                best.selDepth = results[i].selDepth;
+                best.pv = results[i].pv;
+            }
+        }
+
+        best.nodes = this->shared.nodes.load(std::memory_order_relaxed);
+        best.nps = best.nodes * 1000 / static_cast<uint64_t>(std::max<int64_t>(best.timeMs, 1));
+        return best;
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Ask a running search to stop
+     */
+
+    void ParallelSearch::stop(){
+        this->shared.stop.store(true, std::memory_order_relaxed);
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief The move pondered on was played : the limits apply from now on
+     */
+
+    void ParallelSearch::ponderhit(){
+        this->shared.pondering.store(false, std::memory_order_relaxed);
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Forget the move ordering statistics of all the threads (new game)
+     */
+
+    void ParallelSearch::clear(){
+        for(std::unique_ptr<Search>& search : this->searches){
+            search->clear();
+        }
+    }
+}
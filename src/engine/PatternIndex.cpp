@@ -0,0 +1,890 @@
+/**
+ * @author obiwan138
+ * @file PatternIndex.cpp
+ * @brief Implementation of the PatternIndex class
+ */
+
+#include "engine/PatternIndex.hpp"
+#include "engine/Zobrist.hpp"
+
+#include <omp.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace engine{
+
+    namespace{
+
+        const char FILE_MAGIC[8] = {'C', '3', 'D', 'P', 'A', 'T', 'R', 'N'};
+
+        // Header of an index file (followed by zeros up to HEADER_SIZE, the bitmaps start after it)
+        struct FileHeader {
+            char magic[8];
+            uint32_t version;
+            uint32_t reserved;
+            uint64_t keyCount;
+            uint64_t gameCount;
+            uint64_t keysOffset;
+            uint64_t offsetsOffset;
+        };
+
+        static_assert(sizeof(FileHeader) <= PatternIndex::HEADER_SIZE, "The header must fit in its block");
+
+        // Terms waiting for their operator while a query is evaluated on a position
+        constexpr int MAX_QUERY_DEPTH = 64;
+
+        // Key reached by a game, while building
+        struct Pair {
+            uint64_t key;
+            uint32_t game;
+
+            bool operator<(const Pair& other) const{
+                return this->key < other.key || (this->key == other.key && this->game < other.game);
+            }
+        };
+
+        // Games decoded in parallel between two appends to the pairs
+        constexpr uint64_t BATCH_GAMES = 4096;
+
+        // Piece letters of the material signatures, in the order of their names
+        const char MATERIAL_LETTERS[] = {'Q', 'R', 'B', 'N', 'P'};
+        const PieceType MATERIAL_TYPES[] = {QUEEN, ROOK, BISHOP, KNIGHT, PAWN};
+
+        // Shift of the count of a kind of piece in a material signature
+        int materialShift(Color color, PieceType type){
+            return (static_cast<int>(color) * 5 + static_cast<int>(type)) * 4;
+        }
+
+        // Reader of a run file for the merge
+        struct RunReader {
+            std::FILE* file = nullptr;
+            std::vector<Pair> buffer;
+            size_t position = 0;
+            size_t size = 0;
+
+            bool next(Pair& pair){
+                if(this->position == this->size){
+                    this->size = std::fread(this->buffer.data(), sizeof(Pair), this->buffer.size(), this->file);
+                    this->position = 0;
+                    if(this->size == 0){
+                        return false;
+                    }
+                }
+                pair = this->buffer[this->position++];
+                return true;
+            }
+        };
+
+        // Append the whole content of a file to another, return false on a read or write error
+        bool appendFile(std::FILE* output, const std::string& path){
+            std::FILE* input = std::fopen(path.c_str(), "rb");
+            if(!input){
+                return false;
+            }
+            std::vector<char> buffer(1 << 20);
+            bool ok = true;
+            size_t size;
+            while(ok && (size = std::fread(buffer.data(), 1, buffer.size(), input)) > 0){
+                ok = std::fwrite(buffer.data(), 1, size, output) == size;
+            }
+            ok = ok && !std::ferror(input);
+            std::fclose(input);
+            return ok;
+        }
+
+        // Skip the spaces of a query
+        void skipSpaces(std::string_view& text){
+            while(!text.empty() && (text.front() == ' ' || text.front() == '\t')){
+                text.remove_prefix(1);
+            }
+        }
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Constructor
+     */
+
+    PatternIndex::PatternIndex(){
+        this->keyCount = 0;
+        this->gameCount = 0;
+        this->bitmaps = nullptr;
+        this->keys = nullptr;
+        this->bitmapOffsets = nullptr;
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Map an index
+     * @param path : path of the index
+     * @return true if the index is open
+     */
+
+    bool PatternIndex::open(const std::string& path){
+        this->close();
+
+        if(!this->file.open(path, true)){
+            return false;
+        }
+
+        FileHeader header;
+        if(this->file.getSize() < HEADER_SIZE){
+            std::cerr << "Error: " << path << " is not a pattern index" << std::endl;
+            this->file.close();
+            return false;
+        }
+        std::memcpy(&header, this->file.getData(), sizeof(header));
+
+        if(std::memcmp(header.magic, FILE_MAGIC, sizeof(FILE_MAGIC)) != 0 || header.version != FILE_VERSION){
+            std::cerr << "Error: " << path << " is not a pattern index (version " << FILE_VERSION << ")" << std::endl;
+            this->file.close();
+            return false;
+        }
+        if(header.keysOffset % 8 != 0 || header.offsetsOffset % 8 != 0 || header.keysOffset < HEADER_SIZE
+        || header.keysOffset + header.keyCount * sizeof(uint64_t) > header.offsetsOffset
+        || header.offsetsOffset + (header.keyCount + 1) * sizeof(uint64_t) > this->file.getSize()){
+            std::cerr << "Error: " << path << " is truncated" << std::endl;
+            this->file.close();
+            return false;
+        }
+
+        const uint8_t* data = this->file.getData();
+        this->keyCount = header.keyCount;
+        this->gameCount = header.gameCount;
+        this->bitmaps = data + HEADER_SIZE;
+        this->keys = reinterpret_cast<const uint64_t*>(data + header.keysOffset);
+        this->bitmapOffsets = reinterpret_cast<const uint64_t*>(data + header.offsetsOffset);
+        if(this->bitmapOffsets[this->keyCount] > header.keysOffset - HEADER_SIZE){
+            std::cerr << "Error: " << path << " is truncated" << std::endl;
+            this->close();
+            return false;
+        }
+        return true;
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Unmap the index
+     */
+
+    void PatternIndex::close(){
+        this->file.close();
+        this->keyCount = 0;
+        this->gameCount = 0;
+        this->bitmaps = nullptr;
+        this->keys = nullptr;
+        this->bitmapOffsets = nullptr;
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Is an index open
+     * @return bool
+     */
+
+    bool PatternIndex::isOpen() const{
+        return this->file.isOpen();
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Get the number of keys (material signatures and pawn structures)
+     * @return uint64_t
+     */
+
+    uint64_t PatternIndex::getKeyCount() const{
+        return this->keyCount;
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Get the number of games of the indexed archive
+     * @return uint64_t
+     */
+
+    uint64_t PatternIndex::getGameCount() const{
+        return this->gameCount;
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Get the games which reached a key
+     * @param key : material signature or pawn structure
+     * @param games : output, the games (numbers in the archive, from 0)
+     * @return true unless the bitmap of the key is corrupted
+     */
+
+    bool PatternIndex::lookup(uint64_t key, RoaringBitmap& games) const{
+        games.clear();
+        const uint64_t* found = std::lower_bound(this->keys, this->keys + this->keyCount, key);
+        if(found == this->keys + this->keyCount || *found != key){
+            return true;
+        }
+        const uint64_t index = static_cast<uint64_t>(found - this->keys);
+        const uint64_t begin = this->bitmapOffsets[index];
+        const uint64_t end = this->bitmapOffsets[index + 1];
+        return begin <= end && games.deserialize(this->bitmaps + begin, end - begin);
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Get the candidate games of a query
+     * @details The games which reached each key of the query at some ply : a superset of the games with a position
+     * matching the query, the same set for a query without AND
+     * @param expression : the query, for example "KRPvKR & (pawns:8/8/8/4P3/8/8/8/8 | KRvKR)"
+     * @param games : output, the games (numbers in the archive, from 0)
+     * @param error : output, the reason why the query is malformed
+     * @return true if the query is valid
+     */
+
+    bool PatternIndex::candidates(std::string_view expression, RoaringBitmap& games, std::string& error) const{
+        std::vector<QueryStep> steps;
+        if(!compile(expression, steps, error)){
+            games.clear();
+            return false;
+        }
+        if(!this->evaluate(steps, games)){
+            error = "corrupted index";
+            games.clear();
+            return false;
+        }
+        return true;
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Get the games with a position matching a query
+     * @details The candidates of the index are replayed from the archive when the query has an AND, and kept if one of
+     * their positions matches the whole query
+     * @param expression : the query, for example "KRPvKR & (pawns:8/8/8/4P3/8/8/8/8 | KRvKR)"
+     * @param archive : the archive of the index
+     * @param games : output, the games (numbers in the archive, from 0)
+     * @param error : output, the reason why the query is malformed or the games cannot be read
+     * @param threads : threads replaying the candidates
+     * @return true if the query is valid
+     */
+
+    bool PatternIndex::query(std::string_view expression, const GameArchive& archive, RoaringBitmap& games,
+                             std::string& error, int threads) const{
+        std::vector<QueryStep> steps;
+        if(!compile(expression, steps, error)){
+            games.clear();
+            return false;
+        }
+        if(!this->evaluate(steps, games)){
+            error = "corrupted index";
+            games.clear();
+            return false;
+        }
+        if(archive.getGameCount() != this->gameCount){
+            error = "the archive is not the one of the index";
+            games.clear();
+            return false;
+        }
+        const bool combined = std::any_of(steps.begin(), steps.end(), [](const QueryStep& step){ return step.kind == QueryStep::AND; });
+        if(!combined || games.isEmpty()){
+            return true;
+        }
+
+        std::vector<uint32_t> candidateGames;
+        games.toVector(candidateGames);
+        std::vector<uint8_t> matched(candidateGames.size(), 0);
+        int errors = 0;
+
+        #pragma omp parallel num_threads(std::max(threads, 1)) reduction(+ : errors)
+        {
+            Position position;
+            std::vector<Move> moves;
+
+            #pragma omp for schedule(dynamic, 16)
+            for(int64_t i = 0; i < static_cast<int64_t>(candidateGames.size()); i++){
+                const uint64_t game = candidateGames[static_cast<size_t>(i)];
+                if(!archive.readGame(game, position, moves) || !archive.readStartPosition(game, position)){
+                    errors++;
+                    continue;
+                }
+                for(size_t ply = 0; ply <= moves.size(); ply++){
+                    if(matches(steps, materialKey(position), pawnKey(position))){
+                        matched[static_cast<size_t>(i)] = 1;
+                        break;
+                    }
+                    if(ply < moves.size()){
+                        position.doMove(moves[ply]);
+                    }
+                }
+            }
+        }
+
+        games.clear();
+        for(size_t i = 0; i < candidateGames.size(); i++){
+            if(matched[i]){
+                games.add(candidateGames[i]);
+            }
+        }
+        if(errors != 0){
+            error = std::to_string(errors) + " candidate games could not be decoded";
+            return false;
+        }
+        return true;
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Compile a query into postfix steps
+     * @param expression : the query
+     * @param steps : output, the steps
+     * @param error : output, the reason why the query is malformed
+     * @return true if the query is valid
+     */
+
+    bool PatternIndex::compile(std::string_view expression, std::vector<QueryStep>& steps, std::string& error){
+        error.clear();
+        steps.clear();
+        if(!parseOr(expression, steps, error)){
+            return false;
+        }
+        skipSpaces(expression);
+        if(!expression.empty()){
+            error = "unexpected '" + std::string(expression) + "'";
+            return false;
+        }
+
+        // Depth of the evaluation stack, bounded for matches
+        int depth = 0;
+        for(const QueryStep& step : steps){
+            depth += (step.kind == QueryStep::AND || step.kind == QueryStep::OR) ? -1 : 1;
+            if(depth > MAX_QUERY_DEPTH){
+                error = "query nested too deeply";
+                return false;
+            }
+        }
+        return true;
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Parse the terms of a query joined by |
+     * @param text : the rest of the query, consumed
+     * @param steps : output, the steps of the terms appended
+     * @param error : output, the reason of a failure
+     * @return true if the terms are valid
+     */
+
+    bool PatternIndex::parseOr(std::string_view& text, std::vector<QueryStep>& steps, std::string& error){
+        if(!parseAnd(text, steps, error)){
+            return false;
+        }
+        skipSpaces(text);
+        while(!text.empty() && text.front() == '|'){
+            text.remove_prefix(1);
+            if(!parseAnd(text, steps, error)){
+                return false;
+            }
+            steps.push_back({QueryStep::OR, 0});
+            skipSpaces(text);
+        }
+        return true;
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Parse the terms of a query joined by &
+     * @param text : the rest of the query, consumed
+     * @param steps : output, the steps of the terms appended
+     * @param error : output, the reason of a failure
+     * @return true if the terms are valid
+     */
+
+    bool PatternIndex::parseAnd(std::string_view& text, std::vector<QueryStep>& steps, std::string& error){
+        if(!parseTerm(text, steps, error)){
+            return false;
+        }
+        skipSpaces(text);
+        while(!text.empty() && text.front() == '&'){
+            text.remove_prefix(1);
+            if(!parseTerm(text, steps, error)){
+                return false;
+            }
+            steps.push_back({QueryStep::AND, 0});
+            skipSpaces(text);
+        }
+        return true;
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Parse a term of a query : a key or a parenthesized query
+     * @param text : the rest of the query, consumed
+     * @param steps : output, the steps of the term appended
+     * @param error : output, the reason of a failure
+     * @return true if the term is valid
+     */
+
+    bool PatternIndex::parseTerm(std::string_view& text, std::vector<QueryStep>& steps, std::string& error){
+        skipSpaces(text);
+        if(!text.empty() && text.front() == '('){
+            text.remove_prefix(1);
+            if(!parseOr(text, steps, error)){
+                return false;
+            }
+            skipSpaces(text);
+            if(text.empty() || text.front() != ')'){
+                error = "missing ')'";
+                return false;
+            }
+            text.remove_prefix(1);
+            return true;
+        }
+
+        size_t length = 0;
+        while(length < text.size() && std::strchr(" \t()&|", text[length]) == nullptr){
+            length++;
+        }
+        const std::string_view token = text.substr(0, length);
+        text.remove_prefix(length);
+        if(token.empty()){
+            error = "expected a material signature or pawns:<placement>";
+            return false;
+        }
+
+        uint64_t key;
+        if(token.substr(0, 6) == "pawns:"){
+            if(!parsePawns(token.substr(6), key)){
+                error = "invalid piece placement '" + std::string(token.substr(6)) + "'";
+                return false;
+            }
+            steps.push_back({QueryStep::PAWNS, key});
+            return true;
+        }
+
+        if(!parseMaterial(token, key)){
+            error = "invalid material signature '" + std::string(token) + "' (for example KRPvKR)";
+            return false;
+        }
+        steps.push_back({QueryStep::MATERIAL, key});
+        return true;
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Evaluate a compiled query on the bitmaps of the games
+     * @param steps : the steps of the query
+     * @param games : output, the games which reached each key of the query at some ply
+     * @return true if the bitmaps are valid
+     */
+
+    bool PatternIndex::evaluate(const std::vector<QueryStep>& steps, RoaringBitmap& games) const{
+        std::vector<RoaringBitmap> stack;
+        for(const QueryStep& step : steps){
+            if(step.kind == QueryStep::AND || step.kind == QueryStep::OR){
+                RoaringBitmap right = std::move(stack.back());
+                stack.pop_back();
+                if(step.kind == QueryStep::AND){
+                    stack.back().intersect(right);
+                }
+                else{
+                    stack.back().unite(right);
+                }
+                continue;
+            }
+
+            stack.emplace_back();
+            if(!this->lookup(step.key, stack.back())){
+                return false;
+            }
+            if(step.kind == QueryStep::MATERIAL){
+                RoaringBitmap mirrored;
+                if(!this->lookup(mirrorMaterial(step.key), mirrored)){
+                    return false;
+                }
+                stack.back().unite(mirrored);
+            }
+        }
+        games = std::move(stack.back());
+        return true;
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Does a position match a compiled query
+     * @param steps : the steps of the query
+     * @param material : material signature of the position
+     * @param pawns : pawn structure of the position
+     * @return bool
+     */
+
+    bool PatternIndex::matches(const std::vector<QueryStep>& steps, uint64_t material, uint64_t pawns){
+        bool stack[MAX_QUERY_DEPTH];
+        int size = 0;
+        for(const QueryStep& step : steps){
+            if(step.kind == QueryStep::AND){
+                size--;
+                stack[size - 1] = stack[size - 1] && stack[size];
+            }
+            else if(step.kind == QueryStep::OR){
+                size--;
+                stack[size - 1] = stack[size - 1] || stack[size];
+            }
+            else{
+                stack[size++] = (step.kind == QueryStep::PAWNS) ? (pawns == step.key)
+                              : (material == step.key || material == mirrorMaterial(step.key));
+            }
+        }
+        return stack[0];
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Get the material signature of a position
+     * @param position : the position
+     * @return uint64_t
+     */
+
+    uint64_t PatternIndex::materialKey(const Position& position){
+        uint64_t key = MATERIAL_FLAG;
+        for(Color color : {WHITE, BLACK}){
+            for(PieceType type : MATERIAL_TYPES){
+                const uint64_t count = static_cast<uint64_t>(std::min(popCount(position.getPieces(color, type)), 15));
+                key |= count << materialShift(color, type);
+            }
+        }
+        return key;
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Get the pawn structure of a position
+     * @return uint64_t the Zobrist key of the pawns, high bit cleared
+     */
+
+    uint64_t PatternIndex::pawnKey(const Position& position){
+        return position.computePawnKey() & ~MATERIAL_FLAG;
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Parse a material signature
+     * @param name : the signature, for example KRPvKR (white pieces, 'v', black pieces, each side from its king)
+     * @param key : output, the signature
+     * @return true if the name is valid
+     */
+
+    bool PatternIndex::parseMaterial(std::string_view name, uint64_t& key){
+        const size_t separator = name.find('v');
+        if(separator == std::string_view::npos){
+            return false;
+        }
+
+        key = MATERIAL_FLAG;
+        for(Color color : {WHITE, BLACK}){
+            const std::string_view side = (color == WHITE) ? name.substr(0, separator) : name.substr(separator + 1);
+            if(side.empty() || side.front() != 'K'){
+                return false;
+            }
+            for(char letter : side.substr(1)){
+                const char* found = std::find(std::begin(MATERIAL_LETTERS), std::end(MATERIAL_LETTERS), letter);
+                if(found == std::end(MATERIAL_LETTERS)){
+                    return false;
+                }
+                const int shift = materialShift(color, MATERIAL_TYPES[found - MATERIAL_LETTERS]);
+                if(((key >> shift) & 15) == 15){
+                    return false;
+                }
+                key += 1ull << shift;
+            }
+        }
+        return true;
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Get the name of a material signature
+     * @param key : the signature
+     * @return std::string for example KRPvKR
+     */
+
+    std::string PatternIndex::materialName(uint64_t key){
+        std::string name;
+        for(Color color : {WHITE, BLACK}){
+            name += (color == WHITE) ? "K" : "vK";
+            for(size_t i = 0; i < sizeof(MATERIAL_LETTERS); i++){
+                name.append((key >> materialShift(color, MATERIAL_TYPES[i])) & 15, MATERIAL_LETTERS[i]);
+            }
+        }
+        return name;
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Swap the colors of a material signature
+     * @param key : the signature
+     * @return uint64_t
+     */
+
+    uint64_t PatternIndex::mirrorMaterial(uint64_t key){
+        const uint64_t side = (1ull << 20) - 1;
+        return MATERIAL_FLAG | ((key & side) << 20) | ((key >> 20) & side);
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Get the pawn structure of a piece placement
+     * @param placement : the first field of a FEN
+     * @param key : output, the pawn structure (as pawnKey of a position with these pawns)
+     * @return true if the placement is valid
+     */
+
+    bool PatternIndex::parsePawns(std::string_view placement, uint64_t& key){
+        key = 0;
+        int rank = 7;
+        int file = 0;
+        for(char c : placement){
+            if(c == '/'){
+                if(file != 8 || rank == 0){
+                    return false;
+                }
+                rank--;
+                file = 0;
+            }
+            else if(c >= '1' && c <= '8'){
+                file += c - '0';
+            }
+            else if(std::strchr("PNBRQKpnbrqk", c) != nullptr && file < 8){
+                if(c == 'P' || c == 'p'){
+                    key ^= zobrist.psq[c == 'P' ? W_PAWN : B_PAWN][rank * 8 + file];
+                }
+                file++;
+            }
+            else{
+                return false;
+            }
+            if(file > 8){
+                return false;
+            }
+        }
+        key &= ~MATERIAL_FLAG;
+        return rank == 0 && file == 8;
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Build the index of an archive
+     * @details The games are decoded by batches on several threads, and their distinct keys appended in game order to
+     * the pairs ; a full buffer of pairs is sorted into a run file. The sorted pairs (merged from the runs if any)
+     * then give the bitmaps key by key, the games being added in increasing order. The keys and their offsets go to
+     * temporary files next to the index, appended after the bitmaps at the end.
+     * @param archive : the archive
+     * @param path : path of the index
+     * @param threads : number of threads
+     * @param memoryMiB : memory budget of the pairs
+     * @param log : progress output (may be null)
+     * @return true if the index is written
+     */
+
+    bool PatternIndex::build(const GameArchive& archive, const std::string& path, int threads, size_t memoryMiB, std::ostream* log){
+        const uint64_t gameCount = archive.getGameCount();
+        if(gameCount > UINT32_MAX){
+            std::cerr << "Error: the index is limited to " << UINT32_MAX << " games" << std::endl;
+            return false;
+        }
+
+        const std::string keysPath = path + ".keys.tmp";
+        const std::string offsetsPath = path + ".offsets.tmp";
+        std::vector<std::string> runPaths;
+        std::FILE* output = std::fopen(path.c_str(), "wb");
+        std::FILE* keysFile = std::fopen(keysPath.c_str(), "wb");
+        std::FILE* offsetsFile = std::fopen(offsetsPath.c_str(), "wb");
+        auto cleanUp = [&](){
+            for(std::FILE* file : {output, keysFile, offsetsFile}){
+                if(file){
+                    std::fclose(file);
+                }
+            }
+            std::remove(keysPath.c_str());
+            std::remove(offsetsPath.c_str());
+            for(const std::string& runPath : runPaths){
+                std::remove(runPath.c_str());
+            }
+        };
+        if(!output || !keysFile || !offsetsFile){
+            std::cerr << "Error: cannot create " << path << " and its temporary files" << std::endl;
+            cleanUp();
+            return false;
+        }
+
+        bool ok = true;
+        const char zeros[HEADER_SIZE] = {};
+        ok = std::fwrite(zeros, 1, HEADER_SIZE, output) == HEADER_SIZE;
+
+        // Pass over the games : distinct keys of each game, spilled in sorted runs when the buffer is full
+        const size_t maxPairs = std::max<size_t>((static_cast<size_t>(memoryMiB) << 20) / sizeof(Pair), BATCH_GAMES);
+        std::vector<Pair> pairs;
+        pairs.reserve(std::min<size_t>(maxPairs, 1 << 20));
+        std::vector<std::vector<uint64_t>> gameKeys(BATCH_GAMES);
+        uint64_t errors = 0;
+
+        auto spill = [&](){
+            std::sort(pairs.begin(), pairs.end());
+            const std::string runPath = path + ".run" + std::to_string(runPaths.size()) + ".tmp";
+            std::FILE* run = std::fopen(runPath.c_str(), "wb");
+            runPaths.push_back(runPath);
+            ok = ok && run && std::fwrite(pairs.data(), sizeof(Pair), pairs.size(), run) == pairs.size();
+            ok = run && (std::fclose(run) == 0) && ok;
+            pairs.clear();
+        };
+
+        for(uint64_t first = 0; first < gameCount && ok; first += BATCH_GAMES){
+            const int64_t count = static_cast<int64_t>(std::min(BATCH_GAMES, gameCount - first));
+
+            #pragma omp parallel num_threads(threads) reduction(+ : errors)
+            {
+                Position position;
+                std::vector<Move> moves;
+
+                #pragma omp for schedule(dynamic, 64)
+                for(int64_t i = 0; i < count; i++){
+                    std::vector<uint64_t>& keys = gameKeys[i];
+                    keys.clear();
+                    const uint64_t game = first + static_cast<uint64_t>(i);
+                    errors += archive.readGame(game, position, moves) ? 0 : 1;
+                    archive.readStartPosition(game, position);
+                    for(size_t ply = 0; ply <= moves.size(); ply++){
+                        keys.push_back(materialKey(position));
+                        keys.push_back(pawnKey(position));
+                        if(ply < moves.size()){
+                            position.doMove(moves[ply]);
+                        }
+                    }
+                    std::sort(keys.begin(), keys.end());
+                    keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+                }
+            }
+
+            for(int64_t i = 0; i < count; i++){
+                for(uint64_t key : gameKeys[i]){
+                    pairs.push_back({key, static_cast<uint32_t>(first + static_cast<uint64_t>(i))});
+                }
+                if(pairs.size() >= maxPairs){
+                    spill();
+                }
+            }
+        }
+        std::vector<std::vector<uint64_t>>().swap(gameKeys);
+        if(errors != 0){
+            std::cerr << "Warning: " << errors << " games could not be decoded, their first plies are indexed" << std::endl;
+        }
+        if(log){
+            *log << "  " << gameCount << " games decoded, " << runPaths.size() << " runs spilled" << std::endl;
+        }
+
+        // Bitmaps of the keys, from the sorted pairs
+        uint64_t keyCount = 0;
+        uint64_t bitmapSize = 0;
+        uint64_t currentKey = 0;
+        RoaringBitmap current;
+        std::vector<uint8_t> buffer;
+
+        auto finishKey = [&](){
+            if(current.isEmpty()){
+                return;
+            }
+            buffer.clear();
+            current.serialize(buffer);
+            ok = ok && std::fwrite(buffer.data(), 1, buffer.size(), output) == buffer.size()
+                 && std::fwrite(&currentKey, sizeof(currentKey), 1, keysFile) == 1
+                 && std::fwrite(&bitmapSize, sizeof(bitmapSize), 1, offsetsFile) == 1;
+            bitmapSize += buffer.size();
+            keyCount++;
+            current.clear();
+        };
+        auto emit = [&](const Pair& pair){
+            if(pair.key != currentKey){
+                finishKey();
+                currentKey = pair.key;
+            }
+            current.add(pair.game);
+        };
+
+        if(runPaths.empty()){
+            std::sort(pairs.begin(), pairs.end());
+            for(const Pair& pair : pairs){
+                emit(pair);
+            }
+        }
+        else if(ok){
+            if(!pairs.empty()){
+                spill();
+            }
+            std::vector<Pair>().swap(pairs);
+
+            // k-way merge, the smallest pair first (the pairs of a key come in game order)
+            std::vector<RunReader> runs(runPaths.size());
+            std::vector<Pair> heads(runs.size());
+            std::vector<bool> active(runs.size(), false);
+            const size_t runBuffer = std::max<size_t>(maxPairs / runs.size(), 4096);
+            for(size_t r = 0; r < runs.size(); r++){
+                runs[r].file = std::fopen(runPaths[r].c_str(), "rb");
+                runs[r].buffer.resize(runBuffer);
+                active[r] = runs[r].file && runs[r].next(heads[r]);
+                ok = ok && runs[r].file;
+            }
+            while(ok){
+                int best = -1;
+                for(size_t r = 0; r < runs.size(); r++){
+                    if(active[r] && (best < 0 || heads[r] < heads[best])){
+                        best = static_cast<int>(r);
+                    }
+                }
+                if(best < 0){
+                    break;
+                }
+                emit(heads[best]);
+                active[best] = runs[best].next(heads[best]);
+            }
+            for(RunReader& run : runs){
+                if(run.file){
+                    std::fclose(run.file);
+                }
+            }
+        }
+        finishKey();
+
+        // End of the last bitmap, then the keys and the offsets after the bitmaps
+        ok = ok && std::fwrite(&bitmapSize, sizeof(bitmapSize), 1, offsetsFile) == 1;
+        ok = (std::fclose(keysFile) == 0) && ok;
+        ok = (std::fclose(offsetsFile) == 0) && ok;
+        keysFile = nullptr;
+        offsetsFile = nullptr;
+
+        FileHeader header = {};
+        std::memcpy(header.magic, FILE_MAGIC, sizeof(FILE_MAGIC));
+        header.version = FILE_VERSION;
+        header.keyCount = keyCount;
+        header.gameCount = gameCount;
+
+        const uint64_t padding = (64 - (HEADER_SIZE + bitmapSize) % 64) % 64;
+        ok = ok && std::fwrite(zeros, 1, padding, output) == padding;
+        header.keysOffset = HEADER_SIZE + bitmapSize + padding;
+        header.offsetsOffset = header.keysOffset + keyCount * sizeof(uint64_t);
+        ok = ok && appendFile(output, keysPath) && appendFile(output, offsetsPath);
+
+        ok = ok && std::fseek(output, 0, SEEK_SET) == 0 && std::fwrite(&header, sizeof(header), 1, output) == 1;
+        ok = (std::fclose(output) == 0) && ok;
+        output = nullptr;
+        cleanUp();
+
+        if(log){
+            *log << "  " << keyCount << " keys, " << bitmapSize << " bytes of bitmaps" << std::endl;
+        }
+        if(!ok){
+            std::cerr << "Error: cannot write " << path << std::endl;
+        }
+        return ok;
+    }
+}
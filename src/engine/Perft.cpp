@@ -0,0 +1,217 @@
+/**
+ * @author obiwan138
+ * @file Perft.cpp
+ * @brief Implementation of perft and of its hash table
+ */
+
+#include "engine/Perft.hpp"
+#include "engine/MoveGen.hpp"
+
+#include <algorithm>
+#include <omp.h>
+
+namespace engine{
+
+    namespace{
+
+        /////////////////////////////////////////////////////////////////////////////////
+        /**
+         * @brief Recursive perft
+         */
+
+        uint64_t perftRecursive(const Position& position, int depth, PerftHashTable* table){
+
+            MoveList moves;
+            generateLegalMoves(position, moves);
+
+            // Bulk counting
+            if(depth == 1){
+                return moves.size();
+            }
+
+            uint64_t key = 0;
+            uint64_t nodes = 0;
+            if(table != nullptr){
+                key = position.getKey();
+                if(table->probe(key, depth, nodes)){
+                    return nodes;
+                }
+            }
+
+            for(Move move : moves){
+                Position next = position;
+                next.doMove(move);
+                nodes += perftRecursive(next, depth - 1, table);
+            }
+
+            if(table != nullptr){
+                table->store(key, depth, nodes);
+            }
+            return nodes;
+        }
+
+        /////////////////////////////////////////////////////////////////////////////////
+        /**
+         * @brief Recursive perft with make/unmake
+         */
+
+        uint64_t perftRecursive(GameState& state, int depth){
+
+            MoveList moves;
+            generateLegalMoves(state.getPosition(), moves);
+
+            if(depth == 1){
+                return moves.size();
+            }
+
+            uint64_t nodes = 0;
+            for(Move move : moves){
+                state.doMove(move);
+                nodes += perftRecursive(state, depth - 1);
+                state.undoMove();
+            }
+            return nodes;
+        }
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Constructor
+     * @param sizeMb : size of the table in MiB
+     */
+
+    PerftHashTable::PerftHashTable(size_t sizeMb){
+        size_t count = 1;
+        while(count * 2 * sizeof(Entry) <= sizeMb * 1024 * 1024){
+            count *= 2;
+        }
+        this->entries.assign(count, Entry{0, 0});
+        this->mask = count - 1;
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Look up the node count of a position at a depth
+     * @param key : hash of the position
+     * @param depth : remaining depth
+     * @param nodes : output node count
+     * @return true if the entry was found
+     */
+
+    bool PerftHashTable::probe(uint64_t key, int depth, uint64_t& nodes) const{
+        const Entry& entry = this->entries[key & this->mask];
+        const uint64_t data = entry.data;
+        if((entry.check ^ data) == key && static_cast<int>(data & 0xFF) == depth){
+            nodes = data >> 8;
+            return true;
+        }
+        return false;
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Store the node count of a position at a depth
+     * @param key : hash of the position
+     * @param depth : remaining depth
+     * @param nodes : node count of the subtree
+     */
+
+    void PerftHashTable::store(uint64_t key, int depth, uint64_t nodes){
+        Entry& entry = this->entries[key & this->mask];
+        const uint64_t data = (nodes << 8) | static_cast<uint64_t>(depth);
+        entry.check = key ^ data;
+        entry.data = data;
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Empty the table
+     */
+
+    void PerftHashTable::clear(){
+        std::fill(this->entries.begin(), this->entries.end(), Entry{0, 0});
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Count the leaf nodes at a depth
+     * @param position : the root position
+     * @param depth : the depth (0 returns 1)
+     * @param table : optional hash table
+     * @return uint64_t the number of leaf nodes
+     */
+
+    uint64_t perft(const Position& position, int depth, PerftHashTable* table){
+        if(depth <= 0){
+            return 1;
+        }
+        return perftRecursive(position, depth, table);
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Count the leaf nodes at a depth, playing the moves with make/unmake
+     * @details Slower than the copy-make version, it exercises GameState (and checks its keys in CHESS3D_VERIFY_KEYS builds)
+     * @param state : the root position, restored on return
+     * @param depth : the depth (0 returns 1)
+     * @return uint64_t the number of leaf nodes
+     */
+
+    uint64_t perft(GameState& state, int depth){
+        if(depth <= 0){
+            return 1;
+        }
+        return perftRecursive(state, depth);
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Count the leaf nodes at a depth with the root moves split between threads
+     * @details The root subtrees are very unbalanced, hence the dynamic schedule
+     * @param position : the root position
+     * @param depth : the depth
+     * @param table : optional hash table (shared by the threads)
+     * @param threads : number of threads (0 : OpenMP default)
+     * @return uint64_t the number of leaf nodes
+     */
+
+    uint64_t perftParallel(const Position& position, int depth, PerftHashTable* table, int threads){
+        if(depth <= 1){
+            return perft(position, depth, table);
+        }
+
+        MoveList moves;
+        generateLegalMoves(position, moves);
+        const int count = moves.size();
+
+        uint64_t nodes = 0;
+        #pragma omp parallel for schedule(dynamic, 1) reduction(+:nodes) num_threads(threads > 0 ? threads : omp_get_max_threads())
+        for(int i = 0; i < count; i++){
+            Position next = position;
+            next.doMove(moves[i]);
+            nodes += perftRecursive(next, depth - 1, table);
+        }
+        return nodes;
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Node count of each root move (to compare with another engine when a count is wrong)
+     * @param position : the root position
+     * @param depth : the depth
+     * @param table : optional hash table
+     * @return std::vector of (root move, leaf nodes)
+     */
+
+    std::vector<std::pair<Move, uint64_t>> perftDivide(const Position& position, int depth, PerftHashTable* table){
+        std::vector<std::pair<Move, uint64_t>> result;
+        MoveList moves;
+        generateLegalMoves(position, moves);
+        for(Move move : moves){
+            Position next = position;
+            next.doMove(move);
+            result.emplace_back(move, perft(next, depth - 1, table));
+        }
+        return result;
+    }
+}
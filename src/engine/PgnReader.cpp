@@ -0,0 +1,492 @@
+/**
+ * @author obiwan138
+ * @file PgnReader.cpp
+ * @brief Implementation of the PgnReader class
+ */
+
+#include "engine/PgnReader.hpp"
+#include "engine/San.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace engine{
+
+    namespace{
+
+        // Spaces and every other control character (the Ctrl-Z ending the old exports, NUL), as the movetext delimiters
+        inline bool isSpace(char c){
+            return static_cast<unsigned char>(c) <= ' ';
+        }
+
+        // Characters which end a movetext token : spaces and control characters, comments, variations, next tags
+        inline bool isDelimiter(char c){
+            return static_cast<unsigned char>(c) <= ' ' || c == '{' || c == '}' || c == '(' || c == ')' || c == ';' || c == '[';
+        }
+
+        // First delimiter of [p, end), end if none. SSE2 (always present on x86-64) tests 16 characters at a time
+        const char* findDelimiter(const char* p, const char* end){
+#if defined(__SSE2__)
+            const __m128i space = _mm_set1_epi8(' ');
+            const __m128i open = _mm_set1_epi8('{');
+            const __m128i close = _mm_set1_epi8('}');
+            const __m128i openVariation = _mm_set1_epi8('(');
+            const __m128i closeVariation = _mm_set1_epi8(')');
+            const __m128i semicolon = _mm_set1_epi8(';');
+            const __m128i bracket = _mm_set1_epi8('[');
+            while(end - p >= 16){
+                const __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+
+                // Unsigned c <= ' ' as min(c, ' ') == c
+                __m128i found = _mm_cmpeq_epi8(_mm_min_epu8(chunk, space), chunk);
+                found = _mm_or_si128(found, _mm_or_si128(_mm_cmpeq_epi8(chunk, open), _mm_cmpeq_epi8(chunk, close)));
+                found = _mm_or_si128(found, _mm_or_si128(_mm_cmpeq_epi8(chunk, openVariation), _mm_cmpeq_epi8(chunk, closeVariation)));
+                found = _mm_or_si128(found, _mm_or_si128(_mm_cmpeq_epi8(chunk, semicolon), _mm_cmpeq_epi8(chunk, bracket)));
+
+                const int mask = _mm_movemask_epi8(found);
+                if(mask != 0){
+                    return p + __builtin_ctz(static_cast<unsigned>(mask));
+                }
+                p += 16;
+            }
+#endif
+            while(p < end && !isDelimiter(*p)){
+                p++;
+            }
+            return p;
+        }
+
+        // First occurrence of a character in [p, end), end if none (memchr is vectorized by the C library)
+        inline const char* findChar(const char* p, const char* end, char c){
+            const void* found = std::memchr(p, c, static_cast<size_t>(end - p));
+            return found ? static_cast<const char*>(found) : end;
+        }
+
+        // Result of a termination marker, RESULT_UNKNOWN for "*", false if the token is not a marker
+        bool parseResult(std::string_view token, GameResult& result){
+            if(token == "1-0"){
+                result = RESULT_WHITE_WIN;
+            }
+            else if(token == "0-1"){
+                result = RESULT_BLACK_WIN;
+            }
+            else if(token == "1/2-1/2"){
+                result = RESULT_DRAW;
+            }
+            else if(token == "*"){
+                result = RESULT_UNKNOWN;
+            }
+            else{
+                return false;
+            }
+            return true;
+        }
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Get the value of a tag
+     * @param name : name of the tag
+     * @return std::string_view the value, empty if the game has no such tag
+     */
+
+    std::string_view PgnGame::getTag(std::string_view name) const{
+        for(const auto& tag : this->tags){
+            if(tag.first == name){
+                return tag.second;
+            }
+        }
+        return std::string_view();
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Empty the game
+     */
+
+    void PgnGame::clear(){
+        this->tags.clear();
+        this->moves.clear();
+        this->result = RESULT_UNKNOWN;
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Set up the initial position of the game
+     * @param position : output position
+     * @return true if the position is well formed and legal (the move generator needs one king per side...)
+     */
+
+    bool PgnGame::setUpPosition(Position& position) const{
+        const std::string_view fen = this->getTag("FEN");
+        if(!fen.empty()){
+            return position.setFromFen(fen) && !position.checkLegality();
+        }
+
+        // Most games start from the standard position : copied instead of parsed
+        static const Position start = [](){
+            Position initial;
+            initial.setFromFen(Position::startFen);
+            return initial;
+        }();
+        position = start;
+        return true;
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Resolve the moves of the game
+     * @param position : output, the position after the last legal move
+     * @param moves : output, the legal moves of the game
+     * @return true if every move of the game is legal
+     */
+
+    bool PgnGame::replay(Position& position, std::vector<Move>& moves) const{
+        moves.clear();
+        if(!this->setUpPosition(position)){
+            return false;
+        }
+        for(std::string_view san : this->moves){
+            const Move move = parseSan(position, san);
+            if(move.isNull()){
+                return false;
+            }
+            position.doMove(move);
+            moves.push_back(move);
+        }
+        return true;
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Constructor
+     */
+
+    PgnReader::PgnReader(){
+        this->text = nullptr;
+        this->cursor = nullptr;
+        this->textEnd = nullptr;
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Map a file
+     * @param path : path of the PGN file
+     * @return true if the file is open
+     */
+
+    bool PgnReader::open(const std::string& path){
+        this->close();
+
+        if(!this->file.open(path)){
+            return false;
+        }
+        this->text = reinterpret_cast<const char*>(this->file.getData());
+        this->cursor = this->text;
+        this->textEnd = this->text + this->file.getSize();
+        return true;
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Read the games of a text in memory
+     * @param data : start of the text
+     * @param size : size of the text [bytes]
+     */
+
+    void PgnReader::openMemory(const char* data, size_t size){
+        this->close();
+        this->text = data;
+        this->cursor = data;
+        this->textEnd = data + size;
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Close the file
+     */
+
+    void PgnReader::close(){
+        this->file.close();
+        this->current.clear();
+        this->text = nullptr;
+        this->cursor = nullptr;
+        this->textEnd = nullptr;
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Read the next game
+     * @details A game ends with its termination marker (1-0, 0-1, 1/2-1/2, *), or at the next tag section or the end of
+     * the text when the marker is missing (the Result tag gives the result then).
+     * @param game : output game
+     * @return bool false if there is no game left
+     */
+
+    bool PgnReader::readGame(PgnGame& game){
+        game.clear();
+        bool inGame = false;
+        bool inMovetext = false;
+
+        const char* p = this->cursor;
+        const char* end = this->textEnd;
+        while(p < end){
+            const char c = *p;
+
+            if(isSpace(c)){
+                p++;
+            }
+            else if(c == '%' || c == ';'){
+                p = findChar(p, end, '\n');
+            }
+            else if(c == '{'){
+                p = std::min(findChar(p, end, '}') + 1, end);
+            }
+            else if(c == '['){
+                if(inMovetext){
+                    break;
+                }
+
+                // [Name "value"] : malformed tags are kept with what could be read
+                const char* lineEnd = findChar(p, end, '\n');
+                const char* nameStart = p + 1;
+                while(nameStart < lineEnd && isSpace(*nameStart)){
+                    nameStart++;
+                }
+                const char* nameEnd = nameStart;
+                while(nameEnd < lineEnd && !isSpace(*nameEnd) && *nameEnd != '"' && *nameEnd != ']'){
+                    nameEnd++;
+                }
+                const char* valueStart = findChar(nameEnd, lineEnd, '"');
+                const char* valueEnd = valueStart;
+                if(valueStart < lineEnd){
+                    valueStart++;
+                    valueEnd = valueStart;
+                    while(valueEnd < lineEnd && *valueEnd != '"'){
+                        valueEnd += (*valueEnd == '\\' && valueEnd + 1 < lineEnd) ? 2 : 1;
+                    }
+                    valueEnd = std::min(valueEnd, lineEnd);
+                }
+                game.tags.emplace_back(std::string_view(nameStart, static_cast<size_t>(nameEnd - nameStart)),
+                                       std::string_view(valueStart, static_cast<size_t>(valueEnd - valueStart)));
+                p = lineEnd;
+                inGame = true;
+            }
+            else if(c == '('){
+
+                // Variations, possibly nested, with comments which may hold parentheses
+                int depth = 0;
+                while(p < end){
+                    if(*p == '{'){
+                        p = findChar(p, end, '}');
+                    }
+                    else if(*p == '('){
+                        depth++;
+                    }
+                    else if(*p == ')' && --depth == 0){
+                        p++;
+                        break;
+                    }
+                    p += (p < end) ? 1 : 0;
+                }
+            }
+            else if(c == ')' || c == '}'){
+                p++;
+            }
+            else{
+                const char* tokenEnd = findDelimiter(p, end);
+                std::string_view token(p, static_cast<size_t>(tokenEnd - p));
+                p = tokenEnd;
+                inGame = true;
+                inMovetext = true;
+
+                if(parseResult(token, game.result)){
+                    this->cursor = p;
+                    return true;
+                }
+                if(token[0] == '$'){
+                    continue;
+                }
+
+                // Move number ("12.", "12...", or glued to the move : "12.e4"), castling with zeros being a move
+                size_t start = 0;
+                while(start < token.size() && token[start] >= '0' && token[start] <= '9'){
+                    start++;
+                }
+                if(start == token.size()){
+                    continue;
+                }
+                if(token[start] == '.'){
+                    while(start < token.size() && token[start] == '.'){
+                        start++;
+                    }
+                }
+                else{
+                    start = 0;
+                }
+                if(start < token.size()){
+                    game.moves.push_back(token.substr(start));
+                }
+            }
+        }
+        this->cursor = p;
+
+        // No termination marker : the Result tag
+        if(inGame && game.result == RESULT_UNKNOWN){
+            parseResult(game.getTag("Result"), game.result);
+        }
+        return inGame;
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Iterator on the next game
+     * @return Iterator
+     */
+
+    PgnReader::Iterator PgnReader::begin(){
+        return Iterator(this->readGame(this->current) ? this : nullptr);
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Iterator past the last game
+     * @return Iterator
+     */
+
+    PgnReader::Iterator PgnReader::end(){
+        return Iterator(nullptr);
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Split the text at game boundaries
+     * @details A game starts at a line beginning with '[' when the previous line which is not blank is not a tag. The
+     * parts are searched from the offsets of equal sizes, so the split costs a few lines per part.
+     * @param parts : number of parts
+     * @return std::vector<size_t> the offsets of the parts, then the size of the text
+     */
+
+    std::vector<size_t> PgnReader::split(int parts) const{
+        const size_t size = this->getSize();
+        std::vector<size_t> offsets(1, 0);
+
+        for(int i = 1; i < parts; i++){
+            const char* p = this->text + std::max(size / parts * i, offsets.back());
+            const char* boundary = this->textEnd;
+
+            while(p < this->textEnd){
+                const char* newline = findChar(p, this->textEnd, '\n');
+                p = newline + 1;
+                if(p >= this->textEnd || *p != '['){
+                    continue;
+                }
+
+                // Start of the previous line which is not blank
+                const char* line = newline;
+                while(line > this->text && isSpace(line[-1])){
+                    line--;
+                }
+                while(line > this->text && line[-1] != '\n'){
+                    line--;
+                }
+                if(line == this->text || *line != '['){
+                    boundary = p;
+                    break;
+                }
+            }
+            offsets.push_back(static_cast<size_t>(boundary - this->text));
+        }
+
+        offsets.push_back(size);
+        return offsets;
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Get the text of the games
+     * @return const char*
+     */
+
+    const char* PgnReader::getData() const{
+        return this->text;
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Get the size of the text
+     * @return size_t
+     */
+
+    size_t PgnReader::getSize() const{
+        return static_cast<size_t>(this->textEnd - this->text);
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Get the number of bytes consumed
+     * @return uint64_t
+     */
+
+    uint64_t PgnReader::getBytesRead() const{
+        return static_cast<uint64_t>(this->cursor - this->text);
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Constructor
+     * @param reader : the reader, null for the end
+     */
+
+    PgnReader::Iterator::Iterator(PgnReader* reader){
+        this->reader = reader;
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Get the game
+     * @return const PgnGame&
+     */
+
+    const PgnGame& PgnReader::Iterator::operator*() const{
+        return this->reader->current;
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Get the game
+     * @return const PgnGame*
+     */
+
+    const PgnGame* PgnReader::Iterator::operator->() const{
+        return &this->reader->current;
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Read the next game
+     * @return Iterator&
+     */
+
+    PgnReader::Iterator& PgnReader::Iterator::operator++(){
+        if(!this->reader->readGame(this->reader->current)){
+            this->reader = nullptr;
+        }
+        return *this;
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Compare two iterators (only the end is compared in practice)
+     * @param other : the other iterator
+     * @return bool
+     */
+
+    bool PgnReader::Iterator::operator!=(const Iterator& other) const{
+        return this->reader != other.reader;
+    }
+}
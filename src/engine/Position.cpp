@@ -0,0 +1,957 @@
+/**
+ * @author obiwan138
+ * @file Position.cpp
+ * @brief Implementation of the Position class
+ */
+
+#include "engine/Position.hpp"
+#include "engine/Attacks.hpp"
+#include "engine/Zobrist.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <initializer_list>
+
+namespace engine{
+
+    namespace{
+        // FEN characters of the pieces, in the Piece order
+        const char pieceChars[] = "PNBRQKpnbrqk";
+
+        // Castling rights kept when a piece leaves or lands on a square (king and rook squares clear their rights)
+        struct CastlingMask {
+            uint8_t mask[SQUARE_NB];
+            constexpr CastlingMask():mask(){
+                for(int s = 0; s < SQUARE_NB; s++) mask[s] = ALL_CASTLING;
+                mask[E1] = ALL_CASTLING & ~(WHITE_OO | WHITE_OOO);
+                mask[H1] = ALL_CASTLING & ~WHITE_OO;
+                mask[A1] = ALL_CASTLING & ~WHITE_OOO;
+                mask[E8] = ALL_CASTLING & ~(BLACK_OO | BLACK_OOO);
+                mask[H8] = ALL_CASTLING & ~BLACK_OO;
+                mask[A8] = ALL_CASTLING & ~BLACK_OOO;
+            }
+        };
+        constexpr CastlingMask castlingMask;
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Default constructor
+     * @details Empty board, white to move, no castling rights
+     */
+
+    Position::Position(){
+        std::fill(std::begin(this->pieceBB), std::end(this->pieceBB), Bitboard(0));
+        std::fill(std::begin(this->colorBB), std::end(this->colorBB), Bitboard(0));
+        this->sideToMove = WHITE;
+        this->castlingRights = NO_CASTLING;
+        this->epSquare = NO_SQUARE;
+        this->halfmoveClock = 0;
+        this->fullmoveNumber = 1;
+        this->key = 0;
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Set the position from a FEN string
+     * @details The fields are views of the string, nothing is allocated. The move counters are optional (some EPD
+     * strings omit them, or follow the en passant square with operations)
+     * @param fen : the FEN string
+     * @param error : output, the reason why the FEN is malformed (may be null)
+     * @return true if the FEN is well formed, false otherwise (the position is then empty)
+     */
+
+    bool Position::setFromFen(std::string_view fen, const char** error){
+
+        *this = Position();
+        auto fail = [this, error](const char* reason){
+            *this = Position();
+            if(error){
+                *error = reason;
+            }
+            return false;
+        };
+
+        // Fields separated by blanks
+        std::string_view fields[6];
+        int fieldCount = 0;
+        size_t i = 0;
+        while(fieldCount < 6){
+            while(i < fen.size() && (fen[i] == ' ' || fen[i] == '\t' || fen[i] == '\r')){
+                i++;
+            }
+            if(i == fen.size()){
+                break;
+            }
+            const size_t start = i;
+            while(i < fen.size() && fen[i] != ' ' && fen[i] != '\t' && fen[i] != '\r'){
+                i++;
+            }
+            fields[fieldCount++] = fen.substr(start, i - start);
+        }
+        if(fieldCount < 4){
+            return fail("missing fields");
+        }
+
+        // Piece placement, from a8 to h1
+        int file = 0, rank = 7;
+        for(char c : fields[0]){
+            if(c == '/'){
+                if(file != 8 || rank == 0){
+                    return fail("invalid piece placement");
+                }
+                file = 0;
+                rank--;
+            }
+            else if(c >= '1' && c <= '8'){
+                file += c - '0';
+            }
+            else{
+                const char* found = std::strchr(pieceChars, c);
+                if(found == nullptr || c == '\0' || file > 7){
+                    return fail("invalid piece placement");
+                }
+                this->putPiece(static_cast<Piece>(found - pieceChars), makeSquare(file, rank));
+                file++;
+            }
+            if(file > 8){
+                return fail("invalid piece placement");
+            }
+        }
+        if(file != 8 || rank != 0){
+            return fail("invalid piece placement");
+        }
+
+        // Side to move
+        if(fields[1] == "w"){
+            this->sideToMove = WHITE;
+        }
+        else if(fields[1] == "b"){
+            this->sideToMove = BLACK;
+        }
+        else{
+            return fail("invalid side to move");
+        }
+
+        // Castling rights
+        if(fields[2] != "-"){
+            for(char c : fields[2]){
+                switch(c){
+                    case 'K': this->castlingRights |= WHITE_OO; break;
+                    case 'Q': this->castlingRights |= WHITE_OOO; break;
+                    case 'k': this->castlingRights |= BLACK_OO; break;
+                    case 'q': this->castlingRights |= BLACK_OOO; break;
+                    default: return fail("invalid castling rights");
+                }
+            }
+        }
+
+        // En passant square
+        const std::string_view ep = fields[3];
+        if(ep != "-"){
+            if(ep.size() != 2 || ep[0] < 'a' || ep[0] > 'h' || (ep[1] != '3' && ep[1] != '6')){
+                return fail("invalid en passant square");
+            }
+            this->epSquare = makeSquare(ep[0] - 'a', ep[1] - '1');
+            if(const char* reason = this->checkEpSquare()){
+                return fail(reason);
+            }
+        }
+
+        // Move counters (ignored unless both are numbers)
+        auto parseNumber = [](std::string_view text, int& value){
+            value = 0;
+            for(char c : text){
+                if(c < '0' || c > '9'){
+                    return false;
+                }
+                value = std::min(value * 10 + (c - '0'), 1 << 20);
+            }
+            return !text.empty();
+        };
+        int halfmove = 0, fullmove = 1;
+        if(fieldCount < 5 || !parseNumber(fields[4], halfmove)){
+            halfmove = 0;
+        }
+        else if(fieldCount < 6 || !parseNumber(fields[5], fullmove)){
+            fullmove = 1;
+        }
+        this->halfmoveClock = static_cast<uint8_t>(std::clamp(halfmove, 0, 255));
+        this->fullmoveNumber = static_cast<uint16_t>(std::clamp(fullmove, 1, 65535));
+
+        // Same convention as doMove : the en passant square is kept only if a pawn can capture
+        if(this->epSquare != NO_SQUARE && !(pawnAttacks(~this->sideToMove, this->epSquare) & this->getPieces(this->sideToMove, PAWN))){
+            this->epSquare = NO_SQUARE;
+        }
+
+        this->key = this->computeKey();
+
+        if(error){
+            *error = nullptr;
+        }
+        return true;
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Write the FEN string of the position
+     * @param buffer : output, at least MAX_FEN_LENGTH characters
+     * @return size_t the length of the FEN
+     */
+
+    size_t Position::writeFen(char* buffer) const{
+
+        char* out = buffer;
+
+        // Piece placement, from a8 to h1
+        for(int rank = 7; rank >= 0; rank--){
+            int empty = 0;
+            for(int file = 0; file < 8; file++){
+                Piece piece = this->getPieceOn(makeSquare(file, rank));
+                if(piece == NO_PIECE){
+                    empty++;
+                    continue;
+                }
+                if(empty > 0){
+                    *out++ = static_cast<char>('0' + empty);
+                    empty = 0;
+                }
+                *out++ = pieceChars[piece];
+            }
+            if(empty > 0){
+                *out++ = static_cast<char>('0' + empty);
+            }
+            if(rank > 0){
+                *out++ = '/';
+            }
+        }
+
+        // Side to move
+        *out++ = ' ';
+        *out++ = (this->sideToMove == WHITE) ? 'w' : 'b';
+        *out++ = ' ';
+
+        // Castling rights
+        if(this->castlingRights == NO_CASTLING){
+            *out++ = '-';
+        }
+        if(this->castlingRights & WHITE_OO)  *out++ = 'K';
+        if(this->castlingRights & WHITE_OOO) *out++ = 'Q';
+        if(this->castlingRights & BLACK_OO)  *out++ = 'k';
+        if(this->castlingRights & BLACK_OOO) *out++ = 'q';
+
+        // En passant square
+        *out++ = ' ';
+        if(this->epSquare == NO_SQUARE){
+            *out++ = '-';
+        }
+        else{
+            *out++ = static_cast<char>('a' + fileOf(this->epSquare));
+            *out++ = static_cast<char>('1' + rankOf(this->epSquare));
+        }
+
+        // Move counters
+        for(unsigned number : {static_cast<unsigned>(this->halfmoveClock), static_cast<unsigned>(this->fullmoveNumber)}){
+            char digits[5];
+            int count = 0;
+            do{
+                digits[count++] = static_cast<char>('0' + number % 10);
+                number /= 10;
+            }while(number != 0);
+            *out++ = ' ';
+            while(count > 0){
+                *out++ = digits[--count];
+            }
+        }
+
+        return static_cast<size_t>(out - buffer);
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Get the FEN string of the position
+     * @return std::string
+     */
+
+    std::string Position::toFen() const{
+        char buffer[MAX_FEN_LENGTH];
+        return std::string(buffer, this->writeFen(buffer));
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Check that the en passant square follows a double push of the side not to move
+     * @details The square must be on the sixth rank of the side to move, with an enemy pawn just beyond it, and both
+     * the square and the one the pawn came from empty : the move generator and doMove rely on it
+     * @return const char* the reason why the square is impossible, nullptr if it is possible or if there is none
+     */
+
+    const char* Position::checkEpSquare() const{
+        if(this->epSquare == NO_SQUARE){
+            return nullptr;
+        }
+        const Color us = this->sideToMove;
+        if(rankOf(this->epSquare) != (us == WHITE ? 5 : 2)){
+            return "en passant square on the wrong rank";
+        }
+        const Square pushed = static_cast<Square>(us == WHITE ? this->epSquare - 8 : this->epSquare + 8);
+        const Square origin = static_cast<Square>(us == WHITE ? this->epSquare + 8 : this->epSquare - 8);
+        if(this->getPieceOn(pushed) != makePiece(~us, PAWN)
+        || this->getPieceOn(this->epSquare) != NO_PIECE || this->getPieceOn(origin) != NO_PIECE){
+            return "en passant square without a pawn which just moved two squares";
+        }
+        return nullptr;
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Check that the position can be reached in a game
+     * @details Necessary conditions only : one king per color, no pawn on the first or last rank, no more pieces than
+     * the promotions of the missing pawns allow, the side not to move not in check, at most two checkers, an en passant
+     * square behind a pawn which just moved two squares, and castling rights only with the king and the rook on their
+     * initial squares
+     * @return const char* the reason why the position is illegal, nullptr if it passes the checks
+     */
+
+    const char* Position::checkLegality() const{
+
+        if(popCount(this->pieceBB[W_KING]) != 1 || popCount(this->pieceBB[B_KING]) != 1){
+            return "there must be one king of each color";
+        }
+        if((this->pieceBB[W_PAWN] | this->pieceBB[B_PAWN]) & (RANK_1_BB | RANK_8_BB)){
+            return "pawn on the first or last rank";
+        }
+
+        for(Color color : {WHITE, BLACK}){
+            // Each piece beyond the initial ones was a pawn
+            const int promoted = std::max(popCount(this->getPieces(color, KNIGHT)) - 2, 0)
+                               + std::max(popCount(this->getPieces(color, BISHOP)) - 2, 0)
+                               + std::max(popCount(this->getPieces(color, ROOK)) - 2, 0)
+                               + std::max(popCount(this->getPieces(color, QUEEN)) - 1, 0);
+            if(popCount(this->getPieces(color, PAWN)) + promoted > 8){
+                return "more pieces than the promotions allow";
+            }
+        }
+
+        if(this->isAttacked(this->getKingSquare(~this->sideToMove), this->sideToMove, this->getOccupied())){
+            return "the side not to move is in check";
+        }
+        if(popCount(this->getCheckers()) > 2){
+            return "more than two pieces give check";
+        }
+        if(const char* reason = this->checkEpSquare()){
+            return reason;
+        }
+
+        const bool whiteKing = this->getPieceOn(E1) == W_KING;
+        const bool blackKing = this->getPieceOn(E8) == B_KING;
+        if(((this->castlingRights & WHITE_OO) && !(whiteKing && this->getPieceOn(H1) == W_ROOK))
+        || ((this->castlingRights & WHITE_OOO) && !(whiteKing && this->getPieceOn(A1) == W_ROOK))
+        || ((this->castlingRights & BLACK_OO) && !(blackKing && this->getPieceOn(H8) == B_ROOK))
+        || ((this->castlingRights & BLACK_OOO) && !(blackKing && this->getPieceOn(A8) == B_ROOK))){
+            return "castling rights without the king and the rook on their squares";
+        }
+
+        return nullptr;
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Place a piece on an empty square
+     * @param piece : the piece to place
+     * @param square : the destination square
+     */
+
+    void Position::putPiece(Piece piece, Square square){
+        this->pieceBB[piece] |= squareBB(square);
+        this->colorBB[colorOf(piece)] |= squareBB(square);
+        this->key ^= zobrist.psq[piece][square];
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Remove the piece of a square (if any)
+     * @param square : the square to clear
+     */
+
+    void Position::removePiece(Square square){
+        Piece piece = this->getPieceOn(square);
+        if(piece != NO_PIECE){
+            this->pieceBB[piece] ^= squareBB(square);
+            this->colorBB[colorOf(piece)] ^= squareBB(square);
+            this->key ^= zobrist.psq[piece][square];
+        }
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Move a piece to an empty square
+     * @param from : the square of the piece
+     * @param to : the destination square
+     */
+
+    void Position::movePiece(Square from, Square to){
+        Piece piece = this->getPieceOn(from);
+        if(piece != NO_PIECE){
+            Bitboard fromTo = squareBB(from) | squareBB(to);
+            this->pieceBB[piece] ^= fromTo;
+            this->colorBB[colorOf(piece)] ^= fromTo;
+            this->key ^= zobrist.psq[piece][from] ^ zobrist.psq[piece][to];
+        }
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Get the set of squares whose content differs from another position
+     * @details A square differs as soon as one of the 12 piece bitboards differs on it
+     * @param other : the position to compare with
+     * @return Bitboard the changed squares
+     */
+
+    Bitboard Position::diff(const Position& other) const{
+        Bitboard changed = 0;
+        for(int p = 0; p < PIECE_NB; p++){
+            changed |= this->pieceBB[p] ^ other.pieceBB[p];
+        }
+        return changed;
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Play a legal move (copy-make)
+     * @param move : the move to play
+     */
+
+    void Position::doMove(Move move){
+        UndoInfo undo;
+        this->doMove(move, undo);
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Play a legal move, saving what undoMove needs
+     * @details The move must come from the legal move generator. The Zobrist key is updated with XOR deltas. The en
+     * passant square is only set when an enemy pawn can actually capture, so that two positions reached by different
+     * move orders get the same key.
+     * @param move : the move to play
+     * @param undo : output state needed to take the move back
+     */
+
+    void Position::doMove(Move move, UndoInfo& undo){
+
+        const Color us = this->sideToMove;
+        const Color them = ~us;
+        const Square from = move.from();
+        const Square to = move.to();
+        const MoveType type = move.type();
+
+        // The moving piece is one of ours : only our 6 bitboards are scanned
+        Piece piece = makePiece(us, PAWN);
+        while(!(this->pieceBB[piece] & squareBB(from))){
+            piece = static_cast<Piece>(piece + 1);
+        }
+
+        undo.key = this->key;
+        undo.castlingRights = this->castlingRights;
+        undo.epSquare = this->epSquare;
+        undo.halfmoveClock = this->halfmoveClock;
+        undo.captured = NO_PIECE;
+
+        uint64_t k = this->key ^ zobrist.side;
+        if(this->epSquare != NO_SQUARE){
+            k ^= zobrist.enPassant[fileOf(this->epSquare)];
+        }
+
+        this->halfmoveClock = static_cast<uint8_t>(std::min(this->halfmoveClock + 1, 255));
+        if(typeOf(piece) == PAWN){
+            this->halfmoveClock = 0;
+        }
+
+        // Captures
+        if(type == EN_PASSANT){
+            Square captureSquare = static_cast<Square>(us == WHITE ? to - 8 : to + 8);
+            undo.captured = makePiece(them, PAWN);
+            this->pieceBB[undo.captured] ^= squareBB(captureSquare);
+            this->colorBB[them] ^= squareBB(captureSquare);
+            k ^= zobrist.psq[undo.captured][captureSquare];
+        }
+        else if(type != CASTLING && (this->colorBB[them] & squareBB(to))){
+            Piece captured = makePiece(them, PAWN);
+            while(!(this->pieceBB[captured] & squareBB(to))){
+                captured = static_cast<Piece>(captured + 1);
+            }
+            undo.captured = captured;
+            this->pieceBB[captured] ^= squareBB(to);
+            this->colorBB[them] ^= squareBB(to);
+            k ^= zobrist.psq[captured][to];
+            this->halfmoveClock = 0;
+        }
+
+        // Move the piece (and the rook when castling)
+        if(type == PROMOTION){
+            Piece promoted = makePiece(us, move.promotionType());
+            this->pieceBB[piece] ^= squareBB(from);
+            this->pieceBB[promoted] ^= squareBB(to);
+            this->colorBB[us] ^= squareBB(from) | squareBB(to);
+            k ^= zobrist.psq[piece][from] ^ zobrist.psq[promoted][to];
+        }
+        else{
+            Bitboard fromTo = squareBB(from) | squareBB(to);
+            this->pieceBB[piece] ^= fromTo;
+            this->colorBB[us] ^= fromTo;
+            k ^= zobrist.psq[piece][from] ^ zobrist.psq[piece][to];
+
+            if(type == CASTLING){
+                bool kingSide = to > from;
+                Square rookFrom = makeSquare(kingSide ? 7 : 0, rankOf(from));
+                Square rookTo = makeSquare(kingSide ? 5 : 3, rankOf(from));
+                Piece rook = makePiece(us, ROOK);
+                Bitboard rookFromTo = squareBB(rookFrom) | squareBB(rookTo);
+                this->pieceBB[rook] ^= rookFromTo;
+                this->colorBB[us] ^= rookFromTo;
+                k ^= zobrist.psq[rook][rookFrom] ^ zobrist.psq[rook][rookTo];
+            }
+        }
+
+        // Castling rights
+        uint8_t rights = this->castlingRights & castlingMask.mask[from] & castlingMask.mask[to];
+        if(rights != this->castlingRights){
+            k ^= zobrist.castling[this->castlingRights] ^ zobrist.castling[rights];
+            this->castlingRights = rights;
+        }
+
+        // Double pawn push : en passant square only if an enemy pawn attacks it
+        this->epSquare = NO_SQUARE;
+        if(typeOf(piece) == PAWN && (from ^ to) == 16){
+            Square middle = static_cast<Square>((from + to) / 2);
+            if(pawnAttacks(us, middle) & this->pieceBB[makePiece(them, PAWN)]){
+                this->epSquare = middle;
+                k ^= zobrist.enPassant[fileOf(middle)];
+            }
+        }
+
+        if(us == BLACK){
+            this->fullmoveNumber++;
+        }
+        this->sideToMove = them;
+        this->key = k;
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Take back the last move
+     * @param move : the move played with doMove
+     * @param undo : the state saved by doMove
+     */
+
+    void Position::undoMove(Move move, const UndoInfo& undo){
+
+        const Color them = this->sideToMove;
+        const Color us = ~them;
+        const Square from = move.from();
+        const Square to = move.to();
+        const MoveType type = move.type();
+
+        // Move the piece back
+        if(type == PROMOTION){
+            Piece promoted = makePiece(us, move.promotionType());
+            this->pieceBB[promoted] ^= squareBB(to);
+            this->pieceBB[makePiece(us, PAWN)] ^= squareBB(from);
+            this->colorBB[us] ^= squareBB(from) | squareBB(to);
+        }
+        else{
+            Piece piece = makePiece(us, PAWN);
+            while(!(this->pieceBB[piece] & squareBB(to))){
+                piece = static_cast<Piece>(piece + 1);
+            }
+            Bitboard fromTo = squareBB(from) | squareBB(to);
+            this->pieceBB[piece] ^= fromTo;
+            this->colorBB[us] ^= fromTo;
+
+            if(type == CASTLING){
+                bool kingSide = to > from;
+                Bitboard rookFromTo = squareBB(makeSquare(kingSide ? 7 : 0, rankOf(from)))
+                                    | squareBB(makeSquare(kingSide ? 5 : 3, rankOf(from)));
+                this->pieceBB[makePiece(us, ROOK)] ^= rookFromTo;
+                this->colorBB[us] ^= rookFromTo;
+            }
+        }
+
+        // Restore the captured piece
+        if(undo.captured != NO_PIECE){
+            Square captureSquare = (type == EN_PASSANT) ? static_cast<Square>(us == WHITE ? to - 8 : to + 8) : to;
+            this->pieceBB[undo.captured] ^= squareBB(captureSquare);
+            this->colorBB[them] ^= squareBB(captureSquare);
+        }
+
+        if(us == BLACK){
+            this->fullmoveNumber--;
+        }
+        this->sideToMove = us;
+        this->castlingRights = undo.castlingRights;
+        this->epSquare = undo.epSquare;
+        this->halfmoveClock = undo.halfmoveClock;
+        this->key = undo.key;
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Pass the turn
+     * @param undo : output state needed to take the null move back
+     */
+
+    void Position::doNullMove(UndoInfo& undo){
+        undo.key = this->key;
+        undo.castlingRights = this->castlingRights;
+        undo.epSquare = this->epSquare;
+        undo.halfmoveClock = this->halfmoveClock;
+        undo.captured = NO_PIECE;
+
+        this->key ^= zobrist.side;
+        if(this->epSquare != NO_SQUARE){
+            this->key ^= zobrist.enPassant[fileOf(this->epSquare)];
+            this->epSquare = NO_SQUARE;
+        }
+        this->halfmoveClock = static_cast<uint8_t>(std::min(this->halfmoveClock + 1, 255));
+        this->sideToMove = ~this->sideToMove;
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Take back a null move
+     * @param undo : the state saved by doNullMove
+     */
+
+    void Position::undoNullMove(const UndoInfo& undo){
+        this->sideToMove = ~this->sideToMove;
+        this->epSquare = undo.epSquare;
+        this->halfmoveClock = undo.halfmoveClock;
+        this->key = undo.key;
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Key of the position after a move, without playing it
+     * @details Only the moving piece, the captured piece, the side to move and the current en passant square are taken
+     * into account : the key is exact for most moves and is only used to prefetch the transposition table
+     * @param move : a legal move
+     * @return uint64_t the (approximate) key
+     */
+
+    uint64_t Position::keyAfter(Move move) const{
+        const Piece piece = this->getPieceOn(move.from());
+        const Piece captured = this->getPieceOn(move.to());
+
+        uint64_t k = this->key ^ zobrist.side ^ zobrist.psq[piece][move.from()] ^ zobrist.psq[piece][move.to()];
+        if(captured != NO_PIECE && move.type() != CASTLING){
+            k ^= zobrist.psq[captured][move.to()];
+        }
+        if(this->epSquare != NO_SQUARE){
+            k ^= zobrist.enPassant[fileOf(this->epSquare)];
+        }
+        return k;
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Compute the Zobrist key from scratch
+     * @return uint64_t
+     */
+
+    uint64_t Position::computeKey() const{
+        uint64_t k = 0;
+        for(int p = 0; p < PIECE_NB; p++){
+            Bitboard b = this->pieceBB[p];
+            while(b){
+                k ^= zobrist.psq[p][popLsb(b)];
+            }
+        }
+        k ^= zobrist.castling[this->castlingRights];
+        if(this->epSquare != NO_SQUARE){
+            k ^= zobrist.enPassant[fileOf(this->epSquare)];
+        }
+        if(this->sideToMove == BLACK){
+            k ^= zobrist.side;
+        }
+        return k;
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Compute the pawn structure key from scratch
+     * @details XOR of the piece-square keys of the pawns only (used to cache the pawn structure evaluation)
+     * @return uint64_t
+     */
+
+    uint64_t Position::computePawnKey() const{
+        uint64_t k = 0;
+        for(Piece p : {W_PAWN, B_PAWN}){
+            Bitboard b = this->pieceBB[p];
+            while(b){
+                k ^= zobrist.psq[p][popLsb(b)];
+            }
+        }
+        return k;
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Compute the material signature from scratch
+     * @details XOR of the keys psq[piece][i] for i below the piece count : it only depends on the number of pieces of
+     * each kind, and a capture or a promotion changes it with one or two XORs.
+     * @return uint64_t
+     */
+
+    uint64_t Position::computeMaterialKey() const{
+        uint64_t k = 0;
+        for(int p = 0; p < PIECE_NB; p++){
+            for(int i = 0; i < popCount(this->pieceBB[p]); i++){
+                k ^= zobrist.psq[p][i];
+            }
+        }
+        return k;
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Get the pieces of both colors attacking a square
+     * @param square : the attacked square
+     * @param occupied : the occupancy used for the sliding pieces
+     * @return Bitboard the attackers
+     */
+
+    Bitboard Position::attackersTo(Square square, Bitboard occupied) const{
+        return (pawnAttacks(BLACK, square) & this->pieceBB[W_PAWN])
+             | (pawnAttacks(WHITE, square) & this->pieceBB[B_PAWN])
+             | (knightAttacks(square) & (this->pieceBB[W_KNIGHT] | this->pieceBB[B_KNIGHT]))
+             | (kingAttacks(square) & (this->pieceBB[W_KING] | this->pieceBB[B_KING]))
+             | (bishopAttacks(square, occupied) & (this->pieceBB[W_BISHOP] | this->pieceBB[B_BISHOP] | this->pieceBB[W_QUEEN] | this->pieceBB[B_QUEEN]))
+             | (rookAttacks(square, occupied) & (this->pieceBB[W_ROOK] | this->pieceBB[B_ROOK] | this->pieceBB[W_QUEEN] | this->pieceBB[B_QUEEN]));
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Is a square attacked by a color
+     * @param square : the square
+     * @param by : the attacking color
+     * @param occupied : the occupancy used for the sliding pieces
+     * @return true if at least one piece of the color attacks the square
+     */
+
+    bool Position::isAttacked(Square square, Color by, Bitboard occupied) const{
+        const Bitboard* p = this->pieceBB + by * 6;
+        return (pawnAttacks(~by, square) & p[PAWN])
+            || (knightAttacks(square) & p[KNIGHT])
+            || (kingAttacks(square) & p[KING])
+            || (bishopAttacks(square, occupied) & (p[BISHOP] | p[QUEEN]))
+            || (rookAttacks(square, occupied) & (p[ROOK] | p[QUEEN]));
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Get the pieces giving check to the side to move
+     * @return Bitboard
+     */
+
+    Bitboard Position::getCheckers() const{
+        return this->attackersTo(this->getKingSquare(this->sideToMove), this->getOccupied()) & this->colorBB[~this->sideToMove];
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Get the king square of a color
+     * @param color
+     * @return Square
+     */
+
+    Square Position::getKingSquare(Color color) const{
+        return lsb(this->pieceBB[makePiece(color, KING)]);
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Get the squares of a colored piece
+     * @param piece : the colored piece
+     * @return Bitboard
+     */
+
+    Bitboard Position::getPieces(Piece piece) const{
+        return this->pieceBB[piece];
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Get the squares of a piece type of a color
+     * @param color : the color of the pieces
+     * @param type : the type of the pieces
+     * @return Bitboard
+     */
+
+    Bitboard Position::getPieces(Color color, PieceType type) const{
+        return this->pieceBB[makePiece(color, type)];
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Get the squares occupied by a color
+     * @param color : the color
+     * @return Bitboard
+     */
+
+    Bitboard Position::getOccupancy(Color color) const{
+        return this->colorBB[color];
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Get the occupied squares
+     * @return Bitboard
+     */
+
+    Bitboard Position::getOccupied() const{
+        return this->colorBB[WHITE] | this->colorBB[BLACK];
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Get the piece on a square
+     * @details The position has no mailbox (to stay small), so the piece bitboards of the color are scanned
+     * @param square : the square
+     * @return Piece the piece on the square, NO_PIECE if it is empty
+     */
+
+    Piece Position::getPieceOn(Square square) const{
+        const Bitboard b = squareBB(square);
+        for(int c = WHITE; c <= BLACK; c++){
+            if(this->colorBB[c] & b){
+                for(int pt = PAWN; pt <= KING; pt++){
+                    Piece piece = makePiece(static_cast<Color>(c), static_cast<PieceType>(pt));
+                    if(this->pieceBB[piece] & b){
+                        return piece;
+                    }
+                }
+            }
+        }
+        return NO_PIECE;
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Get the side to move
+     * @return Color
+     */
+
+    Color Position::getSideToMove() const{
+        return this->sideToMove;
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Get the castling rights
+     * @return uint8_t the CastlingRights flags
+     */
+
+    uint8_t Position::getCastlingRights() const{
+        return this->castlingRights;
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Get the en passant target square
+     * @return Square NO_SQUARE if there is none
+     */
+
+    Square Position::getEpSquare() const{
+        return this->epSquare;
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Get the number of half moves since the last capture or pawn move
+     * @return uint8_t
+     */
+
+    uint8_t Position::getHalfmoveClock() const{
+        return this->halfmoveClock;
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Get the full move number
+     * @return uint16_t
+     */
+
+    uint16_t Position::getFullmoveNumber() const{
+        return this->fullmoveNumber;
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Get the Zobrist key
+     * @return uint64_t
+     */
+
+    uint64_t Position::getKey() const{
+        return this->key;
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Set the side to move
+     * @param color
+     */
+
+    void Position::setSideToMove(Color color){
+        if(color != this->sideToMove){
+            this->key ^= zobrist.side;
+        }
+        this->sideToMove = color;
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Set the castling rights
+     * @param rights : the CastlingRights flags
+     */
+
+    void Position::setCastlingRights(uint8_t rights){
+        this->key ^= zobrist.castling[this->castlingRights] ^ zobrist.castling[rights];
+        this->castlingRights = rights;
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Set the en passant target square
+     * @param square : NO_SQUARE if there is none
+     */
+
+    void Position::setEpSquare(Square square){
+        if(this->epSquare != NO_SQUARE){
+            this->key ^= zobrist.enPassant[fileOf(this->epSquare)];
+        }
+        if(square != NO_SQUARE){
+            this->key ^= zobrist.enPassant[fileOf(square)];
+        }
+        this->epSquare = square;
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Set the number of half moves since the last capture or pawn move
+     * @param clock
+     */
+
+    void Position::setHalfmoveClock(uint8_t clock){
+        this->halfmoveClock = clock;
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Set the full move number
+     * @param number
+     */
+
+    void Position::setFullmoveNumber(uint16_t number){
+        this->fullmoveNumber = number;
+    }
+}
@@ -0,0 +1,451 @@
+/**
+ * @author obiwan138
+ * @file PositionIndex.cpp
+ * @brief Implementation of the PositionIndex class
+ */
+
+#include "engine/PositionIndex.hpp"
+
+#include <omp.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+
+namespace engine{
+
+    namespace{
+
+        const char FILE_MAGIC[8] = {'C', '3', 'D', 'P', 'O', 'S', 'I', 'X'};
+
+        // Header of an index file (followed by zeros up to HEADER_SIZE, the posting lists start after it)
+        struct FileHeader {
+            char magic[8];
+            uint32_t version;
+            uint32_t keysPerBlock;
+            uint64_t keyCount;
+            uint64_t gameCount;
+            uint64_t keysOffset;
+            uint64_t offsetsOffset;
+            uint64_t treeOffset;
+        };
+
+        static_assert(sizeof(FileHeader) <= PositionIndex::HEADER_SIZE, "The header must fit in its block");
+
+        // Position reached by a game, while building
+        struct Pair {
+            uint64_t key;
+            uint32_t game;
+
+            bool operator<(const Pair& other) const{
+                return this->key < other.key || (this->key == other.key && this->game < other.game);
+            }
+        };
+
+        // Memory of a pair while building (the vector of a thread may grow to twice its size) [bytes]
+        constexpr uint64_t PAIR_MEMORY = 2 * sizeof(Pair);
+
+        // Append the whole content of a file to another, return false on a read or write error
+        bool appendFile(std::FILE* output, const std::string& path){
+            std::FILE* input = std::fopen(path.c_str(), "rb");
+            if(!input){
+                return false;
+            }
+            std::vector<char> buffer(1 << 20);
+            bool ok = true;
+            size_t size;
+            while(ok && (size = std::fread(buffer.data(), 1, buffer.size(), input)) > 0){
+                ok = std::fwrite(buffer.data(), 1, size, output) == size;
+            }
+            ok = ok && !std::ferror(input);
+            std::fclose(input);
+            return ok;
+        }
+
+        // Zeros up to a multiple of 64 bytes, return the new size
+        uint64_t pad(std::FILE* output, uint64_t size, bool& ok){
+            const char zeros[64] = {};
+            const uint64_t padding = (64 - size % 64) % 64;
+            ok = ok && std::fwrite(zeros, 1, padding, output) == padding;
+            return size + padding;
+        }
+
+        // Fill the Eytzinger tree with the sorted first keys of the blocks (in-order walk of the implicit tree)
+        void fillTree(std::vector<PositionIndex::TreeNode>& tree, const std::vector<uint64_t>& firstKeys, uint64_t& next, uint64_t node){
+            if(node < tree.size()){
+                fillTree(tree, firstKeys, next, 2 * node);
+                tree[node] = {firstKeys[next], next};
+                next++;
+                fillTree(tree, firstKeys, next, 2 * node + 1);
+            }
+        }
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Constructor
+     */
+
+    PositionIndex::PositionIndex(){
+        this->keyCount = 0;
+        this->blockCount = 0;
+        this->gameCount = 0;
+        this->postings = nullptr;
+        this->keys = nullptr;
+        this->postingOffsets = nullptr;
+        this->tree = nullptr;
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Map an index
+     * @details The header and the sizes of the sections are checked, the keys and the postings are read by the lookups
+     * @param path : path of the index
+     * @return true if the index is open
+     */
+
+    bool PositionIndex::open(const std::string& path){
+        this->close();
+
+        if(!this->file.open(path, true)){
+            return false;
+        }
+
+        FileHeader header;
+        if(this->file.getSize() < HEADER_SIZE){
+            std::cerr << "Error: " << path << " is not a position index" << std::endl;
+            this->file.close();
+            return false;
+        }
+        std::memcpy(&header, this->file.getData(), sizeof(header));
+
+        if(std::memcmp(header.magic, FILE_MAGIC, sizeof(FILE_MAGIC)) != 0 || header.version != FILE_VERSION
+        || header.keysPerBlock != KEYS_PER_BLOCK){
+            std::cerr << "Error: " << path << " is not a position index (version " << FILE_VERSION << ")" << std::endl;
+            this->file.close();
+            return false;
+        }
+
+        const uint64_t blocks = (header.keyCount + KEYS_PER_BLOCK - 1) / KEYS_PER_BLOCK;
+        const uint64_t size = this->file.getSize();
+        if(header.keysOffset % 8 != 0 || header.offsetsOffset % 8 != 0 || header.treeOffset % 8 != 0
+        || header.keysOffset + header.keyCount * sizeof(uint64_t) > header.offsetsOffset
+        || header.offsetsOffset + (header.keyCount + 1) * sizeof(uint64_t) > header.treeOffset
+        || header.treeOffset + (blocks + 1) * sizeof(TreeNode) > size){
+            std::cerr << "Error: " << path << " is truncated" << std::endl;
+            this->file.close();
+            return false;
+        }
+
+        const uint8_t* data = this->file.getData();
+        this->keyCount = header.keyCount;
+        this->blockCount = blocks;
+        this->gameCount = header.gameCount;
+        this->postings = data + HEADER_SIZE;
+        this->keys = reinterpret_cast<const uint64_t*>(data + header.keysOffset);
+        this->postingOffsets = reinterpret_cast<const uint64_t*>(data + header.offsetsOffset);
+        this->tree = reinterpret_cast<const TreeNode*>(data + header.treeOffset);
+        return true;
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Unmap the index
+     */
+
+    void PositionIndex::close(){
+        this->file.close();
+        this->keyCount = 0;
+        this->blockCount = 0;
+        this->gameCount = 0;
+        this->postings = nullptr;
+        this->keys = nullptr;
+        this->postingOffsets = nullptr;
+        this->tree = nullptr;
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Is an index open
+     * @return bool
+     */
+
+    bool PositionIndex::isOpen() const{
+        return this->file.isOpen();
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Get the number of distinct positions
+     * @return uint64_t
+     */
+
+    uint64_t PositionIndex::getKeyCount() const{
+        return this->keyCount;
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Get the number of games of the indexed archive
+     * @return uint64_t
+     */
+
+    uint64_t PositionIndex::getGameCount() const{
+        return this->gameCount;
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Get the games which reached a position
+     * @param key : Zobrist key of the position
+     * @param games : output, the numbers of the games in the archive (from 0), increasing
+     * @param maxGames : maximum number of games written
+     * @return uint64_t the number of games of the posting list, 0 if the position is not in the index
+     */
+
+    uint64_t PositionIndex::lookup(uint64_t key, std::vector<uint32_t>& games, uint64_t maxGames) const{
+        games.clear();
+        if(this->blockCount == 0){
+            return 0;
+        }
+
+        // Eytzinger descent to the first block starting after the key (the last block if none), 4 nodes per cache line :
+        // the nodes two levels down are prefetched
+        uint64_t node = 1;
+        while(node <= this->blockCount){
+            __builtin_prefetch(this->tree + 4 * node);
+            node = 2 * node + (this->tree[node].firstKey <= key ? 1 : 0);
+        }
+        node >>= __builtin_ffsll(static_cast<long long>(~node));
+        const uint64_t after = (node == 0) ? this->blockCount : this->tree[node].block;    // First block after the key
+        if(after == 0){
+            return 0;
+        }
+
+        // Binary search in the block
+        const uint64_t first = (after - 1) * KEYS_PER_BLOCK;
+        const uint64_t last = std::min(first + KEYS_PER_BLOCK, this->keyCount);
+        const uint64_t* found = std::lower_bound(this->keys + first, this->keys + last, key);
+        if(found == this->keys + last || *found != key){
+            return 0;
+        }
+        const uint64_t index = static_cast<uint64_t>(found - this->keys);
+
+        // Posting list : differences of the game numbers, 7 bits per byte, high bit set on all the bytes but the last
+        const uint8_t* p = this->postings + this->postingOffsets[index];
+        const uint8_t* end = this->postings + this->postingOffsets[index + 1];
+        uint64_t count = 0;
+        uint32_t game = 0;
+        while(p < end && count < maxGames){
+            uint32_t delta = 0;
+            int shift = 0;
+            while(p < end && (*p & 0x80)){
+                delta |= static_cast<uint32_t>(*p++ & 0x7F) << shift;
+                shift += 7;
+            }
+            if(p < end){
+                delta |= static_cast<uint32_t>(*p++) << shift;
+            }
+            game += delta;
+            games.push_back(game);
+            count++;
+        }
+
+        // The games past the maximum are only counted : one last byte per game
+        while(p < end){
+            count += (*p++ & 0x80) ? 0 : 1;
+        }
+        return count;
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Build the index of an archive
+     * @details Each pass replays all the games in parallel and keeps the positions whose key is in its range, each
+     * thread sorting its own pairs ; the sorted lists of the threads are then merged into the posting lists. The keys
+     * and their offsets go to temporary files next to the index, appended after the posting lists at the end.
+     * @param archive : the archive
+     * @param path : path of the index
+     * @param threads : number of threads
+     * @param memoryMiB : memory budget of the pairs of a pass
+     * @param log : progress output (may be null)
+     * @return true if the index is written
+     */
+
+    bool PositionIndex::build(const GameArchive& archive, const std::string& path, int threads, size_t memoryMiB, std::ostream* log){
+        const uint64_t gameCount = archive.getGameCount();
+        if(gameCount > UINT32_MAX){
+            std::cerr << "Error: the index is limited to " << UINT32_MAX << " games" << std::endl;
+            return false;
+        }
+
+        // Passes : equal ranges of the 16 high bits of the keys (the keys are uniform)
+        uint64_t positionCount = 0;
+        for(uint64_t game = 0; game < gameCount; game++){
+            positionCount += archive.getRecord(game).plyCount + 1u;
+        }
+        const uint64_t budget = std::max<uint64_t>(static_cast<uint64_t>(memoryMiB) << 20, PAIR_MEMORY);
+        const uint64_t passes = std::min<uint64_t>(std::max<uint64_t>((positionCount * PAIR_MEMORY + budget - 1) / budget, 1), 1 << 16);
+
+        const std::string keysPath = path + ".keys.tmp";
+        const std::string offsetsPath = path + ".offsets.tmp";
+        std::FILE* output = std::fopen(path.c_str(), "wb");
+        std::FILE* keysFile = std::fopen(keysPath.c_str(), "wb");
+        std::FILE* offsetsFile = std::fopen(offsetsPath.c_str(), "wb");
+        auto cleanUp = [&](){
+            for(std::FILE* file : {output, keysFile, offsetsFile}){
+                if(file){
+                    std::fclose(file);
+                }
+            }
+            std::remove(keysPath.c_str());
+            std::remove(offsetsPath.c_str());
+        };
+        if(!output || !keysFile || !offsetsFile){
+            std::cerr << "Error: cannot create " << path << " and its temporary files" << std::endl;
+            cleanUp();
+            return false;
+        }
+
+        bool ok = true;
+        const char zeros[HEADER_SIZE] = {};
+        ok = std::fwrite(zeros, 1, HEADER_SIZE, output) == HEADER_SIZE;
+
+        uint64_t keyCount = 0;
+        uint64_t postingSize = 0;
+        std::vector<uint64_t> firstKeys;
+        std::vector<uint8_t> postingBuffer;
+        std::vector<uint64_t> keyBuffer;
+        std::vector<uint64_t> offsetBuffer;
+        std::vector<std::vector<Pair>> threadPairs(threads);
+
+        auto flushBuffers = [&](){
+            ok = ok && std::fwrite(postingBuffer.data(), 1, postingBuffer.size(), output) == postingBuffer.size()
+                 && std::fwrite(keyBuffer.data(), sizeof(uint64_t), keyBuffer.size(), keysFile) == keyBuffer.size()
+                 && std::fwrite(offsetBuffer.data(), sizeof(uint64_t), offsetBuffer.size(), offsetsFile) == offsetBuffer.size();
+            postingBuffer.clear();
+            keyBuffer.clear();
+            offsetBuffer.clear();
+        };
+
+        for(uint64_t pass = 0; pass < passes && ok; pass++){
+            const uint64_t low = (pass << 16) / passes;
+            const uint64_t high = ((pass + 1) << 16) / passes;
+
+            // Positions of the games in the range of the pass, sorted per thread
+            #pragma omp parallel num_threads(threads)
+            {
+                std::vector<Pair>& pairs = threadPairs[omp_get_thread_num()];
+                pairs.clear();
+                Position position;
+                std::vector<Move> moves;
+                std::vector<uint64_t> keys;
+
+                #pragma omp for schedule(dynamic, 256)
+                for(int64_t game = 0; game < static_cast<int64_t>(gameCount); game++){
+                    archive.readGame(static_cast<uint64_t>(game), position, moves, &keys);
+                    keys.erase(std::remove_if(keys.begin(), keys.end(), [&](uint64_t key){
+                        return (key >> 48) < low || (key >> 48) >= high;
+                    }), keys.end());
+                    std::sort(keys.begin(), keys.end());
+                    keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+                    for(uint64_t key : keys){
+                        pairs.push_back({key, static_cast<uint32_t>(game)});
+                    }
+                }
+                std::sort(pairs.begin(), pairs.end());
+            }
+
+            // Merge of the lists of the threads into the posting lists
+            std::vector<size_t> heads(threads, 0);
+            uint64_t currentKey = 0;
+            uint32_t previousGame = 0;
+            bool hasKey = false;
+            while(true){
+                int best = -1;
+                for(int t = 0; t < threads; t++){
+                    if(heads[t] < threadPairs[t].size() && (best < 0 || threadPairs[t][heads[t]] < threadPairs[best][heads[best]])){
+                        best = t;
+                    }
+                }
+                if(best < 0){
+                    break;
+                }
+                const Pair pair = threadPairs[best][heads[best]++];
+
+                uint32_t delta = pair.game - previousGame;
+                if(!hasKey || pair.key != currentKey){
+                    if(keyCount % KEYS_PER_BLOCK == 0){
+                        firstKeys.push_back(pair.key);
+                    }
+                    keyBuffer.push_back(pair.key);
+                    offsetBuffer.push_back(postingSize);
+                    keyCount++;
+                    currentKey = pair.key;
+                    hasKey = true;
+                    delta = pair.game;
+                }
+                previousGame = pair.game;
+
+                do{
+                    postingBuffer.push_back(static_cast<uint8_t>((delta & 0x7F) | (delta >= 0x80 ? 0x80 : 0)));
+                    postingSize++;
+                    delta >>= 7;
+                }while(delta != 0);
+
+                if(postingBuffer.size() >= (1 << 20)){
+                    flushBuffers();
+                }
+            }
+            flushBuffers();
+
+            if(log){
+                *log << "  pass " << pass + 1 << "/" << passes << " : " << keyCount << " positions, " << postingSize
+                     << " bytes of posting lists" << std::endl;
+            }
+        }
+        for(std::vector<Pair>& pairs : threadPairs){
+            std::vector<Pair>().swap(pairs);
+        }
+
+        // End of the last posting list, then the sections after the posting lists
+        offsetBuffer.push_back(postingSize);
+        flushBuffers();
+        ok = (std::fclose(keysFile) == 0) && ok;
+        ok = (std::fclose(offsetsFile) == 0) && ok;
+        keysFile = nullptr;
+        offsetsFile = nullptr;
+
+        FileHeader header = {};
+        std::memcpy(header.magic, FILE_MAGIC, sizeof(FILE_MAGIC));
+        header.version = FILE_VERSION;
+        header.keysPerBlock = KEYS_PER_BLOCK;
+        header.keyCount = keyCount;
+        header.gameCount = gameCount;
+
+        uint64_t size = pad(output, HEADER_SIZE + postingSize, ok);
+        header.keysOffset = size;
+        ok = ok && appendFile(output, keysPath);
+        size = pad(output, size + keyCount * sizeof(uint64_t), ok);
+        header.offsetsOffset = size;
+        ok = ok && appendFile(output, offsetsPath);
+        size = pad(output, size + (keyCount + 1) * sizeof(uint64_t), ok);
+        header.treeOffset = size;
+
+        std::vector<TreeNode> tree(firstKeys.size() + 1, TreeNode{0, 0});
+        uint64_t next = 0;
+        fillTree(tree, firstKeys, next, 1);
+        ok = ok && std::fwrite(tree.data(), sizeof(TreeNode), tree.size(), output) == tree.size();
+
+        ok = ok && std::fseek(output, 0, SEEK_SET) == 0 && std::fwrite(&header, sizeof(header), 1, output) == 1;
+        ok = (std::fclose(output) == 0) && ok;
+        output = nullptr;
+        cleanUp();
+
+        if(!ok){
+            std::cerr << "Error: cannot write " << path << std::endl;
+        }
+        return ok;
+    }
+}
@@ -0,0 +1,64 @@
+/**
+ * @author obiwan138
+ * @file ProgressMonitor.cpp
+ * @brief Implementation of the ProgressMonitor class
+ */
+
+#include "engine/ProgressMonitor.hpp"
+
+#include <chrono>
+#include <utility>
+
+namespace engine{
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Constructor
+     * @param periodSecondsIn : time between two reports [s]
+     * @param reportIn : function printing the progress
+     */
+
+    ProgressMonitor::ProgressMonitor(double periodSecondsIn, std::function<void()> reportIn){
+        this->report = std::move(reportIn);
+        this->periodSeconds = periodSecondsIn;
+        this->finished = false;
+        this->thread = std::thread(&ProgressMonitor::run, this);
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Loop of the thread : a report at the end of each period until stop
+     */
+
+    void ProgressMonitor::run(){
+        std::unique_lock<std::mutex> lock(this->mutex);
+        while(!this->condition.wait_for(lock, std::chrono::duration<double>(this->periodSeconds), [this](){ return this->finished; })){
+            this->report();
+        }
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Stop the thread and wait for it
+     */
+
+    void ProgressMonitor::stop(){
+        {
+            std::lock_guard<std::mutex> lock(this->mutex);
+            this->finished = true;
+        }
+        this->condition.notify_all();
+        if(this->thread.joinable()){
+            this->thread.join();
+        }
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Destructor
+     */
+
+    ProgressMonitor::~ProgressMonitor(){
+        this->stop();
+    }
+}
@@ -0,0 +1,47 @@
+/**
+ * @author obiwan138
+ * @file RandomGenerator.cpp
+ * @brief Implementation of the RandomGenerator class
+ */
+
+#include "engine/RandomGenerator.hpp"
+
+namespace engine{
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Constructor
+     * @param seed : seed of the sequence
+     */
+
+    RandomGenerator::RandomGenerator(uint64_t seed){
+        this->seed(seed);
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Restart the sequence of a seed
+     * @details The seed is spread over the bits of the state, which must not be 0 (a fixed point of xorshift)
+     * @param seedIn : seed of the sequence
+     */
+
+    void RandomGenerator::seed(uint64_t seedIn){
+        this->state = seedIn * 0x9E3779B97F4A7C15ull + 1;
+        if(this->state == 0){
+            this->state = 1;
+        }
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Next number of the sequence
+     * @return uint64_t
+     */
+
+    uint64_t RandomGenerator::next(){
+        this->state ^= this->state >> 12;
+        this->state ^= this->state << 25;
+        this->state ^= this->state >> 27;
+        return this->state * 0x2545F4914F6CDD1Dull;
+    }
+}
@@ -0,0 +1,103 @@
+/**
+ * @author obiwan138
+ * @file RepetitionTable.cpp
+ * @brief Implementation of the RepetitionTable class
+ */
+
+#include "engine/RepetitionTable.hpp"
+
+namespace engine{
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Constructor
+     */
+
+    RepetitionTable::RepetitionTable(){
+        this->clear();
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Empty the table
+     */
+
+    void RepetitionTable::clear(){
+        for(Slot& slot : this->slots){
+            slot.key = 0;
+            slot.count = 0;
+        }
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Count one more occurrence of a key
+     * @param key : the position key
+     * @return int the number of occurrences, this one included
+     */
+
+    int RepetitionTable::add(uint64_t key){
+        int i = static_cast<int>(key & (CAPACITY - 1));
+        while(this->slots[i].count != 0 && this->slots[i].key != key){
+            i = (i + 1) & (CAPACITY - 1);
+        }
+        this->slots[i].key = key;
+        return static_cast<int>(++this->slots[i].count);
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Count one less occurrence of a key
+     * @details When the count drops to 0, the following slots of the probe sequence are shifted back into the hole,
+     * so every key stays reachable from its home slot without tombstones
+     * @param key : the position key (must have been added)
+     */
+
+    void RepetitionTable::remove(uint64_t key){
+        int i = static_cast<int>(key & (CAPACITY - 1));
+        while(this->slots[i].count != 0 && this->slots[i].key != key){
+            i = (i + 1) & (CAPACITY - 1);
+        }
+        if(this->slots[i].count == 0 || --this->slots[i].count > 0){
+            return;
+        }
+
+        // Backward shift deletion
+        int hole = i;
+        int j = i;
+        while(true){
+            j = (j + 1) & (CAPACITY - 1);
+            if(this->slots[j].count == 0){
+                break;
+            }
+
+            // The entry at j can move into the hole if its home slot is not in the cyclic range (hole, j]
+            int home = static_cast<int>(this->slots[j].key & (CAPACITY - 1));
+            bool homeInRange = (hole <= j) ? (hole < home && home <= j) : (hole < home || home <= j);
+            if(!homeInRange){
+                this->slots[hole] = this->slots[j];
+                hole = j;
+            }
+        }
+        this->slots[hole].key = 0;
+        this->slots[hole].count = 0;
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Get the number of occurrences of a key
+     * @param key : the position key
+     * @return int
+     */
+
+    int RepetitionTable::count(uint64_t key) const{
+        int i = static_cast<int>(key & (CAPACITY - 1));
+        while(this->slots[i].count != 0){
+            if(this->slots[i].key == key){
+                return static_cast<int>(this->slots[i].count);
+            }
+            i = (i + 1) & (CAPACITY - 1);
+        }
+        return 0;
+    }
+}
@@ -0,0 +1,394 @@
+/**
+ * @author obiwan138
+ * @file RoaringBitmap.cpp
+ * @brief Implementation of the RoaringBitmap class
+ */
+
+#include "engine/RoaringBitmap.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <iterator>
+
+namespace engine{
+
+    namespace{
+
+        // Words of a bitmap container
+        constexpr size_t BITMAP_WORDS = 65536 / 64;
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Convert an array container to a bitmap container
+     * @param container : the container
+     */
+
+    void RoaringBitmap::toBitmap(Container& container){
+        container.bitmap.assign(BITMAP_WORDS, 0);
+        for(uint16_t low : container.array){
+            container.bitmap[low >> 6] |= 1ull << (low & 63);
+        }
+        std::vector<uint16_t>().swap(container.array);
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Convert a bitmap container to an array container
+     * @param container : the container, with its cardinality up to date
+     */
+
+    void RoaringBitmap::toArray(Container& container){
+        container.array.clear();
+        container.array.reserve(container.cardinality);
+        for(size_t word = 0; word < BITMAP_WORDS; word++){
+            uint64_t bits = container.bitmap[word];
+            while(bits){
+                container.array.push_back(static_cast<uint16_t>(word * 64 + static_cast<size_t>(__builtin_ctzll(bits))));
+                bits &= bits - 1;
+            }
+        }
+        std::vector<uint64_t>().swap(container.bitmap);
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Remove all the values
+     */
+
+    void RoaringBitmap::clear(){
+        this->containers.clear();
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Is the set empty
+     * @return bool
+     */
+
+    bool RoaringBitmap::isEmpty() const{
+        return this->containers.empty();
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Get the number of values
+     * @return uint64_t
+     */
+
+    uint64_t RoaringBitmap::getCardinality() const{
+        uint64_t cardinality = 0;
+        for(const Container& container : this->containers){
+            cardinality += container.cardinality;
+        }
+        return cardinality;
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Is a value in the set
+     * @param value : the value
+     * @return bool
+     */
+
+    bool RoaringBitmap::contains(uint32_t value) const{
+        const uint16_t high = static_cast<uint16_t>(value >> 16);
+        const uint16_t low = static_cast<uint16_t>(value);
+        auto it = std::lower_bound(this->containers.begin(), this->containers.end(), high, [](const Container& container, uint16_t h){
+            return container.high < h;
+        });
+        if(it == this->containers.end() || it->high != high){
+            return false;
+        }
+        if(!it->bitmap.empty()){
+            return (it->bitmap[low >> 6] >> (low & 63)) & 1;
+        }
+        return std::binary_search(it->array.begin(), it->array.end(), low);
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Add a value
+     * @details Values added in increasing order are appended to the last container
+     * @param value : the value
+     */
+
+    void RoaringBitmap::add(uint32_t value){
+        const uint16_t high = static_cast<uint16_t>(value >> 16);
+        const uint16_t low = static_cast<uint16_t>(value);
+
+        auto it = this->containers.end();
+        if(this->containers.empty() || this->containers.back().high < high){
+            this->containers.push_back({high, 0, {}, {}});
+            it = this->containers.end() - 1;
+        }
+        else if(this->containers.back().high == high){
+            it = this->containers.end() - 1;
+        }
+        else{
+            it = std::lower_bound(this->containers.begin(), this->containers.end(), high, [](const Container& container, uint16_t h){
+                return container.high < h;
+            });
+            if(it->high != high){
+                it = this->containers.insert(it, {high, 0, {}, {}});
+            }
+        }
+
+        Container& container = *it;
+        if(!container.bitmap.empty()){
+            const uint64_t bit = 1ull << (low & 63);
+            container.cardinality += (container.bitmap[low >> 6] & bit) ? 0 : 1;
+            container.bitmap[low >> 6] |= bit;
+            return;
+        }
+        if(container.array.empty() || container.array.back() < low){
+            container.array.push_back(low);
+        }
+        else{
+            auto position = std::lower_bound(container.array.begin(), container.array.end(), low);
+            if(*position == low){
+                return;
+            }
+            container.array.insert(position, low);
+        }
+        container.cardinality++;
+        if(container.cardinality > ARRAY_MAX){
+            toBitmap(container);
+        }
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Keep the values which are also in another set
+     * @param other : the other set
+     */
+
+    void RoaringBitmap::intersect(const RoaringBitmap& other){
+        std::vector<Container> result;
+        auto a = this->containers.begin();
+        auto b = other.containers.begin();
+        std::vector<uint16_t> values;
+
+        while(a != this->containers.end() && b != other.containers.end()){
+            if(a->high < b->high){
+                a++;
+                continue;
+            }
+            if(b->high < a->high){
+                b++;
+                continue;
+            }
+
+            Container& container = *a;
+            if(container.bitmap.empty() && b->bitmap.empty()){
+                values.clear();
+                std::set_intersection(container.array.begin(), container.array.end(), b->array.begin(), b->array.end(),
+                                      std::back_inserter(values));
+                container.array.swap(values);
+                container.cardinality = static_cast<uint32_t>(container.array.size());
+            }
+            else if(container.bitmap.empty() || b->bitmap.empty()){
+                // Array filtered by the bitmap (the result is an array container)
+                std::vector<uint64_t> owned;
+                const uint64_t* bits = b->bitmap.data();
+                if(!container.bitmap.empty()){
+                    owned.swap(container.bitmap);
+                    bits = owned.data();
+                    container.array = b->array;
+                }
+                container.array.erase(std::remove_if(container.array.begin(), container.array.end(), [bits](uint16_t low){
+                    return !((bits[low >> 6] >> (low & 63)) & 1);
+                }), container.array.end());
+                container.cardinality = static_cast<uint32_t>(container.array.size());
+            }
+            else{
+                uint32_t cardinality = 0;
+                for(size_t word = 0; word < BITMAP_WORDS; word++){
+                    container.bitmap[word] &= b->bitmap[word];
+                    cardinality += static_cast<uint32_t>(__builtin_popcountll(container.bitmap[word]));
+                }
+                container.cardinality = cardinality;
+                if(cardinality <= ARRAY_MAX){
+                    toArray(container);
+                }
+            }
+
+            if(container.cardinality > 0){
+                result.push_back(std::move(container));
+            }
+            a++;
+            b++;
+        }
+        this->containers.swap(result);
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Add the values of another set
+     * @param other : the other set
+     */
+
+    void RoaringBitmap::unite(const RoaringBitmap& other){
+        std::vector<Container> result;
+        result.reserve(this->containers.size() + other.containers.size());
+        auto a = this->containers.begin();
+        auto b = other.containers.begin();
+
+        while(a != this->containers.end() || b != other.containers.end()){
+            if(b == other.containers.end() || (a != this->containers.end() && a->high < b->high)){
+                result.push_back(std::move(*a++));
+                continue;
+            }
+            if(a == this->containers.end() || b->high < a->high){
+                result.push_back(*b++);
+                continue;
+            }
+
+            Container& container = *a;
+            if(container.bitmap.empty() && b->bitmap.empty()){
+                std::vector<uint16_t> values;
+                values.reserve(container.array.size() + b->array.size());
+                std::set_union(container.array.begin(), container.array.end(), b->array.begin(), b->array.end(),
+                               std::back_inserter(values));
+                container.array.swap(values);
+                container.cardinality = static_cast<uint32_t>(container.array.size());
+                if(container.cardinality > ARRAY_MAX){
+                    toBitmap(container);
+                }
+            }
+            else{
+                if(container.bitmap.empty()){
+                    toBitmap(container);
+                }
+                if(b->bitmap.empty()){
+                    for(uint16_t low : b->array){
+                        container.bitmap[low >> 6] |= 1ull << (low & 63);
+                    }
+                }
+                else{
+                    for(size_t word = 0; word < BITMAP_WORDS; word++){
+                        container.bitmap[word] |= b->bitmap[word];
+                    }
+                }
+                uint32_t cardinality = 0;
+                for(uint64_t word : container.bitmap){
+                    cardinality += static_cast<uint32_t>(__builtin_popcountll(word));
+                }
+                container.cardinality = cardinality;
+            }
+            result.push_back(std::move(container));
+            a++;
+            b++;
+        }
+        this->containers.swap(result);
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Get the values
+     * @param values : output, the values in increasing order
+     * @param maxCount : maximum number of values written
+     */
+
+    void RoaringBitmap::toVector(std::vector<uint32_t>& values, uint64_t maxCount) const{
+        values.clear();
+        for(const Container& container : this->containers){
+            const uint32_t base = static_cast<uint32_t>(container.high) << 16;
+            if(container.bitmap.empty()){
+                for(uint16_t low : container.array){
+                    if(values.size() >= maxCount){
+                        return;
+                    }
+                    values.push_back(base | low);
+                }
+                continue;
+            }
+            for(size_t word = 0; word < BITMAP_WORDS; word++){
+                uint64_t bits = container.bitmap[word];
+                while(bits){
+                    if(values.size() >= maxCount){
+                        return;
+                    }
+                    values.push_back(base | static_cast<uint32_t>(word * 64 + static_cast<size_t>(__builtin_ctzll(bits))));
+                    bits &= bits - 1;
+                }
+            }
+        }
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Write the serialized form
+     * @param output : the bytes are appended to it
+     */
+
+    void RoaringBitmap::serialize(std::vector<uint8_t>& output) const{
+        auto append = [&output](const void* data, size_t size){
+            const uint8_t* bytes = static_cast<const uint8_t*>(data);
+            output.insert(output.end(), bytes, bytes + size);
+        };
+
+        const uint32_t count = static_cast<uint32_t>(this->containers.size());
+        append(&count, sizeof(count));
+        for(const Container& container : this->containers){
+            const uint16_t header[2] = {container.high, static_cast<uint16_t>(container.cardinality - 1)};
+            append(header, sizeof(header));
+            if(container.bitmap.empty()){
+                append(container.array.data(), container.array.size() * sizeof(uint16_t));
+            }
+            else{
+                append(container.bitmap.data(), BITMAP_WORDS * sizeof(uint64_t));
+            }
+        }
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Read the serialized form
+     * @param data : the serialized bitmap
+     * @param size : its size [bytes]
+     * @return true if the form is valid
+     */
+
+    bool RoaringBitmap::deserialize(const uint8_t* data, size_t size){
+        this->containers.clear();
+        const uint8_t* end = data + size;
+
+        uint32_t count;
+        if(size < sizeof(count)){
+            return false;
+        }
+        std::memcpy(&count, data, sizeof(count));
+        data += sizeof(count);
+        this->containers.reserve(std::min<size_t>(count, size / 4));
+
+        for(uint32_t i = 0; i < count; i++){
+            uint16_t header[2];
+            if(static_cast<size_t>(end - data) < sizeof(header)){
+                this->containers.clear();
+                return false;
+            }
+            std::memcpy(header, data, sizeof(header));
+            data += sizeof(header);
+
+            Container container = {header[0], static_cast<uint32_t>(header[1]) + 1, {}, {}};
+            const bool isBitmap = container.cardinality > ARRAY_MAX;
+            const size_t bytes = isBitmap ? BITMAP_WORDS * sizeof(uint64_t) : container.cardinality * sizeof(uint16_t);
+            if(static_cast<size_t>(end - data) < bytes || (!this->containers.empty() && this->containers.back().high >= container.high)){
+                this->containers.clear();
+                return false;
+            }
+            if(isBitmap){
+                container.bitmap.resize(BITMAP_WORDS);
+                std::memcpy(container.bitmap.data(), data, bytes);
+            }
+            else{
+                container.array.resize(container.cardinality);
+                std::memcpy(container.array.data(), data, bytes);
+            }
+            data += bytes;
+            this->containers.push_back(std::move(container));
+        }
+        return true;
+    }
+}
@@ -0,0 +1,215 @@
+/**
+ * @author obiwan138
+ * @file San.cpp
+ * @brief Implementation of the SAN parser and writer
+ */
+
+#include "engine/San.hpp"
+#include "engine/MoveGen.hpp"
+
+#include <cstring>
+
+namespace engine{
+
+    namespace{
+
+        const char pieceLetters[] = "PNBRQK";
+
+        // Piece type of an upper case SAN letter (PIECE_TYPE_NB if none)
+        inline PieceType pieceFromLetter(char c){
+            const char* found = (c != '\0') ? std::strchr(pieceLetters, c) : nullptr;
+            return found ? static_cast<PieceType>(found - pieceLetters) : PIECE_TYPE_NB;
+        }
+
+        inline bool isFile(char c){ return c >= 'a' && c <= 'h'; }
+        inline bool isRank(char c){ return c >= '1' && c <= '8'; }
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Parse a move in SAN
+     * @param position : the position
+     * @param text : the move (not null terminated)
+     * @param length : number of characters
+     * @return Move the legal move, a null move if the text is malformed, illegal or ambiguous
+     */
+
+    Move parseSan(const Position& position, const char* text, size_t length){
+
+        // Check and annotation suffixes
+        while(length > 0 && std::strchr("+#!?", text[length - 1])){
+            length--;
+        }
+        if(length < 2){
+            return Move();
+        }
+
+        MoveList moves;
+        generateLegalMoves(position, moves);
+
+        // Castling (with letters or zeros)
+        if(text[0] == 'O' || text[0] == '0'){
+            bool kingSide;
+            if(length == 3 && text[1] == '-' && text[2] == text[0]){
+                kingSide = true;
+            }
+            else if(length == 5 && text[1] == '-' && text[2] == text[0] && text[3] == '-' && text[4] == text[0]){
+                kingSide = false;
+            }
+            else{
+                return Move();
+            }
+            for(Move move : moves){
+                if(move.type() == CASTLING && (move.to() > move.from()) == kingSide){
+                    return move;
+                }
+            }
+            return Move();
+        }
+
+        // Piece letter (none for the pawns)
+        PieceType type = pieceFromLetter(text[0]);
+        size_t start = 1;
+        if(type == PIECE_TYPE_NB || type == PAWN){
+            type = PAWN;
+            start = (text[0] == 'P') ? 1 : 0;
+        }
+
+        // Promotion : "e8=Q", "e8Q", or "e8q"
+        PieceType promotion = PIECE_TYPE_NB;
+        if(type == PAWN && length >= 3){
+            const char last = text[length - 1];
+            const PieceType promoted = pieceFromLetter((last >= 'a' && last <= 'z') ? static_cast<char>(last - 'a' + 'A') : last);
+            const bool lowerCase = (last >= 'a' && last <= 'z');
+            if(promoted >= KNIGHT && promoted <= QUEEN && (!lowerCase || isRank(text[length - 2]))){
+                promotion = promoted;
+                length--;
+                if(text[length - 1] == '='){
+                    length--;
+                }
+            }
+        }
+
+        // Destination square
+        if(length < start + 2 || !isFile(text[length - 2]) || !isRank(text[length - 1])){
+            return Move();
+        }
+        const Square to = makeSquare(text[length - 2] - 'a', text[length - 1] - '1');
+
+        // Origin hints between the piece and the destination ("Nbd7", "R1e2", "Qh4xe1", "exd5", "e2-e4")
+        int fromFile = -1;
+        int fromRank = -1;
+        for(size_t i = start; i < length - 2; i++){
+            if(isFile(text[i])){
+                fromFile = text[i] - 'a';
+            }
+            else if(isRank(text[i])){
+                fromRank = text[i] - '1';
+            }
+            else if(text[i] != 'x' && text[i] != '-' && text[i] != ':'){
+                return Move();
+            }
+        }
+
+        Move found;
+        int matches = 0;
+        for(Move move : moves){
+            const Square from = move.from();
+            if(move.to() != to || typeOf(position.getPieceOn(from)) != type || move.type() == CASTLING){
+                continue;
+            }
+            if((fromFile >= 0 && fileOf(from) != fromFile) || (fromRank >= 0 && rankOf(from) != fromRank)){
+                continue;
+            }
+            if((move.type() == PROMOTION) != (promotion != PIECE_TYPE_NB)
+            || (move.type() == PROMOTION && move.promotionType() != promotion)){
+                continue;
+            }
+            found = move;
+            matches++;
+        }
+
+        return (matches == 1) ? found : Move();
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Parse a move in SAN
+     * @param position : the position
+     * @param text : the move
+     * @return Move the legal move, a null move if the text is malformed, illegal or ambiguous
+     */
+
+    Move parseSan(const Position& position, std::string_view text){
+        return parseSan(position, text.data(), text.size());
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Write a legal move in SAN
+     * @details The origin file, else rank, else square is added when another piece of the same type can go to the same
+     * square. The check (+) and mate (#) suffixes need the position after the move.
+     * @param position : the position
+     * @param move : a legal move of the position
+     * @return std::string
+     */
+
+    std::string toSan(const Position& position, Move move){
+        std::string san;
+        const Square from = move.from();
+        const Square to = move.to();
+        const PieceType type = typeOf(position.getPieceOn(from));
+        const bool capture = move.type() == EN_PASSANT || (move.type() != CASTLING && position.getPieceOn(to) != NO_PIECE);
+
+        if(move.type() == CASTLING){
+            san = (to > from) ? "O-O" : "O-O-O";
+        }
+        else if(type == PAWN){
+            if(capture){
+                san += static_cast<char>('a' + fileOf(from));
+                san += 'x';
+            }
+            san += move.toUci().substr(2, 2);
+            if(move.type() == PROMOTION){
+                san += '=';
+                san += pieceLetters[move.promotionType()];
+            }
+        }
+        else{
+            san += pieceLetters[type];
+
+            MoveList moves;
+            generateLegalMoves(position, moves);
+            bool ambiguous = false, sameFile = false, sameRank = false;
+            for(Move other : moves){
+                if(other.to() == to && other.from() != from && other.type() != CASTLING
+                && typeOf(position.getPieceOn(other.from())) == type){
+                    ambiguous = true;
+                    sameFile = sameFile || fileOf(other.from()) == fileOf(from);
+                    sameRank = sameRank || rankOf(other.from()) == rankOf(from);
+                }
+            }
+            if(ambiguous && (!sameFile || sameRank)){
+                san += static_cast<char>('a' + fileOf(from));
+            }
+            if(ambiguous && sameFile){
+                san += static_cast<char>('1' + rankOf(from));
+            }
+
+            if(capture){
+                san += 'x';
+            }
+            san += move.toUci().substr(2, 2);
+        }
+
+        // Check and mate
+        Position after = position;
+        after.doMove(move);
+        if(after.getCheckers()){
+            MoveList replies;
+            generateLegalMoves(after, replies);
+            san += replies.empty() ? '#' : '+';
+        }
+        return san;
+    }
+}
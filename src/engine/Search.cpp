@@ -0,0 +1,718 @@
+/**
+ * @author obiwan138
+ * @file Search.cpp
+ * @brief Implementation of the Search class
+ */
+
+#include "engine/Search.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#include "engine/MoveGen.hpp"
+#include "engine/Zobrist.hpp"
+
+namespace engine{
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Time budget of a move from a clock
+     * @details The remaining time is spread over the moves to go (30 in sudden death, at most 50), plus most of the
+     * increment, and never more than the remaining time minus the overhead
+     * @param timeLeftMs : time left on the clock [ms]
+     * @param incrementMs : increment per move [ms]
+     * @param movesToGo : moves until the next time control, 0 for sudden death
+     * @param overheadMs : time kept in reserve (communication, move generation of the caller) [ms]
+     * @return int64_t the time budget [ms], at least 1
+     */
+
+    int64_t allocateMoveTime(int64_t timeLeftMs, int64_t incrementMs, int movesToGo, int64_t overheadMs){
+        const int64_t movesLeft = (movesToGo > 0) ? std::min(movesToGo, 50) : 30;
+        const int64_t budget = timeLeftMs / movesLeft + incrementMs * 3 / 4;
+        return std::max<int64_t>(1, std::min(budget, timeLeftMs - overheadMs));
+    }
+
+    namespace{
+
+        // Mate scores are stored relative to the node in the transposition table, and relative to the root in the search
+        inline int scoreToTT(int score, int ply){
+            if(score >= SCORE_MATE_IN_MAX_PLY) return score + ply;
+            if(score <= -SCORE_MATE_IN_MAX_PLY) return score - ply;
+            return score;
+        }
+
+        inline int scoreFromTT(int score, int ply){
+            if(score >= SCORE_MATE_IN_MAX_PLY) return score - ply;
+            if(score <= -SCORE_MATE_IN_MAX_PLY) return score + ply;
+            return score;
+        }
+
+        // Has a color other pieces than pawns and king (zugzwang guard of the null move pruning)
+        inline bool hasNonPawnMaterial(const Position& position, Color c){
+            return (position.getPieces(c, KNIGHT) | position.getPieces(c, BISHOP)
+                  | position.getPieces(c, ROOK) | position.getPieces(c, QUEEN)) != 0;
+        }
+
+        // Late move reductions, indexed by depth and move number : they grow with the log of both
+        struct ReductionTable {
+            int value[64][64];
+
+            ReductionTable(){
+                for(int depth = 0; depth < 64; depth++){
+                    for(int count = 0; count < 64; count++){
+                        value[depth][count] = (depth == 0 || count == 0) ? 0
+                            : static_cast<int>(0.75 + std::log(depth) * std::log(count) / 2.25);
+                    }
+                }
+            }
+        };
+
+        // Filled once by the first search, whatever the thread (initialization of a local static)
+        inline const ReductionTable& reductionTable(){
+            static const ReductionTable table;
+            return table;
+        }
+
+        // Move ordering bands
+        const int TT_MOVE_SCORE = 1 << 30;
+        const int CAPTURE_SCORE = 1 << 28;
+        const int KILLER_SCORE = 1 << 27;
+        const int HISTORY_MAX = 16384;
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Constructor
+     * @param ttIn : transposition table (shared with the caller, which owns it)
+     * @param threadIdIn : index of the thread (0 for the main thread)
+     * @param sharedIn : stop flag and node counter shared with the other threads (nullptr to search alone)
+     */
+
+    Search::Search(TranspositionTable& ttIn, int threadIdIn, SharedSearchState* sharedIn)
+        :tt(ttIn){
+
+        this->threadId = threadIdIn;
+        this->shared = sharedIn ? sharedIn : &(this->ownShared);
+
+        this->nodes = 0;
+        this->flushedNodes = 0;
+        this->selDepth = 0;
+        this->clear();
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Forget the move ordering statistics and the pawn cache (new game)
+     */
+
+    void Search::clear(){
+        std::memset(this->history, 0, sizeof(this->history));
+        for(int ply = 0; ply < MAX_PLY; ply++){
+            this->killers[ply][0] = Move();
+            this->killers[ply][1] = Move();
+        }
+        this->evaluator.clear();
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Evaluate with a network of this search only, whatever the network of the other searches
+     * @details Used to play two engine configurations against each other in the same process
+     * @param networkIn : a loaded network, null for the hand-crafted evaluation
+     */
+
+    void Search::setNetwork(const Network* networkIn){
+        this->evaluator.useNetwork(networkIn);
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Ask a running search to stop
+     * @details Thread safe. run() returns the result of the last completed iteration.
+     */
+
+    void Search::stop(){
+        this->shared->stop.store(true, std::memory_order_relaxed);
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief The move pondered on was played : the limits apply from now on
+     * @details Thread safe. The time limit still counts from the start of the search.
+     */
+
+    void Search::ponderhit(){
+        this->shared->pondering.store(false, std::memory_order_relaxed);
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Has the search been stopped (by a limit, stop() or another thread)
+     * @return bool
+     */
+
+    bool Search::stopped() const{
+        return this->shared->stop.load(std::memory_order_relaxed);
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Get the index of the thread
+     * @return int 0 for the main thread
+     */
+
+    int Search::getThreadId() const{
+        return this->threadId;
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Add the new nodes of this thread to the shared counter
+     * @details Done every few thousand nodes, a shared atomic increment per node would not scale
+     */
+
+    void Search::flushNodes(){
+        this->shared->nodes.fetch_add(this->nodes - this->flushedNodes, std::memory_order_relaxed);
+        this->flushedNodes = this->nodes;
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Elapsed time since the start of the search
+     * @return int64_t the time in milliseconds
+     */
+
+    int64_t Search::elapsedMs() const{
+        return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - this->startTime).count();
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Check the time and node limits, and raise the stop flag when one is reached
+     * @details Only the main thread checks the limits, the node limit counts the nodes of all the threads
+     */
+
+    void Search::checkLimits(){
+        this->flushNodes();
+        if(this->limits.infinite || this->threadId != 0 || this->shared->pondering.load(std::memory_order_relaxed)){
+            return;
+        }
+        if((this->limits.nodes && this->shared->nodes.load(std::memory_order_relaxed) >= this->limits.nodes)
+        || (this->limits.moveTimeMs && this->elapsedMs() >= this->limits.moveTimeMs)){
+            this->stop();
+        }
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Is a move a capture or a promotion
+     * @param move : the move
+     * @return bool
+     */
+
+    bool Search::isTactical(Move move) const{
+        return move.type() == EN_PASSANT || move.type() == PROMOTION
+            || (move.type() != CASTLING && this->state.getPosition().getPieceOn(move.to()) != NO_PIECE);
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Score the moves for the ordering
+     * @param moves : the moves of the node
+     * @param scores : output scores, in the order of the moves
+     * @param ttMove : move of the transposition table (null if none)
+     * @param ply : distance to the root
+     */
+
+    void Search::scoreMoves(const MoveList& moves, int* scores, Move ttMove, int ply) const{
+        const Position& position = this->state.getPosition();
+        const Color us = position.getSideToMove();
+
+        for(int i = 0; i < moves.size(); i++){
+            const Move move = moves[i];
+
+            if(move == ttMove){
+                scores[i] = TT_MOVE_SCORE;
+            }
+            else if(this->isTactical(move)){
+                // MVV-LVA : most valuable victim first, then least valuable attacker
+                const PieceType victim = (move.type() == EN_PASSANT) ? PAWN
+                    : (position.getPieceOn(move.to()) != NO_PIECE ? typeOf(position.getPieceOn(move.to())) : PAWN);
+                const PieceType attacker = typeOf(position.getPieceOn(move.from()));
+                scores[i] = CAPTURE_SCORE + Evaluator::pieceValue(victim) * 8 - attacker;
+                if(move.type() == PROMOTION){
+                    scores[i] += (move.promotionType() == QUEEN) ? Evaluator::pieceValue(QUEEN) * 8 : -CAPTURE_SCORE;
+                }
+            }
+            else if(move == this->killers[ply][0]){
+                scores[i] = KILLER_SCORE + 1;
+            }
+            else if(move == this->killers[ply][1]){
+                scores[i] = KILLER_SCORE;
+            }
+            else{
+                scores[i] = this->history[us][move.from()][move.to()];
+            }
+        }
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Bring the best remaining move to a given index (lazy selection sort)
+     * @param moves : the moves of the node
+     * @param scores : their ordering scores
+     * @param index : index of the next move to try
+     * @return Move the move to try
+     */
+
+    Move Search::pickMove(MoveList& moves, int* scores, int index) const{
+        int best = index;
+        for(int i = index + 1; i < moves.size(); i++){
+            if(scores[i] > scores[best]){
+                best = i;
+            }
+        }
+        std::swap(moves[index], moves[best]);
+        std::swap(scores[index], scores[best]);
+        return moves[index];
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Update the killers and the history after a beta cutoff by a quiet move
+     * @param best : the move which produced the cutoff
+     * @param quietsTried : the quiet moves tried before it (they get a malus)
+     * @param quietCount : number of quiet moves tried before it
+     * @param depth : remaining depth of the node
+     * @param ply : distance to the root
+     */
+
+    void Search::updateQuietStats(Move best, const Move* quietsTried, int quietCount, int depth, int ply){
+        if(this->killers[ply][0] != best){
+            this->killers[ply][1] = this->killers[ply][0];
+            this->killers[ply][0] = best;
+        }
+
+        // History with gravity : the scores stay within [-HISTORY_MAX, HISTORY_MAX]
+        const Color us = this->state.getPosition().getSideToMove();
+        const int bonus = std::min(depth * depth, 400);
+        auto update = [&](Move move, int value){
+            int& entry = this->history[us][move.from()][move.to()];
+            entry += value - entry * std::abs(value) / HISTORY_MAX;
+        };
+        update(best, bonus);
+        for(int i = 0; i < quietCount; i++){
+            update(quietsTried[i], -bonus);
+        }
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Quiescence search : only the captures and the queen promotions, until the position is quiet
+     * @details When the side to move is in check, all the evasions are searched (and mate is detected).
+     * @param alpha : lower bound
+     * @param beta : upper bound
+     * @param ply : distance to the root
+     * @return int the score from the side to move point of view
+     */
+
+    int Search::quiescence(int alpha, int beta, int ply){
+        this->nodes++;
+        this->selDepth = std::max(this->selDepth, ply);
+        if((this->nodes & 2047) == 0){
+            this->checkLimits();
+        }
+        if(this->stopped()){
+            return 0;
+        }
+
+        const Position& position = this->state.getPosition();
+        const bool inCheck = position.getCheckers() != 0;
+
+        if(ply >= MAX_PLY - 1){
+            return inCheck ? 0 : this->evaluator.evaluate(this->state);
+        }
+
+        // Stand pat : the side to move can usually do at least as well as the static evaluation
+        int bestScore = -SCORE_INFINITE;
+        if(!inCheck){
+            bestScore = this->evaluator.evaluate(this->state);
+            if(bestScore >= beta){
+                return bestScore;
+            }
+            alpha = std::max(alpha, bestScore);
+        }
+
+        MoveList moves;
+        if(inCheck){
+            generateLegalMoves(position, moves);
+        }
+        else{
+            generateLegalCaptures(position, moves);
+        }
+
+        int scores[MAX_MOVES];
+        this->scoreMoves(moves, scores, Move(), ply);
+
+        for(int i = 0; i < moves.size(); i++){
+            const Move move = this->pickMove(moves, scores, i);
+
+            // Under promotions are not worth searching here
+            if(!inCheck && move.type() == PROMOTION && move.promotionType() != QUEEN){
+                continue;
+            }
+
+            this->tt.prefetch(position.keyAfter(move));
+            this->evaluator.push(position, move);
+            this->state.doMove(move);
+            const int score = -this->quiescence(-beta, -alpha, ply + 1);
+            this->state.undoMove();
+            this->evaluator.pop();
+
+            if(this->stopped()){
+                return 0;
+            }
+
+            if(score > bestScore){
+                bestScore = score;
+                if(score > alpha){
+                    if(score >= beta){
+                        break;
+                    }
+                    alpha = score;
+                }
+            }
+        }
+
+        // Checkmate (all the evasions were searched)
+        if(inCheck && moves.empty()){
+            return -SCORE_MATE + ply;
+        }
+
+        return bestScore;
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Principal variation search
+     * @param alpha : lower bound
+     * @param beta : upper bound
+     * @param depth : remaining depth [plies]
+     * @param ply : distance to the root
+     * @param pvNode : is the node searched with an open window
+     * @param allowNull : can a null move be tried (not twice in a row)
+     * @return int the score from the side to move point of view
+     */
+
+    int Search::search(int alpha, int beta, int depth, int ply, bool pvNode, bool allowNull){
+        this->pvLength[ply] = ply;
+
+        const Position& position = this->state.getPosition();
+        const bool inCheck = position.getCheckers() != 0;
+
+        // Check extension
+        if(inCheck){
+            depth++;
+        }
+
+        if(depth <= 0){
+            return this->quiescence(alpha, beta, ply);
+        }
+
+        this->nodes++;
+        this->selDepth = std::max(this->selDepth, ply);
+        if((this->nodes & 2047) == 0){
+            this->checkLimits();
+        }
+        if(this->stopped()){
+            return 0;
+        }
+
+        const bool rootNode = (ply == 0);
+        if(!rootNode){
+            // Draws by repetition (the second occurrence is enough inside the tree) and by the 50-move rule
+            if(this->state.getRepetitionCount() >= 2 || position.getHalfmoveClock() >= 100){
+                return 0;
+            }
+            if(ply >= MAX_PLY - 1){
+                return inCheck ? 0 : this->evaluator.evaluate(this->state);
+            }
+
+            // Mate distance pruning
+            alpha = std::max(alpha, -SCORE_MATE + ply);
+            beta = std::min(beta, SCORE_MATE - ply - 1);
+            if(alpha >= beta){
+                return alpha;
+            }
+        }
+
+        // Transposition table
+        const uint64_t key = this->state.getKey();
+        TTData ttData;
+        const bool ttHit = this->tt.probe(key, ttData);
+        const Move ttMove = ttHit ? ttData.move : Move();
+        if(ttHit && !pvNode && ttData.depth >= depth){
+            const int ttScore = scoreFromTT(ttData.score, ply);
+            if(ttData.bound == BOUND_EXACT
+            || (ttData.bound == BOUND_LOWER && ttScore >= beta)
+            || (ttData.bound == BOUND_UPPER && ttScore <= alpha)){
+                return ttScore;
+            }
+        }
+
+        // Static evaluation (not meaningful in check)
+        int staticEval = -SCORE_INFINITE;
+        if(!inCheck){
+            staticEval = (ttHit && ttData.eval != -SCORE_INFINITE) ? ttData.eval : this->evaluator.evaluate(this->state);
+        }
+
+        // Null move pruning : if passing still fails high, a real move will too (except in zugzwang)
+        if(!pvNode && !inCheck && allowNull && depth >= 3 && staticEval >= beta
+        && hasNonPawnMaterial(position, position.getSideToMove())){
+            const int reduction = 3 + depth / 4;
+            this->tt.prefetch(this->state.getKey() ^ zobrist.side
+                ^ (position.getEpSquare() != NO_SQUARE ? zobrist.enPassant[fileOf(position.getEpSquare())] : 0));
+            this->evaluator.pushNull();
+            this->state.doNullMove();
+            const int score = -this->search(-beta, -beta + 1, depth - 1 - reduction, ply + 1, false, false);
+            this->state.undoNullMove();
+            this->evaluator.pop();
+
+            if(this->stopped()){
+                return 0;
+            }
+            if(score >= beta){
+                return (score >= SCORE_MATE_IN_MAX_PLY) ? beta : score;
+            }
+        }
+
+        MoveList moves;
+        generateLegalMoves(position, moves);
+        if(moves.empty()){
+            return inCheck ? -SCORE_MATE + ply : 0;
+        }
+
+        int scores[MAX_MOVES];
+        this->scoreMoves(moves, scores, ttMove, ply);
+
+        const int originalAlpha = alpha;
+        int bestScore = -SCORE_INFINITE;
+        Move bestMove;
+        Move quietsTried[MAX_MOVES];
+        int quietCount = 0;
+
+        for(int i = 0; i < moves.size(); i++){
+            const Move move = this->pickMove(moves, scores, i);
+            const bool quiet = !this->isTactical(move);
+
+            this->tt.prefetch(position.keyAfter(move));
+            this->evaluator.push(position, move);
+            this->state.doMove(move);
+            const bool givesCheck = this->state.getPosition().getCheckers() != 0;
+
+            int score;
+            if(i == 0){
+                score = -this->search(-beta, -alpha, depth - 1, ply + 1, pvNode, true);
+            }
+            else{
+                // Late move reductions of the quiet moves ordered last
+                int reduction = 0;
+                if(depth >= 3 && i >= 1 + (pvNode ? 1 : 0) && quiet && !inCheck && !givesCheck){
+                    reduction = reductionTable().value[std::min(depth, 63)][std::min(i, 63)];
+                    if(pvNode){
+                        reduction--;
+                    }
+                    reduction = std::clamp(reduction, 0, depth - 2);
+                }
+
+                // Null window search, re-searched at full depth then with the full window if it beats alpha
+                score = -this->search(-alpha - 1, -alpha, depth - 1 - reduction, ply + 1, false, true);
+                if(score > alpha && reduction > 0){
+                    score = -this->search(-alpha - 1, -alpha, depth - 1, ply + 1, false, true);
+                }
+                if(score > alpha && score < beta && pvNode){
+                    score = -this->search(-beta, -alpha, depth - 1, ply + 1, true, true);
+                }
+            }
+
+            this->state.undoMove();
+            this->evaluator.pop();
+
+            if(this->stopped()){
+                return 0;
+            }
+
+            if(score > bestScore){
+                bestScore = score;
+                if(score > alpha){
+                    bestMove = move;
+
+                    // Principal variation : this move followed by the one of the child
+                    this->pvTable[ply][ply] = move;
+                    for(int next = ply + 1; next < this->pvLength[ply + 1]; next++){
+                        this->pvTable[ply][next] = this->pvTable[ply + 1][next];
+                    }
+                    this->pvLength[ply] = this->pvLength[ply + 1];
+
+                    if(score >= beta){
+                        if(quiet){
+                            this->updateQuietStats(move, quietsTried, quietCount, depth, ply);
+                        }
+                        break;
+                    }
+                    alpha = score;
+                }
+            }
+
+            if(quiet){
+                quietsTried[quietCount++] = move;
+            }
+        }
+
+        const Bound bound = (bestScore >= beta) ? BOUND_LOWER : (alpha > originalAlpha ? BOUND_EXACT : BOUND_UPPER);
+        this->tt.store(key, bestMove, scoreToTT(bestScore, ply), staticEval, depth, bound);
+
+        return bestScore;
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Search the best move of a position by iterative deepening
+     * @details Each depth is searched with an aspiration window around the score of the previous one, widened when the
+     * score falls outside. A new depth is not started when half of the time budget is spent, since it would most likely
+     * not complete. The result of an interrupted iteration is discarded.
+     * @param root : the position and its history (for the repetitions)
+     * @param limitsIn : depth, node and time limits
+     * @param onIteration : called after each completed depth (may be empty)
+     * @return SearchResult the result of the last completed iteration
+     */
+
+    SearchResult Search::run(const GameState& root, const SearchLimits& limitsIn,
+                             const std::function<void(const SearchResult&)>& onIteration){
+
+        this->state = root;
+        this->evaluator.reset();
+        this->limits = limitsIn;
+        this->startTime = std::chrono::steady_clock::now();
+        this->nodes = 0;
+        this->flushedNodes = 0;
+        this->selDepth = 0;
+        if(this->shared == &(this->ownShared)){
+            this->ownShared.stop.store(false, std::memory_order_relaxed);
+            this->ownShared.nodes.store(0, std::memory_order_relaxed);
+            this->ownShared.pondering.store(this->limits.ponder, std::memory_order_relaxed);
+            this->tt.newSearch();
+        }
+        for(int ply = 0; ply < MAX_PLY; ply++){
+            this->killers[ply][0] = Move();
+            this->killers[ply][1] = Move();
+        }
+
+        SearchResult result;
+
+        // No legal move : nothing to search
+        MoveList rootMoves;
+        generateLegalMoves(this->state.getPosition(), rootMoves);
+        if(rootMoves.empty()){
+            result.score = this->state.getPosition().getCheckers() ? -SCORE_MATE : 0;
+            return result;
+        }
+        result.bestMove = rootMoves[0];
+
+        const int maxDepth = (this->limits.depth > 0 && !this->limits.infinite)
+            ? std::min(this->limits.depth, MAX_PLY - 1) : MAX_PLY - 1;
+        uint64_t previousIterationNodes = 0;
+        uint64_t nodesBefore = 0;
+
+        for(int depth = 1; depth <= maxDepth; depth++){
+
+            // Helpers skip some depths (a different pattern for each thread), so that the threads spread over the
+            // next depths instead of all searching the same one
+            if(this->threadId > 0){
+                static const int skipSize[20] = {1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 3, 3, 4, 4, 4, 4, 4, 4, 4, 4};
+                static const int skipPhase[20] = {0, 1, 0, 1, 2, 3, 0, 1, 2, 3, 4, 5, 0, 1, 2, 3, 4, 5, 6, 7};
+                const int i = (this->threadId - 1) % 20;
+                if(((depth + skipPhase[i]) / skipSize[i]) % 2){
+                    continue;
+                }
+            }
+
+            this->selDepth = 0;
+
+            // Aspiration window
+            int delta = 25;
+            int alpha = -SCORE_INFINITE;
+            int beta = SCORE_INFINITE;
+            if(depth >= 5){
+                alpha = std::max(result.score - delta, -SCORE_INFINITE);
+                beta = std::min(result.score + delta, SCORE_INFINITE);
+            }
+
+            int score;
+            while(true){
+                score = this->search(alpha, beta, depth, 0, true, false);
+                if(this->stopped()){
+                    break;
+                }
+                if(score <= alpha){
+                    beta = (alpha + beta) / 2;
+                    alpha = std::max(score - delta, -SCORE_INFINITE);
+                }
+                else if(score >= beta){
+                    beta = std::min(score + delta, SCORE_INFINITE);
+                }
+                else{
+                    break;
+                }
+                delta *= 2;
+            }
+
+            if(this->stopped()){
+                break;
+            }
+
+            // Completed iteration (the node counts include the other threads)
+            this->flushNodes();
+            const uint64_t totalNodes = this->shared->nodes.load(std::memory_order_relaxed);
+            const uint64_t iterationNodes = totalNodes - nodesBefore;
+            result.bestMove = this->pvTable[0][0];
+            result.score = score;
+            result.depth = depth;
+            result.selDepth = this->selDepth;
+            result.nodes = totalNodes;
+            result.timeMs = this->elapsedMs();
+            result.nps = totalNodes * 1000 / static_cast<uint64_t>(std::max<int64_t>(result.timeMs, 1));
+            result.ebf = previousIterationNodes ? static_cast<double>(iterationNodes) / previousIterationNodes : 0.0;
+            result.hashfull = this->tt.hashfull();
+            result.pv.assign(this->pvTable[0], this->pvTable[0] + this->pvLength[0]);
+            previousIterationNodes = iterationNodes;
+            nodesBefore = totalNodes;
+
+            if(onIteration){
+                onIteration(result);
+            }
+
+            // Stop early on a found mate, or when the next depth would most likely not complete in time
+            if(!this->limits.infinite && !this->shared->pondering.load(std::memory_order_relaxed)){
+                if(std::abs(score) >= SCORE_MATE_IN_MAX_PLY && depth >= SCORE_MATE - std::abs(score)){
+                    break;
+                }
+                if(this->limits.moveTimeMs && result.timeMs * 2 >= this->limits.moveTimeMs){
+                    break;
+                }
+            }
+        }
+
+        // Infinite searches wait for stop() before returning, ponder searches for stop() or ponderhit
+        while((this->limits.infinite || this->shared->pondering.load(std::memory_order_relaxed)) && !this->stopped()){
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+
+        this->flushNodes();
+        result.nodes = this->shared->nodes.load(std::memory_order_relaxed);
+        result.timeMs = this->elapsedMs();
+        result.nps = result.nodes * 1000 / static_cast<uint64_t>(std::max<int64_t>(result.timeMs, 1));
+        return result;
+    }
+}
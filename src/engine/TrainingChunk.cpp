@@ -0,0 +1,167 @@
+/**
+ * @author obiwan138
+ * @file TrainingChunk.cpp
+ * @brief Implementation of the TrainingChunk class
+ */
+
+#include "engine/TrainingChunk.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+namespace engine{
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Constructor
+     */
+
+    TrainingChunk::TrainingChunk(){
+        this->recordCount = 0;
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Map a chunk
+     * @details The header and the size of the file are checked, the records are only read when they are accessed
+     * @param path : path of the chunk
+     * @return true if the chunk is open
+     */
+
+    bool TrainingChunk::open(const std::string& path){
+        this->close();
+
+        if(!this->file.open(path)){
+            return false;
+        }
+
+        TrainingChunkHeader header;
+        if(this->file.getSize() < HEADER_SIZE){
+            std::cerr << "Error: " << path << " is not a training chunk" << std::endl;
+            this->file.close();
+            return false;
+        }
+        std::memcpy(&header, this->file.getData(), sizeof(header));
+
+        if(std::memcmp(header.magic, FILE_MAGIC, sizeof(FILE_MAGIC)) != 0 || header.version != FILE_VERSION
+        || header.recordSize != sizeof(PackedPosition)){
+            std::cerr << "Error: " << path << " is not a training chunk (version " << FILE_VERSION << ")" << std::endl;
+            this->file.close();
+            return false;
+        }
+        if((this->file.getSize() - HEADER_SIZE) / sizeof(PackedPosition) != header.recordCount){
+            std::cerr << "Error: " << path << " does not hold " << header.recordCount << " records" << std::endl;
+            this->file.close();
+            return false;
+        }
+
+        this->recordCount = header.recordCount;
+        return true;
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Unmap the chunk
+     */
+
+    void TrainingChunk::close(){
+        this->file.close();
+        this->recordCount = 0;
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Is a chunk open
+     * @return bool
+     */
+
+    bool TrainingChunk::isOpen() const{
+        return this->file.isOpen();
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Get the number of records
+     * @return uint64_t
+     */
+
+    uint64_t TrainingChunk::getRecordCount() const{
+        return this->recordCount;
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Get the record of a position
+     * @param index : index of the record, below the record count
+     * @return PackedPosition
+     */
+
+    PackedPosition TrainingChunk::getRecord(uint64_t index) const{
+        PackedPosition record;
+        std::memcpy(&record, this->file.getData() + HEADER_SIZE + index * sizeof(PackedPosition), sizeof(record));
+        return record;
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Pack a position and its labels
+     * @param position : the position (at most 32 pieces)
+     * @param score : score of the search, side to move point of view [centipawns], clamped to 16 bits
+     * @param result : result of the game for white (0 loss, 1 draw, 2 win)
+     * @param ply : ply of the position in its game
+     * @return PackedPosition
+     */
+
+    PackedPosition TrainingChunk::pack(const Position& position, int score, uint8_t result, int ply){
+        PackedPosition record = {};
+        record.occupied = position.getOccupied();
+
+        Bitboard occupied = record.occupied;
+        for(int i = 0; occupied && i < 32; i++){
+            const Square square = popLsb(occupied);
+            record.pieces[i / 2] |= static_cast<uint8_t>(position.getPieceOn(square) << ((i % 2) * 4));
+        }
+
+        record.flags = static_cast<uint8_t>((position.getSideToMove() == BLACK ? 1 : 0) | (position.getCastlingRights() << 1));
+        record.epSquare = static_cast<uint8_t>(position.getEpSquare());
+        record.halfmoveClock = position.getHalfmoveClock();
+        record.result = result;
+        record.score = static_cast<int16_t>(std::clamp(score, static_cast<int>(INT16_MIN), static_cast<int>(INT16_MAX)));
+        record.ply = static_cast<uint16_t>(std::clamp(ply, 0, static_cast<int>(UINT16_MAX)));
+        return record;
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Unpack the position of a record
+     * @details The position may still be illegal (see Position::checkLegality)
+     * @param record : the record
+     * @param position : output, the position (its fullmove number from the ply of the record)
+     * @return true if the fields of the record are in range
+     */
+
+    bool TrainingChunk::unpack(const PackedPosition& record, Position& position){
+        if(popCount(record.occupied) > 32 || record.epSquare > NO_SQUARE || record.flags > 31 || record.result > 2){
+            return false;
+        }
+
+        position = Position();
+        Bitboard occupied = record.occupied;
+        for(int i = 0; occupied; i++){
+            const Square square = popLsb(occupied);
+            const int piece = (record.pieces[i / 2] >> ((i % 2) * 4)) & 15;
+            if(piece >= PIECE_NB){
+                return false;
+            }
+            position.putPiece(static_cast<Piece>(piece), square);
+        }
+
+        position.setSideToMove((record.flags & 1) ? BLACK : WHITE);
+        position.setCastlingRights(static_cast<uint8_t>(record.flags >> 1));
+        position.setEpSquare(static_cast<Square>(record.epSquare));
+        position.setHalfmoveClock(record.halfmoveClock);
+        position.setFullmoveNumber(static_cast<uint16_t>(record.ply / 2 + 1));
+        return true;
+    }
+}
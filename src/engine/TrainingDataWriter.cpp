@@ -0,0 +1,151 @@
+/**
+ * @author obiwan138
+ * @file TrainingDataWriter.cpp
+ * @brief Implementation of the TrainingDataWriter class
+ */
+
+#include "engine/TrainingDataWriter.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <utility>
+
+namespace engine{
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Constructor
+     */
+
+    TrainingDataWriter::TrainingDataWriter(){
+        this->chunkSize = 0;
+        this->recordCount = 0;
+        this->chunkCount = 0;
+        this->failed = false;
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Start writing chunks
+     * @details The files are created when their chunk is full (or by close)
+     * @param prefixIn : path of the chunks without their number
+     * @param chunkSizeIn : positions per chunk
+     * @param seed : seed of the shuffles (the same seed gives the same files for the same positions)
+     */
+
+    void TrainingDataWriter::open(const std::string& prefixIn, size_t chunkSizeIn, uint64_t seed){
+        this->prefix = prefixIn;
+        this->chunkSize = std::max<size_t>(chunkSizeIn, 1);
+        this->buffer.clear();
+        this->buffer.reserve(this->chunkSize);
+        this->random.seed(seed);
+        this->recordCount = 0;
+        this->chunkCount = 0;
+        this->failed = false;
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Add a position
+     * @param record : the position and its labels
+     */
+
+    void TrainingDataWriter::add(const PackedPosition& record){
+        this->buffer.push_back(record);
+        if(this->buffer.size() >= this->chunkSize){
+            this->writeChunk();
+        }
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Shuffle the buffer (Fisher-Yates) and write it to the next chunk file
+     */
+
+    void TrainingDataWriter::writeChunk(){
+        if(this->buffer.empty()){
+            return;
+        }
+
+        for(size_t i = this->buffer.size() - 1; i > 0; i--){
+            const size_t j = static_cast<size_t>(this->random.next() % (i + 1));
+            std::swap(this->buffer[i], this->buffer[j]);
+        }
+
+        const std::string path = chunkPath(this->prefix, this->chunkCount);
+        std::FILE* file = std::fopen(path.c_str(), "wb");
+        if(!file){
+            std::cerr << "Error: cannot create " << path << std::endl;
+            this->failed = true;
+            this->buffer.clear();
+            return;
+        }
+
+        uint8_t headerBlock[TrainingChunk::HEADER_SIZE] = {};
+        TrainingChunkHeader header = {};
+        std::memcpy(header.magic, TrainingChunk::FILE_MAGIC, sizeof(header.magic));
+        header.version = TrainingChunk::FILE_VERSION;
+        header.recordSize = sizeof(PackedPosition);
+        header.recordCount = this->buffer.size();
+        std::memcpy(headerBlock, &header, sizeof(header));
+
+        bool written = std::fwrite(headerBlock, 1, sizeof(headerBlock), file) == sizeof(headerBlock);
+        written = written && std::fwrite(this->buffer.data(), sizeof(PackedPosition), this->buffer.size(), file) == this->buffer.size();
+        written = (std::fclose(file) == 0) && written;
+        if(!written){
+            std::cerr << "Error: cannot write " << path << std::endl;
+            this->failed = true;
+        }
+
+        this->recordCount += this->buffer.size();
+        this->chunkCount++;
+        this->buffer.clear();
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Write the last chunk
+     * @return true if every chunk was written
+     */
+
+    bool TrainingDataWriter::close(){
+        this->writeChunk();
+        return !this->failed;
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Get the number of positions written
+     * @return uint64_t
+     */
+
+    uint64_t TrainingDataWriter::getRecordCount() const{
+        return this->recordCount;
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Get the number of chunks written
+     * @return uint64_t
+     */
+
+    uint64_t TrainingDataWriter::getChunkCount() const{
+        return this->chunkCount;
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Get the path of a chunk file
+     * @param prefix : path of the chunks without their number
+     * @param number : number of the chunk, from 0
+     * @return std::string <prefix>-<number on 6 digits>.c3t
+     */
+
+    std::string TrainingDataWriter::chunkPath(const std::string& prefix, uint64_t number){
+        char suffix[32];
+        std::snprintf(suffix, sizeof(suffix), "-%06llu.c3t", static_cast<unsigned long long>(number));
+        return prefix + suffix;
+    }
+}
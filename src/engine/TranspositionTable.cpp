@@ -0,0 +1,352 @@
+/**
+ * @author obiwan138
+ * @file TranspositionTable.cpp
+ * @brief Implementation of the TranspositionTable class
+ */
+
+#include "engine/TranspositionTable.hpp"
+
+#include <algorithm>
+#include <climits>
+#include <cstring>
+#include <iostream>
+#include <new>
+
+#include <omp.h>
+
+#if defined(__linux__)
+#include <sys/mman.h>
+#endif
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#include <xmmintrin.h>
+#endif
+
+namespace engine{
+
+    namespace{
+
+        constexpr size_t MIB = 1024 * 1024;
+
+        // Packing of the data word
+        inline uint64_t packData(Move move, int score, int eval, int depth, Bound bound, uint8_t generation){
+            return static_cast<uint64_t>(move.raw())
+                 | (static_cast<uint64_t>(static_cast<uint16_t>(score)) << 16)
+                 | (static_cast<uint64_t>(static_cast<uint16_t>(eval)) << 32)
+                 | (static_cast<uint64_t>(static_cast<uint8_t>(std::min(depth, 127))) << 48)
+                 | (static_cast<uint64_t>(bound) << 56)
+                 | (static_cast<uint64_t>(generation & 63) << 58);
+        }
+
+        inline Move moveOf(uint64_t data){ return Move(static_cast<uint16_t>(data)); }
+        inline int16_t scoreOf(uint64_t data){ return static_cast<int16_t>(data >> 16); }
+        inline int16_t evalOf(uint64_t data){ return static_cast<int16_t>(data >> 32); }
+        inline int depthOf(uint64_t data){ return static_cast<int8_t>(data >> 48); }
+        inline Bound boundOf(uint64_t data){ return static_cast<Bound>((data >> 56) & 3); }
+        inline uint8_t generationOf(uint64_t data){ return static_cast<uint8_t>(data >> 58); }
+
+        // High 64 bits of a 64 x 64 bit product
+        inline uint64_t mulHi64(uint64_t a, uint64_t b){
+#if defined(__SIZEOF_INT128__)
+            return static_cast<uint64_t>((static_cast<unsigned __int128>(a) * b) >> 64);
+#elif defined(_MSC_VER) && defined(_M_X64)
+            return __umulh(a, b);
+#else
+            const uint64_t aLow = a & 0xFFFFFFFFull, aHigh = a >> 32;
+            const uint64_t bLow = b & 0xFFFFFFFFull, bHigh = b >> 32;
+            const uint64_t middle = aHigh * bLow + ((aLow * bLow) >> 32);
+            return aHigh * bHigh + (middle >> 32) + ((aLow * bHigh + (middle & 0xFFFFFFFFull)) >> 32);
+#endif
+        }
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Constructor
+     * @param sizeMb : size in MiB
+     * @param explicitHugePagesIn : try explicit huge pages (MAP_HUGETLB) before the transparent ones
+     */
+
+    TranspositionTable::TranspositionTable(size_t sizeMb, bool explicitHugePagesIn){
+        this->buckets = nullptr;
+        this->bucketCount = 0;
+        this->allocatedBytes = 0;
+        this->mapped = false;
+        this->explicitHugePages = explicitHugePagesIn;
+        this->generation = 0;
+        this->resize(sizeMb);
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Allocate the buckets
+     * @details On Linux the memory is mapped directly : explicit huge pages if requested (and reserved), otherwise
+     * normal pages with a transparent huge pages hint, which cuts the TLB misses of the random accesses. Elsewhere it
+     * is allocated aligned on a cache line.
+     * @param bytes : size of the table
+     * @return true if the memory was allocated
+     */
+
+    bool TranspositionTable::allocate(size_t bytes){
+#if defined(__linux__)
+        void* memory = MAP_FAILED;
+        constexpr size_t HUGE_PAGE_SIZE = 2 * MIB;
+        const size_t hugeBytes = (bytes + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE * HUGE_PAGE_SIZE;
+
+#if defined(MAP_HUGETLB)
+        if(this->explicitHugePages){
+            memory = mmap(nullptr, hugeBytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+            if(memory == MAP_FAILED){
+                std::cerr << "Warning: no explicit huge pages available for the transposition table, using normal pages" << std::endl;
+            }
+            else{
+                this->allocatedBytes = hugeBytes;
+            }
+        }
+#endif
+        if(memory == MAP_FAILED){
+            memory = mmap(nullptr, hugeBytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+            if(memory == MAP_FAILED){
+                return false;
+            }
+            this->allocatedBytes = hugeBytes;
+#if defined(MADV_HUGEPAGE)
+            madvise(memory, hugeBytes, MADV_HUGEPAGE);
+#endif
+        }
+        this->buckets = static_cast<Bucket*>(memory);
+        this->mapped = true;
+        return true;
+#else
+        this->buckets = static_cast<Bucket*>(::operator new(bytes, std::align_val_t(alignof(Bucket)), std::nothrow));
+        this->allocatedBytes = bytes;
+        this->mapped = false;
+        return this->buckets != nullptr;
+#endif
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Free the buckets
+     */
+
+    void TranspositionTable::release(){
+        if(this->buckets == nullptr){
+            return;
+        }
+#if defined(__linux__)
+        if(this->mapped){
+            munmap(this->buckets, this->allocatedBytes);
+        }
+#else
+        ::operator delete(this->buckets, std::align_val_t(alignof(Bucket)));
+#endif
+        this->buckets = nullptr;
+        this->bucketCount = 0;
+        this->allocatedBytes = 0;
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Change the size of the table
+     * @details Any size is possible (the index is a multiply-high of the key by the bucket count), tens of GiB included
+     * @param sizeMb : size in MiB
+     * @return false if the memory could not be allocated (the table then falls back to 1 MiB)
+     */
+
+    bool TranspositionTable::resize(size_t sizeMb){
+        this->release();
+
+        const size_t bytes = std::max<size_t>(sizeMb, 1) * MIB;
+        bool allocated = this->allocate(bytes);
+        if(!allocated){
+            std::cerr << "Error: could not allocate " << sizeMb << " MiB for the transposition table, using 1 MiB" << std::endl;
+            if(!this->allocate(MIB)){
+                throw std::bad_alloc();
+            }
+        }
+
+        this->bucketCount = (allocated ? bytes : MIB) / sizeof(Bucket);
+        this->clear();
+        return allocated;
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Empty the table
+     * @details The cores clear a slice each, which also spreads the pages over the NUMA nodes (first touch)
+     */
+
+    void TranspositionTable::clear(){
+        const int threadCount = std::max(1, omp_get_max_threads());
+        const size_t slice = (this->bucketCount + threadCount - 1) / threadCount;
+
+        #pragma omp parallel for num_threads(threadCount) schedule(static)
+        for(int i = 0; i < threadCount; i++){
+            const size_t begin = std::min(this->bucketCount, i * slice);
+            const size_t end = std::min(this->bucketCount, begin + slice);
+            if(end > begin){
+                std::memset(static_cast<void*>(this->buckets + begin), 0, (end - begin) * sizeof(Bucket));
+            }
+        }
+        this->generation = 0;
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Start a new search
+     */
+
+    void TranspositionTable::newSearch(){
+        this->generation = (this->generation + 1) & 63;
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Get the bucket of a key
+     * @param key : Zobrist key of the position
+     * @return Bucket&
+     */
+
+    TranspositionTable::Bucket& TranspositionTable::bucketOf(uint64_t key) const{
+        return this->buckets[mulHi64(key, this->bucketCount)];
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Load the bucket of a key into the cache
+     * @details Called with the key of the next position before a move is played, so the memory access overlaps with
+     * the make-move and the probe of the child finds the bucket in the cache
+     * @param key : Zobrist key of the position
+     */
+
+    void TranspositionTable::prefetch(uint64_t key) const{
+#if defined(__GNUC__)
+        __builtin_prefetch(&(this->bucketOf(key)));
+#elif defined(_MSC_VER)
+        _mm_prefetch(reinterpret_cast<const char*>(&(this->bucketOf(key))), _MM_HINT_T0);
+#endif
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Look up a position
+     * @param key : Zobrist key of the position
+     * @param data : output stored data
+     * @return true if the position is in the table
+     */
+
+    bool TranspositionTable::probe(uint64_t key, TTData& data) const{
+        const Bucket& bucket = this->bucketOf(key);
+        for(const Entry& entry : bucket.entries){
+            const uint64_t entryData = entry.data.load(std::memory_order_relaxed);
+            const uint64_t entryKey = entry.keyXorData.load(std::memory_order_relaxed) ^ entryData;
+            if(entryKey == key && boundOf(entryData) != BOUND_NONE){
+                data.move = moveOf(entryData);
+                data.score = scoreOf(entryData);
+                data.eval = evalOf(entryData);
+                data.depth = static_cast<int8_t>(depthOf(entryData));
+                data.bound = boundOf(entryData);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Store a search result
+     * @details The entry of the same position is updated, unless it holds a deeper result of the current search and
+     * the new one is not exact. Otherwise the entry with the lowest depth is replaced, minus 8 plies per generation of age.
+     * @param key : Zobrist key of the position
+     * @param move : best move (null move to keep the stored one)
+     * @param score : score, with the mate scores relative to this position
+     * @param eval : static evaluation
+     * @param depth : remaining depth of the search
+     * @param bound : kind of bound of the score
+     */
+
+    void TranspositionTable::store(uint64_t key, Move move, int score, int eval, int depth, Bound bound){
+        Bucket& bucket = this->bucketOf(key);
+
+        Entry* replaced = &(bucket.entries[0]);
+        uint64_t replacedData = 0;
+        bool samePosition = false;
+        int lowestValue = INT_MAX;
+
+        for(Entry& entry : bucket.entries){
+            const uint64_t entryData = entry.data.load(std::memory_order_relaxed);
+            const uint64_t entryKey = entry.keyXorData.load(std::memory_order_relaxed) ^ entryData;
+
+            if(entryKey == key && boundOf(entryData) != BOUND_NONE){
+                replaced = &entry;
+                replacedData = entryData;
+                samePosition = true;
+                break;
+            }
+
+            // Empty entries first, then the shallow and old ones
+            const int age = (this->generation - generationOf(entryData)) & 63;
+            const int value = (boundOf(entryData) == BOUND_NONE) ? INT_MIN : depthOf(entryData) - 8 * age;
+            if(value < lowestValue){
+                lowestValue = value;
+                replaced = &entry;
+                replacedData = entryData;
+            }
+        }
+
+        if(samePosition){
+            if(bound != BOUND_EXACT && generationOf(replacedData) == this->generation && depthOf(replacedData) > depth + 3){
+                return;
+            }
+            if(move.isNull()){
+                move = moveOf(replacedData);
+            }
+        }
+
+        const uint64_t newData = packData(move, score, eval, depth, bound, this->generation);
+        replaced->data.store(newData, std::memory_order_relaxed);
+        replaced->keyXorData.store(key ^ newData, std::memory_order_relaxed);
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Per mille of the entries written by the current search
+     * @details Sampled on the first 1000 entries
+     * @return int between 0 and 1000
+     */
+
+    int TranspositionTable::hashfull() const{
+        int used = 0;
+        int sampled = 0;
+        const size_t sampleBuckets = std::min<size_t>(1000 / BUCKET_SIZE, this->bucketCount);
+        for(size_t i = 0; i < sampleBuckets; i++){
+            for(const Entry& entry : this->buckets[i].entries){
+                const uint64_t entryData = entry.data.load(std::memory_order_relaxed);
+                used += (boundOf(entryData) != BOUND_NONE && generationOf(entryData) == this->generation) ? 1 : 0;
+                sampled++;
+            }
+        }
+        return sampled ? used * 1000 / sampled : 0;
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Get the size of the table
+     * @return size_t the size in MiB
+     */
+
+    size_t TranspositionTable::getSizeMb() const{
+        return this->bucketCount * sizeof(Bucket) / MIB;
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Destructor
+     */
+
+    TranspositionTable::~TranspositionTable(){
+        this->release();
+    }
+}
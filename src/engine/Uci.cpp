@@ -0,0 +1,415 @@
+/**
+ * @author obiwan138
+ * @file Uci.cpp
+ * @brief Implementation of the Uci class
+ */
+
+#include "engine/Uci.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <iomanip>
+#include <stdexcept>
+
+#include "engine/Attacks.hpp"
+#include "engine/Bench.hpp"
+#include "engine/MoveGen.hpp"
+
+namespace engine{
+
+    namespace{
+
+        // Time kept in reserve for the communication with the GUI [ms]
+        const int64_t MOVE_OVERHEAD_MS = 30;
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Constructor
+     */
+
+    Uci::Uci()
+        :tt(DEFAULT_HASH_MB), search(tt, 1){
+        initAttacks();
+        this->ownBook = false;
+        this->bookBestMove = false;
+        this->bookRandom.seed(static_cast<uint64_t>(std::chrono::steady_clock::now().time_since_epoch().count()));
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Write a line on the standard output
+     * @param line : the line, without the end of line
+     */
+
+    void Uci::send(const std::string& line){
+        std::lock_guard<std::mutex> lock(this->outputMutex);
+        std::cout << line << std::endl;
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Parse a move in UCI notation
+     * @param position : the position where the move is played
+     * @param text : the move (e.g. e2e4, e1g1, e7e8q)
+     * @return Move the legal move, null if the text is not a legal move
+     */
+
+    Move Uci::parseMove(const Position& position, const std::string& text){
+        MoveList moves;
+        generateLegalMoves(position, moves);
+        for(Move move : moves){
+            if(move.toUci() == text){
+                return move;
+            }
+        }
+        return Move();
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Format a search iteration as an "info" line
+     * @param result : the iteration
+     * @return std::string the line
+     */
+
+    std::string Uci::formatInfo(const SearchResult& result){
+        std::ostringstream line;
+        line << "info depth " << result.depth << " seldepth " << result.selDepth << " score ";
+        if(result.score >= SCORE_MATE_IN_MAX_PLY){
+            line << "mate " << (SCORE_MATE - result.score + 1) / 2;
+        }
+        else if(result.score <= -SCORE_MATE_IN_MAX_PLY){
+            line << "mate -" << (SCORE_MATE + result.score) / 2;
+        }
+        else{
+            line << "cp " << result.score;
+        }
+        line << " nodes " << result.nodes << " nps " << result.nps << " hashfull " << result.hashfull
+             << " time " << result.timeMs << " pv";
+        for(Move move : result.pv){
+            line << " " << move.toUci();
+        }
+        return line.str();
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Wait for the end of the running search
+     */
+
+    void Uci::waitSearch(){
+        if(this->searchThread.joinable()){
+            this->searchThread.join();
+        }
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief "uci" : identify the engine and list its options
+     */
+
+    void Uci::handleUci(){
+        this->send("id name Chess3D");
+        this->send("id author obiwan138");
+        this->send("option name Hash type spin default " + std::to_string(DEFAULT_HASH_MB) + " min 1 max " + std::to_string(MAX_HASH_MB));
+        this->send("option name Threads type spin default 1 min 1 max 1024");
+        this->send("option name Ponder type check default false");
+        this->send("option name EvalFile type string default <empty>");
+        this->send("option name OwnBook type check default false");
+        this->send("option name BookFile type string default <empty>");
+        this->send("option name BookBestMove type check default false");
+        this->send("option name BookKeyFile type string default <empty>");
+        this->send("uciok");
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief "setoption name <name> value <value>"
+     * @param input : the rest of the command
+     */
+
+    void Uci::handleSetOption(std::istringstream& input){
+        std::string token, name, value;
+        input >> token;
+        while(input >> token && token != "value"){
+            name += (name.empty() ? "" : " ") + token;
+        }
+        std::getline(input >> std::ws, value);
+        value.erase(value.find_last_not_of(" \t\r") + 1);
+
+        // The options are never changed during a search
+        this->waitSearch();
+
+        if((name == "Hash" || name == "Threads") && !value.empty()){
+            try{
+                if(name == "Hash"){
+                    this->tt.resize(static_cast<size_t>(std::clamp<long long>(std::stoll(value), 1, MAX_HASH_MB)));
+                }
+                else{
+                    this->search.setThreadCount(std::clamp(std::stoi(value), 1, 1024));
+                }
+            }
+            catch(const std::exception&){
+                this->send("info string invalid value " + value + " of the option " + name);
+            }
+        }
+        else if(name == "EvalFile"){
+            // The table holds evaluations of the previous evaluation function
+            Evaluator::setNetwork(nullptr);
+            this->tt.clear();
+            if(value.empty() || value == "<empty>"){
+                this->send("info string hand-crafted evaluation");
+            }
+            else if(this->network.load(value)){
+                Evaluator::setNetwork(&this->network);
+                this->send("info string network " + value + " loaded (" + this->network.getKernels().name + " kernels)");
+            }
+            else{
+                this->send("info string cannot load the network " + value + ", hand-crafted evaluation");
+            }
+        }
+        else if(name == "OwnBook"){
+            this->ownBook = (value == "true");
+        }
+        else if(name == "BookBestMove"){
+            this->bookBestMove = (value == "true");
+        }
+        else if(name == "BookFile"){
+            if(value.empty() || value == "<empty>"){
+                this->book.close();
+            }
+            else if(this->book.open(value)){
+                this->send("info string book " + value + " opened (" + std::to_string(this->book.getEntryCount()) + " entries)");
+            }
+            else{
+                this->send("info string cannot open the book " + value);
+            }
+        }
+        else if(name == "BookKeyFile" && !value.empty() && value != "<empty>"){
+            if(PolyglotBook::loadKeys(value)){
+                this->send("info string book keys read from " + value);
+            }
+            else{
+                this->send("info string cannot read the book keys " + value);
+            }
+        }
+        else if(name != "Ponder"){
+            this->send("info string unknown option " + name);
+        }
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief "position startpos|fen <fen> [moves <move>...]"
+     * @param input : the rest of the command
+     */
+
+    void Uci::handlePosition(std::istringstream& input){
+        std::string token, fen;
+        input >> token;
+        if(token == "startpos"){
+            fen = Position::startFen;
+            input >> token;
+        }
+        else if(token == "fen"){
+            while(input >> token && token != "moves"){
+                fen += token + " ";
+            }
+        }
+        else{
+            return;
+        }
+
+        if(!this->game.setFromFen(fen)){
+            this->send("info string invalid fen " + fen);
+            this->game.setFromFen(Position::startFen);
+            return;
+        }
+
+        // The move generator and the search assume a reachable position (one king per side...)
+        if(const char* reason = this->game.getPosition().checkLegality()){
+            this->send("info string illegal position " + fen + "(" + reason + ")");
+            this->game.setFromFen(Position::startFen);
+            return;
+        }
+
+        // The moves after "moves" (token holds "moves" here if there are some)
+        while(input >> token){
+            const Move move = parseMove(this->game.getPosition(), token);
+            if(move.isNull()){
+                this->send("info string illegal move " + token);
+                return;
+            }
+            this->game.doMove(move);
+        }
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief "go" : start a search on the search thread
+     * @details With a clock (wtime/btime), the budget is the remaining time divided by the moves to go (30 when
+     * unknown) plus most of the increment, never more than the remaining time minus a safety margin. With OwnBook, a
+     * book move is played at once, the search only starts when the position is out of book.
+     * @param input : the rest of the command
+     */
+
+    void Uci::handleGo(std::istringstream& input){
+        SearchLimits limits;
+        int64_t time[COLOR_NB] = {0, 0};
+        int64_t increment[COLOR_NB] = {0, 0};
+        int movesToGo = 0;
+        std::string token;
+
+        while(input >> token){
+            if(token == "depth") input >> limits.depth;
+            else if(token == "nodes") input >> limits.nodes;
+            else if(token == "movetime") input >> limits.moveTimeMs;
+            else if(token == "wtime") input >> time[WHITE];
+            else if(token == "btime") input >> time[BLACK];
+            else if(token == "winc") input >> increment[WHITE];
+            else if(token == "binc") input >> increment[BLACK];
+            else if(token == "movestogo") input >> movesToGo;
+            else if(token == "infinite") limits.infinite = true;
+            else if(token == "ponder") limits.ponder = true;
+        }
+
+        this->waitSearch();
+
+        if(this->ownBook && !limits.infinite && !limits.ponder){
+            const Move bookMove = this->book.pick(this->game.getPosition(), this->bookBestMove, this->bookRandom);
+            if(!bookMove.isNull()){
+                this->send("bestmove " + bookMove.toUci());
+                return;
+            }
+        }
+
+        const Color us = this->game.getPosition().getSideToMove();
+        if(limits.moveTimeMs == 0 && time[us] > 0){
+            limits.moveTimeMs = allocateMoveTime(time[us], increment[us], movesToGo, MOVE_OVERHEAD_MS);
+        }
+
+        this->searchRoot = this->game;
+        this->searchThread = std::thread([this, limits](){
+            const SearchResult result = this->search.run(this->searchRoot, limits, [this](const SearchResult& iteration){
+                this->send(formatInfo(iteration));
+            });
+
+            std::string line = "bestmove " + (result.bestMove.isNull() ? std::string("0000") : result.bestMove.toUci());
+            if(result.pv.size() >= 2){
+                line += " ponder " + result.pv[1].toUci();
+            }
+            this->send(line);
+        });
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief "bench [depth] [threads]" : search the bench positions to a fixed depth
+     * @details The single-threaded run gives the node count signature and the speed. With more threads, the bench is run
+     * again with 2, 4, ... threads and the nodes per second are compared to the single-threaded run.
+     * @param input : the rest of the command
+     */
+
+    void Uci::handleBench(std::istringstream& input){
+        int depth = BENCH_DEFAULT_DEPTH;
+        int maxThreads = 1;
+        input >> depth >> maxThreads;
+        depth = std::max(depth, 1);
+        maxThreads = std::max(maxThreads, 1);
+
+        this->waitSearch();
+        const int threadCount = this->search.getThreadCount();
+
+        // Signature : single-threaded, deterministic
+        this->search.setThreadCount(1);
+        const BenchResult reference = runBench(this->tt, this->search, depth, &std::cerr);
+        this->send("Total time (ms) : " + std::to_string(reference.timeMs));
+        this->send("Nodes searched  : " + std::to_string(reference.nodes));
+        this->send("Nodes/second    : " + std::to_string(reference.nps));
+
+        // Scaling of the speed with the threads
+        for(int threads = 2; maxThreads > 1; threads = std::min(threads * 2, maxThreads)){
+            this->search.setThreadCount(threads);
+            const BenchResult result = runBench(this->tt, this->search, depth);
+            std::ostringstream line;
+            line << std::fixed << std::setprecision(2) << "Threads " << threads << " : " << result.nps << " nodes/second, x"
+                 << static_cast<double>(result.nps) / std::max<uint64_t>(reference.nps, 1) << " (per thread x"
+                 << static_cast<double>(result.nps) / std::max<uint64_t>(reference.nps, 1) / threads << ")";
+            this->send(line.str());
+            if(threads == maxThreads){
+                break;
+            }
+        }
+
+        this->search.setThreadCount(threadCount);
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Read and execute the commands until "quit" or the end of the input
+     * @param input : the command stream (standard input by default)
+     */
+
+    void Uci::loop(std::istream& input){
+        std::string line;
+        while(std::getline(input, line)){
+            std::istringstream stream(line);
+            std::string command;
+            stream >> command;
+
+            if(command == "quit"){
+                break;
+            }
+            else if(command == "uci"){
+                this->handleUci();
+            }
+            else if(command == "isready"){
+                this->send("readyok");
+            }
+            else if(command == "ucinewgame"){
+                this->waitSearch();
+                this->tt.clear();
+                this->search.clear();
+            }
+            else if(command == "setoption"){
+                this->handleSetOption(stream);
+            }
+            else if(command == "position"){
+                this->handlePosition(stream);
+            }
+            else if(command == "go"){
+                this->handleGo(stream);
+            }
+            else if(command == "stop"){
+                this->search.stop();
+            }
+            else if(command == "ponderhit"){
+                this->search.ponderhit();
+            }
+            else if(command == "bench"){
+                this->handleBench(stream);
+            }
+            else if(!command.empty()){
+                this->send("info string unknown command " + command);
+            }
+        }
+
+        this->search.stop();
+        this->waitSearch();
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    /**
+     * @brief Destructor
+     */
+
+    Uci::~Uci(){
+        this->search.stop();
+        this->waitSearch();
+        if(Evaluator::getNetwork() == &this->network){
+            Evaluator::setNetwork(nullptr);
+        }
+    }
+}
@@ -14,13 +14,162 @@
 #include <SFML/Window.hpp>					// SFML Window creation and management
 #include <SFML/OpenGL.hpp>					// SFML OpenGL integration
 
+// Include standard headers
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <string>
+#include <vector>
+
 // Include project header files
+#include "Ray.hpp"
+#include "DynamicResolution.hpp"
+#include "FrameTimeStats.hpp"
 #include "Shader.hpp"
 #include "SceneManager.hpp"
 #include "ViewController.hpp"
+#include "engine/AnalysisWorker.hpp"
+#include "engine/Attacks.hpp"
+#include "engine/Evaluator.hpp"
+#include "engine/GameArchive.hpp"
+#include "engine/GameState.hpp"
+#include "engine/MoveGen.hpp"
+#include "engine/Network.hpp"
+#include "engine/ParallelSearch.hpp"
+#include "engine/PgnReader.hpp"
+#include "engine/PolyglotBook.hpp"
+#include "engine/PositionIndex.hpp"
+#include "engine/RandomGenerator.hpp"
+#include "engine/TranspositionTable.hpp"
+#include "engine/Uci.hpp"
 
 int main(int argc, char* argv[])
 {
+	/********************************************************************
+	 * UCI mode : the engine alone on the standard input and output, without window nor OpenGL context
+	 ********************************************************************/
+
+	for (int i = 1; i < argc; i++)
+	{
+		if (std::string(argv[i]) == "--uci")
+		{
+			engine::Uci uci;
+			uci.loop();
+			return 0;
+		}
+	}
+
+	/********************************************************************
+	 * Read the command line options
+	 * --target-ms <ms> : GPU time budget of the scene
+	 * --min-scale <s> / --max-scale <s> : bounds of the resolution scale
+	 * --engine-ms <ms> : thinking time of the engine
+	 * --threads <n> : number of search threads (default : all the hardware threads but one, left to the rendering)
+	 * --hash <MiB> : size of the transposition table
+	 * --huge-pages : allocate the transposition table on explicit huge pages
+	 * --eval-file <path> : evaluate with a network file (hand-crafted evaluation by default)
+	 * --book <path> : Polyglot opening book of the engine moves
+	 * --book-best : play the best book move (a random one in proportion to the weights by default)
+	 * --book-keys <path> : key table of the book, instead of the Polyglot one (text file of 781 hexadecimal numbers)
+	 * --fen "<fen>" : initial position of the board (checked for legality)
+	 * --pgn <path> : PGN file of a game to replay on the board (N key : next move)
+	 * --archive <path> : game archive of a game to replay on the board (instead of a PGN file)
+	 * --game <n> : number of the game in the file (default : 1)
+	 * --index <path> : position index of an archive (L key : games of the archive which reached the position)
+	 ********************************************************************/
+
+	float targetFrameTimeMs = 8.f;
+	float minScale = 0.5f;
+	float maxScale = 1.f;
+	int64_t engineMoveTimeMs = 500;
+	int searchThreads = std::max(1, engine::ParallelSearch::getMaxThreads() - 1);
+	size_t hashMb = 256;
+	bool hugePages = false;
+	std::string evalFile;
+	std::string bookFile;
+	bool bookBest = false;
+	std::string bookKeyFile;
+	std::string fenString;
+	std::string pgnFile;
+	std::string archiveFile;
+	int gameNumber = 1;
+	std::string indexFile;
+
+	for (int i = 1; i < argc; i++)
+	{
+		std::string option = argv[i];
+		if (i + 1 < argc && option == "--target-ms")
+		{
+			targetFrameTimeMs = std::stof(argv[++i]);
+		}
+		else if (i + 1 < argc && option == "--min-scale")
+		{
+			minScale = std::stof(argv[++i]);
+		}
+		else if (i + 1 < argc && option == "--max-scale")
+		{
+			maxScale = std::stof(argv[++i]);
+		}
+		else if (i + 1 < argc && option == "--engine-ms")
+		{
+			engineMoveTimeMs = std::stoll(argv[++i]);
+		}
+		else if (i + 1 < argc && option == "--threads")
+		{
+			searchThreads = std::stoi(argv[++i]);
+		}
+		else if (i + 1 < argc && option == "--hash")
+		{
+			hashMb = std::stoull(argv[++i]);
+		}
+		else if (option == "--huge-pages")
+		{
+			hugePages = true;
+		}
+		else if (i + 1 < argc && option == "--eval-file")
+		{
+			evalFile = argv[++i];
+		}
+		else if (i + 1 < argc && option == "--book")
+		{
+			bookFile = argv[++i];
+		}
+		else if (i + 1 < argc && option == "--book-keys")
+		{
+			bookKeyFile = argv[++i];
+		}
+		else if (i + 1 < argc && option == "--fen")
+		{
+			fenString = argv[++i];
+		}
+		else if (i + 1 < argc && option == "--pgn")
+		{
+			pgnFile = argv[++i];
+		}
+		else if (i + 1 < argc && option == "--archive")
+		{
+			archiveFile = argv[++i];
+		}
+		else if (i + 1 < argc && option == "--game")
+		{
+			gameNumber = std::max(1, std::stoi(argv[++i]));
+		}
+		else if (i + 1 < argc && option == "--index")
+		{
+			indexFile = argv[++i];
+		}
+		else if (option == "--book-best")
+		{
+			bookBest = true;
+		}
+		else
+		{
+			std::cerr << "Unknown option " << option << std::endl;
+		}
+	}
+
 	/********************************************************************
 	 * Initialize the SFML Window with OPENGL settings
 	 ********************************************************************/
@@ -43,9 +192,8 @@ int main(int argc, char* argv[])
 	window.setVisible(true);				// Make window visible
 	window.setActive(true); 				// Create context for OpenGL
 
-	// Hide the mouse cursor and set it to the center of the window
-	window.setMouseCursorVisible(false);
-	sf::Mouse::setPosition(sf::Vector2i(window.getSize().x / 2, window.getSize().y / 2), window);
+	// Show the mouse cursor (used to pick the squares and pieces)
+	window.setMouseCursorVisible(true);
 
 	/********************************************************************
 	 * Initialize the OpenGL state machine
@@ -79,11 +227,173 @@ int main(int argc, char* argv[])
 	/**
 	 * Load the chess object manager
 	 */
-	SceneManager sceneManager = SceneManager::getInstance();
+	SceneManager& sceneManager = SceneManager::getInstance();
 
 	ViewController viewController;
 	Shader shader("shaders/vertexShader.glsl", "shaders/fragmentShader.glsl");
 
+	// Bake (first run) or load the static lighting of the board
+	if (!sceneManager.loadLightmap("../resources/Stone_Chess_Board/Chess_Board_lightmap.bmp", shader.getLightPosition()))
+	{
+		std::cerr << "Error while loading the board lightmap, the board is lit dynamically" << std::endl;
+	}
+
+	/********************************************************************
+	 * Game state : the rules work on a bitboard position, the board only displays it
+	 ********************************************************************/
+
+	// Build the attack tables of the move generator
+	engine::initAttacks();
+
+	// Place the pieces of the initial position
+	engine::GameState game;
+	sceneManager.setUpBoard();
+
+	// Position given on the command line, kept only if it can be reached in a game
+	if (!fenString.empty())
+	{
+		engine::Position position;
+		const char* error = nullptr;
+		if (!position.setFromFen(fenString, &error) || (error = position.checkLegality()) != nullptr)
+		{
+			std::cerr << "Error: " << error << " in the FEN " << fenString << std::endl;
+		}
+		else
+		{
+			game.setPosition(position);
+			sceneManager.syncPosition(game.getPosition());
+		}
+	}
+
+	// Game of the PGN file or archive replayed with the N key : its initial position is set up, its moves are played one by one
+	std::vector<engine::Move> pgnMoves;
+	size_t pgnPly = 0;
+	if (!archiveFile.empty())
+	{
+		engine::GameArchive archive;
+		engine::Position position;
+		if (archive.open(archiveFile))
+		{
+			if (static_cast<uint64_t>(gameNumber) > archive.getGameCount())
+			{
+				std::cerr << "Error: no game " << gameNumber << " in " << archiveFile << std::endl;
+			}
+			else if (archive.readGame(gameNumber - 1, position, pgnMoves) && archive.readStartPosition(gameNumber - 1, position))
+			{
+				game.setFromFen(position.toFen());
+				sceneManager.syncPosition(game.getPosition());
+				std::cout << "Game " << gameNumber << " of " << archiveFile << " : " << pgnMoves.size() << " moves (N : next move)" << std::endl;
+			}
+			else
+			{
+				std::cerr << "Error: game " << gameNumber << " of " << archiveFile << " is corrupted" << std::endl;
+				pgnMoves.clear();
+			}
+		}
+	}
+	else if (!pgnFile.empty())
+	{
+		engine::PgnReader pgnReader;
+		engine::PgnGame pgn;
+		int index = 0;
+		if (pgnReader.open(pgnFile))
+		{
+			while (index < gameNumber && pgnReader.readGame(pgn))
+			{
+				index++;
+			}
+		}
+
+		engine::Position position;
+		if (index < gameNumber)
+		{
+			std::cerr << "Error: no game " << gameNumber << " in " << pgnFile << std::endl;
+		}
+		else if (pgn.setUpPosition(position))
+		{
+			if (!pgn.replay(position, pgnMoves))
+			{
+				std::cerr << "Error: move " << pgnMoves.size() + 1 << " of the game cannot be played, the game stops before it" << std::endl;
+			}
+			const std::string_view fen = pgn.getTag("FEN");
+			if (!fen.empty())
+			{
+				game.setFromFen(fen);
+				sceneManager.syncPosition(game.getPosition());
+			}
+			std::cout << "Game " << gameNumber << " of " << pgnFile << " : " << pgn.getTag("White") << " - " << pgn.getTag("Black")
+					  << ", " << pgnMoves.size() << " moves (N : next move)" << std::endl;
+		}
+	}
+
+	// Position index : mapped for the whole session, the lookups only read the pages they need
+	engine::PositionIndex positionIndex;
+	if (!indexFile.empty() && positionIndex.open(indexFile))
+	{
+		std::cout << "Position index " << indexFile << " : " << positionIndex.getKeyCount() << " positions of "
+				  << positionIndex.getGameCount() << " games (L : games of the position)" << std::endl;
+	}
+
+	// Square of the piece selected by the player (first click), NO_SQUARE if none
+	engine::Square selectedSquare = engine::NO_SQUARE;
+
+	// Evaluation network, mapped before the engine thread starts and kept until it ends
+	engine::Network network;
+	if (!evalFile.empty() && network.load(evalFile))
+	{
+		engine::Evaluator::setNetwork(&network);
+		std::cout << "Network " << evalFile << " loaded (" << network.getKernels().name << " kernels)" << std::endl;
+	}
+
+	// Opening book of the engine moves (mapped, probed without search)
+	engine::PolyglotBook book;
+	engine::RandomGenerator bookRandom(static_cast<uint64_t>(std::chrono::steady_clock::now().time_since_epoch().count()));
+	if (!bookKeyFile.empty())
+	{
+		engine::PolyglotBook::loadKeys(bookKeyFile);
+	}
+	if (!bookFile.empty() && book.open(bookFile))
+	{
+		std::cout << "Book " << bookFile << " opened (" << book.getEntryCount() << " entries)" << std::endl;
+	}
+
+	// Engine thread : the built-in opponent (E key) and the live analysis (A key) never block the rendering
+	engine::TranspositionTable transpositionTable(hashMb, hugePages);
+	engine::AnalysisWorker analysisWorker(transpositionTable, searchThreads);
+	bool analysisEnabled = false;
+	uint32_t analysisId = 0;				// Request of the displayed analysis
+	uint32_t engineMoveId = 0;				// Request whose final update is the engine move (0 if none)
+	engine::AnalysisUpdate analysis{};		// Last update of the displayed analysis
+	bool hasAnalysis = false;
+
+	// Play a move on the game and the board, then check the draw rules (O(1) after each move)
+	auto playMove = [&](engine::Move move)
+	{
+		game.doMove(move);
+		sceneManager.syncPosition(game.getPosition());
+		std::cout << "Played " << move.toUci() << std::endl;
+
+		// A pending engine move is for the previous position, the analysis restarts on the new one
+		engineMoveId = 0;
+		hasAnalysis = false;
+		if (analysisEnabled)
+		{
+			analysisId = analysisWorker.analyze(game.getPosition());
+		}
+
+		if (game.isThreefoldRepetition())
+		{
+			std::cout << "Draw by threefold repetition" << std::endl;
+		}
+		else if (game.isFiftyMoveDraw())
+		{
+			std::cout << "Draw by the 50-move rule" << std::endl;
+		}
+	};
+
+	// Offscreen rendering of the scene at a resolution adapted to the GPU frame time
+	DynamicResolution dynamicResolution(window.getSize().x, window.getSize().y, targetFrameTimeMs, minScale, maxScale);
+
 	/********************************************************************
 	 * Main loop
 	 ********************************************************************/
@@ -91,6 +401,12 @@ int main(int argc, char* argv[])
 	// Boolean for the main loop
     bool running = true;
 
+	// Clock to refresh the timings displayed in the title bar
+	sf::Clock telemetryClock;
+
+	// CPU frame times of the last frames
+	FrameTimeStats frameTimeStats;
+
 	// Main loop
     while (running)
     {
@@ -115,32 +431,206 @@ int main(int argc, char* argv[])
 			// Check if the window was resized
             else if (event.type == sf::Event::Resized)
             {
-                // Adjust the viewport when the window is resized
-                glViewport(0, 0, event.size.width, event.size.height);
+                // Adjust the offscreen buffer (and the viewport) when the window is resized
+                dynamicResolution.resize(event.size.width, event.size.height);
             }
+			// Check if the user clicked on the board
+			else if (event.type == sf::Event::MouseButtonPressed && event.mouseButton.button == sf::Mouse::Left)
+			{
+				// Cast a ray through the cursor and find the picked square (CPU only, no GPU readback)
+				sf::Clock pickingClock;
+				Ray ray = viewController.computePickingRay(sf::Vector2i(event.mouseButton.x, event.mouseButton.y), window.getSize());
+				int row, col;
+				bool picked = sceneManager.pickSquare(ray, row, col);
+				sf::Int64 pickingTime = pickingClock.getElapsedTime().asMicroseconds();
+
+				if (picked)
+				{
+					std::cout << "Picked square " << sceneManager.getSquareNotation(row, col) << " (" << pickingTime << " us)" << std::endl;
+
+					// Second click : play the move if it is legal (promotions to a queen)
+					engine::Square square = engine::makeSquare(col, row);
+					bool played = false;
+					if (selectedSquare != engine::NO_SQUARE)
+					{
+						engine::MoveList moves;
+						engine::generateLegalMoves(game.getPosition(), moves);
+						for (engine::Move move : moves)
+						{
+							if (move.from() == selectedSquare && move.to() == square
+								&& (move.type() != engine::PROMOTION || move.promotionType() == engine::QUEEN))
+							{
+								playMove(move);
+								played = true;
+								break;
+							}
+						}
+						selectedSquare = engine::NO_SQUARE;
+					}
+
+					// First click (or click on another piece) : select a piece of the side to move
+					if (!played && (game.getPosition().getOccupancy(game.getPosition().getSideToMove()) & engine::squareBB(square)))
+					{
+						selectedSquare = square;
+					}
+				}
+			}
+			// Check if the user asked the engine to play (the move is played when the engine thread answers)
+			else if (event.type == sf::Event::KeyPressed && event.key.code == sf::Keyboard::E)
+			{
+				// A book move is played at once, the engine only thinks out of book
+				const engine::Move bookMove = book.pick(game.getPosition(), bookBest, bookRandom);
+				if (!bookMove.isNull())
+				{
+					std::cout << "Engine : book move" << std::endl;
+					selectedSquare = engine::NO_SQUARE;
+					playMove(bookMove);
+				}
+				else
+				{
+					engineMoveId = analysisWorker.think(game.getPosition(), engineMoveTimeMs);
+				}
+			}
+			// Check if the user asked for the next move of the PGN game (if the board is still on the game)
+			else if (event.type == sf::Event::KeyPressed && event.key.code == sf::Keyboard::N && pgnPly < pgnMoves.size())
+			{
+				engine::MoveList moves;
+				engine::generateLegalMoves(game.getPosition(), moves);
+				const engine::Move next = pgnMoves[pgnPly];
+				if (std::find(moves.begin(), moves.end(), next) != moves.end())
+				{
+					selectedSquare = engine::NO_SQUARE;
+					playMove(next);
+					pgnPly++;
+				}
+				else
+				{
+					std::cout << "The board left the game at move " << pgnPly + 1 << std::endl;
+				}
+			}
+			// Check if the user asked for the games of the archive which reached the position (numbers for --game)
+			else if (event.type == sf::Event::KeyPressed && event.key.code == sf::Keyboard::L && positionIndex.isOpen())
+			{
+				std::vector<uint32_t> games;
+				const uint64_t count = positionIndex.lookup(game.getPosition().getKey(), games, 20);
+				std::cout << count << " games reached the position" << (games.empty() ? "" : " :");
+				for (uint32_t number : games)
+				{
+					std::cout << " " << number + 1;
+				}
+				std::cout << (count > games.size() ? " ..." : "") << std::endl;
+			}
+			// Check if the user toggled the live analysis
+			else if (event.type == sf::Event::KeyPressed && event.key.code == sf::Keyboard::A)
+			{
+				// Frame times of the period which ends, to compare the rendering with and without analysis
+				std::cout << std::fixed << std::setprecision(2)
+						  << "Frame times (analysis " << (analysisEnabled ? "on" : "off") << ", " << frameTimeStats.getCount() << " frames) : "
+						  << "p50 " << frameTimeStats.getPercentile(50.f) << " ms, p95 " << frameTimeStats.getPercentile(95.f)
+						  << " ms, p99 " << frameTimeStats.getPercentile(99.f) << " ms" << std::endl;
+				frameTimeStats.reset();
+
+				// A pending engine move is not interrupted, the analysis starts after it
+				analysisEnabled = !analysisEnabled;
+				hasAnalysis = false;
+				if (engineMoveId == 0)
+				{
+					if (analysisEnabled)
+					{
+						analysisId = analysisWorker.analyze(game.getPosition());
+					}
+					else
+					{
+						analysisWorker.stop();
+					}
+				}
+			}
         }
 
+		/********************************************************************
+	 	* Read the engine updates (never blocks)
+	 	********************************************************************/
+		engine::AnalysisUpdate update;
+		while (analysisWorker.poll(update))
+		{
+			if (update.id == engineMoveId && update.final)
+			{
+				if (update.bestMove.isNull())
+				{
+					std::cout << "No legal move" << std::endl;
+					engineMoveId = 0;
+				}
+				else
+				{
+					std::cout << "Engine : depth " << update.depth << " score " << update.score << " cp, "
+							  << update.nodes << " nodes, " << update.nps / 1000 << " knps, EBF "
+							  << std::setprecision(3) << update.ebf << std::endl;
+					selectedSquare = engine::NO_SQUARE;
+					playMove(update.bestMove);
+				}
+			}
+			else if (update.id == analysisId && analysisEnabled)
+			{
+				analysis = update;
+				hasAnalysis = true;
+			}
+		}
+
 		/********************************************************************
 	 	* Actualize the scene
 	 	********************************************************************/
 
-		// Clear the screen
-		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+		// Render into the offscreen buffer at the current scale
+		dynamicResolution.beginScene();
 
 		// Use the view controller to update the view settins and matrices from user inputs
 		viewController.updateMatrices();	
 
 		// Render the scene
 		sceneManager.render(&shader, &viewController);
+
+		// Adapt the scale to the measured GPU time and upscale the image to the window
+		dynamicResolution.endScene();
+		dynamicResolution.present();
 		
+		// Display the GPU timings (shadow map updates are reported apart from the main pass)
+		if (telemetryClock.getElapsedTime().asSeconds() > 0.5f)
+		{
+			std::ostringstream title;
+			title << std::fixed << std::setprecision(2)
+				  << "3D Chess game - scale " << dynamicResolution.getScale()
+				  << " (" << dynamicResolution.getRenderWidth() << "x" << dynamicResolution.getRenderHeight() << ")"
+				  << " scene " << dynamicResolution.getSceneTimeMs() << " ms"
+				  << " | main pass " << sceneManager.getMainPassTimeMs() << " ms"
+				  << " | shadow map updates " << sceneManager.getShadowUpdateCount()
+				  << " (last " << sceneManager.getShadowUpdateTimeMs() << " ms)"
+				  << " | frame p50 " << frameTimeStats.getPercentile(50.f) << " p99 " << frameTimeStats.getPercentile(99.f) << " ms";
+
+			// Live analysis : score from the white point of view and the beginning of the principal variation
+			if (hasAnalysis)
+			{
+				const int whiteScore = (game.getPosition().getSideToMove() == engine::WHITE) ? analysis.score : -analysis.score;
+				title << " | eval " << std::showpos << whiteScore / 100.0 << std::noshowpos << " (depth " << analysis.depth << ")";
+				for (int i = 0; i < std::min(analysis.pvLength, 4); i++)
+				{
+					title << " " << analysis.pv[i].toUci();
+				}
+			}
+			window.setTitle(title.str());
+			telemetryClock.restart();
+		}
+
 		// End the current frame (internally swaps the front and back buffers of the window)
         window.display();
+		frameTimeStats.frame();
 	}
 
 	// Unbind Open GL states
 	glBindVertexArray(0);	// Unbind the VAO
 	glUseProgram(0);		// Unbind the shader program
 
+	dynamicResolution.deleteBuffers();
+
 	// The different OpenGL VAO, VBO and shaders are destroyed by the classes which own them
 
 	return 0;
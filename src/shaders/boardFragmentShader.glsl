@@ -0,0 +1,51 @@
+#version 330 core
+
+// Interpolated values from the vertex shaders
+in vec2 UV;
+in vec4 ShadowCoord;
+
+// Output data
+out vec3 color;
+
+// Values that stay constant for the whole mesh.
+uniform sampler2D ShaderTexture;
+uniform sampler2D Lightmap;
+uniform sampler2DShadow ShadowMap;
+
+// Percentage closer filtering : 3x3 taps, each one is a hardware 2x2 filtered comparison
+float shadowVisibility(){
+	vec3 coord = ShadowCoord.xyz / ShadowCoord.w;
+
+	// Outside of the light frustum : lit
+	if(coord.x < 0.0 || coord.x > 1.0 || coord.y < 0.0 || coord.y > 1.0 || coord.z > 1.0){
+		return 1.0;
+	}
+
+	vec2 texelSize = 1.0 / vec2(textureSize(ShadowMap, 0));
+	float visibility = 0.0;
+	for(int x = -1; x <= 1; x++){
+		for(int y = -1; y <= 1; y++){
+			visibility += texture(ShadowMap, vec3(coord.xy + vec2(x,y) * texelSize, coord.z));
+		}
+	}
+	return visibility / 9.0;
+}
+
+void main(){
+
+	// Light emission properties (same as the dynamic shader)
+	vec3 LightColor = vec3(1,1,1);
+
+	// Material properties
+	vec3 MaterialDiffuseColor = texture( ShaderTexture, UV ).rgb;
+	vec3 MaterialAmbientColor = vec3(0.1,0.1,0.1) * MaterialDiffuseColor;
+
+	// Baked lighting : red = direct diffuse irradiance (LightPower * cos(theta) / distance^2), green = ambient occlusion
+	vec2 baked = texture( Lightmap, UV ).rg;
+
+	color = 
+	// Ambient : simulates indirect lighting, occluded by the pieces start positions
+	baked.g * MaterialAmbientColor +
+	// Diffuse : baked, only the shadows of the moving pieces are dynamic
+	shadowVisibility() * MaterialDiffuseColor * LightColor * baked.r;
+}
@@ -0,0 +1,69 @@
+#version 330 core
+
+// Interpolated values from the vertex shaders
+in vec2 UV;
+in vec3 Position_worldspace;
+in vec3 Normal_worldspace;
+in vec4 Tangent_worldspace;
+in vec4 ShadowCoord;
+
+// Output data
+out vec3 color;
+
+// Values that stay constant for the whole mesh.
+uniform sampler2D ShaderTexture;
+uniform sampler2D Lightmap;
+uniform sampler2D NormalMap;
+uniform sampler2DShadow ShadowMap;
+uniform vec3 LightPosition_worldspace;
+
+// Percentage closer filtering : 3x3 taps, each one is a hardware 2x2 filtered comparison
+float shadowVisibility(){
+	vec3 coord = ShadowCoord.xyz / ShadowCoord.w;
+
+	// Outside of the light frustum : lit
+	if(coord.x < 0.0 || coord.x > 1.0 || coord.y < 0.0 || coord.y > 1.0 || coord.z > 1.0){
+		return 1.0;
+	}
+
+	vec2 texelSize = 1.0 / vec2(textureSize(ShadowMap, 0));
+	float visibility = 0.0;
+	for(int x = -1; x <= 1; x++){
+		for(int y = -1; y <= 1; y++){
+			visibility += texture(ShadowMap, vec3(coord.xy + vec2(x,y) * texelSize, coord.z));
+		}
+	}
+	return visibility / 9.0;
+}
+
+void main(){
+
+	// Light emission properties (same as the dynamic shader)
+	vec3 LightColor = vec3(1,1,1);
+
+	// Material properties
+	vec3 MaterialDiffuseColor = texture( ShaderTexture, UV ).rgb;
+	vec3 MaterialAmbientColor = vec3(0.1,0.1,0.1) * MaterialDiffuseColor;
+
+	// Tangent frame (MikkTSpace convention : bitangent rebuilt from the normal, the tangent and its sign)
+	vec3 n = normalize( Normal_worldspace );
+	vec3 t = normalize( Tangent_worldspace.xyz - n * dot(n, Tangent_worldspace.xyz) );
+	vec3 b = Tangent_worldspace.w * cross( n, t );
+
+	// Perturbed normal from the normal map
+	vec3 normalTangentspace = texture( NormalMap, UV ).rgb * 2.0 - 1.0;
+	vec3 nPerturbed = normalize( mat3(t, b, n) * normalTangentspace );
+
+	// Baked lighting : red = direct diffuse irradiance for the geometric normal, green = ambient occlusion
+	vec2 baked = texture( Lightmap, UV ).rg;
+
+	// Move the baked direct term from the geometric normal to the perturbed one (distance falloff unchanged)
+	vec3 l = normalize( LightPosition_worldspace - Position_worldspace );
+	float bumpFactor = clamp( dot(nPerturbed, l), 0, 1 ) / max( dot(n, l), 0.05 );
+
+	color = 
+	// Ambient : simulates indirect lighting, occluded by the pieces start positions
+	baked.g * MaterialAmbientColor +
+	// Diffuse : baked and bumped, only the shadows of the moving pieces are dynamic
+	shadowVisibility() * MaterialDiffuseColor * LightColor * baked.r * bumpFactor;
+}
@@ -0,0 +1,38 @@
+#version 330 core
+
+// Input vertex data, different for all executions of this shader.
+layout(location = 0) in vec3 vertexPosition_modelspace;
+layout(location = 1) in vec2 vertexUV;
+layout(location = 2) in vec3 vertexNormal_modelspace;
+layout(location = 3) in vec4 vertexTangent_modelspace;
+
+// Output data ; will be interpolated for each fragment.
+out vec2 UV;
+out vec3 Position_worldspace;
+out vec3 Normal_worldspace;
+out vec4 Tangent_worldspace;
+out vec4 ShadowCoord;
+
+// Values that stay constant for the whole mesh.
+uniform mat4 MVP;
+uniform mat4 M;
+uniform mat4 DepthBiasVP;
+
+void main(){
+
+	// Output position of the vertex, in clip space : MVP * position
+	gl_Position =  MVP * vec4(vertexPosition_modelspace,1);
+	
+	// Position of the vertex, in worldspace : M * position
+	Position_worldspace = (M * vec4(vertexPosition_modelspace,1)).xyz;
+
+	// Tangent frame in worldspace (the bitangent sign is kept in w). Only correct if ModelMatrix does not scale the model !
+	Normal_worldspace = (M * vec4(vertexNormal_modelspace,0)).xyz;
+	Tangent_worldspace = vec4((M * vec4(vertexTangent_modelspace.xyz,0)).xyz, vertexTangent_modelspace.w);
+	
+	// UV of the vertex. No special space for this one.
+	UV = vertexUV;
+
+	// Position of the vertex in the shadow map texture space
+	ShadowCoord = DepthBiasVP * M * vec4(vertexPosition_modelspace,1);
+}
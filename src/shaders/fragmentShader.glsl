@@ -6,6 +6,7 @@ in vec3 Position_worldspace;
 in vec3 Normal_cameraspace;
 in vec3 EyeDirection_cameraspace;
 in vec3 LightDirection_cameraspace;
+in vec4 ShadowCoord;
 
 // Output data
 out vec3 color;
@@ -14,6 +15,26 @@ out vec3 color;
 uniform sampler2D ShaderTexture;
 uniform mat4 MV;
 uniform vec3 LightPosition_worldspace;
+uniform sampler2DShadow ShadowMap;
+
+// Percentage closer filtering : 3x3 taps, each one is a hardware 2x2 filtered comparison
+float shadowVisibility(){
+	vec3 coord = ShadowCoord.xyz / ShadowCoord.w;
+
+	// Outside of the light frustum : lit
+	if(coord.x < 0.0 || coord.x > 1.0 || coord.y < 0.0 || coord.y > 1.0 || coord.z > 1.0){
+		return 1.0;
+	}
+
+	vec2 texelSize = 1.0 / vec2(textureSize(ShadowMap, 0));
+	float visibility = 0.0;
+	for(int x = -1; x <= 1; x++){
+		for(int y = -1; y <= 1; y++){
+			visibility += texture(ShadowMap, vec3(coord.xy + vec2(x,y) * texelSize, coord.z));
+		}
+	}
+	return visibility / 9.0;
+}
 
 void main(){
 
@@ -50,14 +71,17 @@ void main(){
 	//  - Looking into the reflection -> 1
 	//  - Looking elsewhere -> < 1
 	float cosAlpha = clamp( dot( E,R ), 0,1 );
+
+	// Fraction of the light reaching the fragment (cached shadow map)
+	float visibility = shadowVisibility();
 	
 	color = 
 	// Ambient : simulates indirect lighting
 	MaterialAmbientColor +
 	// Diffuse : "color" of the object
-	MaterialDiffuseColor * LightColor * LightPower * cosTheta / (distance*distance) +
+	visibility * MaterialDiffuseColor * LightColor * LightPower * cosTheta / (distance*distance) +
 	// Specular : reflective highlight, like a mirror
-	MaterialSpecularColor * LightColor * LightPower * pow(cosAlpha,5) / (distance*distance);
+	visibility * MaterialSpecularColor * LightColor * LightPower * pow(cosAlpha,5) / (distance*distance);
 	
 	
 
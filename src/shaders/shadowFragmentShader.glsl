@@ -0,0 +1,5 @@
+#version 330 core
+
+// Depth only pass : the depth is written automatically, no color output
+void main(){
+}
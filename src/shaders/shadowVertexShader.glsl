@@ -0,0 +1,13 @@
+#version 330 core
+
+// Input vertex data, only the position is needed for the depth pass
+layout(location = 0) in vec3 vertexPosition_modelspace;
+
+// Light view-projection times model matrix
+uniform mat4 MVP;
+
+void main(){
+
+	// Output position of the vertex, in the light clip space
+	gl_Position = MVP * vec4(vertexPosition_modelspace,1);
+}
@@ -0,0 +1,35 @@
+#version 330 core
+
+// Interpolated values from the vertex shaders
+in vec2 UV;
+
+// Output data
+out vec3 color;
+
+// Values that stay constant for the whole draw
+uniform sampler2D SceneTexture;
+uniform vec2 UvScale;       // Part of the texture covered by the rendered image
+uniform vec2 TexelSize;     // Size of a texel of the offscreen texture
+uniform float Sharpness;    // 0 = plain bilinear upscale, 1 = strongest sharpening
+
+void main(){
+
+	// Clamp the taps to the rendered sub-rectangle (the rest of the texture is stale)
+	vec2 uvMax = UvScale - 0.5 * TexelSize;
+
+	// Bilinear sample and its 4 neighbours
+	vec3 center = texture( SceneTexture, UV ).rgb;
+	vec3 north  = texture( SceneTexture, min(UV + vec2(0, TexelSize.y), uvMax) ).rgb;
+	vec3 south  = texture( SceneTexture, max(UV - vec2(0, TexelSize.y), vec2(0)) ).rgb;
+	vec3 east   = texture( SceneTexture, min(UV + vec2(TexelSize.x, 0), uvMax) ).rgb;
+	vec3 west   = texture( SceneTexture, max(UV - vec2(TexelSize.x, 0), vec2(0)) ).rgb;
+
+	// Contrast adaptive sharpening : sharpen less where the local contrast is already high, to avoid ringing
+	vec3 minColor = min( center, min( min(north, south), min(east, west) ) );
+	vec3 maxColor = max( center, max( max(north, south), max(east, west) ) );
+	vec3 amplitude = sqrt( clamp( min(minColor, 1.0 - maxColor) / max(maxColor, 1e-4), 0.0, 1.0 ) );
+	vec3 weight = -amplitude * mix(0.125, 0.2, Sharpness) * Sharpness;
+
+	// Unsharp mask with the adaptive negative lobe weight
+	color = clamp( (center + weight * (north + south + east + west)) / (1.0 + 4.0 * weight), 0.0, 1.0 );
+}
@@ -0,0 +1,17 @@
+#version 330 core
+
+// Output data ; will be interpolated for each fragment.
+out vec2 UV;
+
+// Values that stay constant for the whole draw : part of the texture covered by the rendered image
+uniform vec2 UvScale;
+
+void main(){
+
+	// Fullscreen triangle generated from the vertex index : (-1,-1), (3,-1), (-1,3)
+	vec2 position = vec2( (gl_VertexID == 1) ? 3.0 : -1.0, (gl_VertexID == 2) ? 3.0 : -1.0 );
+	gl_Position = vec4(position, 0, 1);
+
+	// Map the window to the rendered sub-rectangle of the offscreen texture
+	UV = (position * 0.5 + 0.5) * UvScale;
+}
@@ -11,12 +11,14 @@ out vec3 Position_worldspace;
 out vec3 Normal_cameraspace;
 out vec3 EyeDirection_cameraspace;
 out vec3 LightDirection_cameraspace;
+out vec4 ShadowCoord;
 
 // Values that stay constant for the whole mesh.
 uniform mat4 MVP;
 uniform mat4 V;
 uniform mat4 M;
 uniform vec3 LightPosition_worldspace;
+uniform mat4 DepthBiasVP;
 
 void main(){
 
@@ -40,5 +42,8 @@ void main(){
 	
 	// UV of the vertex. No special space for this one.
 	UV = vertexUV;
+
+	// Position of the vertex in the shadow map texture space
+	ShadowCoord = DepthBiasVP * M * vec4(vertexPosition_modelspace,1);
 }
 
@@ -0,0 +1,371 @@
+/**
+ * @author obiwan138
+ * @file archive.cpp
+ * @brief Converter between PGN files and binary game archives, and decoding benchmark (headless)
+ * @details Usage :
+ *   archive pack <pgn>... -o <archive>        convert PGN files (result, Elo, date and initial position kept)
+ *   archive pack ... --verify                 read the games back from the archive and compare them with the PGN
+ *   archive unpack <archive> -o <pgn>         convert an archive back to PGN
+ *   archive bench <archive>                   decode every game (games/s, moves/s), then replay random games (us/game)
+ *   archive bench <archive> --threads <n>     threads of the sequential decoding (default : all the cores)
+ * The packing reports the compression ratio against the PGN text. The games with a move which cannot be resolved are
+ * kept up to that move.
+ */
+
+// Include standard headers
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <iomanip>
+#include <iostream>
+#include <omp.h>
+#include <string>
+#include <vector>
+
+// Include project header files
+#include "engine/Attacks.hpp"
+#include "engine/GameArchive.hpp"
+#include "engine/GameArchiveWriter.hpp"
+#include "engine/PgnReader.hpp"
+#include "engine/Position.hpp"
+#include "engine/San.hpp"
+
+namespace{
+
+	// Games replayed at random by the benchmark
+	const int RANDOM_GAMES = 10000;
+
+	// Digits of a tag value as a number (the '?' of the unknown parts count as zeros)
+	uint32_t parseNumber(std::string_view text)
+	{
+		uint32_t value = 0;
+		for (char c : text)
+		{
+			if (c >= '0' && c <= '9')
+			{
+				value = value * 10 + static_cast<uint32_t>(c - '0');
+			}
+			else if (c == '?')
+			{
+				value *= 10;
+			}
+		}
+		return value;
+	}
+
+	int pack(const std::vector<std::string>& inputs, const std::string& outputPath, bool verify)
+	{
+		engine::GameArchiveWriter writer;
+		if (!writer.open(outputPath))
+		{
+			return 1;
+		}
+
+		const auto start = std::chrono::steady_clock::now();
+		uint64_t pgnBytes = 0;
+		uint64_t moveCount = 0;
+		uint64_t truncated = 0;
+		engine::Position position;
+		engine::Position initial;
+		std::vector<engine::Move> moves;
+
+		for (const std::string& input : inputs)
+		{
+			engine::PgnReader reader;
+			if (!reader.open(input))
+			{
+				return 1;
+			}
+			pgnBytes += reader.getSize();
+
+			for (const engine::PgnGame& game : reader)
+			{
+				if (!game.setUpPosition(initial))
+				{
+					truncated++;
+					continue;
+				}
+				truncated += game.replay(position, moves) ? 0 : 1;
+
+				engine::GameRecord record = {};
+				record.result = game.result;
+				record.whiteElo = static_cast<uint16_t>(std::min<uint32_t>(parseNumber(game.getTag("WhiteElo")), UINT16_MAX));
+				record.blackElo = static_cast<uint16_t>(std::min<uint32_t>(parseNumber(game.getTag("BlackElo")), UINT16_MAX));
+				record.date = game.getTag("Date").size() == 10 ? parseNumber(game.getTag("Date")) : 0;
+				writer.addGame(initial, moves.data(), moves.size(), record);
+				moveCount += moves.size();
+			}
+		}
+		if (!writer.close())
+		{
+			return 1;
+		}
+
+		const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		const uint64_t archiveBytes = writer.getFileSize();
+		std::cout << writer.getGameCount() << " games, " << moveCount << " moves (" << truncated
+				  << " games stopped at a move which could not be resolved) in " << std::fixed << std::setprecision(1) << seconds
+				  << " s" << std::endl;
+		std::cout << "PGN " << pgnBytes / 1e6 << " MB -> archive " << std::setprecision(2) << archiveBytes / 1e6 << " MB : ratio "
+				  << std::setprecision(1) << static_cast<double>(pgnBytes) / std::max<uint64_t>(archiveBytes, 1) << ", "
+				  << std::setprecision(2) << archiveBytes * 8.0 / std::max<uint64_t>(moveCount, 1) << " bits per move" << std::endl;
+
+		if (!verify)
+		{
+			return 0;
+		}
+
+		// Second pass over the PGN files, game by game against the archive
+		engine::GameArchive archive;
+		if (!archive.open(outputPath))
+		{
+			return 1;
+		}
+		uint64_t index = 0;
+		uint64_t mismatches = 0;
+		std::vector<engine::Move> archived;
+		for (const std::string& input : inputs)
+		{
+			engine::PgnReader reader;
+			if (!reader.open(input))
+			{
+				return 1;
+			}
+			for (const engine::PgnGame& game : reader)
+			{
+				if (!game.setUpPosition(initial))
+				{
+					continue;
+				}
+				game.replay(position, moves);
+				const engine::GameRecord record = archive.getRecord(index);
+				if (!archive.readGame(index, position, archived) || archived != moves || record.result != game.result)
+				{
+					mismatches++;
+				}
+				index++;
+			}
+		}
+		std::cout << "Verification : " << (mismatches == 0 && index == archive.getGameCount() ? "OK" : "FAILED") << " ("
+				  << index << " games, " << mismatches << " mismatches)" << std::endl;
+		return (mismatches == 0 && index == archive.getGameCount()) ? 0 : 1;
+	}
+
+	int unpack(const std::string& inputPath, const std::string& outputPath)
+	{
+		engine::GameArchive archive;
+		if (!archive.open(inputPath))
+		{
+			return 1;
+		}
+		std::FILE* output = std::fopen(outputPath.c_str(), "wb");
+		if (!output)
+		{
+			std::cerr << "Error: cannot write " << outputPath << std::endl;
+			return 1;
+		}
+
+		const char* results[] = {"1-0", "0-1", "1/2-1/2", "*"};
+		engine::Position position;
+		std::vector<engine::Move> moves;
+		std::string text;
+		uint64_t errors = 0;
+
+		for (uint64_t index = 0; index < archive.getGameCount(); index++)
+		{
+			const engine::GameRecord record = archive.getRecord(index);
+			errors += archive.readGame(index, position, moves) ? 0 : 1;
+			archive.readStartPosition(index, position);
+			const char* result = results[std::min<int>(record.result, engine::RESULT_UNKNOWN)];
+
+			// Date : the parts stored as zeros are unknown
+			std::string date = "????.??.??";
+			const uint32_t parts[3] = {record.date / 10000, record.date / 100 % 100, record.date % 100};
+			for (int part = 0; part < 3; part++)
+			{
+				if (parts[part] != 0)
+				{
+					const std::string digits = std::to_string(parts[part] + (part == 0 ? 10000 : 100)).substr(1);
+					date.replace(part == 0 ? 0 : 2 + 3 * part, digits.size(), digits);
+				}
+			}
+			text = "[Event \"?\"]\n[Site \"?\"]\n[Date \"" + std::string(date) + "\"]\n[Round \"?\"]\n[White \"?\"]\n[Black \"?\"]\n"
+				 + "[Result \"" + result + "\"]\n";
+			if (record.whiteElo != 0)
+			{
+				text += "[WhiteElo \"" + std::to_string(record.whiteElo) + "\"]\n";
+			}
+			if (record.blackElo != 0)
+			{
+				text += "[BlackElo \"" + std::to_string(record.blackElo) + "\"]\n";
+			}
+			if (record.flags & engine::GameArchive::FLAG_SETUP)
+			{
+				text += "[SetUp \"1\"]\n[FEN \"" + position.toFen() + "\"]\n";
+			}
+			text += "\n";
+
+			// Movetext, lines of at most 80 characters
+			size_t lineStart = text.size();
+			for (size_t ply = 0; ply < moves.size(); ply++)
+			{
+				std::string token;
+				if (position.getSideToMove() == engine::WHITE || ply == 0)
+				{
+					token = std::to_string(position.getFullmoveNumber()) + (position.getSideToMove() == engine::WHITE ? ". " : "... ");
+				}
+				token += engine::toSan(position, moves[ply]);
+				if (text.size() - lineStart + token.size() + 1 > 80)
+				{
+					text += "\n";
+					lineStart = text.size();
+				}
+				else if (text.size() > lineStart)
+				{
+					text += " ";
+				}
+				text += token;
+				position.doMove(moves[ply]);
+			}
+			text += (text.size() > lineStart ? " " : "") + std::string(result) + "\n\n";
+
+			if (std::fwrite(text.data(), 1, text.size(), output) != text.size())
+			{
+				std::cerr << "Error: cannot write " << outputPath << std::endl;
+				std::fclose(output);
+				return 1;
+			}
+		}
+
+		if (std::fclose(output) != 0)
+		{
+			std::cerr << "Error: cannot write " << outputPath << std::endl;
+			return 1;
+		}
+		std::cout << archive.getGameCount() << " games written to " << outputPath << " (" << errors << " corrupted)" << std::endl;
+		return errors == 0 ? 0 : 1;
+	}
+
+	int bench(const std::string& path, int threads)
+	{
+		engine::GameArchive archive;
+		if (!archive.open(path))
+		{
+			return 1;
+		}
+		const uint64_t gameCount = archive.getGameCount();
+		if (gameCount == 0)
+		{
+			std::cerr << "Error: " << path << " holds no game" << std::endl;
+			return 1;
+		}
+
+		// Every game, in order
+		uint64_t moveCount = 0;
+		uint64_t errors = 0;
+		auto start = std::chrono::steady_clock::now();
+		#pragma omp parallel num_threads(threads) reduction(+ : moveCount, errors)
+		{
+			engine::Position position;
+			std::vector<engine::Move> moves;
+			#pragma omp for schedule(dynamic, 1024)
+			for (int64_t index = 0; index < static_cast<int64_t>(gameCount); index++)
+			{
+				errors += archive.readGame(static_cast<uint64_t>(index), position, moves) ? 0 : 1;
+				moveCount += moves.size();
+			}
+		}
+		double seconds = std::max(std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count(), 1e-9);
+		std::cout << path << " : " << gameCount << " games, " << moveCount << " moves, " << std::fixed << std::setprecision(2)
+				  << archive.getFileSize() / 1e6 << " MB (" << archive.getFileSize() * 8.0 / std::max<uint64_t>(moveCount, 1)
+				  << " bits per move)" << std::endl;
+		std::cout << "decode    " << std::setprecision(3) << seconds << " s, " << std::setprecision(0) << gameCount / seconds
+				  << " games/s, " << moveCount / seconds << " moves/s (" << threads << " threads)" << std::endl;
+
+		// Random access : one game at a time, as the viewer loads one
+		uint64_t state = 0x2545F4914F6CDD1Dull;
+		engine::Position position;
+		std::vector<engine::Move> moves;
+		uint64_t randomMoves = 0;
+		start = std::chrono::steady_clock::now();
+		for (int i = 0; i < RANDOM_GAMES; i++)
+		{
+			state ^= state >> 12;
+			state ^= state << 25;
+			state ^= state >> 27;
+			errors += archive.readGame((state * 0x2545F4914F6CDD1Dull) % gameCount, position, moves) ? 0 : 1;
+			randomMoves += moves.size();
+		}
+		seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		std::cout << "random    " << std::setprecision(2) << seconds * 1e6 / RANDOM_GAMES << " us per game ("
+				  << std::setprecision(1) << static_cast<double>(randomMoves) / RANDOM_GAMES << " moves on average)" << std::endl;
+
+		if (errors != 0)
+		{
+			std::cerr << "Error: " << errors << " games could not be decoded" << std::endl;
+			return 1;
+		}
+		return 0;
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	if (argc < 2)
+	{
+		std::cerr << "Usage : archive pack <pgn>... -o <archive> [--verify] | unpack <archive> -o <pgn> | bench <archive> [--threads <n>]"
+				  << std::endl;
+		return 1;
+	}
+
+	const std::string command = argv[1];
+	std::vector<std::string> inputs;
+	std::string outputPath;
+	bool verify = false;
+	int threads = omp_get_max_threads();
+
+	for (int i = 2; i < argc; i++)
+	{
+		std::string option = argv[i];
+		if (i + 1 < argc && (option == "-o" || option == "--output"))
+		{
+			outputPath = argv[++i];
+		}
+		else if (option == "--verify")
+		{
+			verify = true;
+		}
+		else if (i + 1 < argc && option == "--threads")
+		{
+			threads = std::max(std::stoi(argv[++i]), 1);
+		}
+		else if (option.rfind("-", 0) != 0)
+		{
+			inputs.push_back(option);
+		}
+		else
+		{
+			std::cerr << "Unknown option " << option << std::endl;
+			return 1;
+		}
+	}
+
+	engine::initAttacks();
+
+	if (command == "pack" && !inputs.empty() && !outputPath.empty())
+	{
+		return pack(inputs, outputPath, verify);
+	}
+	if (command == "unpack" && inputs.size() == 1 && !outputPath.empty())
+	{
+		return unpack(inputs[0], outputPath);
+	}
+	if (command == "bench" && inputs.size() == 1)
+	{
+		return bench(inputs[0], threads);
+	}
+
+	std::cerr << "Unknown command " << command << " (pack, unpack or bench)" << std::endl;
+	return 1;
+}
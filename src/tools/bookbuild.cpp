@@ -0,0 +1,552 @@
+/**
+ * @author obiwan138
+ * @file bookbuild.cpp
+ * @brief Polyglot opening book builder from PGN collections (headless)
+ * @details Usage :
+ *   bookbuild <pgn>... -o <book.bin>         build the book of the games of the PGN files
+ *   bookbuild ... --max-ply <n>              positions recorded in the first n plies of each game (default : 30)
+ *   bookbuild ... --min-games <n>            moves kept if played in at least n games of the position (default : 5)
+ *   bookbuild ... --memory <MiB>             memory of the statistics before spilling a run to disk (default : 1024)
+ *   bookbuild ... --threads <n>              threads replaying the games (default : all the cores)
+ *   bookbuild ... --tmp <dir>                directory of the spilled runs (default : the directory of the book)
+ *   bookbuild ... --keys <file>              key table (see PolyglotBook::loadKeys, default : the Polyglot table)
+ * The games are read in batches, replayed in parallel and their (position, move) pairs counted as wins, draws and
+ * losses of the side to move, in hash maps sharded by the high bits of the key. When the maps go over the memory
+ * budget, they are written to disk as a run sorted by key and move, and emptied : the memory does not depend on the
+ * size of the collection. The runs are then merged into the book. The weight of a move is twice its wins plus its
+ * draws, scaled into 16 bits per position, and the moves of a position are written best first. The games without a
+ * result are skipped, and a game stops being recorded at its first unreadable move.
+ */
+
+// Include standard headers
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <omp.h>
+#include <queue>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Include project header files
+#include "engine/Attacks.hpp"
+#include "engine/PgnReader.hpp"
+#include "engine/PolyglotBook.hpp"
+#include "engine/Position.hpp"
+#include "engine/San.hpp"
+
+namespace{
+
+	// Games read then replayed in parallel at once
+	const size_t BATCH_GAMES = 4096;
+
+	// Shards of the statistics, selected by the high bits of the key (so the shards in order are sorted by key)
+	const int SHARD_BITS = 6;
+	const int SHARD_COUNT = 1 << SHARD_BITS;
+
+	// Estimated memory of an entry of a hash map (node, allocator overhead and bucket) [bytes]
+	const size_t ENTRY_MEMORY = 64;
+
+	// Records of the merge read from each run at once
+	const size_t RUN_BUFFER_RECORDS = 4096;
+
+	// Position and move
+	struct PairKey {
+		uint64_t key;
+		uint16_t move;
+
+		bool operator==(const PairKey& other) const { return this->key == other.key && this->move == other.move; }
+	};
+
+	struct PairKeyHash {
+		size_t operator()(const PairKey& pair) const { return static_cast<size_t>(pair.key ^ (pair.move * 0x9E3779B97F4A7C15ull)); }
+	};
+
+	// Results of the games in which the side to move played the move
+	struct Counts {
+		uint32_t wins = 0;
+		uint32_t draws = 0;
+		uint32_t losses = 0;
+	};
+
+	// Record of a run file (native layout : the runs are temporary)
+	struct Record {
+		uint64_t key;
+		uint16_t move;
+		uint16_t padding;
+		uint32_t wins;
+		uint32_t draws;
+		uint32_t losses;
+	};
+
+	bool operator<(const Record& a, const Record& b)
+	{
+		return a.key < b.key || (a.key == b.key && a.move < b.move);
+	}
+
+	// Position and move played in a game, with the result for the side to move (0 loss, 1 draw, 2 win)
+	struct Sample {
+		uint64_t key;
+		uint16_t move;
+		uint8_t outcome;
+	};
+
+	using ShardMap = std::unordered_map<PairKey, Counts, PairKeyHash>;
+
+	// Replay a game and append its samples to the shards of the thread
+	void replayGame(const engine::PgnGame& game, int maxPly, std::vector<Sample>* shards)
+	{
+		engine::Position position;
+		if (!game.setUpPosition(position))
+		{
+			return;
+		}
+
+		const int whiteOutcome = (game.result == engine::RESULT_WHITE_WIN) ? 2 : (game.result == engine::RESULT_DRAW) ? 1 : 0;
+		const int plies = std::min(static_cast<int>(game.moves.size()), maxPly);
+		for (int ply = 0; ply < plies; ply++)
+		{
+			const engine::Move move = engine::parseSan(position, game.moves[ply]);
+			if (move.isNull())
+			{
+				return;
+			}
+
+			const uint64_t key = engine::PolyglotBook::computeKey(position);
+			const int outcome = (position.getSideToMove() == engine::WHITE) ? whiteOutcome : 2 - whiteOutcome;
+			shards[key >> (64 - SHARD_BITS)].push_back({key, engine::PolyglotBook::encodeMove(move), static_cast<uint8_t>(outcome)});
+			position.doMove(move);
+		}
+	}
+
+	// Sorted records of a shard
+	std::vector<Record> sortShard(const ShardMap& map)
+	{
+		std::vector<Record> records;
+		records.reserve(map.size());
+		for (const auto& entry : map)
+		{
+			records.push_back({entry.first.key, entry.first.move, 0, entry.second.wins, entry.second.draws, entry.second.losses});
+		}
+		std::sort(records.begin(), records.end());
+		return records;
+	}
+
+	// Writer of the book : receives the records sorted by key and move, one record per pair
+	class BookWriter
+	{
+	  public:
+		BookWriter(std::FILE* file, uint32_t minGames) : file(file), minGames(minGames) {}
+
+		void add(const Record& record)
+		{
+			if (!this->group.empty() && this->group[0].key != record.key)
+			{
+				this->flush();
+			}
+			if (record.wins + record.draws + record.losses >= this->minGames)
+			{
+				this->group.push_back(record);
+			}
+		}
+
+		// Write the last position, return the number of entries written
+		uint64_t finish()
+		{
+			this->flush();
+			return this->entries;
+		}
+
+		uint64_t getPositions() const { return this->positions; }
+
+	  private:
+		std::FILE* file;
+		uint32_t minGames;
+		std::vector<Record> group;
+		uint64_t entries = 0;
+		uint64_t positions = 0;
+
+		void flush()
+		{
+			if (this->group.empty())
+			{
+				return;
+			}
+
+			// Weight : two points for a win, one for a draw, scaled per position into 16 bits
+			uint64_t maxWeight = 0;
+			for (const Record& record : this->group)
+			{
+				maxWeight = std::max<uint64_t>(maxWeight, 2ull * record.wins + record.draws);
+			}
+
+			std::vector<std::pair<uint16_t, uint16_t>> moves;
+			for (const Record& record : this->group)
+			{
+				uint64_t weight = 2ull * record.wins + record.draws;
+				if (maxWeight > 0xFFFF)
+				{
+					weight = (weight * 0xFFFF + maxWeight - 1) / maxWeight;
+				}
+				moves.emplace_back(record.move, static_cast<uint16_t>(weight));
+			}
+			std::stable_sort(moves.begin(), moves.end(), [](const auto& a, const auto& b) { return a.second > b.second; });
+
+			const uint64_t key = this->group[0].key;
+			for (const auto& move : moves)
+			{
+				uint8_t entry[engine::PolyglotBook::ENTRY_SIZE] = {};
+				for (int i = 0; i < 8; i++)
+				{
+					entry[i] = static_cast<uint8_t>(key >> (56 - 8 * i));
+				}
+				entry[8] = static_cast<uint8_t>(move.first >> 8);
+				entry[9] = static_cast<uint8_t>(move.first);
+				entry[10] = static_cast<uint8_t>(move.second >> 8);
+				entry[11] = static_cast<uint8_t>(move.second);
+				std::fwrite(entry, 1, sizeof(entry), this->file);
+			}
+
+			this->entries += moves.size();
+			this->positions++;
+			this->group.clear();
+		}
+	};
+
+	// Reader of a run file for the merge
+	struct RunReader {
+		std::FILE* file = nullptr;
+		std::vector<Record> buffer;
+		size_t position = 0;
+		size_t size = 0;
+
+		bool next(Record& record)
+		{
+			if (this->position == this->size)
+			{
+				this->size = std::fread(this->buffer.data(), sizeof(Record), this->buffer.size(), this->file);
+				this->position = 0;
+				if (this->size == 0)
+				{
+					return false;
+				}
+			}
+			record = this->buffer[this->position++];
+			return true;
+		}
+	};
+}
+
+int main(int argc, char* argv[])
+{
+	std::vector<std::string> inputs;
+	std::string outputPath;
+	std::string tmpDirectory;
+	std::string keysPath;
+	int maxPly = 30;
+	uint32_t minGames = 5;
+	size_t memoryMiB = 1024;
+	int threads = omp_get_max_threads();
+
+	for (int i = 1; i < argc; i++)
+	{
+		std::string option = argv[i];
+		if (i + 1 < argc && (option == "-o" || option == "--output"))
+		{
+			outputPath = argv[++i];
+		}
+		else if (i + 1 < argc && option == "--max-ply")
+		{
+			maxPly = std::max(std::stoi(argv[++i]), 1);
+		}
+		else if (i + 1 < argc && option == "--min-games")
+		{
+			minGames = static_cast<uint32_t>(std::max(std::stoi(argv[++i]), 1));
+		}
+		else if (i + 1 < argc && option == "--memory")
+		{
+			memoryMiB = static_cast<size_t>(std::max(std::stoi(argv[++i]), 1));
+		}
+		else if (i + 1 < argc && option == "--threads")
+		{
+			threads = std::max(std::stoi(argv[++i]), 1);
+		}
+		else if (i + 1 < argc && option == "--tmp")
+		{
+			tmpDirectory = argv[++i];
+		}
+		else if (i + 1 < argc && option == "--keys")
+		{
+			keysPath = argv[++i];
+		}
+		else if (option.rfind("-", 0) != 0)
+		{
+			inputs.push_back(option);
+		}
+		else
+		{
+			std::cerr << "Unknown option " << option << std::endl;
+			return 1;
+		}
+	}
+
+	if (inputs.empty() || outputPath.empty())
+	{
+		std::cerr << "Usage : bookbuild <pgn>... -o <book.bin> [--max-ply <n>] [--min-games <n>] [--memory <MiB>] "
+					 "[--threads <n>] [--tmp <dir>] [--keys <file>]" << std::endl;
+		return 1;
+	}
+
+	engine::initAttacks();
+	if (!keysPath.empty() && !engine::PolyglotBook::loadKeys(keysPath))
+	{
+		return 1;
+	}
+
+	// Runs next to the book unless told otherwise
+	if (tmpDirectory.empty())
+	{
+		const size_t slash = outputPath.find_last_of('/');
+		tmpDirectory = (slash == std::string::npos) ? "." : outputPath.substr(0, slash);
+	}
+
+	const auto start = std::chrono::steady_clock::now();
+	const size_t memoryBudget = memoryMiB << 20;
+
+	std::vector<ShardMap> maps(SHARD_COUNT);
+	std::vector<std::vector<std::vector<Sample>>> samples(threads, std::vector<std::vector<Sample>>(SHARD_COUNT));
+	std::vector<engine::PgnGame> batch(BATCH_GAMES);
+	std::vector<std::string> runPaths;
+
+	uint64_t totalBytes = 0;
+	uint64_t games = 0;
+	uint64_t skipped = 0;
+	uint64_t positions = 0;
+
+	// Write the maps as a sorted run and empty them
+	auto spill = [&]()
+	{
+		const std::string path = tmpDirectory + "/bookbuild-run-" + std::to_string(runPaths.size()) + ".tmp";
+		std::FILE* file = std::fopen(path.c_str(), "wb");
+		if (!file)
+		{
+			std::cerr << "Error: cannot write " << path << std::endl;
+			return false;
+		}
+		size_t records = 0;
+		for (ShardMap& map : maps)
+		{
+			const std::vector<Record> sorted = sortShard(map);
+			std::fwrite(sorted.data(), sizeof(Record), sorted.size(), file);
+			records += sorted.size();
+			ShardMap().swap(map);
+		}
+		const bool written = std::fclose(file) == 0;
+		runPaths.push_back(path);
+		std::cout << "  run " << runPaths.size() << " : " << records << " records written to " << path << std::endl;
+		return written;
+	};
+
+	auto removeRuns = [&]()
+	{
+		for (const std::string& path : runPaths)
+		{
+			std::remove(path.c_str());
+		}
+	};
+
+	engine::PgnReader reader;
+	for (const std::string& input : inputs)
+	{
+		if (!reader.open(input))
+		{
+			removeRuns();
+			return 1;
+		}
+
+		while (true)
+		{
+			// Read a batch (serial), reusing the games of the previous batch
+			size_t count = 0;
+			while (count < BATCH_GAMES && reader.readGame(batch[count]))
+			{
+				if (batch[count].result == engine::RESULT_UNKNOWN)
+				{
+					skipped++;
+					continue;
+				}
+				count++;
+			}
+			if (count == 0)
+			{
+				break;
+			}
+			games += count;
+
+			// Replay the games (parallel), each thread into its own shards
+			#pragma omp parallel for schedule(dynamic, 16) num_threads(threads)
+			for (size_t g = 0; g < count; g++)
+			{
+				replayGame(batch[g], maxPly, samples[omp_get_thread_num()].data());
+			}
+
+			// Count the samples (parallel over the shards, one map per shard so no locks)
+			uint64_t batchPositions = 0;
+			#pragma omp parallel for schedule(dynamic, 1) num_threads(threads) reduction(+ : batchPositions)
+			for (int shard = 0; shard < SHARD_COUNT; shard++)
+			{
+				for (auto& threadSamples : samples)
+				{
+					for (const Sample& sample : threadSamples[shard])
+					{
+						Counts& counts = maps[shard][{sample.key, sample.move}];
+						counts.wins += (sample.outcome == 2) ? 1 : 0;
+						counts.draws += (sample.outcome == 1) ? 1 : 0;
+						counts.losses += (sample.outcome == 0) ? 1 : 0;
+					}
+					batchPositions += threadSamples[shard].size();
+					threadSamples[shard].clear();
+				}
+			}
+			positions += batchPositions;
+
+			size_t entries = 0;
+			for (const ShardMap& map : maps)
+			{
+				entries += map.size();
+			}
+			if (entries * ENTRY_MEMORY > memoryBudget)
+			{
+				std::cout << std::endl;
+				if (!spill())
+				{
+					removeRuns();
+					return 1;
+				}
+			}
+
+			const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+			std::cout << "\r" << input << " : " << std::fixed << std::setprecision(0) << (totalBytes + reader.getBytesRead()) / 1e6
+					  << " MB, " << games << " games, " << positions << " positions, " << std::setprecision(1)
+					  << (totalBytes + reader.getBytesRead()) / 1e6 / std::max(seconds, 1e-3) << " MB/s" << std::flush;
+		}
+		totalBytes += reader.getBytesRead();
+		reader.close();
+		std::cout << std::endl;
+	}
+
+	std::FILE* output = std::fopen(outputPath.c_str(), "wb");
+	if (!output)
+	{
+		std::cerr << "Error: cannot write " << outputPath << std::endl;
+		removeRuns();
+		return 1;
+	}
+	BookWriter writer(output, minGames);
+
+	if (runPaths.empty())
+	{
+		// Everything fits in memory : the shards in order are sorted by key
+		for (const ShardMap& map : maps)
+		{
+			for (const Record& record : sortShard(map))
+			{
+				writer.add(record);
+			}
+		}
+	}
+	else
+	{
+		// Last run, then k-way merge of the runs, summing the counts of a pair found in several runs
+		if (!spill())
+		{
+			std::fclose(output);
+			removeRuns();
+			return 1;
+		}
+
+		std::vector<RunReader> runs(runPaths.size());
+		using Head = std::pair<Record, size_t>;
+		auto later = [](const Head& a, const Head& b) { return b.first < a.first; };
+		std::priority_queue<Head, std::vector<Head>, decltype(later)> heads(later);
+
+		for (size_t r = 0; r < runs.size(); r++)
+		{
+			runs[r].file = std::fopen(runPaths[r].c_str(), "rb");
+			if (!runs[r].file)
+			{
+				std::cerr << "Error: cannot read " << runPaths[r] << std::endl;
+				for (size_t opened = 0; opened < r; opened++)
+				{
+					std::fclose(runs[opened].file);
+				}
+				std::fclose(output);
+				removeRuns();
+				return 1;
+			}
+			runs[r].buffer.resize(RUN_BUFFER_RECORDS);
+			Record record;
+			if (runs[r].next(record))
+			{
+				heads.push({record, r});
+			}
+		}
+
+		bool pending = false;
+		Record current{};
+		while (!heads.empty())
+		{
+			const Head head = heads.top();
+			heads.pop();
+
+			if (pending && current.key == head.first.key && current.move == head.first.move)
+			{
+				current.wins += head.first.wins;
+				current.draws += head.first.draws;
+				current.losses += head.first.losses;
+			}
+			else
+			{
+				if (pending)
+				{
+					writer.add(current);
+				}
+				current = head.first;
+				pending = true;
+			}
+
+			Record record;
+			if (runs[head.second].next(record))
+			{
+				heads.push({record, head.second});
+			}
+		}
+		if (pending)
+		{
+			writer.add(current);
+		}
+
+		for (RunReader& run : runs)
+		{
+			std::fclose(run.file);
+		}
+		removeRuns();
+	}
+
+	const uint64_t entries = writer.finish();
+	if (std::fclose(output) != 0)
+	{
+		std::cerr << "Error: cannot write " << outputPath << std::endl;
+		return 1;
+	}
+
+	const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	std::cout << "Book " << outputPath << " : " << entries << " entries, " << writer.getPositions() << " positions, from "
+			  << games << " games (" << skipped << " without result skipped), " << runPaths.size() << " runs, "
+			  << std::fixed << std::setprecision(1) << seconds << " s" << std::endl;
+	return 0;
+}
@@ -0,0 +1,439 @@
+/**
+ * @author obiwan138
+ * @file datagen.cpp
+ * @brief Self-play generator of training positions for the evaluation networks (headless)
+ * @details Usage :
+ *   datagen --output <directory>             play games on all the cores and write their quiet positions to chunk files
+ *   datagen ... --positions <n>              positions to write (default : 1000000)
+ *   datagen ... --threads <n>                games played at the same time (default : all the cores)
+ *   datagen ... --nodes <n>                  nodes searched per move (default : 5000)
+ *   datagen ... --random-plies <n>           random moves from the standard position before the search plays (default : 8)
+ *   datagen ... --opening-score <cp>         openings searched beyond this score are played again (default : 500)
+ *   datagen ... --chunk <n>                  positions per chunk file (default : 1048576, 32 MiB)
+ *   datagen ... --hash <MiB>                 transposition table of each thread (default : 16)
+ *   datagen ... --eval <network>             search with a network (default : the hand-crafted evaluation)
+ *   datagen ... --seed <n>                   seed of the openings and of the shuffles (default : 1)
+ *   datagen ... --status <seconds>           period of the progress line (default : 10)
+ *   datagen --verify <directory>             check every record of the chunks of a directory (exit code 1 if any is bad)
+ * Each thread plays its own games with a fixed number of nodes per move and writes its own chunks (t<thread>-<n>.c3t,
+ * see TrainingChunk), labelled with the score of the search and the result of the game. The positions in check, those
+ * whose best move is a capture or a promotion, and those with a winning capture available (a more valuable piece, or
+ * an undefended one) are left out : the labels of the quiet positions are the ones a static evaluation can learn. The
+ * games are adjudicated once decided (won at 2000 cp for 4 plies, drawn within 10 cp for 12 plies from ply 80).
+ */
+
+// Include standard headers
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <filesystem>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <omp.h>
+#include <string>
+#include <vector>
+
+// Include project header files
+#include "engine/Attacks.hpp"
+#include "engine/GameState.hpp"
+#include "engine/MoveGen.hpp"
+#include "engine/Network.hpp"
+#include "engine/Position.hpp"
+#include "engine/ProgressMonitor.hpp"
+#include "engine/RandomGenerator.hpp"
+#include "engine/Search.hpp"
+#include "engine/TrainingChunk.hpp"
+#include "engine/TrainingDataWriter.hpp"
+#include "engine/TranspositionTable.hpp"
+
+namespace{
+
+	// Adjudication : won beyond WIN_SCORE for WIN_PLIES plies, drawn within DRAW_SCORE for DRAW_PLIES plies from DRAW_PLY
+	const int WIN_SCORE = 2000;
+	const int WIN_PLIES = 4;
+	const int DRAW_SCORE = 10;
+	const int DRAW_PLIES = 12;
+	const int DRAW_PLY = 80;
+
+	// Longest game [plies], drawn beyond
+	const int MAX_GAME_PLIES = 400;
+
+	// Value of the pieces for the winning captures [pawns]
+	const int PIECE_VALUES[6] = {1, 3, 3, 5, 9, 100};
+
+	// Settings of the games
+	struct Settings {
+		uint64_t nodes = 5000;
+		int randomPlies = 8;
+		int openingScore = 500;
+		const engine::Network* network = nullptr;
+	};
+
+	// Position of a game waiting for its result
+	struct PendingPosition {
+		engine::Position position;
+		int score;
+		int ply;
+	};
+
+	// Search and output of a thread
+	struct Worker {
+		std::unique_ptr<engine::TranspositionTable> table;
+		std::unique_ptr<engine::Search> search;
+		engine::TrainingDataWriter writer;
+		engine::RandomGenerator random;
+
+		Worker(size_t hashMb, const engine::Network* network, uint64_t seed)
+		{
+			this->table = std::make_unique<engine::TranspositionTable>(hashMb);
+			this->search = std::make_unique<engine::Search>(*this->table);
+			this->search->setNetwork(network);
+			this->random.seed(seed);
+		}
+	};
+
+	// Is a move a capture or a promotion
+	bool isTactical(const engine::Position& position, engine::Move move)
+	{
+		return move.type() == engine::EN_PASSANT || move.type() == engine::PROMOTION
+			|| (move.type() != engine::CASTLING && position.getPieceOn(move.to()) != engine::NO_PIECE);
+	}
+
+	// Can the side to move win material at once : capture a more valuable piece, or an undefended one
+	bool hasWinningCapture(const engine::Position& position)
+	{
+		engine::MoveList captures;
+		engine::generateLegalCaptures(position, captures);
+		const engine::Color them = (position.getSideToMove() == engine::WHITE) ? engine::BLACK : engine::WHITE;
+		for (int i = 0; i < captures.size(); i++)
+		{
+			const engine::Move move = captures[i];
+			const engine::Piece victim = position.getPieceOn(move.to());
+			if (move.type() == engine::CASTLING || (victim == engine::NO_PIECE && move.type() != engine::EN_PASSANT))
+			{
+				continue;
+			}
+			const int attackerValue = PIECE_VALUES[engine::typeOf(position.getPieceOn(move.from()))];
+			const int victimValue = (victim == engine::NO_PIECE) ? PIECE_VALUES[engine::PAWN] : PIECE_VALUES[engine::typeOf(victim)];
+			if (victimValue > attackerValue
+				|| !position.isAttacked(move.to(), them, position.getOccupied() ^ engine::squareBB(move.from())))
+			{
+				return true;
+			}
+		}
+		return false;
+	}
+
+	// Random opening from the standard position, balanced according to a search
+	void playOpening(Worker& worker, const Settings& settings, engine::GameState& game)
+	{
+		while (true)
+		{
+			game.setFromFen(engine::Position::startFen);
+			for (int ply = 0; ply < settings.randomPlies; ply++)
+			{
+				engine::MoveList moves;
+				engine::generateLegalMoves(game.getPosition(), moves);
+				if (moves.empty())
+				{
+					break;
+				}
+				game.doMove(moves[static_cast<int>(worker.random.next() % moves.size())]);
+			}
+
+			engine::MoveList moves;
+			engine::generateLegalMoves(game.getPosition(), moves);
+			if (game.getPly() < settings.randomPlies || moves.empty())
+			{
+				continue;
+			}
+			engine::SearchLimits limits;
+			limits.nodes = settings.nodes;
+			worker.table->clear();
+			worker.search->clear();
+			if (std::abs(worker.search->run(game, limits).score) <= settings.openingScore)
+			{
+				return;
+			}
+		}
+	}
+
+	// Play a game and write its quiet positions, return the number written
+	uint64_t playGame(Worker& worker, const Settings& settings)
+	{
+		engine::GameState game;
+		playOpening(worker, settings, game);
+
+		std::vector<PendingPosition> pending;
+		int result = 1;
+		int winPlies[2] = {0, 0};
+		int drawPlies = 0;
+		engine::SearchLimits limits;
+		limits.nodes = settings.nodes;
+
+		while (true)
+		{
+			const engine::Position& position = game.getPosition();
+			engine::MoveList moves;
+			engine::generateLegalMoves(position, moves);
+			if (moves.empty())
+			{
+				result = !position.getCheckers() ? 1 : (position.getSideToMove() == engine::WHITE) ? 0 : 2;
+				break;
+			}
+			if (game.isThreefoldRepetition() || game.isFiftyMoveDraw() || game.isInsufficientMaterial()
+				|| game.getPly() >= MAX_GAME_PLIES)
+			{
+				break;
+			}
+
+			const engine::SearchResult searchResult = worker.search->run(game, limits);
+			const int score = searchResult.score;
+			const engine::Move move = searchResult.bestMove;
+
+			if (!position.getCheckers() && !isTactical(position, move) && std::abs(score) < engine::SCORE_MATE_IN_MAX_PLY
+				&& !hasWinningCapture(position))
+			{
+				pending.push_back({position, score, game.getPly()});
+			}
+
+			// Adjudication (white point of view)
+			const int whiteScore = (position.getSideToMove() == engine::WHITE) ? score : -score;
+			winPlies[0] = (whiteScore >= WIN_SCORE) ? winPlies[0] + 1 : 0;
+			winPlies[1] = (whiteScore <= -WIN_SCORE) ? winPlies[1] + 1 : 0;
+			drawPlies = (game.getPly() >= DRAW_PLY && std::abs(score) <= DRAW_SCORE) ? drawPlies + 1 : 0;
+			if (winPlies[0] >= WIN_PLIES || winPlies[1] >= WIN_PLIES)
+			{
+				result = (winPlies[0] >= WIN_PLIES) ? 2 : 0;
+				break;
+			}
+			if (drawPlies >= DRAW_PLIES)
+			{
+				break;
+			}
+
+			game.doMove(move);
+		}
+
+		for (const PendingPosition& entry : pending)
+		{
+			worker.writer.add(engine::TrainingChunk::pack(entry.position, entry.score, static_cast<uint8_t>(result), entry.ply));
+		}
+		return pending.size();
+	}
+
+	// Write the training positions of self-play games
+	int generate(const std::string& directory, uint64_t positionTarget, int threads, const Settings& settings, size_t chunkSize,
+				 size_t hashMb, uint64_t seed, double statusSeconds)
+	{
+		std::error_code error;
+		std::filesystem::create_directories(directory, error);
+		if (error)
+		{
+			std::cerr << "Error: cannot create " << directory << " (" << error.message() << ")" << std::endl;
+			return 1;
+		}
+
+		std::vector<std::unique_ptr<Worker>> workers;
+		for (int i = 0; i < threads; i++)
+		{
+			workers.push_back(std::make_unique<Worker>(hashMb, settings.network, seed * 1000003 + static_cast<uint64_t>(i)));
+			workers.back()->writer.open((std::filesystem::path(directory) / ("t" + std::to_string(i))).string(), chunkSize,
+										seed * 1000003 + static_cast<uint64_t>(i));
+		}
+
+		std::atomic<uint64_t> positions{0};
+		std::atomic<uint64_t> games{0};
+		const auto start = std::chrono::steady_clock::now();
+		auto elapsedSeconds = [&start]() {
+			return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		};
+		auto status = [&]() {
+			const double seconds = elapsedSeconds();
+			const uint64_t positionCount = positions.load();
+			const uint64_t gameCount = games.load();
+			std::cout << std::fixed << std::setprecision(0) << positionCount << " positions  " << gameCount << " games  "
+					  << (seconds > 0.0 ? static_cast<double>(positionCount) / seconds : 0.0) << " positions/s  "
+					  << std::setprecision(1) << (gameCount > 0 ? static_cast<double>(positionCount) / gameCount : 0.0)
+					  << " positions/game" << std::endl;
+		};
+
+		// Progress line, every few seconds
+		engine::ProgressMonitor monitor(statusSeconds, status);
+
+		#pragma omp parallel num_threads(threads)
+		{
+			Worker& worker = *workers[static_cast<size_t>(omp_get_thread_num())];
+			while (positions.load(std::memory_order_relaxed) < positionTarget)
+			{
+				positions.fetch_add(playGame(worker, settings), std::memory_order_relaxed);
+				games.fetch_add(1, std::memory_order_relaxed);
+			}
+		}
+
+		monitor.stop();
+
+		bool written = true;
+		uint64_t chunks = 0;
+		for (const std::unique_ptr<Worker>& worker : workers)
+		{
+			written = worker->writer.close() && written;
+			chunks += worker->writer.getChunkCount();
+		}
+		status();
+		std::cout << chunks << " chunks written to " << directory << " in " << std::setprecision(1) << elapsedSeconds() << " s ("
+				  << threads << " threads, " << settings.nodes << " nodes per move)" << std::endl;
+		return written ? 0 : 1;
+	}
+
+	// Check every record of the chunks of a directory
+	int verify(const std::string& directory)
+	{
+		std::vector<std::string> paths;
+		std::error_code error;
+		for (const std::filesystem::directory_entry& entry : std::filesystem::directory_iterator(directory, error))
+		{
+			if (entry.path().extension() == ".c3t")
+			{
+				paths.push_back(entry.path().string());
+			}
+		}
+		if (error || paths.empty())
+		{
+			std::cerr << "Error: no chunk in " << directory << std::endl;
+			return 1;
+		}
+		std::sort(paths.begin(), paths.end());
+
+		uint64_t records = 0;
+		uint64_t bad = 0;
+		uint64_t results[3] = {0, 0, 0};
+		uint64_t quietViolations = 0;
+		for (const std::string& path : paths)
+		{
+			engine::TrainingChunk chunk;
+			if (!chunk.open(path))
+			{
+				return 1;
+			}
+			engine::Position position;
+			for (uint64_t i = 0; i < chunk.getRecordCount(); i++)
+			{
+				const engine::PackedPosition record = chunk.getRecord(i);
+				records++;
+				if (!engine::TrainingChunk::unpack(record, position) || position.checkLegality())
+				{
+					bad++;
+					continue;
+				}
+				results[record.result]++;
+				quietViolations += (position.getCheckers() || hasWinningCapture(position)) ? 1 : 0;
+			}
+		}
+
+		std::cout << paths.size() << " chunks, " << records << " positions (white wins " << results[2] << ", draws "
+				  << results[1] << ", black wins " << results[0] << ")" << std::endl;
+		std::cout << "Verification : " << (bad == 0 && quietViolations == 0 ? "OK" : "FAILED") << " (" << bad
+				  << " malformed or illegal, " << quietViolations << " not quiet)" << std::endl;
+		return (bad == 0 && quietViolations == 0) ? 0 : 1;
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	std::string outputPath;
+	std::string verifyPath;
+	std::string evalPath;
+	uint64_t positionTarget = 1000000;
+	int threads = omp_get_max_threads();
+	Settings settings;
+	size_t chunkSize = 1 << 20;
+	size_t hashMb = 16;
+	uint64_t seed = 1;
+	double statusSeconds = 10.0;
+
+	for (int i = 1; i < argc; i++)
+	{
+		std::string option = argv[i];
+		if (i + 1 < argc && (option == "-o" || option == "--output"))
+		{
+			outputPath = argv[++i];
+		}
+		else if (i + 1 < argc && option == "--verify")
+		{
+			verifyPath = argv[++i];
+		}
+		else if (i + 1 < argc && option == "--positions")
+		{
+			positionTarget = static_cast<uint64_t>(std::max(std::stoll(argv[++i]), 1LL));
+		}
+		else if (i + 1 < argc && option == "--threads")
+		{
+			threads = std::max(std::stoi(argv[++i]), 1);
+		}
+		else if (i + 1 < argc && option == "--nodes")
+		{
+			settings.nodes = static_cast<uint64_t>(std::max(std::stoll(argv[++i]), 1LL));
+		}
+		else if (i + 1 < argc && option == "--random-plies")
+		{
+			settings.randomPlies = std::max(std::stoi(argv[++i]), 0);
+		}
+		else if (i + 1 < argc && option == "--opening-score")
+		{
+			settings.openingScore = std::max(std::stoi(argv[++i]), 0);
+		}
+		else if (i + 1 < argc && option == "--chunk")
+		{
+			chunkSize = static_cast<size_t>(std::max(std::stoll(argv[++i]), 1LL));
+		}
+		else if (i + 1 < argc && option == "--hash")
+		{
+			hashMb = static_cast<size_t>(std::max(std::stoll(argv[++i]), 1LL));
+		}
+		else if (i + 1 < argc && option == "--eval")
+		{
+			evalPath = argv[++i];
+		}
+		else if (i + 1 < argc && option == "--seed")
+		{
+			seed = static_cast<uint64_t>(std::stoull(argv[++i]));
+		}
+		else if (i + 1 < argc && option == "--status")
+		{
+			statusSeconds = std::max(std::stod(argv[++i]), 0.1);
+		}
+		else
+		{
+			std::cerr << "Unknown option " << option << std::endl;
+			return 1;
+		}
+	}
+
+	engine::initAttacks();
+
+	if (!verifyPath.empty())
+	{
+		return verify(verifyPath);
+	}
+	if (outputPath.empty())
+	{
+		std::cerr << "Usage : datagen --output <directory> [--positions <n>] [--threads <n>] [--nodes <n>] [--random-plies <n>] "
+				  << "[--chunk <n>] [--eval <network>] [--seed <n>] or datagen --verify <directory>" << std::endl;
+		return 1;
+	}
+
+	engine::Network network;
+	if (!evalPath.empty())
+	{
+		if (!network.load(evalPath))
+		{
+			return 1;
+		}
+		settings.network = &network;
+	}
+	return generate(outputPath, positionTarget, threads, settings, chunkSize, hashMb, seed, statusSeconds);
+}
@@ -0,0 +1,388 @@
+/**
+ * @author obiwan138
+ * @file fencheck.cpp
+ * @brief Batch validation of FEN files (headless)
+ * @details Usage :
+ *   fencheck --generate <file> [--lines <n>] [--seed <n>]   write positions of random games, one line in 100 made
+ *                                                           illegal or malformed (default : 1000000 lines)
+ *   fencheck <file>                                         parse and check every line on all the cores
+ *   fencheck <file> --threads <n>                           number of threads (the file is split at line boundaries)
+ *   fencheck <file> --errors <n>                            rejected lines listed (default : 20, every reason counted)
+ *   fencheck <file> --round-trip                            the accepted lines must be written back identical
+ *   fencheck <file> --expect-rejected <n>                   exit code 1 unless exactly n lines are rejected
+ * A line is rejected if it is malformed or if the position cannot be reached in a game (see
+ * Position::checkLegality). The check reports the lines per second and the MB/s ; nothing is allocated per line.
+ */
+
+// Include standard headers
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <omp.h>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+// Include project header files
+#include "engine/Attacks.hpp"
+#include "engine/MappedFile.hpp"
+#include "engine/MoveGen.hpp"
+#include "engine/Position.hpp"
+
+namespace{
+
+	// Longest generated game [plies]
+	const int MAX_GENERATED_PLIES = 160;
+
+	// One generated line in CORRUPTION_PERIOD is corrupted
+	const uint64_t CORRUPTION_PERIOD = 100;
+
+	// Reason why a FEN line differs from the position written back
+	const char* ROUND_TRIP_ERROR = "written back differently";
+
+	// Rejected line kept for the report
+	struct Rejection {
+		uint64_t line;			// Line in the part of the file, then in the file
+		size_t offset;
+		const char* reason;
+	};
+
+	// Results of the check of a part of the file
+	struct PartResult {
+		uint64_t lines = 0;
+		uint64_t accepted = 0;
+		std::vector<std::pair<const char*, uint64_t>> reasons;
+		std::vector<Rejection> rejections;
+	};
+
+	// Write the positions of random games, with one corrupted line in CORRUPTION_PERIOD
+	bool generate(const std::string& path, uint64_t lineCount, uint64_t seed)
+	{
+		std::FILE* file = std::fopen(path.c_str(), "wb");
+		if (!file)
+		{
+			std::cerr << "Error: cannot write " << path << std::endl;
+			return false;
+		}
+
+		uint64_t state = seed * 0x9E3779B97F4A7C15ull + 1;
+		auto next = [&state]() {
+			state ^= state >> 12;
+			state ^= state << 25;
+			state ^= state >> 27;
+			return state * 0x2545F4914F6CDD1Dull;
+		};
+
+		engine::Position position;
+		int ply = MAX_GENERATED_PLIES;
+		std::string line;
+		uint64_t corrupted = 0;
+		for (uint64_t index = 0; index < lineCount; index++)
+		{
+			// Next position of the current random game, a new game after its end
+			engine::MoveList moves;
+			if (ply < MAX_GENERATED_PLIES)
+			{
+				engine::generateLegalMoves(position, moves);
+			}
+			if (moves.empty())
+			{
+				position.setFromFen(engine::Position::startFen);
+				ply = 0;
+			}
+			else
+			{
+				position.doMove(moves[static_cast<int>(next() % moves.size())]);
+				ply++;
+			}
+			line = position.toFen();
+
+			// Corruptions which always make the line invalid (the first one when the others do not apply)
+			if (index % CORRUPTION_PERIOD == CORRUPTION_PERIOD - 1)
+			{
+				const size_t placementEnd = line.find(' ');
+				int kind = static_cast<int>((index / CORRUPTION_PERIOD) % 6);
+				if ((kind == 3 && position.getPieceOn(engine::E1) == engine::W_KING)
+				 || (kind == 4 && !position.getCheckers()))
+				{
+					kind = 0;
+				}
+				switch (kind)
+				{
+					case 0:		// No white king
+						line[line.find('K')] = 'Q';
+						break;
+					case 1:		// Pawn on the first rank (or no white king)
+						line.replace(line.rfind('/', placementEnd) + 1, placementEnd - line.rfind('/', placementEnd) - 1, "1P6");
+						break;
+					case 2:		// Missing fields
+						line.resize(placementEnd + 2);
+						break;
+					case 3:		// White kingside castling without the king on e1
+						line.replace(placementEnd + 3, line.find(' ', placementEnd + 3) - placementEnd - 3, "K");
+						break;
+					case 4:		// Side to move swapped while in check : the side not to move is in check
+						line = line.substr(0, placementEnd) + (position.getSideToMove() == engine::WHITE ? " b " : " w ")
+							 + line.substr(placementEnd + 3, line.find(' ', placementEnd + 3) - placementEnd - 3) + " - 0 1";
+						break;
+					default:	// En passant square without a pawn pushed two squares (on the wrong rank if every file has one)
+					{
+						const bool white = position.getSideToMove() == engine::WHITE;
+						std::string ep = white ? "e3" : "e6";
+						for (int file = 0; file < 8; file++)
+						{
+							const engine::Square pushed = engine::makeSquare(file, white ? 4 : 3);
+							if (position.getPieceOn(pushed) != (white ? engine::B_PAWN : engine::W_PAWN))
+							{
+								ep = std::string(1, static_cast<char>('a' + file)) + (white ? "6" : "3");
+								break;
+							}
+						}
+						const size_t epStart = line.find(' ', line.find(' ', placementEnd + 1) + 1) + 1;
+						line.replace(epStart, line.find(' ', epStart) - epStart, ep);
+						break;
+					}
+				}
+				corrupted++;
+			}
+
+			line += '\n';
+			if (std::fwrite(line.data(), 1, line.size(), file) != line.size())
+			{
+				std::cerr << "Error: cannot write " << path << std::endl;
+				std::fclose(file);
+				return false;
+			}
+		}
+
+		if (std::fclose(file) != 0)
+		{
+			std::cerr << "Error: cannot write " << path << std::endl;
+			return false;
+		}
+		std::cout << lineCount << " lines written to " << path << " (" << corrupted << " invalid)" << std::endl;
+		return true;
+	}
+
+	// Check the lines of a part of the file
+	void checkPart(const char* begin, const char* end, bool roundTrip, size_t maxRejections, PartResult& result)
+	{
+		engine::Position position;
+		char buffer[engine::Position::MAX_FEN_LENGTH];
+
+		auto reject = [&](const char* reason, const char* line) {
+			auto it = std::find_if(result.reasons.begin(), result.reasons.end(), [reason](const std::pair<const char*, uint64_t>& entry) {
+				return entry.first == reason;
+			});
+			if (it == result.reasons.end())
+			{
+				result.reasons.push_back({reason, 1});
+			}
+			else
+			{
+				it->second++;
+			}
+			if (result.rejections.size() < maxRejections)
+			{
+				result.rejections.push_back({result.lines, static_cast<size_t>(line - begin), reason});
+			}
+		};
+
+		const char* cursor = begin;
+		while (cursor < end)
+		{
+			const char* newline = static_cast<const char*>(std::memchr(cursor, '\n', static_cast<size_t>(end - cursor)));
+			const char* lineEnd = newline ? newline : end;
+			std::string_view line(cursor, static_cast<size_t>(lineEnd - cursor));
+			while (!line.empty() && (line.back() == '\r' || line.back() == ' '))
+			{
+				line.remove_suffix(1);
+			}
+
+			if (!line.empty())
+			{
+				const char* reason = nullptr;
+				if (!position.setFromFen(line, &reason) || (reason = position.checkLegality()) != nullptr)
+				{
+					reject(reason, cursor);
+				}
+				else if (roundTrip && std::string_view(buffer, position.writeFen(buffer)) != line)
+				{
+					reject(ROUND_TRIP_ERROR, cursor);
+				}
+				else
+				{
+					result.accepted++;
+				}
+			}
+
+			result.lines++;
+			cursor = lineEnd + 1;
+		}
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	std::string path;
+	std::string generatePath;
+	uint64_t lineCount = 1000000;
+	uint64_t seed = 1;
+	int threads = omp_get_max_threads();
+	size_t maxRejections = 20;
+	bool roundTrip = false;
+	int64_t expectedRejections = -1;
+
+	for (int i = 1; i < argc; i++)
+	{
+		std::string option = argv[i];
+		if (i + 1 < argc && option == "--generate")
+		{
+			generatePath = argv[++i];
+		}
+		else if (i + 1 < argc && option == "--lines")
+		{
+			lineCount = std::max<uint64_t>(std::stoull(argv[++i]), 1);
+		}
+		else if (i + 1 < argc && option == "--seed")
+		{
+			seed = std::stoull(argv[++i]);
+		}
+		else if (i + 1 < argc && option == "--threads")
+		{
+			threads = std::max(std::stoi(argv[++i]), 1);
+		}
+		else if (i + 1 < argc && option == "--errors")
+		{
+			maxRejections = static_cast<size_t>(std::max(std::stoll(argv[++i]), 0LL));
+		}
+		else if (option == "--round-trip")
+		{
+			roundTrip = true;
+		}
+		else if (i + 1 < argc && option == "--expect-rejected")
+		{
+			expectedRejections = std::max(std::stoll(argv[++i]), 0LL);
+		}
+		else if (option.rfind("--", 0) != 0 && path.empty())
+		{
+			path = option;
+		}
+		else
+		{
+			std::cerr << "Unknown option " << option << std::endl;
+			return 1;
+		}
+	}
+
+	engine::initAttacks();
+
+	if (!generatePath.empty())
+	{
+		return generate(generatePath, lineCount, seed) ? 0 : 1;
+	}
+	if (path.empty())
+	{
+		std::cerr << "Usage : fencheck <file> [--threads <n>] [--errors <n>] [--round-trip] [--expect-rejected <n>] | "
+				  << "fencheck --generate <file> [--lines <n>] [--seed <n>]" << std::endl;
+		return 1;
+	}
+
+	engine::MappedFile file;
+	if (!file.open(path))
+	{
+		return 1;
+	}
+	const char* data = reinterpret_cast<const char*>(file.getData());
+	const size_t size = file.getSize();
+
+	// Parts of the file, cut after a newline
+	std::vector<size_t> offsets(static_cast<size_t>(threads) + 1, size);
+	offsets[0] = 0;
+	for (int part = 1; part < threads; part++)
+	{
+		size_t offset = std::max(size / static_cast<size_t>(threads) * static_cast<size_t>(part), offsets[part - 1]);
+		const void* newline = offset < size ? std::memchr(data + offset, '\n', size - offset) : nullptr;
+		offsets[part] = newline ? static_cast<size_t>(static_cast<const char*>(newline) - data) + 1 : size;
+	}
+
+	std::vector<PartResult> results(static_cast<size_t>(threads));
+	const auto start = std::chrono::steady_clock::now();
+	#pragma omp parallel for schedule(static, 1) num_threads(threads)
+	for (int part = 0; part < threads; part++)
+	{
+		checkPart(data + offsets[part], data + offsets[part + 1], roundTrip, maxRejections, results[part]);
+	}
+	const double seconds = std::max(std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count(), 1e-9);
+
+	// Totals, and the line numbers of the rejections from the line counts of the parts
+	uint64_t lines = 0;
+	uint64_t accepted = 0;
+	std::vector<std::pair<const char*, uint64_t>> reasons;
+	std::vector<Rejection> rejections;
+	for (int part = 0; part < threads; part++)
+	{
+		for (const std::pair<const char*, uint64_t>& reason : results[part].reasons)
+		{
+			auto it = std::find_if(reasons.begin(), reasons.end(), [&reason](const std::pair<const char*, uint64_t>& entry) {
+				return entry.first == reason.first;
+			});
+			if (it == reasons.end())
+			{
+				reasons.push_back(reason);
+			}
+			else
+			{
+				it->second += reason.second;
+			}
+		}
+		for (Rejection rejection : results[part].rejections)
+		{
+			if (rejections.size() < maxRejections)
+			{
+				rejection.line += lines + 1;
+				rejection.offset += offsets[part];
+				rejections.push_back(rejection);
+			}
+		}
+		lines += results[part].lines;
+		accepted += results[part].accepted;
+	}
+
+	for (const Rejection& rejection : rejections)
+	{
+		const char* line = data + rejection.offset;
+		const char* lineEnd = static_cast<const char*>(std::memchr(line, '\n', size - rejection.offset));
+		std::string_view text(line, static_cast<size_t>((lineEnd ? lineEnd : data + size) - line));
+		while (!text.empty() && (text.back() == '\r' || text.back() == ' '))
+		{
+			text.remove_suffix(1);
+		}
+		std::cout << "line " << rejection.line << " : " << rejection.reason << " : " << text << std::endl;
+	}
+
+	uint64_t rejected = 0;
+	std::sort(reasons.begin(), reasons.end(), [](const std::pair<const char*, uint64_t>& a, const std::pair<const char*, uint64_t>& b) {
+		return a.second > b.second;
+	});
+	for (const std::pair<const char*, uint64_t>& reason : reasons)
+	{
+		std::cout << std::setw(10) << reason.second << "  " << reason.first << std::endl;
+		rejected += reason.second;
+	}
+	std::cout << path << " : " << lines << " lines, " << accepted << " accepted, " << rejected << " rejected in " << std::fixed
+			  << std::setprecision(3) << seconds << " s (" << std::setprecision(0) << lines / seconds << " lines/s, "
+			  << std::setprecision(1) << size / 1e6 / seconds << " MB/s, " << threads << " threads)" << std::endl;
+
+	if (expectedRejections >= 0 && rejected != static_cast<uint64_t>(expectedRejections))
+	{
+		std::cerr << "Error: " << rejected << " lines rejected, " << expectedRejections << " expected" << std::endl;
+		return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,898 @@
+/**
+ * @author obiwan138
+ * @file match.cpp
+ * @brief Match between two engine configurations, games played in parallel, with a sequential test (headless)
+ * @details Usage :
+ *   match --engine <options> --engine <options>     the two configurations, the first one being tested against the second
+ *         options (separated by spaces, in one argument) : name=<name> tc=<seconds>+<increment> depth=<d> nodes=<n>
+ *         hash=<MiB> (default : 16) eval=<network> (default : the hand-crafted evaluation)
+ *   match ... --games <n>                           maximum number of games (default : 1000)
+ *   match ... --concurrency <n>                     games played at the same time (default : all the cores)
+ *   match ... --openings <file>                     opening suite : a .pgn file, or FEN / EPD lines (default : random
+ *                                                   openings from the standard position)
+ *   match ... --opening-plies <n>                   plies of the games of a .pgn suite (default : 8)
+ *   match ... --random-plies <n>                    plies of the random openings (default : 8)
+ *   match ... --pgn <file>                          the games are written to a PGN file
+ *   match ... --draw-movenumber <n> --draw-movecount <n> --draw-score <cp>
+ *                                                   draw when both engines score within draw-score for draw-movecount
+ *                                                   moves in a row, from move draw-movenumber (default : 40 8 10)
+ *   match ... --resign-movecount <n> --resign-score <cp>
+ *                                                   loss when both engines agree on a score beyond resign-score for
+ *                                                   resign-movecount moves in a row (default : 4 600)
+ *   match ... --max-plies <n>                       draw after n plies (default : 400)
+ *   match ... --sprt <elo0> <elo1>                  sequential probability ratio test of H0 elo0 against H1 elo1 (logistic
+ *                                                   Elo, default : 0 5), the match stops when a hypothesis is accepted
+ *   match ... --alpha <a> --beta <b>                error rates of the test (default : 0.05 0.05)
+ *   match ... --status <seconds>                    period of the progress line (default : 10)
+ * Each opening is played twice, the colors reversed, and a worker thread takes the next game as soon as its game is
+ * over. The test is computed on the pairs of games (pentanomial model), which removes most of the noise of the
+ * openings. The progress line reports the games per minute, the score of the first engine, its Elo difference with a
+ * 95% interval and the log-likelihood ratio of the test. The exit code is 1 if a game could not be played.
+ */
+
+// Include standard headers
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <ctime>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <omp.h>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// Include project header files
+#include "engine/Attacks.hpp"
+#include "engine/GameState.hpp"
+#include "engine/MoveGen.hpp"
+#include "engine/Network.hpp"
+#include "engine/PgnReader.hpp"
+#include "engine/Position.hpp"
+#include "engine/ProgressMonitor.hpp"
+#include "engine/RandomGenerator.hpp"
+#include "engine/San.hpp"
+#include "engine/Search.hpp"
+#include "engine/TranspositionTable.hpp"
+
+namespace{
+
+	// Time kept in reserve on the clock, for the move generation and the bookkeeping of the game [ms]
+	const int64_t MOVE_OVERHEAD_MS = 10;
+
+	// Pairs of games added to the outcomes of the sequential test (spread evenly)
+	const double PAIR_PRIOR = 1.0;
+
+	// Configuration of an engine
+	struct EngineConfig {
+		std::string name;
+		std::string evalPath;				// Empty : hand-crafted evaluation
+		size_t hashMb = 16;
+		int64_t timeMs = 0;					// Base time of the clock, 0 : no clock
+		int64_t incrementMs = 0;
+		int depth = 0;
+		uint64_t nodes = 0;
+		const engine::Network* network = nullptr;
+	};
+
+	// Adjudication rules
+	struct Adjudication {
+		int drawMoveNumber = 40;
+		int drawMoveCount = 8;
+		int drawScore = 10;
+		int resignMoveCount = 4;
+		int resignScore = 600;
+		int maxPlies = 400;
+	};
+
+	// Start of the games : a position and the moves played from it
+	struct Opening {
+		std::string fen;
+		std::vector<engine::Move> moves;
+	};
+
+	// Outcome of a game
+	enum class Outcome {
+		WHITE_WINS,
+		BLACK_WINS,
+		DRAW,
+		ABORTED
+	};
+
+	// Game played by a worker
+	struct GameRecord {
+		Outcome outcome = Outcome::ABORTED;
+		std::string termination;			// PGN Termination tag
+		std::string reason;					// Final comment
+		std::string movetext;
+		int plies = 0;
+	};
+
+	// Results of the match, from the point of view of the first engine
+	struct Tally {
+		uint64_t wins = 0;
+		uint64_t draws = 0;
+		uint64_t losses = 0;
+		uint64_t pentanomial[5] = {0, 0, 0, 0, 0};	// Pairs scoring 0, 0.5, 1, 1.5 and 2 points
+		std::map<int, int> pendingPairs;			// Points x 2 of the first game of the pairs not complete yet
+		uint64_t errors = 0;
+	};
+
+	// Sequential probability ratio test
+	struct Sprt {
+		double elo0 = 0.0;
+		double elo1 = 5.0;
+		double alpha = 0.05;
+		double beta = 0.05;
+
+		double lowerBound() const
+		{
+			return std::log(this->beta / (1.0 - this->alpha));
+		}
+
+		double upperBound() const
+		{
+			return std::log((1.0 - this->beta) / this->alpha);
+		}
+	};
+
+	// Expected score of an Elo difference (logistic)
+	double eloToScore(double elo)
+	{
+		return 1.0 / (1.0 + std::pow(10.0, -elo / 400.0));
+	}
+
+	// Elo difference of an expected score
+	double scoreToElo(double score)
+	{
+		score = std::clamp(score, 1e-6, 1.0 - 1e-6);
+		return -400.0 * std::log10(1.0 / score - 1.0);
+	}
+
+	// Log-likelihood ratio of the pairs (generalized SPRT, normal approximation of the pentanomial distribution). A prior
+	// of one pair spread over the five outcomes keeps a one-sided start of the match from having a null variance
+	double logLikelihoodRatio(const Tally& tally, const Sprt& sprt)
+	{
+		double counts[5];
+		double pairs = 0.0;
+		double sum = 0.0;
+		for (int i = 0; i < 5; i++)
+		{
+			counts[i] = static_cast<double>(tally.pentanomial[i]) + PAIR_PRIOR / 5.0;
+			pairs += counts[i];
+			sum += counts[i] * i / 4.0;
+		}
+		if (pairs <= PAIR_PRIOR)
+		{
+			return 0.0;
+		}
+		const double mean = sum / pairs;
+		double variance = 0.0;
+		for (int i = 0; i < 5; i++)
+		{
+			variance += counts[i] * (i / 4.0 - mean) * (i / 4.0 - mean);
+		}
+		variance /= pairs;
+		if (variance <= 0.0)
+		{
+			return 0.0;
+		}
+		const double s0 = eloToScore(sprt.elo0);
+		const double s1 = eloToScore(sprt.elo1);
+		return pairs * (s1 - s0) * (2.0 * mean - s0 - s1) / (2.0 * variance);
+	}
+
+	// Progress line : games, speed, score, Elo and test
+	std::string formatStatus(const Tally& tally, const Sprt& sprt, double minutes)
+	{
+		const uint64_t games = tally.wins + tally.draws + tally.losses;
+		std::ostringstream line;
+		line << std::fixed << "Games " << games << "  " << std::setprecision(1)
+			 << (minutes > 0.0 ? static_cast<double>(games) / minutes : 0.0) << " games/min  +" << tally.wins << " ="
+			 << tally.draws << " -" << tally.losses;
+		if (games > 0)
+		{
+			const double n = static_cast<double>(games);
+			const double score = (static_cast<double>(tally.wins) + static_cast<double>(tally.draws) / 2.0) / n;
+			const double variance = (static_cast<double>(tally.wins) * (1.0 - score) * (1.0 - score)
+								   + static_cast<double>(tally.draws) * (0.5 - score) * (0.5 - score)
+								   + static_cast<double>(tally.losses) * score * score) / n;
+			const double margin = 1.96 * std::sqrt(variance / n);
+			const double elo = scoreToElo(score);
+			const double eloMargin = (scoreToElo(std::min(score + margin, 1.0)) - scoreToElo(std::max(score - margin, 0.0))) / 2.0;
+			line << "  Elo " << std::showpos << std::setprecision(1) << elo << std::noshowpos << " +- " << eloMargin;
+		}
+		line << "  LLR " << std::setprecision(2) << logLikelihoodRatio(tally, sprt) << " (" << sprt.lowerBound() << ", "
+			 << sprt.upperBound() << ")";
+		return line.str();
+	}
+
+	// Parse "name=... tc=10+0.1 depth=... nodes=... hash=... eval=..."
+	bool parseEngine(const std::string& text, EngineConfig& config)
+	{
+		std::istringstream input(text);
+		std::string option;
+		while (input >> option)
+		{
+			const size_t equal = option.find('=');
+			if (equal == std::string::npos)
+			{
+				std::cerr << "Error: engine option " << option << " is not key=value" << std::endl;
+				return false;
+			}
+			const std::string key = option.substr(0, equal);
+			const std::string value = option.substr(equal + 1);
+			try
+			{
+				if (key == "name")
+				{
+					config.name = value;
+				}
+				else if (key == "eval")
+				{
+					config.evalPath = value;
+				}
+				else if (key == "hash")
+				{
+					config.hashMb = static_cast<size_t>(std::max(std::stoll(value), 1LL));
+				}
+				else if (key == "depth")
+				{
+					config.depth = std::max(std::stoi(value), 0);
+				}
+				else if (key == "nodes")
+				{
+					config.nodes = static_cast<uint64_t>(std::max(std::stoll(value), 0LL));
+				}
+				else if (key == "tc")
+				{
+					const size_t plus = value.find('+');
+					config.timeMs = static_cast<int64_t>(std::stod(value.substr(0, plus)) * 1000.0);
+					config.incrementMs = (plus == std::string::npos) ? 0 : static_cast<int64_t>(std::stod(value.substr(plus + 1)) * 1000.0);
+				}
+				else
+				{
+					std::cerr << "Error: unknown engine option " << key << std::endl;
+					return false;
+				}
+			}
+			catch (const std::exception&)
+			{
+				std::cerr << "Error: invalid value of the engine option " << option << std::endl;
+				return false;
+			}
+		}
+		if (config.timeMs <= 0 && config.depth == 0 && config.nodes == 0)
+		{
+			std::cerr << "Error: engine " << config.name << " has no limit (tc, depth or nodes)" << std::endl;
+			return false;
+		}
+		return true;
+	}
+
+	// PGN TimeControl tag of an engine
+	std::string timeControlTag(const EngineConfig& config)
+	{
+		if (config.timeMs <= 0)
+		{
+			return "-";
+		}
+		std::ostringstream tag;
+		tag << config.timeMs / 1000.0;
+		if (config.incrementMs > 0)
+		{
+			tag << "+" << config.incrementMs / 1000.0;
+		}
+		return tag.str();
+	}
+
+	// Openings of a .pgn file (first plies of each game) or of FEN / EPD lines
+	bool loadOpenings(const std::string& path, int openingPlies, std::vector<Opening>& openings)
+	{
+		if (path.size() >= 4 && path.compare(path.size() - 4, 4, ".pgn") == 0)
+		{
+			engine::PgnReader reader;
+			if (!reader.open(path))
+			{
+				return false;
+			}
+			engine::Position position;
+			std::vector<engine::Move> moves;
+			for (const engine::PgnGame& game : reader)
+			{
+				if (!game.setUpPosition(position))
+				{
+					continue;
+				}
+				Opening opening;
+				opening.fen = position.toFen();
+				game.replay(position, moves);
+				moves.resize(std::min(moves.size(), static_cast<size_t>(openingPlies)));
+				opening.moves = moves;
+				openings.push_back(std::move(opening));
+			}
+		}
+		else
+		{
+			std::ifstream file(path);
+			if (!file)
+			{
+				std::cerr << "Error: cannot read " << path << std::endl;
+				return false;
+			}
+			std::string line;
+			uint64_t number = 0;
+			engine::Position position;
+			while (std::getline(file, line))
+			{
+				number++;
+				// EPD operations (after the fourth field) are dropped
+				std::istringstream fields(line);
+				std::string field;
+				std::string fen;
+				for (int i = 0; i < 6 && fields >> field; i++)
+				{
+					if (i >= 4 && field.find_first_not_of("0123456789") != std::string::npos)
+					{
+						break;
+					}
+					fen += (i > 0 ? " " : "") + field;
+				}
+				if (fen.empty())
+				{
+					continue;
+				}
+				const char* error = nullptr;
+				if (!position.setFromFen(fen, &error) || (error = position.checkLegality()))
+				{
+					std::cerr << "Warning: line " << number << " of " << path << " skipped (" << error << ")" << std::endl;
+					continue;
+				}
+				openings.push_back({position.toFen(), {}});
+			}
+		}
+		if (openings.empty())
+		{
+			std::cerr << "Error: no opening in " << path << std::endl;
+			return false;
+		}
+		return true;
+	}
+
+	// Random opening from the standard position (the same for a given index)
+	Opening randomOpening(uint64_t index, int plies)
+	{
+		engine::RandomGenerator random(index);
+
+		Opening opening;
+		opening.fen = engine::Position::startFen;
+		while (true)
+		{
+			engine::Position position;
+			position.setFromFen(opening.fen);
+			opening.moves.clear();
+			for (int ply = 0; ply < plies; ply++)
+			{
+				engine::MoveList moves;
+				engine::generateLegalMoves(position, moves);
+				if (moves.empty())
+				{
+					break;
+				}
+				const engine::Move move = moves[static_cast<int>(random.next() % moves.size())];
+				opening.moves.push_back(move);
+				position.doMove(move);
+			}
+			engine::MoveList moves;
+			engine::generateLegalMoves(position, moves);
+			if (static_cast<int>(opening.moves.size()) == plies && !moves.empty())
+			{
+				return opening;
+			}
+		}
+	}
+
+	// Score of a search for the PGN comments (white or black point of view : the side which searched)
+	std::string formatScore(int score)
+	{
+		char text[32];
+		if (std::abs(score) >= engine::SCORE_MATE_IN_MAX_PLY)
+		{
+			const int plies = engine::SCORE_MATE - std::abs(score);
+			std::snprintf(text, sizeof(text), "%sM%d", score > 0 ? "+" : "-", (plies + 1) / 2);
+		}
+		else
+		{
+			std::snprintf(text, sizeof(text), "%+.2f", score / 100.0);
+		}
+		return text;
+	}
+
+	// Searches and tables of a worker thread, reused from game to game
+	struct Worker {
+		std::unique_ptr<engine::TranspositionTable> tables[2];
+		std::unique_ptr<engine::Search> searches[2];
+
+		explicit Worker(const EngineConfig* configs)
+		{
+			for (int i = 0; i < 2; i++)
+			{
+				this->tables[i] = std::make_unique<engine::TranspositionTable>(configs[i].hashMb);
+				this->searches[i] = std::make_unique<engine::Search>(*this->tables[i]);
+				this->searches[i]->setNetwork(configs[i].network);
+			}
+		}
+	};
+
+	// Play a game, the first engine playing white if firstIsWhite. An aborted game is not finished (stop raised)
+	GameRecord playGame(Worker& worker, const EngineConfig* configs, const Opening& opening, bool firstIsWhite,
+						const Adjudication& rules, const std::atomic<bool>& stop)
+	{
+		GameRecord record;
+		engine::GameState game;
+		game.setFromFen(opening.fen);
+
+		for (int i = 0; i < 2; i++)
+		{
+			worker.tables[i]->clear();
+			worker.searches[i]->clear();
+		}
+
+		// Opening moves, written as book moves
+		std::string movetext;
+		auto appendMove = [&](engine::Move move, const std::string& comment) {
+			const engine::Position& position = game.getPosition();
+			if (position.getSideToMove() == engine::WHITE || record.plies == 0)
+			{
+				movetext += std::to_string(position.getFullmoveNumber())
+						  + (position.getSideToMove() == engine::WHITE ? ". " : "... ");
+			}
+			movetext += engine::toSan(position, move) + " {" + comment + "} ";
+			game.doMove(move);
+			record.plies++;
+		};
+		for (engine::Move move : opening.moves)
+		{
+			appendMove(move, "book");
+		}
+
+		// Clocks, by engine
+		int64_t clocks[2] = {configs[0].timeMs, configs[1].timeMs};
+
+		// Consecutive moves within the draw score, and beyond the resign score by color (positive : white wins)
+		int drawMoves = 0;
+		int resignMoves[2] = {0, 0};
+
+		while (true)
+		{
+			const engine::Position& position = game.getPosition();
+			engine::MoveList moves;
+			engine::generateLegalMoves(position, moves);
+			const engine::Color us = position.getSideToMove();
+			if (moves.empty())
+			{
+				if (position.getCheckers())
+				{
+					record.outcome = (us == engine::WHITE) ? Outcome::BLACK_WINS : Outcome::WHITE_WINS;
+					record.reason = std::string(us == engine::WHITE ? "Black" : "White") + " mates";
+				}
+				else
+				{
+					record.outcome = Outcome::DRAW;
+					record.reason = "Draw by stalemate";
+				}
+				record.termination = "normal";
+				break;
+			}
+			if (game.isThreefoldRepetition() || game.isFiftyMoveDraw() || game.isInsufficientMaterial())
+			{
+				record.outcome = Outcome::DRAW;
+				record.reason = game.isThreefoldRepetition() ? "Draw by 3-fold repetition"
+							  : game.isFiftyMoveDraw() ? "Draw by fifty moves rule" : "Draw by insufficient mating material";
+				record.termination = "normal";
+				break;
+			}
+			if (record.plies >= rules.maxPlies)
+			{
+				record.outcome = Outcome::DRAW;
+				record.reason = "Draw by maximum game length";
+				record.termination = "adjudication";
+				break;
+			}
+			if (stop.load(std::memory_order_relaxed))
+			{
+				record.outcome = Outcome::ABORTED;
+				return record;
+			}
+
+			const int engineIndex = ((us == engine::WHITE) == firstIsWhite) ? 0 : 1;
+			const EngineConfig& config = configs[engineIndex];
+			engine::SearchLimits limits;
+			limits.depth = config.depth;
+			limits.nodes = config.nodes;
+			if (config.timeMs > 0)
+			{
+				limits.moveTimeMs = engine::allocateMoveTime(clocks[engineIndex], config.incrementMs, 0, MOVE_OVERHEAD_MS);
+			}
+
+			const auto start = std::chrono::steady_clock::now();
+			const engine::SearchResult result = worker.searches[engineIndex]->run(game, limits);
+			const int64_t elapsedMs = std::chrono::duration_cast<std::chrono::milliseconds>(
+				std::chrono::steady_clock::now() - start).count();
+
+			if (config.timeMs > 0)
+			{
+				clocks[engineIndex] -= elapsedMs;
+				if (clocks[engineIndex] < 0)
+				{
+					record.outcome = (us == engine::WHITE) ? Outcome::BLACK_WINS : Outcome::WHITE_WINS;
+					record.reason = std::string(us == engine::WHITE ? "White" : "Black") + " loses on time";
+					record.termination = "time forfeit";
+					break;
+				}
+				clocks[engineIndex] += config.incrementMs;
+			}
+			if (result.bestMove.isNull() || !moves.contains(result.bestMove))
+			{
+				record.outcome = (us == engine::WHITE) ? Outcome::BLACK_WINS : Outcome::WHITE_WINS;
+				record.reason = std::string(us == engine::WHITE ? "White" : "Black") + " makes an illegal move";
+				record.termination = "rules infraction";
+				break;
+			}
+
+			char timeText[32];
+			std::snprintf(timeText, sizeof(timeText), " %.3fs", elapsedMs / 1000.0);
+			appendMove(result.bestMove, formatScore(result.score) + "/" + std::to_string(result.depth) + timeText);
+
+			// Adjudication on the scores of both engines (white point of view for the resignation)
+			const int whiteScore = (us == engine::WHITE) ? result.score : -result.score;
+			drawMoves = (std::abs(result.score) <= rules.drawScore) ? drawMoves + 1 : 0;
+			resignMoves[0] = (whiteScore >= rules.resignScore) ? resignMoves[0] + 1 : 0;
+			resignMoves[1] = (whiteScore <= -rules.resignScore) ? resignMoves[1] + 1 : 0;
+			if (rules.drawMoveCount > 0 && game.getPosition().getFullmoveNumber() > rules.drawMoveNumber
+				&& drawMoves >= 2 * rules.drawMoveCount)
+			{
+				record.outcome = Outcome::DRAW;
+				record.reason = "Draw by adjudication";
+				record.termination = "adjudication";
+				break;
+			}
+			if (rules.resignMoveCount > 0 && (resignMoves[0] >= 2 * rules.resignMoveCount || resignMoves[1] >= 2 * rules.resignMoveCount))
+			{
+				const bool whiteWins = resignMoves[0] >= 2 * rules.resignMoveCount;
+				record.outcome = whiteWins ? Outcome::WHITE_WINS : Outcome::BLACK_WINS;
+				record.reason = std::string(whiteWins ? "Black" : "White") + " resigns";
+				record.termination = "adjudication";
+				break;
+			}
+		}
+
+		record.movetext = std::move(movetext);
+		return record;
+	}
+
+	// PGN text of a game
+	std::string formatPgn(const GameRecord& record, const EngineConfig* configs, const Opening& opening, bool firstIsWhite,
+						  uint64_t round, const std::string& date)
+	{
+		const char* result = (record.outcome == Outcome::WHITE_WINS) ? "1-0" : (record.outcome == Outcome::BLACK_WINS) ? "0-1" : "1/2-1/2";
+		const EngineConfig& white = configs[firstIsWhite ? 0 : 1];
+		const EngineConfig& black = configs[firstIsWhite ? 1 : 0];
+		std::string text = "[Event \"Engine match\"]\n[Site \"match\"]\n[Date \"" + date + "\"]\n[Round \"" + std::to_string(round)
+						 + "\"]\n[White \"" + white.name + "\"]\n[Black \"" + black.name + "\"]\n[Result \"" + result + "\"]\n";
+		if (opening.fen != engine::Position::startFen)
+		{
+			text += "[FEN \"" + opening.fen + "\"]\n[SetUp \"1\"]\n";
+		}
+		text += "[PlyCount \"" + std::to_string(record.plies) + "\"]\n[Termination \"" + record.termination + "\"]\n";
+		const std::string whiteControl = timeControlTag(white);
+		const std::string blackControl = timeControlTag(black);
+		if (whiteControl == blackControl)
+		{
+			text += "[TimeControl \"" + whiteControl + "\"]\n";
+		}
+		else
+		{
+			text += "[WhiteTimeControl \"" + whiteControl + "\"]\n[BlackTimeControl \"" + blackControl + "\"]\n";
+		}
+
+		// Movetext wrapped at 80 columns, the comments kept on one line
+		text += "\n";
+		size_t column = 0;
+		std::istringstream tokens(record.movetext + "{" + record.reason + "} " + result);
+		std::string token;
+		std::string item;
+		while (tokens >> token)
+		{
+			item += (item.empty() ? "" : " ") + token;
+			if (item.front() == '{' && item.back() != '}')
+			{
+				continue;
+			}
+			if (column > 0 && column + 1 + item.size() > 80)
+			{
+				text += "\n";
+				column = 0;
+			}
+			text += (column > 0 ? " " : "") + item;
+			column += (column > 0 ? 1 : 0) + item.size();
+			item.clear();
+		}
+		return text + "\n\n";
+	}
+
+	// Today's date in the PGN format
+	std::string currentDate()
+	{
+		const std::time_t now = std::time(nullptr);
+		char text[16];
+		std::strftime(text, sizeof(text), "%Y.%m.%d", std::localtime(&now));
+		return text;
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	std::vector<std::string> engineOptions;
+	uint64_t gameCount = 1000;
+	int concurrency = omp_get_max_threads();
+	std::string openingsPath;
+	int openingPlies = 8;
+	int randomPlies = 8;
+	std::string pgnPath;
+	Adjudication rules;
+	Sprt sprt;
+	double statusSeconds = 10.0;
+
+	for (int i = 1; i < argc; i++)
+	{
+		std::string option = argv[i];
+		if (i + 1 < argc && option == "--engine")
+		{
+			engineOptions.push_back(argv[++i]);
+		}
+		else if (i + 1 < argc && option == "--games")
+		{
+			gameCount = static_cast<uint64_t>(std::max(std::stoll(argv[++i]), 1LL));
+		}
+		else if (i + 1 < argc && option == "--concurrency")
+		{
+			concurrency = std::max(std::stoi(argv[++i]), 1);
+		}
+		else if (i + 1 < argc && option == "--openings")
+		{
+			openingsPath = argv[++i];
+		}
+		else if (i + 1 < argc && option == "--opening-plies")
+		{
+			openingPlies = std::max(std::stoi(argv[++i]), 0);
+		}
+		else if (i + 1 < argc && option == "--random-plies")
+		{
+			randomPlies = std::max(std::stoi(argv[++i]), 0);
+		}
+		else if (i + 1 < argc && option == "--pgn")
+		{
+			pgnPath = argv[++i];
+		}
+		else if (i + 1 < argc && option == "--draw-movenumber")
+		{
+			rules.drawMoveNumber = std::max(std::stoi(argv[++i]), 0);
+		}
+		else if (i + 1 < argc && option == "--draw-movecount")
+		{
+			rules.drawMoveCount = std::max(std::stoi(argv[++i]), 0);
+		}
+		else if (i + 1 < argc && option == "--draw-score")
+		{
+			rules.drawScore = std::max(std::stoi(argv[++i]), 0);
+		}
+		else if (i + 1 < argc && option == "--resign-movecount")
+		{
+			rules.resignMoveCount = std::max(std::stoi(argv[++i]), 0);
+		}
+		else if (i + 1 < argc && option == "--resign-score")
+		{
+			rules.resignScore = std::max(std::stoi(argv[++i]), 1);
+		}
+		else if (i + 1 < argc && option == "--max-plies")
+		{
+			rules.maxPlies = std::max(std::stoi(argv[++i]), 1);
+		}
+		else if (i + 2 < argc && option == "--sprt")
+		{
+			sprt.elo0 = std::stod(argv[++i]);
+			sprt.elo1 = std::stod(argv[++i]);
+		}
+		else if (i + 1 < argc && option == "--alpha")
+		{
+			sprt.alpha = std::clamp(std::stod(argv[++i]), 1e-6, 0.5);
+		}
+		else if (i + 1 < argc && option == "--beta")
+		{
+			sprt.beta = std::clamp(std::stod(argv[++i]), 1e-6, 0.5);
+		}
+		else if (i + 1 < argc && option == "--status")
+		{
+			statusSeconds = std::max(std::stod(argv[++i]), 0.1);
+		}
+		else
+		{
+			std::cerr << "Unknown option " << option << std::endl;
+			return 1;
+		}
+	}
+
+	if (engineOptions.size() != 2)
+	{
+		std::cerr << "Usage : match --engine \"name=A tc=10+0.1\" --engine \"name=B depth=8\" [--games <n>] [--concurrency <n>] "
+				  << "[--openings <file>] [--pgn <file>] [--sprt <elo0> <elo1>] (see the header of match.cpp)" << std::endl;
+		return 1;
+	}
+	if (sprt.elo1 <= sprt.elo0)
+	{
+		std::cerr << "Error: the SPRT needs elo0 < elo1" << std::endl;
+		return 1;
+	}
+
+	engine::initAttacks();
+
+	// Engines, the networks loaded once and shared by the workers (read only)
+	EngineConfig configs[2];
+	std::map<std::string, std::unique_ptr<engine::Network>> networks;
+	for (int i = 0; i < 2; i++)
+	{
+		configs[i].name = "engine" + std::to_string(i + 1);
+		if (!parseEngine(engineOptions[static_cast<size_t>(i)], configs[i]))
+		{
+			return 1;
+		}
+		if (!configs[i].evalPath.empty())
+		{
+			std::unique_ptr<engine::Network>& network = networks[configs[i].evalPath];
+			if (!network)
+			{
+				network = std::make_unique<engine::Network>();
+				if (!network->load(configs[i].evalPath))
+				{
+					return 1;
+				}
+			}
+			configs[i].network = network.get();
+		}
+	}
+	if (configs[0].name == configs[1].name)
+	{
+		configs[1].name += "-2";
+	}
+
+	// Openings, each played with both colors
+	std::vector<Opening> openings;
+	if (!openingsPath.empty() && !loadOpenings(openingsPath, openingPlies, openings))
+	{
+		return 1;
+	}
+	const uint64_t pairCount = (gameCount + 1) / 2;
+	if (openings.empty())
+	{
+		openings.reserve(pairCount);
+		for (uint64_t pair = 0; pair < pairCount; pair++)
+		{
+			openings.push_back(randomOpening(pair, randomPlies));
+		}
+	}
+
+	std::FILE* pgnFile = nullptr;
+	if (!pgnPath.empty())
+	{
+		pgnFile = std::fopen(pgnPath.c_str(), "wb");
+		if (!pgnFile)
+		{
+			std::cerr << "Error: cannot write " << pgnPath << std::endl;
+			return 1;
+		}
+	}
+
+	concurrency = static_cast<int>(std::min<uint64_t>(static_cast<uint64_t>(concurrency), gameCount));
+	std::cout << configs[0].name << " vs " << configs[1].name << " : " << gameCount << " games at most, " << concurrency
+			  << " at a time, " << openings.size() << " openings, SPRT elo0 " << sprt.elo0 << " elo1 " << sprt.elo1
+			  << " alpha " << sprt.alpha << " beta " << sprt.beta << std::endl;
+
+	std::vector<std::unique_ptr<Worker>> workers;
+	for (int i = 0; i < concurrency; i++)
+	{
+		workers.push_back(std::make_unique<Worker>(configs));
+	}
+
+	Tally tally;
+	std::mutex tallyMutex;
+	std::atomic<bool> stop{false};
+	const std::string date = currentDate();
+	const auto start = std::chrono::steady_clock::now();
+	auto elapsedMinutes = [&start]() {
+		return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() / 60.0;
+	};
+
+	// Progress line, every few seconds
+	engine::ProgressMonitor monitor(statusSeconds, [&]() {
+		std::lock_guard<std::mutex> lock(tallyMutex);
+		std::cout << formatStatus(tally, sprt, elapsedMinutes()) << std::endl;
+	});
+
+	// The next game goes to the first free worker
+	#pragma omp parallel for schedule(dynamic, 1) num_threads(concurrency)
+	for (int64_t index = 0; index < static_cast<int64_t>(gameCount); index++)
+	{
+		if (stop.load(std::memory_order_relaxed))
+		{
+			continue;
+		}
+		Worker& worker = *workers[static_cast<size_t>(omp_get_thread_num())];
+		const uint64_t pair = static_cast<uint64_t>(index) / 2;
+		const Opening& opening = openings[pair % openings.size()];
+		const bool firstIsWhite = (index % 2) == 0;
+		const GameRecord record = playGame(worker, configs, opening, firstIsWhite, rules, stop);
+		if (record.outcome == Outcome::ABORTED)
+		{
+			continue;
+		}
+
+		// Points x 2 of the first engine
+		const bool whiteWins = record.outcome == Outcome::WHITE_WINS;
+		const int points = (record.outcome == Outcome::DRAW) ? 1 : (whiteWins == firstIsWhite) ? 2 : 0;
+		const std::string pgn = pgnFile ? formatPgn(record, configs, opening, firstIsWhite, static_cast<uint64_t>(index) + 1, date) : "";
+
+		std::lock_guard<std::mutex> lock(tallyMutex);
+		tally.wins += (points == 2) ? 1 : 0;
+		tally.draws += (points == 1) ? 1 : 0;
+		tally.losses += (points == 0) ? 1 : 0;
+		tally.errors += (record.termination == "rules infraction") ? 1 : 0;
+		auto pending = tally.pendingPairs.find(static_cast<int>(pair));
+		if (pending == tally.pendingPairs.end())
+		{
+			tally.pendingPairs[static_cast<int>(pair)] = points;
+		}
+		else
+		{
+			tally.pentanomial[pending->second + points]++;
+			tally.pendingPairs.erase(pending);
+			const double llr = logLikelihoodRatio(tally, sprt);
+			if (llr <= sprt.lowerBound() || llr >= sprt.upperBound())
+			{
+				stop.store(true, std::memory_order_relaxed);
+			}
+		}
+		if (pgnFile)
+		{
+			std::fwrite(pgn.data(), 1, pgn.size(), pgnFile);
+		}
+	}
+
+	monitor.stop();
+
+	if (pgnFile && std::fclose(pgnFile) != 0)
+	{
+		std::cerr << "Error: cannot write " << pgnPath << std::endl;
+		return 1;
+	}
+
+	const double llr = logLikelihoodRatio(tally, sprt);
+	std::cout << formatStatus(tally, sprt, elapsedMinutes()) << std::endl;
+	std::cout << "Pairs (0, 0.5, 1, 1.5, 2 points) : " << tally.pentanomial[0] << " " << tally.pentanomial[1] << " "
+			  << tally.pentanomial[2] << " " << tally.pentanomial[3] << " " << tally.pentanomial[4] << std::endl;
+	std::cout << "SPRT : " << (llr >= sprt.upperBound() ? "H1 accepted" : llr <= sprt.lowerBound() ? "H0 accepted" : "inconclusive")
+			  << std::endl;
+	if (tally.errors > 0)
+	{
+		std::cerr << "Error: " << tally.errors << " games lost by an illegal move" << std::endl;
+		return 1;
+	}
+	return 0;
+}
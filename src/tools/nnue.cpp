@@ -0,0 +1,257 @@
+/**
+ * @author obiwan138
+ * @file nnue.cpp
+ * @brief Network file generator, bit-exactness check and speed benchmark of the NNUE kernels (headless)
+ * @details Usage :
+ *   nnue --generate <file> [--seed <n>]      write a network of random weights (no chess knowledge : tests, benchmarks)
+ *   nnue <file>                              check then benchmark the kernels of every instruction set of the processor
+ *   nnue <file> --games <n>                  number of random games played from the bench positions (default : 200)
+ *   nnue <file> --repeat <n>                 passes over the games for the benchmark (default : 5)
+ * The check evaluates every position of the games incrementally (accumulators updated move by move) and from scratch,
+ * with each instruction set, and fails (exit code 1) if any evaluation differs from the scalar incremental one. The
+ * benchmark then reports the evaluations per second of each instruction set, incremental and from scratch, and their
+ * speedup over the scalar kernels.
+ */
+
+// Include standard headers
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Include project header files
+#include "engine/Attacks.hpp"
+#include "engine/Bench.hpp"
+#include "engine/MoveGen.hpp"
+#include "engine/Network.hpp"
+#include "engine/NnueAccumulator.hpp"
+#include "engine/NnueKernels.hpp"
+#include "engine/Position.hpp"
+
+namespace{
+
+	// Plies of a random game (below the size of the accumulator stack)
+	const int MAX_GAME_PLIES = 120;
+
+	// Positions of a game and the moves between them
+	struct Game {
+		std::vector<engine::Position> positions;
+		std::vector<engine::Move> moves;
+	};
+
+	// Random games from the bench positions (same games for every instruction set)
+	std::vector<Game> playGames(int gameCount)
+	{
+		uint64_t state = 0x2545F4914F6CDD1Dull;
+		auto next = [&state]() {
+			state ^= state >> 12;
+			state ^= state << 25;
+			state ^= state >> 27;
+			return state * 0x2545F4914F6CDD1Dull;
+		};
+
+		std::vector<Game> games(gameCount);
+		for (int g = 0; g < gameCount; g++)
+		{
+			engine::Position position;
+			position.setFromFen(engine::benchPositions[g % engine::benchPositionCount]);
+			games[g].positions.push_back(position);
+
+			for (int ply = 0; ply < MAX_GAME_PLIES; ply++)
+			{
+				engine::MoveList moves;
+				engine::generateLegalMoves(position, moves);
+				if (moves.empty())
+				{
+					break;
+				}
+				const engine::Move move = moves[static_cast<int>(next() % moves.size())];
+				position.doMove(move);
+				games[g].moves.push_back(move);
+				games[g].positions.push_back(position);
+			}
+		}
+		return games;
+	}
+
+	// Evaluate every position of the games, incrementally or from scratch
+	void evaluateGames(const std::vector<Game>& games, const engine::Network& network, engine::NnueAccumulator& accumulator,
+					   bool incremental, std::vector<int>* scores)
+	{
+		for (const Game& game : games)
+		{
+			accumulator.reset();
+			int score = accumulator.evaluate(game.positions[0], network);
+			if (scores)
+			{
+				scores->push_back(score);
+			}
+
+			for (size_t i = 0; i < game.moves.size(); i++)
+			{
+				if (incremental)
+				{
+					accumulator.push(game.positions[i], game.moves[i]);
+				}
+				else
+				{
+					accumulator.reset();
+				}
+				score = accumulator.evaluate(game.positions[i + 1], network);
+				if (scores)
+				{
+					scores->push_back(score);
+				}
+			}
+		}
+	}
+
+	// Evaluations per second of a pass over the games, repeated
+	double measure(const std::vector<Game>& games, const engine::Network& network, engine::NnueAccumulator& accumulator,
+				   bool incremental, int repeat, size_t evaluationCount)
+	{
+		const auto start = std::chrono::steady_clock::now();
+		for (int r = 0; r < repeat; r++)
+		{
+			evaluateGames(games, network, accumulator, incremental, nullptr);
+		}
+		const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		return static_cast<double>(evaluationCount) * repeat / std::max(seconds, 1e-9);
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	std::string path;
+	std::string generatePath;
+	uint64_t seed = 1;
+	int gameCount = 200;
+	int repeat = 5;
+
+	for (int i = 1; i < argc; i++)
+	{
+		std::string option = argv[i];
+		if (i + 1 < argc && option == "--generate")
+		{
+			generatePath = argv[++i];
+		}
+		else if (i + 1 < argc && option == "--seed")
+		{
+			seed = std::stoull(argv[++i]);
+		}
+		else if (i + 1 < argc && option == "--games")
+		{
+			gameCount = std::max(std::stoi(argv[++i]), 1);
+		}
+		else if (i + 1 < argc && option == "--repeat")
+		{
+			repeat = std::max(std::stoi(argv[++i]), 1);
+		}
+		else if (option.rfind("--", 0) != 0 && path.empty())
+		{
+			path = option;
+		}
+		else
+		{
+			std::cerr << "Unknown option " << option << std::endl;
+			return 1;
+		}
+	}
+
+	if (!generatePath.empty())
+	{
+		if (!engine::Network::writeRandom(generatePath, seed))
+		{
+			return 1;
+		}
+		std::cout << "Random network written to " << generatePath << " (" << engine::Network::getFileSize() << " bytes, seed "
+				  << seed << ")" << std::endl;
+		return 0;
+	}
+
+	if (path.empty())
+	{
+		std::cerr << "Usage : nnue <file> [--games <n>] [--repeat <n>] or nnue --generate <file> [--seed <n>]" << std::endl;
+		return 1;
+	}
+
+	engine::initAttacks();
+	engine::Network network;
+	if (!network.load(path))
+	{
+		return 1;
+	}
+
+	const std::vector<Game> games = playGames(gameCount);
+	std::unique_ptr<engine::NnueAccumulator> accumulator = std::make_unique<engine::NnueAccumulator>();
+
+	// Bit-exactness : every instruction set, incremental and from scratch, against the scalar incremental evaluations
+	std::vector<engine::SimdLevel> levels;
+	for (int level = engine::SIMD_SCALAR; level < engine::SIMD_LEVEL_NB; level++)
+	{
+		if (engine::isSimdLevelSupported(static_cast<engine::SimdLevel>(level)))
+		{
+			levels.push_back(static_cast<engine::SimdLevel>(level));
+		}
+	}
+
+	std::vector<int> reference;
+	network.setSimdLevel(engine::SIMD_SCALAR);
+	evaluateGames(games, network, *accumulator, true, &reference);
+
+	bool exact = true;
+	for (engine::SimdLevel level : levels)
+	{
+		network.setSimdLevel(level);
+		for (bool incremental : {true, false})
+		{
+			std::vector<int> scores;
+			evaluateGames(games, network, *accumulator, incremental, &scores);
+
+			size_t mismatches = 0;
+			for (size_t i = 0; i < scores.size(); i++)
+			{
+				mismatches += (scores[i] != reference[i]) ? 1 : 0;
+			}
+			std::cout << std::setw(8) << network.getKernels().name << (incremental ? " incremental : " : " refresh     : ")
+					  << (mismatches == 0 ? "OK" : "FAILED") << " (" << scores.size() << " evaluations, " << mismatches
+					  << " mismatches)" << std::endl;
+			exact = exact && mismatches == 0;
+		}
+	}
+	if (!exact)
+	{
+		return 1;
+	}
+
+	// Speed
+	std::cout << std::endl << std::setw(8) << "kernels" << std::setw(18) << "incremental (/s)" << std::setw(10) << "speedup"
+			  << std::setw(18) << "refresh (/s)" << std::setw(10) << "speedup" << std::endl;
+
+	double scalarIncremental = 0.0;
+	double scalarRefresh = 0.0;
+	for (engine::SimdLevel level : levels)
+	{
+		network.setSimdLevel(level);
+		const double incremental = measure(games, network, *accumulator, true, repeat, reference.size());
+		const double refresh = measure(games, network, *accumulator, false, repeat, reference.size());
+		if (level == engine::SIMD_SCALAR)
+		{
+			scalarIncremental = incremental;
+			scalarRefresh = refresh;
+		}
+
+		std::cout << std::fixed << std::setprecision(0)
+				  << std::setw(8) << network.getKernels().name
+				  << std::setw(18) << incremental
+				  << std::setw(10) << std::setprecision(2) << incremental / scalarIncremental
+				  << std::setw(18) << std::setprecision(0) << refresh
+				  << std::setw(10) << std::setprecision(2) << refresh / scalarRefresh << std::endl;
+	}
+
+	return 0;
+}
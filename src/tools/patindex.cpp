@@ -0,0 +1,273 @@
+/**
+ * @author obiwan138
+ * @file patindex.cpp
+ * @brief Builder and query tool of the material and pawn structure index of a game archive (headless)
+ * @details Usage :
+ *   patindex build <archive> -o <index>       index the material signatures and pawn structures of the games
+ *   patindex build ... --threads <n>          threads of the decoding (default : all the cores)
+ *   patindex build ... --memory <MiB>         memory of the pairs (key, game) before spilling a run (default : 1024)
+ *   patindex query <index> <archive> "<query>"   games with a position matching a query (numbers from 1), for example
+ *                                             "KRPvKR & (pawns:8/5k2/8/4P3/8/8/8/8 | KRvKR)" : the games reaching
+ *                                             each key at some ply are found in the index, then replayed from the
+ *                                             archive to keep those with one position matching the whole query
+ *   patindex query ... --max <n>              number of games listed (default : 20)
+ *   patindex query ... --threads <n>          threads of the replay (default : all the cores)
+ *   patindex bench <index> <archive>          combined queries of random positions of the archive (ms/query, p99) ;
+ *                                             every game must match the queries built from its positions
+ */
+
+// Include standard headers
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <omp.h>
+#include <string>
+#include <vector>
+
+// Include project header files
+#include "engine/Attacks.hpp"
+#include "engine/GameArchive.hpp"
+#include "engine/PatternIndex.hpp"
+#include "engine/Position.hpp"
+#include "engine/RoaringBitmap.hpp"
+
+namespace{
+
+	// Queries of the benchmark
+	const int RANDOM_QUERIES = 2000;
+
+	int build(const std::string& archivePath, const std::string& indexPath, int threads, size_t memoryMiB)
+	{
+		engine::GameArchive archive;
+		if (!archive.open(archivePath))
+		{
+			return 1;
+		}
+
+		const auto start = std::chrono::steady_clock::now();
+		if (!engine::PatternIndex::build(archive, indexPath, threads, memoryMiB, &std::cout))
+		{
+			return 1;
+		}
+		const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		std::cout << archive.getGameCount() << " games indexed in " << std::fixed << std::setprecision(1) << seconds << " s ("
+				  << threads << " threads)" << std::endl;
+		return 0;
+	}
+
+	int query(const std::string& indexPath, const std::string& archivePath, const std::string& expression, uint64_t maxGames,
+			  int threads)
+	{
+		engine::PatternIndex index;
+		engine::GameArchive archive;
+		if (!index.open(indexPath) || !archive.open(archivePath))
+		{
+			return 1;
+		}
+
+		engine::RoaringBitmap games;
+		std::string error;
+		const auto start = std::chrono::steady_clock::now();
+		if (!index.query(expression, archive, games, error, threads))
+		{
+			std::cerr << "Error: " << error << std::endl;
+			return 1;
+		}
+		const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+		std::vector<uint32_t> numbers;
+		games.toVector(numbers, maxGames);
+		std::cout << games.getCardinality() << " games (" << std::fixed << std::setprecision(2) << seconds * 1e3 << " ms)";
+		for (uint32_t game : numbers)
+		{
+			std::cout << " " << game + 1;
+		}
+		std::cout << (games.getCardinality() > numbers.size() ? " ..." : "") << std::endl;
+		return 0;
+	}
+
+	int bench(const std::string& indexPath, const std::string& archivePath, int threads)
+	{
+		engine::PatternIndex index;
+		engine::GameArchive archive;
+		if (!index.open(indexPath) || !archive.open(archivePath))
+		{
+			return 1;
+		}
+		const uint64_t gameCount = archive.getGameCount();
+		if (gameCount == 0 || index.getGameCount() != gameCount)
+		{
+			std::cerr << "Error: " << indexPath << " is not the index of " << archivePath << std::endl;
+			return 1;
+		}
+
+		// Queries of random positions of random games : (their material | the material of another position) & their pawns
+		struct Query {
+			std::string expression;
+			uint32_t game;
+		};
+		std::vector<Query> queries;
+		uint64_t state = 0x2545F4914F6CDD1Dull;
+		auto next = [&]()
+		{
+			state ^= state >> 12;
+			state ^= state << 25;
+			state ^= state >> 27;
+			return state * 0x2545F4914F6CDD1Dull;
+		};
+		engine::Position position;
+		std::vector<engine::Move> moves;
+		std::string otherMaterial = "KvK";
+		while (queries.size() < static_cast<size_t>(RANDOM_QUERIES))
+		{
+			const uint64_t game = next() % gameCount;
+			if (!archive.readGame(game, position, moves))
+			{
+				std::cerr << "Error: game " << game + 1 << " could not be decoded" << std::endl;
+				return 1;
+			}
+			archive.readStartPosition(game, position);
+			const size_t ply = next() % (moves.size() + 1);
+			for (size_t i = 0; i < ply; i++)
+			{
+				position.doMove(moves[i]);
+			}
+			const std::string fen = position.toFen();
+			const std::string material = engine::PatternIndex::materialName(engine::PatternIndex::materialKey(position));
+			queries.push_back({"(" + material + " | " + otherMaterial + ") & pawns:" + fen.substr(0, fen.find(' ')),
+							   static_cast<uint32_t>(game)});
+			otherMaterial = material;
+		}
+
+		// The index alone gives the candidates, the replay of the candidates the games with a matching position
+		std::vector<double> latencies;
+		latencies.reserve(queries.size());
+		engine::RoaringBitmap games;
+		std::string error;
+		uint64_t candidateTotal = 0;
+		uint64_t total = 0;
+		uint64_t missing = 0;
+		double replaySeconds = 0.0;
+		for (const Query& query : queries)
+		{
+			auto start = std::chrono::steady_clock::now();
+			if (!index.candidates(query.expression, games, error))
+			{
+				std::cerr << "Error: " << error << " in " << query.expression << std::endl;
+				return 1;
+			}
+			latencies.push_back(std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+			candidateTotal += games.getCardinality();
+
+			start = std::chrono::steady_clock::now();
+			if (!index.query(query.expression, archive, games, error, threads))
+			{
+				std::cerr << "Error: " << error << " in " << query.expression << std::endl;
+				return 1;
+			}
+			replaySeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+			total += games.getCardinality();
+			missing += games.contains(query.game) ? 0 : 1;
+		}
+
+		// Material only : the largest bitmaps (the unions of the frequent signatures)
+		double broadSeconds = 0.0;
+		uint64_t broadTotal = 0;
+		const int broadQueries = std::min<int>(RANDOM_QUERIES, 200);
+		for (int i = 0; i < broadQueries; i++)
+		{
+			const std::string& expression = queries[static_cast<size_t>(i)].expression;
+			const std::string materials = expression.substr(0, expression.find(')') + 1);
+			const auto start = std::chrono::steady_clock::now();
+			index.candidates(materials + " | KQvKQ | KRvKR", games, error);
+			broadSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+			broadTotal += games.getCardinality();
+		}
+
+		double sum = 0.0;
+		for (double latency : latencies)
+		{
+			sum += latency;
+		}
+		std::sort(latencies.begin(), latencies.end());
+		std::cout << indexPath << " : " << gameCount << " games, " << index.getKeyCount() << " keys" << std::endl;
+		std::cout << "material & pawns  " << std::fixed << std::setprecision(3) << sum * 1e3 / latencies.size() << " ms on average, p99 "
+				  << latencies[latencies.size() * 99 / 100] * 1e3 << " ms (" << std::setprecision(1)
+				  << static_cast<double>(candidateTotal) / queries.size() << " candidate games per query on average)" << std::endl;
+		std::cout << "with the replay   " << std::setprecision(3) << replaySeconds * 1e3 / queries.size() << " ms on average ("
+				  << std::setprecision(1) << static_cast<double>(total) / queries.size() << " games per query on average, "
+				  << threads << " threads)" << std::endl;
+		std::cout << "material unions   " << std::setprecision(3) << broadSeconds * 1e3 / broadQueries << " ms on average ("
+				  << std::setprecision(1) << static_cast<double>(broadTotal) / broadQueries << " games per query on average)" << std::endl;
+		std::cout << "Verification : " << (missing == 0 ? "OK" : "FAILED") << " (" << queries.size() << " queries, " << missing
+				  << " games missing)" << std::endl;
+		return missing == 0 ? 0 : 1;
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	if (argc < 2)
+	{
+		std::cerr << "Usage : patindex build <archive> -o <index> [--threads <n>] [--memory <MiB>] | query <index> <archive> "
+				  << "\"<query>\" [--max <n>] [--threads <n>] | bench <index> <archive> [--threads <n>]" << std::endl;
+		return 1;
+	}
+
+	const std::string command = argv[1];
+	std::vector<std::string> inputs;
+	std::string outputPath;
+	int threads = omp_get_max_threads();
+	size_t memoryMiB = 1024;
+	uint64_t maxGames = 20;
+
+	for (int i = 2; i < argc; i++)
+	{
+		std::string option = argv[i];
+		if (i + 1 < argc && (option == "-o" || option == "--output"))
+		{
+			outputPath = argv[++i];
+		}
+		else if (i + 1 < argc && option == "--threads")
+		{
+			threads = std::max(std::stoi(argv[++i]), 1);
+		}
+		else if (i + 1 < argc && option == "--memory")
+		{
+			memoryMiB = static_cast<size_t>(std::max(std::stoll(argv[++i]), 1LL));
+		}
+		else if (i + 1 < argc && option == "--max")
+		{
+			maxGames = static_cast<uint64_t>(std::max(std::stoll(argv[++i]), 0LL));
+		}
+		else if (option.rfind("-", 0) != 0)
+		{
+			inputs.push_back(option);
+		}
+		else
+		{
+			std::cerr << "Unknown option " << option << std::endl;
+			return 1;
+		}
+	}
+
+	engine::initAttacks();
+
+	if (command == "build" && inputs.size() == 1 && !outputPath.empty())
+	{
+		return build(inputs[0], outputPath, threads, memoryMiB);
+	}
+	if (command == "query" && inputs.size() == 3)
+	{
+		return query(inputs[0], inputs[1], inputs[2], maxGames, threads);
+	}
+	if (command == "bench" && inputs.size() == 2)
+	{
+		return bench(inputs[0], inputs[1], threads);
+	}
+
+	std::cerr << "Unknown command " << command << " (build, query or bench)" << std::endl;
+	return 1;
+}
@@ -0,0 +1,243 @@
+/**
+ * @author obiwan138
+ * @file perft.cpp
+ * @brief Perft correctness suite and benchmark of the move generator (headless, no graphics dependency)
+ * @details Usage :
+ *   perft                                    run the suite of reference positions
+ *   perft --max-nodes <n>                    skip the suite entries with more than n nodes (quick check)
+ *   perft --fen "<fen>" --depth <d>          count a single position
+ *   perft ... --divide                       print the count of each root move (single position only)
+ *   perft ... --hash <MiB>                   use a perft hash table (default : none)
+ *   perft ... --threads <n>                  split the root moves between n threads (default : 1)
+ *   perft ... --unmake                       play the moves with make/unmake (GameState) instead of copy-make
+ * The program returns 1 if a suite entry does not match its reference count.
+ */
+
+// Include standard headers
+#include <chrono>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <string>
+
+// Include project header files
+#include "engine/Attacks.hpp"
+#include "engine/Perft.hpp"
+#include "engine/Position.hpp"
+
+namespace{
+
+	// Reference node counts
+	struct PerftEntry {
+		const char* name;
+		const char* fen;
+		int depth;
+		uint64_t nodes;
+	};
+
+	const PerftEntry perftSuite[] = {
+		// Standard positions
+		{"start",              "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1", 5, 4865609ull},
+		{"start",              "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1", 6, 119060324ull},
+		{"kiwipete",           "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1", 4, 4085603ull},
+		{"kiwipete",           "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1", 5, 193690690ull},
+		{"position 3",         "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1", 6, 11030083ull},
+		{"position 3",         "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1", 7, 178633661ull},
+		{"position 4",         "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1", 5, 15833292ull},
+		{"position 4 mirrored","r2q1rk1/pP1p2pp/Q4n2/bbp1p3/Np6/1B3NBn/pPPP1PPP/R3K2R b KQ - 0 1", 5, 15833292ull},
+		{"position 5",         "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8", 4, 2103487ull},
+		{"position 5",         "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8", 5, 89941194ull},
+		{"position 6",         "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10", 4, 3894594ull},
+		{"position 6",         "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10", 5, 164075551ull},
+
+		// En passant edge cases
+		{"illegal ep (pin)",        "3k4/3p4/8/K1P4r/8/8/8/8 b - - 0 1", 6, 1134888ull},
+		{"illegal ep (diagonal)",   "8/8/4k3/8/2p5/8/B2P2K1/8 w - - 0 1", 6, 1015133ull},
+		{"ep gives check",          "8/8/1k6/2b5/2pP4/8/5K2/8 b - d3 0 1", 6, 1440467ull},
+
+		// Castling edge cases
+		{"short castling check",    "5k2/8/8/8/8/8/8/4K2R w K - 0 1", 6, 661072ull},
+		{"long castling check",     "3k4/8/8/8/8/8/8/R3K3 w Q - 0 1", 6, 803711ull},
+		{"castling rights",         "r3k2r/1b4bq/8/8/8/8/7B/R3K2R w KQkq - 0 1", 4, 1274206ull},
+		{"castling prevented",      "r3k2r/8/3Q4/8/8/5q2/8/R3K2R b KQkq - 0 1", 4, 1720476ull},
+
+		// Promotion edge cases
+		{"promote out of check",    "2K2r2/4P3/8/8/8/8/8/3k4 w - - 0 1", 6, 3821001ull},
+		{"promote to give check",   "4k3/1P6/8/8/8/8/K7/8 w - - 0 1", 6, 217342ull},
+		{"underpromote to check",   "8/P1k5/K7/8/8/8/8/8 w - - 0 1", 6, 92683ull},
+
+		// Checks and mates
+		{"discovered check",        "8/8/1P2K3/8/2n5/1q6/8/5k2 b - - 0 1", 5, 1004658ull},
+		{"self stalemate",          "K1k5/8/P7/8/8/8/8/8 w - - 0 1", 6, 2217ull},
+		{"stalemate and mate",      "8/k1P5/8/1K6/8/8/8/8 w - - 0 1", 7, 567584ull},
+		{"stalemate and mate 2",    "8/8/2k5/5q2/5n2/8/5K2/8 b - - 0 1", 4, 23527ull},
+	};
+
+	/////////////////////////////////////////////////////////////////////////////////////
+	/**
+	 * @brief Count a position and measure the speed
+	 */
+
+	uint64_t timedPerft(const engine::Position& position, int depth, engine::PerftHashTable* table, int threads, bool unmake, double& seconds){
+		auto start = std::chrono::steady_clock::now();
+		uint64_t nodes = 0;
+		if (unmake)
+		{
+			engine::GameState state;
+			state.setPosition(position);
+			nodes = engine::perft(state, depth);
+		}
+		else
+		{
+			nodes = (threads > 1) ? engine::perftParallel(position, depth, table, threads)
+			                      : engine::perft(position, depth, table);
+		}
+		seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		return nodes;
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	/********************************************************************
+	 * Read the command line options
+	 ********************************************************************/
+
+	std::string fen;
+	int depth = 0;
+	bool divide = false;
+	bool unmake = false;
+	size_t hashMb = 0;
+	int threads = 1;
+	uint64_t maxNodes = UINT64_MAX;
+
+	for (int i = 1; i < argc; i++)
+	{
+		std::string option = argv[i];
+		if (i + 1 < argc && option == "--fen")
+		{
+			fen = argv[++i];
+		}
+		else if (i + 1 < argc && option == "--depth")
+		{
+			depth = std::stoi(argv[++i]);
+		}
+		else if (i + 1 < argc && option == "--hash")
+		{
+			hashMb = std::stoul(argv[++i]);
+		}
+		else if (i + 1 < argc && option == "--threads")
+		{
+			threads = std::stoi(argv[++i]);
+		}
+		else if (i + 1 < argc && option == "--max-nodes")
+		{
+			maxNodes = std::stoull(argv[++i]);
+		}
+		else if (option == "--divide")
+		{
+			divide = true;
+		}
+		else if (option == "--unmake")
+		{
+			unmake = true;
+		}
+		else
+		{
+			std::cerr << "Unknown option " << option << std::endl;
+			return 2;
+		}
+	}
+
+	engine::initAttacks();
+	std::cout << "Slider attacks : " << (engine::usesPext() ? "PEXT" : "magic bitboards")
+			  << " | " << (unmake ? "make/unmake" : "copy-make") << " | threads " << threads << " | hash " << hashMb << " MiB" << std::endl;
+
+	std::unique_ptr<engine::PerftHashTable> table;
+	if (hashMb > 0)
+	{
+		table = std::make_unique<engine::PerftHashTable>(hashMb);
+	}
+
+	std::cout << std::fixed << std::setprecision(1);
+
+	/********************************************************************
+	 * Single position
+	 ********************************************************************/
+
+	if (!fen.empty() || depth > 0)
+	{
+		engine::Position position;
+		if (!position.setFromFen(fen.empty() ? engine::Position::startFen : fen))
+		{
+			std::cerr << "Invalid FEN : " << fen << std::endl;
+			return 2;
+		}
+
+		if (divide)
+		{
+			uint64_t total = 0;
+			for (const auto& [move, nodes] : engine::perftDivide(position, depth, table.get()))
+			{
+				std::cout << move.toUci() << ": " << nodes << std::endl;
+				total += nodes;
+			}
+			std::cout << "Total : " << total << std::endl;
+			return 0;
+		}
+
+		double seconds;
+		uint64_t nodes = timedPerft(position, depth, table.get(), threads, unmake, seconds);
+		std::cout << "perft(" << depth << ") = " << nodes << " in " << seconds * 1000.0 << " ms ("
+				  << nodes / std::max(seconds, 1e-9) / 1e6 << " Mnps)" << std::endl;
+		return 0;
+	}
+
+	/********************************************************************
+	 * Reference suite
+	 ********************************************************************/
+
+	int failures = 0;
+	uint64_t totalNodes = 0;
+	double totalSeconds = 0.0;
+
+	for (const PerftEntry& entry : perftSuite)
+	{
+		if (entry.nodes > maxNodes)
+		{
+			continue;
+		}
+
+		engine::Position position;
+		position.setFromFen(entry.fen);
+
+		// The table is emptied so each entry is measured alone
+		if (table)
+		{
+			table->clear();
+		}
+
+		double seconds;
+		uint64_t nodes = timedPerft(position, entry.depth, table.get(), threads, unmake, seconds);
+		bool ok = (nodes == entry.nodes);
+		failures += ok ? 0 : 1;
+		totalNodes += nodes;
+		totalSeconds += seconds;
+
+		std::cout << (ok ? "[ OK ] " : "[FAIL] ") << std::left << std::setw(24) << entry.name << std::right
+				  << " depth " << entry.depth << " : " << std::setw(10) << nodes;
+		if (!ok)
+		{
+			std::cout << " (expected " << entry.nodes << ")";
+		}
+		std::cout << "  " << std::setw(8) << seconds * 1000.0 << " ms  "
+				  << std::setw(7) << nodes / std::max(seconds, 1e-9) / 1e6 << " Mnps" << std::endl;
+	}
+
+	std::cout << "Total : " << totalNodes << " nodes in " << totalSeconds << " s ("
+			  << totalNodes / std::max(totalSeconds, 1e-9) / 1e6 << " Mnps), "
+			  << failures << " failure(s)" << std::endl;
+
+	return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,246 @@
+/**
+ * @author obiwan138
+ * @file pgnbench.cpp
+ * @brief Speed benchmark of the PGN reader (headless)
+ * @details Usage :
+ *   pgnbench --generate <file> [--games <n>] [--seed <n>]   write random legal games with clock comments (default : 100000)
+ *   pgnbench <file>                                         read then replay the games of the file on all the cores
+ *   pgnbench <file> --threads <n>                           number of threads (the file is split at game boundaries)
+ *   pgnbench <file> --parse-only                            tokenize the games without resolving the moves
+ * The reading reports the games per second and the MB/s of the tokenizer alone, then of the tokenizer with the SAN
+ * moves resolved against the move generator and played. The first pass also loads the file into the page cache : run
+ * the benchmark twice to measure a file already in memory. The exit code is 1 if a game cannot be replayed, so the
+ * generated files test the SAN writer and parser.
+ */
+
+// Include standard headers
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <iomanip>
+#include <iostream>
+#include <omp.h>
+#include <string>
+#include <vector>
+
+// Include project header files
+#include "engine/Attacks.hpp"
+#include "engine/MoveGen.hpp"
+#include "engine/PgnReader.hpp"
+#include "engine/Position.hpp"
+#include "engine/San.hpp"
+
+namespace{
+
+	// Longest generated game [plies]
+	const int MAX_GENERATED_PLIES = 160;
+
+	// Totals of a pass over the file
+	struct PassResult {
+		uint64_t games = 0;
+		uint64_t moves = 0;
+		uint64_t errors = 0;		// Games with a move which could not be resolved
+		double seconds = 0.0;
+	};
+
+	// Write random legal games, tagged and commented like the exports of the online databases
+	bool generate(const std::string& path, uint64_t gameCount, uint64_t seed)
+	{
+		std::FILE* file = std::fopen(path.c_str(), "wb");
+		if (!file)
+		{
+			std::cerr << "Error: cannot write " << path << std::endl;
+			return false;
+		}
+
+		uint64_t state = seed * 0x9E3779B97F4A7C15ull + 1;
+		auto next = [&state]() {
+			state ^= state >> 12;
+			state ^= state << 25;
+			state ^= state >> 27;
+			return state * 0x2545F4914F6CDD1Dull;
+		};
+
+		const char* results[] = {"1-0", "0-1", "1/2-1/2"};
+		std::string text;
+		for (uint64_t g = 0; g < gameCount; g++)
+		{
+			engine::Position position;
+			position.setFromFen(engine::Position::startFen);
+
+			// Moves first : the result of a mate or a stalemate goes in the tags
+			std::string movetext;
+			const char* result = results[next() % 3];
+			const int plies = 20 + static_cast<int>(next() % (MAX_GENERATED_PLIES - 20));
+			for (int ply = 0; ply < plies; ply++)
+			{
+				engine::MoveList moves;
+				engine::generateLegalMoves(position, moves);
+				if (moves.empty())
+				{
+					result = position.getCheckers() ? (position.getSideToMove() == engine::WHITE ? "0-1" : "1-0") : "1/2-1/2";
+					break;
+				}
+				const engine::Move move = moves[static_cast<int>(next() % moves.size())];
+				if (ply % 2 == 0)
+				{
+					movetext += std::to_string(ply / 2 + 1) + ". ";
+				}
+				const int clock = 180 - ply / 2;
+				movetext += engine::toSan(position, move) + " { [%clk 0:0" + std::to_string(clock / 60) + ":"
+						  + (clock % 60 < 10 ? "0" : "") + std::to_string(clock % 60) + "] } ";
+				if (ply % 2 == 0 && ply + 1 < plies)
+				{
+					movetext += std::to_string(ply / 2 + 1) + "... ";
+				}
+				position.doMove(move);
+			}
+
+			text = "[Event \"Random game\"]\n[Site \"pgnbench\"]\n[Round \"" + std::to_string(g + 1) + "\"]\n"
+				 + "[White \"Random\"]\n[Black \"Random\"]\n[Result \"" + result + "\"]\n\n" + movetext + result + "\n\n";
+			std::fwrite(text.data(), 1, text.size(), file);
+		}
+
+		return std::fclose(file) == 0;
+	}
+
+	// Read (and replay) the games of each part of the file in parallel
+	PassResult readGames(engine::PgnReader& reader, int threads, bool replay)
+	{
+		const std::vector<size_t> offsets = reader.split(threads);
+		PassResult result;
+		uint64_t games = 0;
+		uint64_t moveCount = 0;
+		uint64_t errors = 0;
+
+		const auto start = std::chrono::steady_clock::now();
+		#pragma omp parallel for schedule(static, 1) num_threads(threads) reduction(+ : games, moveCount, errors)
+		for (int part = 0; part < threads; part++)
+		{
+			engine::PgnReader partReader;
+			partReader.openMemory(reader.getData() + offsets[part], offsets[part + 1] - offsets[part]);
+			engine::Position position;
+			std::vector<engine::Move> moves;
+
+			for (const engine::PgnGame& game : partReader)
+			{
+				games++;
+				moveCount += game.moves.size();
+				if (replay && !game.replay(position, moves))
+				{
+					errors++;
+				}
+			}
+		}
+		result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		result.games = games;
+		result.moves = moveCount;
+		result.errors = errors;
+		return result;
+	}
+
+	void printPass(const char* name, const PassResult& result, size_t bytes)
+	{
+		const double seconds = std::max(result.seconds, 1e-9);
+		std::cout << std::left << std::setw(10) << name << std::right << std::fixed << std::setprecision(3)
+				  << std::setw(10) << result.seconds << " s" << std::setprecision(0)
+				  << std::setw(12) << result.games / seconds << " games/s"
+				  << std::setw(12) << result.moves / seconds << " moves/s" << std::setprecision(1)
+				  << std::setw(10) << bytes / 1e6 / seconds << " MB/s" << std::endl;
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	std::string path;
+	std::string generatePath;
+	uint64_t gameCount = 100000;
+	uint64_t seed = 1;
+	int threads = omp_get_max_threads();
+	bool parseOnly = false;
+
+	for (int i = 1; i < argc; i++)
+	{
+		std::string option = argv[i];
+		if (i + 1 < argc && option == "--generate")
+		{
+			generatePath = argv[++i];
+		}
+		else if (i + 1 < argc && option == "--games")
+		{
+			gameCount = std::max<uint64_t>(std::stoull(argv[++i]), 1);
+		}
+		else if (i + 1 < argc && option == "--seed")
+		{
+			seed = std::stoull(argv[++i]);
+		}
+		else if (i + 1 < argc && option == "--threads")
+		{
+			threads = std::max(std::stoi(argv[++i]), 1);
+		}
+		else if (option == "--parse-only")
+		{
+			parseOnly = true;
+		}
+		else if (option.rfind("--", 0) != 0 && path.empty())
+		{
+			path = option;
+		}
+		else
+		{
+			std::cerr << "Unknown option " << option << std::endl;
+			return 1;
+		}
+	}
+
+	engine::initAttacks();
+
+	if (!generatePath.empty())
+	{
+		if (!generate(generatePath, gameCount, seed))
+		{
+			return 1;
+		}
+		std::cout << gameCount << " random games written to " << generatePath << std::endl;
+		return 0;
+	}
+
+	if (path.empty())
+	{
+		std::cerr << "Usage : pgnbench <file> [--threads <n>] [--parse-only] or pgnbench --generate <file> [--games <n>] [--seed <n>]"
+				  << std::endl;
+		return 1;
+	}
+
+	engine::PgnReader reader;
+	if (!reader.open(path))
+	{
+		return 1;
+	}
+	const size_t bytes = reader.getSize();
+	std::cout << path << " : " << std::fixed << std::setprecision(1) << bytes / 1e6 << " MB, " << threads << " threads"
+			  << std::endl;
+
+	const PassResult parsed = readGames(reader, threads, false);
+	printPass("parse", parsed, bytes);
+	std::cout << "  " << parsed.games << " games, " << parsed.moves << " moves" << std::endl;
+
+	if (!parseOnly)
+	{
+		const PassResult replayed = readGames(reader, threads, true);
+		printPass("replay", replayed, bytes);
+		std::cout << "  " << replayed.errors << " games with a move which could not be resolved" << std::endl;
+		if (replayed.games != parsed.games)
+		{
+			std::cerr << "Error: " << replayed.games << " games read on the second pass" << std::endl;
+			return 1;
+		}
+		if (replayed.errors != 0)
+		{
+			return 1;
+		}
+	}
+
+	return 0;
+}
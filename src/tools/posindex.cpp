@@ -0,0 +1,240 @@
+/**
+ * @author obiwan138
+ * @file posindex.cpp
+ * @brief Builder and query tool of the position index of a game archive (headless)
+ * @details Usage :
+ *   posindex build <archive> -o <index>       index the positions of the games of an archive
+ *   posindex build ... --threads <n>          threads of the replay (default : all the cores)
+ *   posindex build ... --memory <MiB>         memory budget of the sorted positions of a pass (default : 1024)
+ *   posindex query <index> --fen "<fen>"      games of the archive which reached a position (numbers from 1)
+ *   posindex query ... --max <n>              number of games listed (default : 20)
+ *   posindex bench <index> <archive>          lookups of random positions of the archive (us/lookup, p99) ; every
+ *                                             game must be found in the posting list of its positions
+ */
+
+// Include standard headers
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <omp.h>
+#include <string>
+#include <vector>
+
+// Include project header files
+#include "engine/Attacks.hpp"
+#include "engine/GameArchive.hpp"
+#include "engine/Position.hpp"
+#include "engine/PositionIndex.hpp"
+
+namespace{
+
+	// Positions looked up by the benchmark
+	const int RANDOM_QUERIES = 100000;
+
+	// Games decoded per lookup of the benchmark (the start position is reached by every game)
+	const uint64_t BENCH_MAX_GAMES = 1000;
+
+	int build(const std::string& archivePath, const std::string& indexPath, int threads, size_t memoryMiB)
+	{
+		engine::GameArchive archive;
+		if (!archive.open(archivePath))
+		{
+			return 1;
+		}
+
+		const auto start = std::chrono::steady_clock::now();
+		if (!engine::PositionIndex::build(archive, indexPath, threads, memoryMiB, &std::cout))
+		{
+			return 1;
+		}
+		const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+		engine::PositionIndex index;
+		if (!index.open(indexPath))
+		{
+			return 1;
+		}
+		std::cout << archive.getGameCount() << " games, " << index.getKeyCount() << " distinct positions in " << std::fixed
+				  << std::setprecision(1) << seconds << " s (" << threads << " threads)" << std::endl;
+		return 0;
+	}
+
+	int query(const std::string& indexPath, const std::string& fen, uint64_t maxGames)
+	{
+		engine::PositionIndex index;
+		if (!index.open(indexPath))
+		{
+			return 1;
+		}
+		engine::Position position;
+		if (!position.setFromFen(fen))
+		{
+			std::cerr << "Error: invalid FEN " << fen << std::endl;
+			return 1;
+		}
+
+		std::vector<uint32_t> games;
+		const auto start = std::chrono::steady_clock::now();
+		const uint64_t count = index.lookup(position.getKey(), games, maxGames);
+		const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+		std::cout << count << " games (" << std::fixed << std::setprecision(1) << seconds * 1e6 << " us)";
+		for (uint32_t game : games)
+		{
+			std::cout << " " << game + 1;
+		}
+		std::cout << (count > games.size() ? " ..." : "") << std::endl;
+		return 0;
+	}
+
+	int bench(const std::string& indexPath, const std::string& archivePath)
+	{
+		engine::PositionIndex index;
+		engine::GameArchive archive;
+		if (!index.open(indexPath) || !archive.open(archivePath))
+		{
+			return 1;
+		}
+		const uint64_t gameCount = archive.getGameCount();
+		if (gameCount == 0 || index.getGameCount() != gameCount)
+		{
+			std::cerr << "Error: " << indexPath << " is not the index of " << archivePath << std::endl;
+			return 1;
+		}
+
+		// Random positions of random games, replayed before the measure
+		struct Query {
+			uint64_t key;
+			uint32_t game;
+		};
+		std::vector<Query> queries;
+		queries.reserve(RANDOM_QUERIES);
+		uint64_t state = 0x2545F4914F6CDD1Dull;
+		auto next = [&]()
+		{
+			state ^= state >> 12;
+			state ^= state << 25;
+			state ^= state >> 27;
+			return state * 0x2545F4914F6CDD1Dull;
+		};
+		engine::Position position;
+		std::vector<engine::Move> moves;
+		std::vector<uint64_t> keys;
+		while (queries.size() < static_cast<size_t>(RANDOM_QUERIES))
+		{
+			const uint64_t game = next() % gameCount;
+			if (!archive.readGame(game, position, moves, &keys))
+			{
+				std::cerr << "Error: game " << game + 1 << " could not be decoded" << std::endl;
+				return 1;
+			}
+			queries.push_back({keys[next() % keys.size()], static_cast<uint32_t>(game)});
+		}
+
+		std::vector<double> latencies;
+		latencies.reserve(queries.size());
+		std::vector<uint32_t> games;
+		uint64_t total = 0;
+		for (const Query& query : queries)
+		{
+			const auto start = std::chrono::steady_clock::now();
+			total += index.lookup(query.key, games, BENCH_MAX_GAMES);
+			latencies.push_back(std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+		}
+
+		// Every game must be in the posting lists of its positions (complete lists, out of the measure)
+		uint64_t missing = 0;
+		for (const Query& query : queries)
+		{
+			index.lookup(query.key, games);
+			missing += std::binary_search(games.begin(), games.end(), query.game) ? 0 : 1;
+		}
+
+		double sum = 0.0;
+		for (double latency : latencies)
+		{
+			sum += latency;
+		}
+		std::sort(latencies.begin(), latencies.end());
+		std::cout << indexPath << " : " << gameCount << " games, " << index.getKeyCount() << " distinct positions" << std::endl;
+		std::cout << "lookup    " << std::fixed << std::setprecision(2) << sum * 1e6 / latencies.size() << " us on average, p99 "
+				  << latencies[latencies.size() * 99 / 100] * 1e6 << " us, max " << latencies.back() * 1e6 << " us (first "
+				  << BENCH_MAX_GAMES << " games decoded, " << std::setprecision(1) << static_cast<double>(total) / queries.size()
+				  << " games per position on average)" << std::endl;
+		std::cout << "Verification : " << (missing == 0 ? "OK" : "FAILED") << " (" << queries.size() << " positions, " << missing
+				  << " games missing)" << std::endl;
+		return missing == 0 ? 0 : 1;
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	if (argc < 2)
+	{
+		std::cerr << "Usage : posindex build <archive> -o <index> [--threads <n>] [--memory <MiB>] | query <index> --fen \"<fen>\" "
+				  << "[--max <n>] | bench <index> <archive>" << std::endl;
+		return 1;
+	}
+
+	const std::string command = argv[1];
+	std::vector<std::string> inputs;
+	std::string outputPath;
+	std::string fen;
+	int threads = omp_get_max_threads();
+	size_t memoryMiB = 1024;
+	uint64_t maxGames = 20;
+
+	for (int i = 2; i < argc; i++)
+	{
+		std::string option = argv[i];
+		if (i + 1 < argc && (option == "-o" || option == "--output"))
+		{
+			outputPath = argv[++i];
+		}
+		else if (i + 1 < argc && option == "--fen")
+		{
+			fen = argv[++i];
+		}
+		else if (i + 1 < argc && option == "--threads")
+		{
+			threads = std::max(std::stoi(argv[++i]), 1);
+		}
+		else if (i + 1 < argc && option == "--memory")
+		{
+			memoryMiB = static_cast<size_t>(std::max(std::stoll(argv[++i]), 1LL));
+		}
+		else if (i + 1 < argc && option == "--max")
+		{
+			maxGames = static_cast<uint64_t>(std::max(std::stoll(argv[++i]), 0LL));
+		}
+		else if (option.rfind("-", 0) != 0)
+		{
+			inputs.push_back(option);
+		}
+		else
+		{
+			std::cerr << "Unknown option " << option << std::endl;
+			return 1;
+		}
+	}
+
+	engine::initAttacks();
+
+	if (command == "build" && inputs.size() == 1 && !outputPath.empty())
+	{
+		return build(inputs[0], outputPath, threads, memoryMiB);
+	}
+	if (command == "query" && inputs.size() == 1 && !fen.empty())
+	{
+		return query(inputs[0], fen, maxGames);
+	}
+	if (command == "bench" && inputs.size() == 2)
+	{
+		return bench(inputs[0], inputs[1]);
+	}
+
+	std::cerr << "Unknown command " << command << " (build, query or bench)" << std::endl;
+	return 1;
+}
@@ -0,0 +1,147 @@
+/**
+ * @author obiwan138
+ * @file smpscale.cpp
+ * @brief Scaling benchmark of the Lazy SMP search from 1 to N threads (headless, no graphics dependency)
+ * @details Usage :
+ *   smpscale                                 search the benchmark positions to a fixed depth with 1, 2, 4, ... N threads
+ *   smpscale --depth <d>                     depth of the searches (default : 12)
+ *   smpscale --threads <n>                   maximum number of threads (default : all the hardware threads)
+ *   smpscale --hash <MiB>                    size of the transposition table (default : 256)
+ *   smpscale --elo-per-doubling <elo>        Elo gained by doubling the thinking time (default : 70)
+ * For each thread count, the table is cleared before each position and the program reports the time to depth, its
+ * speedup over one thread, the nodes per second and the Elo-equivalent of the speedup, i.e. the Elo a single thread
+ * would gain with that much more time (elo-per-doubling x log2(speedup)). Lazy SMP also widens the search, so the time
+ * to depth underestimates the real strength gain.
+ */
+
+// Include standard headers
+#include <cmath>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// Include project header files
+#include "engine/Attacks.hpp"
+#include "engine/GameState.hpp"
+#include "engine/ParallelSearch.hpp"
+#include "engine/TranspositionTable.hpp"
+
+namespace{
+
+	// Middle game positions with various structures
+	const char* benchPositions[] = {
+		"rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+		"r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+		"r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10",
+		"r1bq1rk1/pp2bppp/2n1pn2/3p4/2PP4/2N1PN2/PP2BPPP/R2QKB1R w KQ - 0 8",
+		"2rq1rk1/pb1nbppp/1p2pn2/2pp4/2PP4/1P2PNP1/PB1N1PBP/R2Q1RK1 w - - 0 11",
+		"r2qr1k1/1p1nbppp/p2pbn2/4p3/4P3/1NN1BP2/PPPQ2PP/2KR1B1R w - - 0 12",
+		"8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+		"6k1/5p1p/p3p1p1/1p1rP3/3P4/P4P2/1P3KPP/2R5 w - - 0 30",
+	};
+
+	// Totals of one thread count
+	struct ScalingResult {
+		int threads;
+		double timeMs;
+		uint64_t nodes;
+	};
+
+	// Search all the positions to a depth, the table and the statistics are cleared before each one
+	ScalingResult runPositions(engine::TranspositionTable& tt, engine::ParallelSearch& search, int depth)
+	{
+		ScalingResult total{search.getThreadCount(), 0.0, 0};
+		for (const char* fen : benchPositions)
+		{
+			engine::GameState game;
+			game.setFromFen(fen);
+			tt.clear();
+			search.clear();
+
+			engine::SearchLimits limits;
+			limits.depth = depth;
+			engine::SearchResult result = search.run(game, limits);
+
+			total.timeMs += static_cast<double>(result.timeMs);
+			total.nodes += result.nodes;
+		}
+		return total;
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	int depth = 12;
+	int maxThreads = engine::ParallelSearch::getMaxThreads();
+	size_t hashMb = 256;
+	double eloPerDoubling = 70.0;
+
+	for (int i = 1; i < argc; i++)
+	{
+		std::string option = argv[i];
+		if (i + 1 < argc && option == "--depth")
+		{
+			depth = std::stoi(argv[++i]);
+		}
+		else if (i + 1 < argc && option == "--threads")
+		{
+			maxThreads = std::stoi(argv[++i]);
+		}
+		else if (i + 1 < argc && option == "--hash")
+		{
+			hashMb = std::stoul(argv[++i]);
+		}
+		else if (i + 1 < argc && option == "--elo-per-doubling")
+		{
+			eloPerDoubling = std::stod(argv[++i]);
+		}
+		else
+		{
+			std::cerr << "Unknown option " << option << std::endl;
+			return 1;
+		}
+	}
+
+	engine::initAttacks();
+	engine::TranspositionTable tt(hashMb);
+
+	// Thread counts : powers of two, then the maximum
+	std::vector<int> threadCounts;
+	for (int threads = 1; threads < maxThreads; threads *= 2)
+	{
+		threadCounts.push_back(threads);
+	}
+	threadCounts.push_back(std::max(maxThreads, 1));
+
+	std::cout << "Lazy SMP scaling, depth " << depth << ", " << sizeof(benchPositions) / sizeof(benchPositions[0])
+			  << " positions, " << hashMb << " MiB hash" << std::endl;
+	std::cout << std::setw(8) << "threads" << std::setw(12) << "time (ms)" << std::setw(10) << "speedup"
+			  << std::setw(12) << "Mnps" << std::setw(12) << "nps ratio" << std::setw(10) << "Elo" << std::endl;
+
+	ScalingResult reference{};
+	for (int threads : threadCounts)
+	{
+		engine::ParallelSearch search(tt, threads);
+		ScalingResult result = runPositions(tt, search, depth);
+		if (threads == 1)
+		{
+			reference = result;
+		}
+
+		const double nps = result.nodes * 1000.0 / std::max(result.timeMs, 1.0);
+		const double referenceNps = reference.nodes * 1000.0 / std::max(reference.timeMs, 1.0);
+		const double speedup = reference.timeMs / std::max(result.timeMs, 1.0);
+
+		std::cout << std::fixed << std::setprecision(2)
+				  << std::setw(8) << threads
+				  << std::setw(12) << std::setprecision(0) << result.timeMs
+				  << std::setw(10) << std::setprecision(2) << speedup
+				  << std::setw(12) << nps / 1e6
+				  << std::setw(12) << nps / referenceNps
+				  << std::setw(10) << std::setprecision(0) << eloPerDoubling * std::log2(speedup) << std::endl;
+	}
+
+	return 0;
+}
@@ -0,0 +1,37 @@
+/**
+ * @author obiwan138
+ * @file uci.cpp
+ * @brief UCI engine executable (headless, no graphics dependency)
+ * @details Usage :
+ *   chess3d-uci                              read the UCI commands on the standard input
+ *   chess3d-uci bench [depth] [threads]      run the bench command and exit (node signature and speed, then the
+ *                                            speed with 2, 4, ... threads)
+ */
+
+// Include standard headers
+#include <sstream>
+#include <string>
+
+// Include project header files
+#include "engine/Uci.hpp"
+
+int main(int argc, char* argv[])
+{
+	engine::Uci uci;
+
+	// Commands given on the command line are executed instead of reading the standard input
+	if (argc > 1)
+	{
+		std::string commands;
+		for (int i = 1; i < argc; i++)
+		{
+			commands += std::string(argv[i]) + " ";
+		}
+		std::istringstream input(commands);
+		uci.loop(input);
+		return 0;
+	}
+
+	uci.loop();
+	return 0;
+}